@@ -0,0 +1,473 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "incg_adj.h"
+#include "incg_sort.h"
+
+
+//
+// Function to return the edge (0,1,2) of a triangle and its vertex at the
+// start of the edge in the triangle's loop
+//
+static const edge_t* incg_Adj_TriEdge( const triangle_t* t, int k,
+                                       long int *iv )
+{
+   const edge_t *e;
+   char d;
+
+   if( k == 0 ) {
+      e = t->e1; d = t->d1;
+   } else if( k == 1 ) {
+      e = t->e2; d = t->d2;
+   } else {
+      e = t->e3; d = t->d3;
+   }
+
+   if( iv != NULL ) *iv = d == 0 ? e->va->id : e->vb->id;
+   return e;
+}
+
+
+//
+// Function to return the edges of a triangle that leave from and arrive at a
+// vertex in the triangle's loop (a triangle without the vertex gives nulls)
+//
+static void incg_Adj_Spokes( const triangle_t* t, long int iv,
+                             const edge_t** eout, const edge_t** ein )
+{
+   long int ic;
+   int k;
+
+   *eout = NULL;
+   *ein = NULL;
+   for(k=0;k<3;++k) {
+      const edge_t *e = incg_Adj_TriEdge( t, k, &ic );
+      if( ic == iv ) {
+         *eout = e;
+         *ein = incg_Adj_TriEdge( t, (k+2)%3, NULL );
+         return;
+      }
+   }
+}
+
+
+//
+// Function to return the triangle on the other side of an edge
+//
+static const triangle_t* incg_Adj_Across( const edge_t* e, const triangle_t* t )
+{
+   if( e->tl == t ) return e->tr;
+   return e->tl;
+}
+
+
+//
+// Function to append an edge to a ring unless it is already there
+//
+static void incg_Adj_PutEdge( const edge_t* e, long int iv,
+                              long int* edge, long int* vert, long int *n )
+{
+   long int k;
+
+   for(k=0;k<*n;++k) if( edge[k] == e->id ) return;
+   edge[*n] = e->id;
+   vert[*n] = e->va->id == iv ? e->vb->id : e->va->id;
+   ++(*n);
+}
+
+
+//
+// Function to return the position of a triangle in a list (or -1)
+//
+static long int incg_Adj_Find( long int n, const long int* list, long int it )
+{
+   long int k;
+
+   for(k=0;k<n;++k) if( list[k] == it ) return k;
+   return -1;
+}
+
+
+//
+// Function to order the ring of a vertex from unordered lists of its
+// triangles and edges (which are overwritten). Fans of triangles are walked
+// one after the other: a fan starts at a triangle with no unvisited neighbour
+// before it in the rotation, or at the lowest-numbered unvisited triangle when
+// the fan is closed. Edges that belong to no triangle of the vertex are put
+// last, in increasing order.
+//
+static void incg_Adj_Order( const mesh_t* m, long int iv,
+                            long int nt, long int* tri, char* seen,
+                            long int ne, long int* edge, long int* vert,
+                            long int* ut, long int* ue )
+{
+   long int k,j,n=0,ntr=0,ned=0;
+
+
+   memcpy( ut, tri, ((size_t) nt) * sizeof( long int ) );
+   memcpy( ue, edge, ((size_t) ne) * sizeof( long int ) );
+
+   // sort the triangles for determinism
+   for(k=1;k<nt;++k) {
+      long int tmp = ut[k];
+      for(j=k;j>0 && ut[j-1]>tmp;--j) ut[j] = ut[j-1];
+      ut[j] = tmp;
+   }
+   memset( seen, 0, (size_t) nt );
+
+   while( n < nt ) {
+      const triangle_t *t=NULL, *tn;
+      const edge_t *eo, *ei;
+      long int is=-1;
+
+      // find the start of a fan
+      for(k=0;k<nt && is<0;++k) {
+         if( seen[k] ) continue;
+         incg_Adj_Spokes( &( m->t[ ut[k] ] ), iv, &eo, &ei );
+         if( eo == NULL ) { is = k; break; }
+         tn = incg_Adj_Across( eo, &( m->t[ ut[k] ] ) );
+         j = tn != NULL ? incg_Adj_Find( nt, ut, tn->id ) : -1;
+         if( j < 0 || seen[j] ) is = k;
+      }
+      if( is < 0 ) {
+         for(k=0;k<nt && is<0;++k) if( !seen[k] ) is = k;
+      }
+
+      // walk the fan
+      k = is;
+      while( k >= 0 ) {
+         t = &( m->t[ ut[k] ] );
+         seen[k] = 1;
+         ++n;
+         incg_Adj_Spokes( t, iv, &eo, &ei );
+         if( eo != NULL ) incg_Adj_PutEdge( eo, iv, edge, vert, &ned );
+         tri[ntr++] = t->id;
+         if( ei == NULL ) break;
+         tn = incg_Adj_Across( ei, t );
+         k = tn != NULL ? incg_Adj_Find( nt, ut, tn->id ) : -1;
+         if( k >= 0 && seen[k] ) k = -1;
+         if( k < 0 ) incg_Adj_PutEdge( ei, iv, edge, vert, &ned );
+      }
+   }
+
+   // edges outside of the fans
+   for(k=1;k<ne;++k) {
+      long int tmp = ue[k];
+      for(j=k;j>0 && ue[j-1]>tmp;--j) ue[j] = ue[j-1];
+      ue[j] = tmp;
+   }
+   for(k=0;k<ne && ned<ne;++k) {
+      incg_Adj_PutEdge( &( m->e[ ue[k] ] ), iv, edge, vert, &ned );
+   }
+}
+
+
+//
+// Function to allocate the arrays of an adjacency object
+//
+static int incg_Adj_Alloc( struct incg_adj_s* a, long int nv,
+                           long int nt3, long int ne2 )
+{
+   memset( a, 0, sizeof(struct incg_adj_s) );
+   a->nv = nv;
+   a->tofs = (long int *) malloc( ((size_t) (nv+1)) * sizeof( long int ) );
+   a->eofs = (long int *) malloc( ((size_t) (nv+1)) * sizeof( long int ) );
+   a->tri  = (long int *) malloc( ((size_t) nt3) * sizeof( long int ) );
+   a->edge = (long int *) malloc( ((size_t) ne2) * sizeof( long int ) );
+   a->vert = (long int *) malloc( ((size_t) ne2) * sizeof( long int ) );
+   if( a->tofs == NULL || a->eofs == NULL ||
+       a->tri == NULL || a->edge == NULL || a->vert == NULL ) {
+      incg_Adj_Free( a );
+      return -1;
+   }
+
+   return 0;
+}
+
+
+//
+// Function to build the adjacency of the vertices of a mesh object in two
+// passes: the triangles and edges of every vertex are counted, the counts are
+// turned into offsets by a prefix sum, and the lists are filled. The lists of
+// every vertex are then ordered by rotation, independently of each other.
+//
+
+int incg_Adj_Build( const mesh_t* m, struct incg_adj_s* a )
+{
+   long int *pt=NULL, *pe=NULL, *ut=NULL, nv,i;
+   long int maxd=0;
+   char *seen=NULL;
+   int nthr=1,ierr=0;
+
+
+   if( m == NULL || a == NULL ) return 1;
+   if( m->nv == 0 || m->nt == 0 ) return 2;
+
+   nv = m->nv;
+#ifdef _OPENMP
+   nthr = omp_get_max_threads();
+#endif
+   ierr = incg_Adj_Alloc( a, nv, 3*m->nt, 2*m->ne );
+   if( ierr ) return ierr;
+   pt = (long int *) malloc( ((size_t) nv) * sizeof( long int ) );
+   pe = (long int *) malloc( ((size_t) nv) * sizeof( long int ) );
+   if( pt == NULL || pe == NULL ) {
+      ierr = -1;
+      goto cleanup;
+   }
+
+   // count
+#pragma omp parallel for
+   for(i=0;i<nv;++i) {
+      a->tofs[i] = 0;
+      a->eofs[i] = 0;
+   }
+#pragma omp parallel for
+   for(i=0;i<m->nt;++i) {
+      int k;
+      for(k=0;k<3;++k) {
+         long int iv;
+         (void) incg_Adj_TriEdge( &( m->t[i] ), k, &iv );
+#pragma omp atomic
+         a->tofs[iv] += 1;
+      }
+   }
+#pragma omp parallel for
+   for(i=0;i<m->ne;++i) {
+#pragma omp atomic
+      a->eofs[ m->e[i].va->id ] += 1;
+#pragma omp atomic
+      a->eofs[ m->e[i].vb->id ] += 1;
+   }
+
+   // offsets
+   a->tofs[nv] = incg_Sort_ScanExclusive( nv, a->tofs );
+   a->eofs[nv] = incg_Sort_ScanExclusive( nv, a->eofs );
+
+   // fill (in no particular order)
+#pragma omp parallel for reduction(max:maxd)
+   for(i=0;i<nv;++i) {
+      pt[i] = a->tofs[i];
+      pe[i] = a->eofs[i];
+      if( a->eofs[i+1] - a->eofs[i] > maxd ) maxd = a->eofs[i+1] - a->eofs[i];
+      if( a->tofs[i+1] - a->tofs[i] > maxd ) maxd = a->tofs[i+1] - a->tofs[i];
+   }
+#pragma omp parallel for
+   for(i=0;i<m->nt;++i) {
+      int k;
+      for(k=0;k<3;++k) {
+         long int iv,j;
+         (void) incg_Adj_TriEdge( &( m->t[i] ), k, &iv );
+#pragma omp atomic capture
+         j = pt[iv]++;
+         a->tri[j] = i;
+      }
+   }
+#pragma omp parallel for
+   for(i=0;i<m->ne;++i) {
+      long int j;
+#pragma omp atomic capture
+      j = pe[ m->e[i].va->id ]++;
+      a->edge[j] = i;
+#pragma omp atomic capture
+      j = pe[ m->e[i].vb->id ]++;
+      a->edge[j] = i;
+   }
+
+   // order the rings (with scratch lists for every thread)
+   ut = (long int *) malloc( ((size_t) (nthr*(2*maxd+2))) *
+                             sizeof( long int ) );
+   seen = (char *) malloc( (size_t) (nthr*(maxd+1)) );
+   if( ut == NULL || seen == NULL ) {
+      ierr = -1;
+      goto cleanup;
+   }
+#pragma omp parallel for schedule(dynamic,256) num_threads( nthr )
+   for(i=0;i<nv;++i) {
+      long int *u;
+      int it=0;
+
+#ifdef _OPENMP
+      it = omp_get_thread_num();
+#endif
+      u = &( ut[ it*(2*maxd+2) ] );
+      incg_Adj_Order( m, i,
+                      a->tofs[i+1] - a->tofs[i], &( a->tri[ a->tofs[i] ] ),
+                      &( seen[ it*(maxd+1) ] ),
+                      a->eofs[i+1] - a->eofs[i], &( a->edge[ a->eofs[i] ] ),
+                      &( a->vert[ a->eofs[i] ] ), u, &( u[maxd+1] ) );
+   }
+
+cleanup:
+   if( ut != NULL ) free( ut );
+   if( seen != NULL ) free( seen );
+   if( pt != NULL ) free( pt );
+   if( pe != NULL ) free( pe );
+   if( ierr ) incg_Adj_Free( a );
+
+   return ierr;
+}
+
+
+//
+// Function to update the adjacency of a mesh object after the mesh has been
+// refined by incg_RefineMesh_Uniform(). It uses the numbering of the refined
+// mesh rather than searching: an incoming vertex keeps its ring, in which
+// each triangle is replaced by its child at the vertex, each edge by its half
+// at the vertex, and each neighbour by the midpoint of the edge. A vertex made
+// at the midpoint of an edge has a ring of known size (three triangles and two
+// edges per side of the edge, plus the two halves), which is walked from a
+// triangle at one of the halves.
+//
+
+int incg_Adj_Refine( const mesh_t* m, struct incg_adj_s* a )
+{
+   struct incg_adj_s b;
+   long int nv0,ne0,nt0,i;
+   int ierr;
+
+
+   if( m == NULL || a == NULL ) return 1;
+   if( a->tofs == NULL ) return 2;
+
+   nv0 = a->nv;
+   ne0 = m->nv - nv0;
+   nt0 = m->nt / 4;
+   if( ne0 <= 0 || 4*nt0 != m->nt || m->ne != 2*ne0 + 3*nt0 ||
+       a->eofs[nv0] != 2*ne0 || a->tofs[nv0] != 3*nt0 ) return 3;
+
+   ierr = incg_Adj_Alloc( &b, m->nv, 3*m->nt, 2*m->ne );
+   if( ierr ) return ierr;
+
+   // counts: incoming vertices keep theirs
+#pragma omp parallel for
+   for(i=0;i<m->nv;++i) {
+      if( i < nv0 ) {
+         b.tofs[i] = a->tofs[i+1] - a->tofs[i];
+         b.eofs[i] = a->eofs[i+1] - a->eofs[i];
+      } else {
+         const edge_t *e = &( m->e[ 2*(i-nv0) ] );
+         long int ns = ( e->tl != NULL ? 1 : 0 ) + ( e->tr != NULL ? 1 : 0 );
+         b.tofs[i] = 3*ns;
+         b.eofs[i] = 2 + 2*ns;
+      }
+   }
+   b.tofs[m->nv] = incg_Sort_ScanExclusive( m->nv, b.tofs );
+   b.eofs[m->nv] = incg_Sort_ScanExclusive( m->nv, b.eofs );
+
+#pragma omp parallel for schedule(dynamic,256)
+   for(i=0;i<m->nv;++i) {
+      long int *tri = &( b.tri[ b.tofs[i] ] );
+      long int *edge = &( b.edge[ b.eofs[i] ] );
+      long int *vert = &( b.vert[ b.eofs[i] ] );
+      long int k,n;
+
+      if( i < nv0 ) {
+         n = a->tofs[i+1] - a->tofs[i];
+         for(k=0;k<n;++k) {
+            long int it = 4*a->tri[ a->tofs[i] + k ];
+            long int iv;
+
+            // the corner children have the corner at the start of edge 1
+            (void) incg_Adj_TriEdge( &( m->t[it] ), 0, &iv );
+            if( iv != i ) {
+               ++it;
+               (void) incg_Adj_TriEdge( &( m->t[it] ), 0, &iv );
+               if( iv != i ) ++it;
+            }
+            tri[k] = it;
+         }
+         n = a->eofs[i+1] - a->eofs[i];
+         for(k=0;k<n;++k) {
+            long int ie = a->edge[ a->eofs[i] + k ];
+            edge[k] = m->e[2*ie].va->id == i ? 2*ie : 2*ie + 1;
+            vert[k] = nv0 + ie;
+         }
+      } else {
+         const edge_t *eh = &( m->e[ 2*(i-nv0) ] );
+         const triangle_t *t = eh->tl != NULL ? eh->tl : eh->tr;
+         const triangle_t *ts = t, *tn;
+         const edge_t *eo, *ei;
+         long int ned=0;
+
+         // back to the start of the fan at a boundary (or around)
+         while( 1 ) {
+            incg_Adj_Spokes( t, i, &eo, &ei );
+            tn = incg_Adj_Across( eo, t );
+            if( tn == NULL || tn == ts ) break;
+            t = tn;
+         }
+         ts = t;
+         n = 0;
+         while( 1 ) {
+            incg_Adj_Spokes( t, i, &eo, &ei );
+            edge[ned] = eo->id;
+            vert[ned++] = eo->va->id == i ? eo->vb->id : eo->va->id;
+            tri[n++] = t->id;
+            tn = incg_Adj_Across( ei, t );
+            if( tn == NULL ) {
+               edge[ned] = ei->id;
+               vert[ned++] = ei->va->id == i ? ei->vb->id : ei->va->id;
+            }
+            if( tn == NULL || tn == ts ) break;
+            t = tn;
+         }
+
+         // a closed ring starts at its lowest-numbered triangle, as built
+         if( ned == n ) {
+            long int tmp[3][6], j=0;
+
+            for(k=1;k<n;++k) if( tri[k] < tri[j] ) j = k;
+            for(k=0;k<n;++k) {
+               tmp[0][k] = tri[ (k+j)%n ];
+               tmp[1][k] = edge[ (k+j)%n ];
+               tmp[2][k] = vert[ (k+j)%n ];
+            }
+            for(k=0;k<n;++k) {
+               tri[k] = tmp[0][k];
+               edge[k] = tmp[1][k];
+               vert[k] = tmp[2][k];
+            }
+         }
+      }
+   }
+
+   incg_Adj_Free( a );
+   *a = b;
+
+   return 0;
+}
+
+
+//
+// Function to release the arrays of an adjacency object
+//
+
+int incg_Adj_Free( struct incg_adj_s* a )
+{
+   if( a == NULL ) return 1;
+
+   if( a->tofs != NULL ) free( a->tofs );
+   if( a->eofs != NULL ) free( a->eofs );
+   if( a->tri != NULL ) free( a->tri );
+   if( a->edge != NULL ) free( a->edge );
+   if( a->vert != NULL ) free( a->vert );
+   memset( a, 0, sizeof(struct incg_adj_s) );
+
+   return 0;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
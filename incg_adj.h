@@ -0,0 +1,33 @@
+
+#ifndef _INCG_ADJ_H_
+#define _INCG_ADJ_H_
+
+#include "incg_mesh.h"
+
+//
+// Adjacency of the vertices of a mesh object in compressed-row (CSR) form.
+// The triangles of vertex i are tri[ tofs[i] ... tofs[i+1]-1 ], and its edges
+// and the vertices at their other ends are edge[] and vert[] over the range
+// of eofs[]. Rings are ordered by rotation around the vertex, in the sense of
+// the triangles' loops, as: edge 0, triangle 0, edge 1, triangle 1, ... with
+// edge k+1 shared by triangles k and k+1. A boundary vertex starts at its
+// boundary edge and has one edge more than it has triangles.
+//
+struct incg_adj_s {
+   long int nv;
+   long int *tofs, *tri;
+   long int *eofs, *edge, *vert;
+};
+
+int incg_Adj_Build(
+   const mesh_t* m,
+   struct incg_adj_s* a );
+
+int incg_Adj_Refine(
+   const mesh_t* m,
+   struct incg_adj_s* a );
+
+int incg_Adj_Free( struct incg_adj_s* a );
+
+#endif
+
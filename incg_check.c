@@ -0,0 +1,513 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "incg_check.h"
+#include "incg_utils.h"
+
+
+//
+// Function to return an edge (0,1,2) of a triangle and its direction in the
+// triangle's loop
+//
+static const edge_t* incg_Check_TriEdge( const triangle_t* t, int k,
+                                         char *d )
+{
+   if( k == 0 ) {
+      *d = t->d1; return t->e1;
+   } else if( k == 1 ) {
+      *d = t->d2; return t->e2;
+   }
+   *d = t->d3; return t->e3;
+}
+
+
+//
+// Function to return the (unnormalized) normal of a triangle whose links are
+// known to be sound
+//
+static void incg_Check_Normal( const triangle_t* t, double* n )
+{
+   const vertex_t *p[3];
+   double u[3],w[3];
+   const edge_t *e;
+   char d;
+   int k;
+
+   for(k=0;k<3;++k) {
+      e = incg_Check_TriEdge( t, k, &d );
+      p[k] = d == 0 ? e->va : e->vb;
+   }
+   u[0] = p[1]->x - p[0]->x; w[0] = p[2]->x - p[0]->x;
+   u[1] = p[1]->y - p[0]->y; w[1] = p[2]->y - p[0]->y;
+   u[2] = p[1]->z - p[0]->z; w[2] = p[2]->z - p[0]->z;
+   incg_Vec_CrossProduct( u, w, n );
+}
+
+
+//
+// Function to count the triangles of the fan of a vertex that is reached from
+// a triangle by rotating both ways over the corners of the triangles (their
+// vertices "cv" and the triangles "ct" across their outgoing edges); the walk
+// is bounded by the number of the vertex's triangles
+//
+static long int incg_Check_Fan( const long int* cv, const long int* ct,
+                                long int ts, long int iv, long int ntv )
+{
+   long int t, n=1;
+   int iw,k;
+
+   for(iw=0;iw<2;++iw) {
+      t = ts;
+      while( n <= ntv ) {
+         for(k=0;k<3 && cv[3*t+k] != iv;++k);
+         if( k == 3 ) return -1;
+         // across the edge leaving the vertex (first way) or arriving at it
+         t = ct[ 3*t + ( iw == 0 ? k : (k+2)%3 ) ];
+         if( t < 0 ) break;
+         if( t == ts ) return n;      // closed fan
+         ++n;
+      }
+   }
+
+   return n;
+}
+
+
+//
+// Function to check the links and the loop of a triangle: its edges and their
+// vertices are in the mesh's arrays, the edges place the triangle on the side
+// of their direction (d1,d2,d3) in its loop, and the loop is closed; the
+// vertices that start the edges in the loop are returned when all is sound
+//
+static unsigned int incg_Check_Loop( const mesh_t* m, const triangle_t* t,
+                                     long int* iv )
+{
+   const edge_t *e;
+   long int ia[3],ib[3];
+   unsigned int f=0;
+   char d;
+   int k;
+
+   for(k=0;k<3;++k) {
+      e = incg_Check_TriEdge( t, k, &d );
+      if( e < m->e || e >= m->e + m->ne ) return INCG_CHECK_LINK;
+      if( e->va < m->v || e->va >= m->v + m->nv ||
+          e->vb < m->v || e->vb >= m->v + m->nv ) return INCG_CHECK_LINK;
+
+      if( d == 0 ) {
+         if( e->tl != t ) f |= INCG_CHECK_SIDE;
+         ia[k] = e->va - m->v;
+         ib[k] = e->vb - m->v;
+      } else if( d == 1 ) {
+         if( e->tr != t ) f |= INCG_CHECK_SIDE;
+         ia[k] = e->vb - m->v;
+         ib[k] = e->va - m->v;
+      } else {
+         return INCG_CHECK_SIDE;
+      }
+   }
+   for(k=0;k<3;++k) {
+      if( ib[k] != ia[(k+1)%3] ) f |= INCG_CHECK_LOOP;
+      iv[k] = ia[k];
+   }
+
+   return f;
+}
+
+
+//
+// Function to check whether a triangle traverses an edge in a direction
+//
+static int incg_Check_HasEdge( const triangle_t* t, const edge_t* e, char d )
+{
+   if( t->e1 == e && t->d1 == d ) return 1;
+   if( t->e2 == e && t->d2 == d ) return 1;
+   if( t->e3 == e && t->d3 == d ) return 1;
+   return 0;
+}
+
+
+//
+// Function to check the topology and geometry of a mesh object with every
+// entity checked independently of the others in parallel sweeps:
+//  - IDs agree with the positions in the arrays;
+//  - pointers are not null and point inside the mesh's arrays;
+//  - edges have their "left" triangle, and the "left" and "right" triangles
+//    traverse them in the directions (d1,d2,d3) that place them there;
+//  - the edges of every triangle form a closed loop;
+//  - edges have distinct vertices and triangles have non-zero area;
+//  - triangles on the two sides of an edge are not folded onto each other;
+//  - vertices are in triangles, and their triangles form a single fan.
+// (The fans are only walked when all links are sound.) The violations are
+// returned in lists by kind of entity.
+//
+
+int incg_Check_Mesh( const mesh_t* m, struct incg_check_s* c )
+{
+   return incg_Check_MeshSample( m, 1, 0, c );
+}
+
+
+//
+// Function to check a sample of the entities of a mesh object: part "ioff" of
+// "nstride" equal and contiguous parts of the arrays of every kind (see
+// incg_Check_Mesh()). Every entity is checked from its own links, so the cost
+// is that of the sample; successive checks of parts 0 ... nstride-1 cover all
+// entities. The vertices are only checked for their IDs, as their fans are
+// found by a sweep over all triangles that is made when there is one part.
+//
+
+int incg_Check_MeshSample( const mesh_t* m, long int nstride, long int ioff,
+                           struct incg_check_s* c )
+{
+   unsigned int *fv=NULL, *fe=NULL, *ft=NULL;
+   long int *ntv=NULL, *tsv=NULL, *cv=NULL, *ct=NULL, *ids=NULL;
+   long int nv,ne,nt,iv0,ie0,it0,nsv,nse,nst,i,j,nlink=0;
+   int ierr=0;
+
+
+   if( m == NULL || c == NULL ) return 1;
+   if( nstride < 1 || ioff < 0 || ioff >= nstride ) return 1;
+   memset( c, 0, sizeof(struct incg_check_s) );
+
+   nv = m->nv;
+   ne = m->ne;
+   nt = m->nt;
+   if( nv < 0 || ne < 0 || nt < 0 ) return 2;
+   if( ( nv > 0 && m->v == NULL ) || ( ne > 0 && m->e == NULL ) ||
+       ( nt > 0 && m->t == NULL ) ) return 2;
+
+   // the parts that are sampled
+   iv0 = nv*ioff/nstride;
+   ie0 = ne*ioff/nstride;
+   it0 = nt*ioff/nstride;
+   nsv = nv*(ioff+1)/nstride - iv0;
+   nse = ne*(ioff+1)/nstride - ie0;
+   nst = nt*(ioff+1)/nstride - it0;
+
+   fv = (unsigned int *) malloc( ((size_t) nsv+1) * sizeof( unsigned int ) );
+   fe = (unsigned int *) malloc( ((size_t) nse+1) * sizeof( unsigned int ) );
+   ft = (unsigned int *) malloc( ((size_t) nst+1) * sizeof( unsigned int ) );
+   if( fv == NULL || fe == NULL || ft == NULL ) {
+      ierr = -1;
+      goto cleanup;
+   }
+   if( nstride == 1 ) {
+      ntv = (long int *) malloc( ((size_t) nv+1) * sizeof( long int ) );
+      tsv = (long int *) malloc( ((size_t) nv+1) * sizeof( long int ) );
+      cv = (long int *) malloc( ((size_t) 3*nt+1) * sizeof( long int ) );
+      ct = (long int *) malloc( ((size_t) 3*nt+1) * sizeof( long int ) );
+      if( ntv == NULL || tsv == NULL || cv == NULL || ct == NULL ) {
+         ierr = -1;
+         goto cleanup;
+      }
+   } else {
+      i = nsv > nse ? nsv : nse;
+      if( nst > i ) i = nst;
+      ids = (long int *) malloc( ((size_t) i+1) * sizeof( long int ) );
+      if( ids == NULL ) {
+         ierr = -1;
+         goto cleanup;
+      }
+   }
+
+#pragma omp parallel for
+   for(j=0;j<nsv;++j) {
+      long int iv = iv0 + j;
+
+      fv[j] = m->v[iv].id == iv ? 0 : INCG_CHECK_ID;
+      if( ntv != NULL ) {
+         ntv[iv] = 0;
+         tsv[iv] = -1;
+      }
+   }
+
+   // triangles
+#pragma omp parallel for reduction(+:nlink)
+   for(j=0;j<nst;++j) {
+      long int it = it0 + j;
+      const triangle_t *t = &( m->t[it] );
+      long int iv[3];
+      unsigned int f=0;
+      int k;
+
+      if( ct != NULL ) {
+         for(k=0;k<3;++k) {
+            cv[3*it+k] = -1;
+            ct[3*it+k] = -1;
+         }
+      }
+
+      if( t->id != it ) f |= INCG_CHECK_ID;
+      f |= incg_Check_Loop( m, t, iv );
+      if( f & (INCG_CHECK_LINK | INCG_CHECK_SIDE | INCG_CHECK_LOOP) ) {
+         ft[j] = f;
+         ++nlink;
+         continue;
+      }
+
+      if( iv[0] == iv[1] || iv[1] == iv[2] || iv[2] == iv[0] ) {
+         f |= INCG_CHECK_DEGENERATE;
+      } else {
+         double s=0.0, tn[3];
+         for(k=0;k<3;++k) {
+            char d;
+            const edge_t *e = incg_Check_TriEdge( t, k, &d );
+            double dx = e->vb->x - e->va->x;
+            double dy = e->vb->y - e->va->y;
+            double dz = e->vb->z - e->va->z;
+            s += dx*dx + dy*dy + dz*dz;
+         }
+         incg_Check_Normal( t, tn );
+         if( incg_Vec_DotProduct( tn, tn ) <= 1.0e-24*s*s ) {
+            f |= INCG_CHECK_DEGENERATE;
+         }
+      }
+      ft[j] = f;
+
+      // corners, and counts of triangles of the vertices of sound loops
+      if( ct == NULL ) continue;
+      for(k=0;k<3;++k) {
+         char d;
+         const edge_t *e = incg_Check_TriEdge( t, k, &d );
+         const triangle_t *to = d == 0 ? e->tr : e->tl;
+         long int jv = iv[k];
+
+         cv[3*it+k] = jv;
+         if( to >= m->t && to < m->t + nt ) ct[3*it+k] = to - m->t;
+#pragma omp atomic
+         ntv[jv] += 1;
+#pragma omp atomic write
+         tsv[jv] = it;     // any one triangle of the vertex
+      }
+   }
+
+   // edges (the triangles on their sides are checked from their own links)
+#pragma omp parallel for reduction(+:nlink)
+   for(j=0;j<nse;++j) {
+      const edge_t *e = &( m->e[ ie0 + j ] );
+      const triangle_t *tl = e->tl, *tr = e->tr;
+      unsigned int f=0;
+
+      if( e->id != ie0 + j ) f |= INCG_CHECK_ID;
+      if( e->va < m->v || e->va >= m->v + nv ||
+          e->vb < m->v || e->vb >= m->v + nv ) f |= INCG_CHECK_LINK;
+      if( ( tl != NULL && ( tl < m->t || tl >= m->t + nt ) ) ||
+          ( tr != NULL && ( tr < m->t || tr >= m->t + nt ) ) ) {
+         f |= INCG_CHECK_LINK;
+      }
+      if( f & INCG_CHECK_LINK ) {
+         fe[j] = f;
+         ++nlink;
+         continue;
+      }
+
+      if( e->va == e->vb ||
+          ( e->va->x == e->vb->x && e->va->y == e->vb->y &&
+            e->va->z == e->vb->z ) ) f |= INCG_CHECK_DEGENERATE;
+
+      if( tl == NULL ) {
+         if( tr == NULL ) f |= INCG_CHECK_FREE;
+         else f |= INCG_CHECK_SIDE;
+      } else {
+         if( incg_Check_HasEdge( tl, e, 0 ) == 0 ) f |= INCG_CHECK_SIDE;
+         if( tr != NULL && incg_Check_HasEdge( tr, e, 1 ) == 0 ) {
+            f |= INCG_CHECK_SIDE;
+         }
+      }
+      if( f & INCG_CHECK_SIDE ) ++nlink;
+
+      // faces folded over the edge (when both of their loops are sound)
+      if( tl != NULL && tr != NULL && f == 0 ) {
+         long int iv[3];
+         double nl[3], nr[3], dd;
+
+         if( incg_Check_Loop( m, tl, iv ) == 0 &&
+             incg_Check_Loop( m, tr, iv ) == 0 ) {
+            incg_Check_Normal( tl, nl );
+            incg_Check_Normal( tr, nr );
+            dd = incg_Vec_DotProduct( nl, nr );
+            if( dd < 0.0 &&
+                dd*dd > INCG_CHECK_FOLDCOS*INCG_CHECK_FOLDCOS *
+                        incg_Vec_DotProduct( nl, nl ) *
+                        incg_Vec_DotProduct( nr, nr ) ) {
+               f |= INCG_CHECK_FOLDED;
+            }
+         }
+      }
+      fe[j] = f;
+   }
+
+   // vertices (when all of them are checked)
+   if( ntv != NULL ) {
+#pragma omp parallel for schedule(dynamic,1024)
+      for(j=0;j<nv;++j) {
+         if( ntv[j] == 0 ) {
+            fv[j] |= INCG_CHECK_FREE;
+         } else if( nlink == 0 ) {
+            if( incg_Check_Fan( cv, ct, tsv[j], j, ntv[j] ) != ntv[j] ) {
+               fv[j] |= INCG_CHECK_MANIFOLD;
+            }
+         }
+      }
+   }
+
+   // the violations by kind, with the indices of the entities of the parts
+{  const long int i0[3] = { iv0, ie0, it0 }, ns[3] = { nsv, nse, nst };
+   const unsigned int *fl[3] = { fv, fe, ft };
+   const int kind[3] = { INCG_CHECK_VERTICES, INCG_CHECK_EDGES,
+                         INCG_CHECK_TRIS };
+
+   for(i=0;i<3 && ierr==0;++i) {
+      if( ids != NULL ) {
+#pragma omp parallel for
+         for(j=0;j<ns[i];++j) ids[j] = i0[i] + j;
+      }
+      ierr = incg_Check_Collect( c, kind[i], ns[i], fl[i], ids );
+   }
+}
+   if( ierr ) incg_Check_Free( c );
+
+cleanup:
+   if( fv != NULL ) free( fv );
+   if( fe != NULL ) free( fe );
+   if( ft != NULL ) free( ft );
+   if( ntv != NULL ) free( ntv );
+   if( tsv != NULL ) free( tsv );
+   if( cv != NULL ) free( cv );
+   if( ct != NULL ) free( ct );
+   if( ids != NULL ) free( ids );
+
+   return ierr;
+}
+
+
+//
+// Function to gather the entities of a kind that have flags of violations
+// set into the lists of a check (in parallel with a prefix sum of the counts
+// of the threads). Entities are reported by index, or by the given IDs.
+//
+
+int incg_Check_Collect( struct incg_check_s* c, int kind,
+                        long int n, const unsigned int* flags,
+                        const long int* ids )
+{
+   long int *cnt, nb;
+   int nthr=1;
+
+
+   if( c == NULL || kind < 0 || kind > 3 ) return 1;
+   if( n > 0 && flags == NULL ) return 1;
+   c->nbad[kind] = 0;
+   c->ibad[kind] = NULL;
+   c->fbad[kind] = NULL;
+   if( n <= 0 ) return 0;
+
+#ifdef _OPENMP
+   nthr = omp_get_max_threads();
+#endif
+   cnt = (long int *) malloc( ((size_t) nthr+1) * sizeof( long int ) );
+   if( cnt == NULL ) return -1;
+
+   // count by contiguous ranges of the threads
+#pragma omp parallel num_threads( nthr )
+{  int it=0, nth=1;
+   long int i,i0,i1,k=0;
+
+#ifdef _OPENMP
+   it = omp_get_thread_num();
+   nth = omp_get_num_threads();
+#endif
+   i0 = (long int) ( ((double) n) * it / nth );
+   i1 = (long int) ( ((double) n) * (it+1) / nth );
+   if( it == nth-1 ) i1 = n;
+   for(i=i0;i<i1;++i) if( flags[i] ) ++k;
+   cnt[it] = k;
+#pragma omp barrier
+#pragma omp single
+{  long int off=0, tmp;
+   int j;
+
+   for(j=0;j<nth;++j) {
+      tmp = cnt[j];
+      cnt[j] = off;
+      off += tmp;
+   }
+   cnt[nth] = off;
+   c->nbad[kind] = cnt[nth];
+   if( cnt[nth] > 0 ) {
+      c->ibad[kind] = (long int *) malloc( ((size_t) cnt[nth]) *
+                                           sizeof( long int ) );
+      c->fbad[kind] = (unsigned int *) malloc( ((size_t) cnt[nth]) *
+                                               sizeof( unsigned int ) );
+   }
+}
+   if( c->ibad[kind] != NULL && c->fbad[kind] != NULL ) {
+      k = cnt[it];
+      for(i=i0;i<i1;++i) {
+         if( flags[i] == 0 ) continue;
+         c->ibad[kind][k] = ids != NULL ? ids[i] : i;
+         c->fbad[kind][k] = flags[i];
+         ++k;
+      }
+   }
+}
+   nb = c->nbad[kind];
+   free( cnt );
+
+   if( nb > 0 && ( c->ibad[kind] == NULL || c->fbad[kind] == NULL ) ) {
+      if( c->ibad[kind] != NULL ) free( c->ibad[kind] );
+      if( c->fbad[kind] != NULL ) free( c->fbad[kind] );
+      c->ibad[kind] = NULL;
+      c->fbad[kind] = NULL;
+      c->nbad[kind] = 0;
+      return -1;
+   }
+
+   return 0;
+}
+
+
+//
+// Function to return the total number of entities with violations
+//
+
+long int incg_Check_Count( const struct incg_check_s* c )
+{
+   if( c == NULL ) return 0;
+   return c->nbad[0] + c->nbad[1] + c->nbad[2] + c->nbad[3];
+}
+
+
+//
+// Function to release the lists of a check
+//
+
+int incg_Check_Free( struct incg_check_s* c )
+{
+   int k;
+
+   if( c == NULL ) return 1;
+   for(k=0;k<4;++k) {
+      if( c->ibad[k] != NULL ) free( c->ibad[k] );
+      if( c->fbad[k] != NULL ) free( c->fbad[k] );
+   }
+   memset( c, 0, sizeof(struct incg_check_s) );
+
+   return 0;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
@@ -0,0 +1,67 @@
+
+#ifndef _INCG_CHECK_H_
+#define _INCG_CHECK_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "incg_mesh.h"
+
+//
+// Violations found by a check of a mesh, listed by kind of entity: the
+// entities (indices of a mesh object, or UIDs of an sMesh) and a word of flags
+// for each one of them
+//
+
+// kinds of entities
+#define INCG_CHECK_VERTICES     0
+#define INCG_CHECK_EDGES        1
+#define INCG_CHECK_TRIS         2
+#define INCG_CHECK_QUADS        3
+
+// flags of violations
+#define INCG_CHECK_ID           0x0001   // ID differs from index or UID maps
+#define INCG_CHECK_LINK         0x0002   // null or foreign pointer
+#define INCG_CHECK_SIDE         0x0004   // sides of an edge and loops disagree
+#define INCG_CHECK_LOOP         0x0008   // edges of a face do not close a loop
+#define INCG_CHECK_MANIFOLD     0x0010   // not a single fan, or edge over-used
+#define INCG_CHECK_DEGENERATE   0x0020   // zero length or area
+#define INCG_CHECK_FOLDED       0x0040   // faces folded back over an edge
+#define INCG_CHECK_FREE         0x0080   // not part of any face
+#define INCG_CHECK_HANGING      0x0100   // leaf face has a split edge
+
+// cosine of the dihedral turn beyond which faces are taken as folded
+#define INCG_CHECK_FOLDCOS      (-0.99)
+
+// number of parts of a mesh for a check that is left on: one part is checked
+// at a time (in turn) at a small fraction of the cost of a refinement step
+// (see incg_Check_MeshSample() and sMesh_Core::checkSample())
+#define INCG_CHECK_PARTS        128
+
+struct incg_check_s {
+   long int nbad[4];
+   long int *ibad[4];
+   unsigned int *fbad[4];
+};
+
+// -------------------- function prototypes/signatures --------------------
+
+int incg_Check_Mesh( const mesh_t* m, struct incg_check_s* c );
+
+int incg_Check_MeshSample( const mesh_t* m, long int nstride, long int ioff,
+                           struct incg_check_s* c );
+
+int incg_Check_Collect( struct incg_check_s* c, int kind,
+                        long int n, const unsigned int* flags,
+                        const long int* ids );
+
+long int incg_Check_Count( const struct incg_check_s* c );
+
+int incg_Check_Free( struct incg_check_s* c );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
@@ -0,0 +1,321 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "incg_curv.h"
+#include "incg_sort.h"
+
+
+//
+// Function to return the number of vertices of a face (3 or 4)
+//
+static int incg_Curv_FaceSize( const long int* f )
+{
+   return f[3] < 0 ? 3 : 4;
+}
+
+
+//
+// Function to form the corners of the vertices by a (stable) sort of all the
+// corners of the faces by their vertex. The corners of vertex i are left in
+// vc[ vofs[i] ... vofs[i+1]-1 ], each as 4*face+k in ascending order. The
+// offsets are found at the changes of the sorted keys, so that every vertex
+// is written by one corner only.
+//
+static int incg_Curv_Corners( long int nv, long int nf, const long int* faces,
+                              long int** vofs_, long int** vc_ )
+{
+   unsigned long *key;
+   long int *vofs, *vc, nc = 4*nf, i;
+   int ierr;
+
+
+   key = (unsigned long *) malloc( ((size_t) nc) * sizeof( unsigned long ) );
+   vc = (long int *) malloc( ((size_t) nc) * sizeof( long int ) );
+   vofs = (long int *) malloc( ((size_t) (nv+1)) * sizeof( long int ) );
+   if( key == NULL || vc == NULL || vofs == NULL ) {
+      if( key != NULL ) free( key );
+      if( vc != NULL ) free( vc );
+      if( vofs != NULL ) free( vofs );
+      return -1;
+   }
+
+#pragma omp parallel for
+   for(i=0;i<nc;++i) {
+      const long int *f = &( faces[ i - i%4 ] );
+
+      key[i] = i%4 < incg_Curv_FaceSize( f ) ?
+               (unsigned long) faces[i] : (unsigned long) nv;
+      vc[i] = i;
+   }
+   ierr = incg_Sort_RadixKeys( nc, key, vc,
+                               incg_Sort_NumBits( (unsigned long) nv ) );
+   if( ierr ) {
+      free( key );
+      free( vc );
+      free( vofs );
+      return ierr;
+   }
+
+   // vertices from the key before a change up to the key after it start here
+#pragma omp parallel for
+   for(i=0;i<=nc;++i) {
+      long int ka = i == 0 ? -1 : (long int) key[i-1];
+      long int kb = i == nc ? nv : (long int) key[i];
+      long int j;
+
+      for(j=ka+1;j<=kb;++j) vofs[j] = i;
+   }
+   free( key );
+
+   *vofs_ = vofs;
+   *vc_ = vc;
+
+   return 0;
+}
+
+
+//
+// Function to return whether a vertex is on the boundary of the surface (or
+// is where the surface is not a manifold): not every edge out of the vertex
+// is used once in each direction by its faces
+//
+static int incg_Curv_Boundary( const long int* faces,
+                               long int ja, long int jb, const long int* vc )
+{
+   long int j,l;
+
+   for(j=ja;j<jb;++j) {
+      const long int *f = &( faces[ vc[j] - vc[j]%4 ] );
+      int m = incg_Curv_FaceSize( f ), k = (int) ( vc[j]%4 );
+      long int iv = f[ (k+1)%m ];
+      int nn=0, np=0;
+
+      for(l=ja;l<jb;++l) {
+         const long int *g = &( faces[ vc[l] - vc[l]%4 ] );
+         int mg = incg_Curv_FaceSize( g ), kg = (int) ( vc[l]%4 );
+
+         if( g[ (kg+1)%mg ] == iv ) ++nn;
+         if( g[ (kg+mg-1)%mg ] == iv ) ++np;
+      }
+      if( nn != np || nn != 1 ) return 1;
+   }
+
+   return 0;
+}
+
+
+//
+// Function to return the triangles of a face that have corner k, as the pairs
+// of their other vertices in the sense of the face. A quad is taken as two
+// triangles across its shorter diagonal, which every corner finds the same.
+//
+static int incg_Curv_CornerTris( const double* x, const long int* f, int k,
+                                 long int t[2][2] )
+{
+   const double *p[4];
+   double d[2];
+   int i,j;
+
+   if( incg_Curv_FaceSize( f ) == 3 ) {
+      t[0][0] = f[ (k+1)%3 ];
+      t[0][1] = f[ (k+2)%3 ];
+      return 1;
+   }
+
+   for(i=0;i<4;++i) p[i] = &( x[ 3*f[i] ] );
+   for(i=0;i<2;++i) {
+      d[i] = 0.0;
+      for(j=0;j<3;++j) d[i] += ( p[i+2][j] - p[i][j] )*( p[i+2][j] - p[i][j] );
+   }
+   if( k%2 == ( d[1] < d[0] ? 1 : 0 ) ) {
+      t[0][0] = f[ (k+1)%4 ];
+      t[0][1] = f[ (k+2)%4 ];
+      t[1][0] = f[ (k+2)%4 ];
+      t[1][1] = f[ (k+3)%4 ];
+      return 2;
+   }
+   t[0][0] = f[ (k+1)%4 ];
+   t[0][1] = f[ (k+3)%4 ];
+   return 1;
+}
+
+
+//
+// Function to compute the normals, areas and curvatures of the vertices of
+// the faces (triangles and quads, as with incg_MeshFile_WriteFaces()) of a
+// set of vertices with coordinates "x". The unit normals ("vn", 3 per vertex)
+// weigh the normals of the faces by their areas or angles (INCG_CURV_*). The
+// area of a vertex ("va") is its "mixed" area (the Voronoi region of its
+// corners, or a part of the triangle at obtuse ones) after Meyer et al., such
+// that areas add up to that of the surface. The curvatures ("vk",
+// INCG_CURV_NCURV per vertex) are from the cotangent formula (mean curvature)
+// and the angle defect (Gaussian curvature) over that area; values on the
+// boundary (where the defect is measured from 180 degrees) are less reliable.
+// Quads are taken as two triangles across their shorter diagonal. Any of the
+// outputs may be null. Every vertex gathers the terms of its own corners in
+// one parallel pass, so no vertex is written by two threads and the results
+// do not depend on the number of threads.
+//
+
+int incg_Curv_Faces( long int nv, const double* x,
+                     long int nf, const long int* faces, int iweight,
+                     double* vn, double* va, double* vk )
+{
+   long int *vofs=NULL, *vc=NULL, i;
+   int ierr;
+
+
+   if( nv <= 0 || nf <= 0 ) return 1;
+   if( x == NULL || faces == NULL ) return 2;
+   if( iweight != INCG_CURV_AREA && iweight != INCG_CURV_ANGLE ) return 3;
+
+   ierr = incg_Curv_Corners( nv, nf, faces, &vofs, &vc );
+   if( ierr ) return ierr;
+
+#pragma omp parallel for schedule(dynamic,1024)
+   for(i=0;i<nv;++i) {
+      const double *xi = &( x[3*i] );
+      double n[3] = { 0.0, 0.0, 0.0 }, h[3] = { 0.0, 0.0, 0.0 };
+      double a = 0.0, asum = 0.0, s, hm, kg, dk;
+      long int j;
+      int k;
+
+      for(j=vofs[i];j<vofs[i+1];++j) {
+         long int t[2][2];
+         int nt,l;
+
+         nt = incg_Curv_CornerTris( x, &( faces[ vc[j] - vc[j]%4 ] ),
+                                    (int) ( vc[j]%4 ), t );
+         for(l=0;l<nt;++l) {
+            const double *xa = &( x[ 3*t[l][0] ] );
+            const double *xb = &( x[ 3*t[l][1] ] );
+            double e1[3], e2[3], e3[3], c[3], d, d12, ca, cb, th;
+
+            for(k=0;k<3;++k) {
+               e1[k] = xa[k] - xi[k];
+               e2[k] = xb[k] - xi[k];
+               e3[k] = xb[k] - xa[k];
+            }
+            c[0] = e1[1]*e2[2] - e1[2]*e2[1];
+            c[1] = e1[2]*e2[0] - e1[0]*e2[2];
+            c[2] = e1[0]*e2[1] - e1[1]*e2[0];
+            d = sqrt( c[0]*c[0] + c[1]*c[1] + c[2]*c[2] );
+            if( d == 0.0 ) continue;
+
+            // angle at the vertex and cotangents of those at a and b
+            d12 = e1[0]*e2[0] + e1[1]*e2[1] + e1[2]*e2[2];
+            th = atan2( d, d12 );
+            ca = -( e1[0]*e3[0] + e1[1]*e3[1] + e1[2]*e3[2] )/d;
+            cb =  ( e2[0]*e3[0] + e2[1]*e3[1] + e2[2]*e3[2] )/d;
+
+            s = iweight == INCG_CURV_AREA ? 1.0 : th/d;
+            for(k=0;k<3;++k) {
+               n[k] += s*c[k];
+               h[k] -= cb*e1[k] + ca*e2[k];
+            }
+            asum += th;
+
+            if( d12 < 0.0 ) {
+               a += 0.25*d;
+            } else if( ca < 0.0 || cb < 0.0 ) {
+               a += 0.125*d;
+            } else {
+               a += 0.125*( ca*( e2[0]*e2[0] + e2[1]*e2[1] + e2[2]*e2[2] ) +
+                            cb*( e1[0]*e1[0] + e1[1]*e1[1] + e1[2]*e1[2] ) );
+            }
+         }
+      }
+
+      s = sqrt( n[0]*n[0] + n[1]*n[1] + n[2]*n[2] );
+      if( s > 0.0 ) for(k=0;k<3;++k) n[k] /= s;
+      hm = 0.0;
+      kg = 0.0;
+      if( a > 0.0 ) {
+         hm = 0.25*( h[0]*n[0] + h[1]*n[1] + h[2]*n[2] )/a;
+         kg = incg_Curv_Boundary( faces, vofs[i], vofs[i+1], vc ) ?
+              ( M_PI - asum )/a : ( 2.0*M_PI - asum )/a;
+      }
+      dk = hm*hm - kg;
+      dk = dk > 0.0 ? sqrt( dk ) : 0.0;
+
+      if( vn != NULL ) for(k=0;k<3;++k) vn[3*i+k] = n[k];
+      if( va != NULL ) va[i] = a;
+      if( vk != NULL ) {
+         vk[ INCG_CURV_NCURV*i + INCG_CURV_MEAN ] = hm;
+         vk[ INCG_CURV_NCURV*i + INCG_CURV_GAUSS ] = kg;
+         vk[ INCG_CURV_NCURV*i + INCG_CURV_K1 ] = hm + dk;
+         vk[ INCG_CURV_NCURV*i + INCG_CURV_K2 ] = hm - dk;
+      }
+   }
+
+   free( vofs );
+   free( vc );
+
+   return 0;
+}
+
+
+//
+// Function to compute the normals, areas and curvatures of the vertices of a
+// mesh object (see incg_Curv_Faces()), in the order of the vertices
+//
+
+int incg_Curv_Mesh( const mesh_t* m, int iweight,
+                    double* vn, double* va, double* vk )
+{
+   double *x;
+   long int *faces, i;
+   int ierr;
+
+
+   if( m == NULL ) return 1;
+   if( m->nv == 0 || m->ne == 0 || m->nt == 0 ) return 2;
+
+   x = (double *) malloc( ((size_t) (3*m->nv)) * sizeof( double ) );
+   faces = (long int *) malloc( ((size_t) (4*m->nt)) * sizeof( long int ) );
+   if( x == NULL || faces == NULL ) {
+      if( x != NULL ) free( x );
+      if( faces != NULL ) free( faces );
+      return -1;
+   }
+
+#pragma omp parallel for
+   for(i=0;i<m->nv;++i) {
+      x[3*i+0] = m->v[i].x;
+      x[3*i+1] = m->v[i].y;
+      x[3*i+2] = m->v[i].z;
+   }
+#pragma omp parallel for
+   for(i=0;i<m->nt;++i) {
+      const triangle_t *t = &( m->t[i] );
+
+      faces[4*i+0] = ( t->d1 == 0 ? t->e1->va : t->e1->vb ) - m->v;
+      faces[4*i+1] = ( t->d2 == 0 ? t->e2->va : t->e2->vb ) - m->v;
+      faces[4*i+2] = ( t->d3 == 0 ? t->e3->va : t->e3->vb ) - m->v;
+      faces[4*i+3] = -1;
+   }
+
+   ierr = incg_Curv_Faces( m->nv, x, m->nt, faces, iweight, vn, va, vk );
+
+   free( x );
+   free( faces );
+
+   return ierr;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
@@ -0,0 +1,39 @@
+
+#ifndef _INCG_CURV_H_
+#define _INCG_CURV_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "incg_mesh.h"
+
+//
+// Normals, areas and discrete curvatures at the vertices of a mesh
+//
+
+// weighting of the normals of the faces around a vertex
+#define INCG_CURV_AREA          0   // by the areas of the faces
+#define INCG_CURV_ANGLE         1   // by the angles of the faces at the vertex
+
+// curvatures of a vertex
+#define INCG_CURV_MEAN          0   // mean curvature (> 0 on a convex part)
+#define INCG_CURV_GAUSS         1   // Gaussian curvature
+#define INCG_CURV_K1            2   // larger principal curvature
+#define INCG_CURV_K2            3   // smaller principal curvature
+#define INCG_CURV_NCURV         4
+
+// -------------------- function prototypes/signatures --------------------
+
+int incg_Curv_Mesh( const mesh_t* m, int iweight,
+                    double* vn, double* va, double* vk );
+
+int incg_Curv_Faces( long int nv, const double* x,
+                     long int nf, const long int* faces, int iweight,
+                     double* vn, double* va, double* vk );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
@@ -0,0 +1,41 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <charconv>
+
+#include "incg_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+//
+// Function to write the shortest text of a double that reads back to the
+// same value; it returns the number of characters (there is no terminator)
+//
+
+int incg_Format_Double( char* buf, double x )
+{
+   std::to_chars_result r = std::to_chars( buf, buf + INCG_FORMAT_MAXLEN, x );
+
+   return (int) ( r.ptr - buf );
+}
+
+
+//
+// Function to write the text of an integer; it returns the number of
+// characters (there is no terminator)
+//
+
+int incg_Format_Long( char* buf, long int i )
+{
+   std::to_chars_result r = std::to_chars( buf, buf + INCG_FORMAT_MAXLEN, i );
+
+   return (int) ( r.ptr - buf );
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
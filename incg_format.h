@@ -0,0 +1,20 @@
+
+#ifndef _INCG_FORMAT_H_
+#define _INCG_FORMAT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// room needed by a formatted number (the longest double takes 24 characters)
+#define INCG_FORMAT_MAXLEN  32
+
+int incg_Format_Double( char* buf, double x );
+
+int incg_Format_Long( char* buf, long int i );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
@@ -0,0 +1,903 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "incg_geod.h"
+#include "incg_sort.h"
+
+// attempts to find a pseudo-peripheral vertex to start a dissection
+#define INCG_GEOD_NPERIPH        8
+
+// largest piece of the surface that is not dissected further
+#define INCG_GEOD_LEAF           32
+
+// regularization of the Poisson operator (relative to the time step)
+#define INCG_GEOD_EPS            1.0e-8
+
+//
+// A range of the ordered vertices: a piece of the surface to be dissected
+//
+struct incg_geod_range_s {
+   long int i0,i1;
+};
+
+
+//
+// Function to return the number of neighbours of a vertex
+//
+static long int incg_Geod_Degree( const struct incg_adj_s* a, long int i )
+{
+   return a->eofs[i+1] - a->eofs[i];
+}
+
+
+//
+// Function to visit the vertices of a piece (those with the label "lab")
+// connected to a root in breadth-first order. The vertices are stored in
+// "queue" and their levels in level[], which is to be negative for those not
+// yet visited; the number of vertices and the depth are returned.
+//
+static long int incg_Geod_Visit( const struct incg_adj_s* a,
+                                 const long int* label, long int lab,
+                                 long int root, long int* queue,
+                                 long int* level, long int* depth )
+{
+   long int head=0, tail=1;
+
+   queue[0] = root;
+   level[root] = 0;
+   while( head < tail ) {
+      long int i = queue[head++], j;
+
+      for(j=a->eofs[i];j<a->eofs[i+1];++j) {
+         long int iv = a->vert[j];
+
+         if( label[iv] != lab || level[iv] >= 0 ) continue;
+         level[iv] = level[i] + 1;
+         queue[tail++] = iv;
+      }
+   }
+   *depth = level[ queue[tail-1] ];
+
+   return tail;
+}
+
+
+//
+// Function to dissect a piece of the surface: the vertices order[i0 ... i1-1],
+// which carry the label i0. A piece that is not connected is split into the
+// vertices reached from its first one and the rest. Otherwise it is visited
+// from a pseudo-peripheral vertex (one of least degree in the last level of a
+// visit, for as long as the depth grows) and the level of its median vertex
+// separates the levels before it from those after it; the separator is put
+// last in the range and is not labelled by any piece. The two new pieces are
+// stored in "sub" and their number is returned (none when the piece is small
+// or too shallow to separate). "queue" is scratch over the same range.
+//
+static int incg_Geod_Dissect( const struct incg_adj_s* a,
+                              long int i0, long int i1,
+                              long int* order, long int* queue,
+                              long int* label, long int* level,
+                              struct incg_geod_range_s* sub )
+{
+   long int n = i1 - i0, root, last, cnt, depth, d, m, sa, sb, j;
+   int iter;
+
+
+   if( n <= INCG_GEOD_LEAF ) return 0;
+
+   for(j=i0;j<i1;++j) level[ order[j] ] = -1;
+   root = order[i0];
+   last = root;
+   cnt = incg_Geod_Visit( a, label, i0, root, &( queue[i0] ), level, &depth );
+   for(iter=0;iter<INCG_GEOD_NPERIPH && cnt == n;++iter) {
+      long int cand = queue[i1-1];
+
+      for(j=i1-1;j>=i0 && level[ queue[j] ] == depth;--j) {
+         if( incg_Geod_Degree( a, queue[j] ) <
+             incg_Geod_Degree( a, cand ) ) cand = queue[j];
+      }
+      for(j=i0;j<i1;++j) level[ order[j] ] = -1;
+      (void) incg_Geod_Visit( a, label, i0, cand, &( queue[i0] ), level, &d );
+      last = cand;
+      if( d <= depth ) break;
+      root = cand;
+      depth = d;
+   }
+   if( last != root ) {
+      for(j=i0;j<i1;++j) level[ order[j] ] = -1;
+      (void) incg_Geod_Visit( a, label, i0, root, &( queue[i0] ), level, &d );
+   }
+
+   if( cnt < n ) {
+      m = i0 + cnt;
+      for(j=i0;j<i1;++j) if( level[ order[j] ] < 0 ) queue[m++] = order[j];
+      memcpy( &( order[i0] ), &( queue[i0] ), ((size_t) n) * sizeof( long int ) );
+      for(j=i0+cnt;j<i1;++j) label[ order[j] ] = i0 + cnt;
+      sub[0].i0 = i0;
+      sub[0].i1 = i0 + cnt;
+      sub[1].i0 = i0 + cnt;
+      sub[1].i1 = i1;
+      return 2;
+   }
+   if( depth < 2 ) return 0;
+
+   // the separating level is kept off the ends of the visit
+   m = level[ queue[i0 + n/2] ];
+   if( m < 1 ) m = 1;
+   if( m > depth-1 ) m = depth-1;
+   for(sa=0;level[ queue[i0+sa] ] < m;++sa);
+   for(sb=sa;level[ queue[i0+sb] ] == m;++sb);
+
+   memcpy( &( order[i0] ), &( queue[i0] ), ((size_t) sa) * sizeof( long int ) );
+   memcpy( &( order[i0+sa] ), &( queue[i0+sb] ),
+           ((size_t) (n-sb)) * sizeof( long int ) );
+   memcpy( &( order[i1-sb+sa] ), &( queue[i0+sa] ),
+           ((size_t) (sb-sa)) * sizeof( long int ) );
+   for(j=i0+sa;j<i1-sb+sa;++j) label[ order[j] ] = i0 + sa;
+   for(j=i1-sb+sa;j<i1;++j) label[ order[j] ] = -1;
+   sub[0].i0 = i0;
+   sub[0].i1 = i0 + sa;
+   sub[1].i0 = i0 + sa;
+   sub[1].i1 = i1 - sb + sa;
+
+   return 2;
+}
+
+
+//
+// Function to order the vertices by nested dissection to limit the fill of
+// the factors. The connected components are the first pieces; pieces are
+// dissected in rounds, those of a round in parallel (they share no vertex,
+// and their neighbours outside are separators), and every piece is numbered
+// before its separator.
+//
+static int incg_Geod_Order( struct incg_geod_s* g )
+{
+   const struct incg_adj_s *a = &( g->adj );
+   struct incg_geod_range_s *range, *work, *next, *tmp;
+   long int *order, *queue, *label, *level, nv = g->nv, n=0, iv=0, nw=0, i;
+
+
+   order = (long int *) malloc( ((size_t) nv) * sizeof( long int ) );
+   queue = (long int *) malloc( ((size_t) nv) * sizeof( long int ) );
+   label = (long int *) malloc( ((size_t) nv) * sizeof( long int ) );
+   level = (long int *) malloc( ((size_t) nv) * sizeof( long int ) );
+   range = (struct incg_geod_range_s *)
+           malloc( ((size_t) (2*nv)) * sizeof( struct incg_geod_range_s ) );
+   if( order == NULL || queue == NULL || label == NULL || level == NULL ||
+       range == NULL ) {
+      if( order != NULL ) free( order );
+      if( queue != NULL ) free( queue );
+      if( label != NULL ) free( label );
+      if( level != NULL ) free( level );
+      if( range != NULL ) free( range );
+      return -1;
+   }
+   work = range;
+   next = &( range[nv] );
+
+#pragma omp parallel for
+   for(i=0;i<nv;++i) {
+      label[i] = 0;
+      level[i] = -1;
+   }
+   g->ncomp = 0;
+   while( n < nv ) {
+      long int cnt, depth, j;
+
+      while( level[iv] >= 0 ) ++iv;
+      cnt = incg_Geod_Visit( a, label, 0, iv, &( order[n] ), level, &depth );
+      for(j=n;j<n+cnt;++j) {
+         g->comp[ order[j] ] = g->ncomp;
+         label[ order[j] ] = n;
+      }
+      work[nw].i0 = n;
+      work[nw].i1 = n + cnt;
+      ++nw;
+      ++g->ncomp;
+      n += cnt;
+   }
+
+   while( nw > 0 ) {
+      long int nn = 0, iw;
+
+#pragma omp parallel for schedule(dynamic,1)
+      for(iw=0;iw<nw;++iw) {
+         struct incg_geod_range_s sub[2];
+         int ns = incg_Geod_Dissect( a, work[iw].i0, work[iw].i1,
+                                     order, queue, label, level, sub ), k;
+
+         for(k=0;k<ns;++k) {
+            long int in;
+#pragma omp atomic capture
+            in = nn++;
+            next[in] = sub[k];
+         }
+      }
+      tmp = work;
+      work = next;
+      next = tmp;
+      nw = nn;
+   }
+
+#pragma omp parallel for
+   for(i=0;i<nv;++i) {
+      g->perm[i] = order[i];
+      g->iperm[ order[i] ] = i;
+   }
+
+   free( order );
+   free( queue );
+   free( label );
+   free( level );
+   free( range );
+
+   return 0;
+}
+
+
+//
+// Function to compute the areas of the triangles and the gradients of the
+// linear functions of their corners: the normal crossed with the opposite
+// edge, over twice the area (zero for degenerate triangles)
+//
+static void incg_Geod_Triangles( const mesh_t* m, struct incg_geod_s* g )
+{
+   long int i;
+
+#pragma omp parallel for
+   for(i=0;i<m->nt;++i) {
+      const triangle_t *t = &( m->t[i] );
+      const vertex_t *v[3];
+      double e[3][3], c[3], a2;
+      int k,j;
+
+      v[0] = t->d1 == 0 ? t->e1->va : t->e1->vb;
+      v[1] = t->d2 == 0 ? t->e2->va : t->e2->vb;
+      v[2] = t->d3 == 0 ? t->e3->va : t->e3->vb;
+      for(k=0;k<3;++k) {
+         const vertex_t *va = v[(k+1)%3], *vb = v[(k+2)%3];
+
+         g->tv[3*i+k] = v[k] - m->v;
+         e[k][0] = vb->x - va->x;
+         e[k][1] = vb->y - va->y;
+         e[k][2] = vb->z - va->z;
+      }
+      c[0] = e[2][1]*e[0][2] - e[2][2]*e[0][1];
+      c[1] = e[2][2]*e[0][0] - e[2][0]*e[0][2];
+      c[2] = e[2][0]*e[0][1] - e[2][1]*e[0][0];
+      a2 = c[0]*c[0] + c[1]*c[1] + c[2]*c[2];
+
+      g->ta[i] = 0.5*sqrt( a2 );
+      for(k=0;k<3;++k) {
+         double *gk = &( g->tg[9*i+3*k] );
+
+         if( a2 == 0.0 ) {
+            for(j=0;j<3;++j) gk[j] = 0.0;
+            continue;
+         }
+         gk[0] = ( c[1]*e[k][2] - c[2]*e[k][1] )/a2;
+         gk[1] = ( c[2]*e[k][0] - c[0]*e[k][2] )/a2;
+         gk[2] = ( c[0]*e[k][1] - c[1]*e[k][0] )/a2;
+      }
+   }
+}
+
+
+//
+// Function to return the corner of a vertex in a triangle
+//
+static int incg_Geod_Corner( const struct incg_geod_s* g, long int it,
+                             long int iv )
+{
+   return g->tv[3*it] == iv ? 0 : ( g->tv[3*it+1] == iv ? 1 : 2 );
+}
+
+
+//
+// Function to return the off-diagonal rows of the factors reached from row r
+// of the reordered operators: the paths up the elimination tree from the
+// columns left of the diagonal, which stop at r or at a vertex marked already.
+// The columns are stored in "col" and counted in "ccnt" when not null.
+//
+static long int incg_Geod_Reach( const struct incg_geod_s* g,
+                                 const long int* parent, long int r,
+                                 long int* mark, long int* col,
+                                 long int* ccnt )
+{
+   const struct incg_adj_s *a = &( g->adj );
+   long int iv = g->perm[r], n=0, j, k;
+
+   mark[r] = r;
+   for(j=a->eofs[iv];j<a->eofs[iv+1];++j) {
+      for(k=g->iperm[ a->vert[j] ];k<r && mark[k] != r;k=parent[k]) {
+         mark[k] = r;
+         if( col != NULL ) col[n] = k;
+         if( ccnt != NULL ) {
+#pragma omp atomic
+            ++ccnt[k];
+         }
+         ++n;
+      }
+   }
+
+   return n;
+}
+
+
+//
+// Function to compare two integers for sorting with qsort()
+//
+static int incg_Geod_CompareLong( const void* a, const void* b )
+{
+   long int ia = *( (const long int *) a ), ib = *( (const long int *) b );
+
+   return ia < ib ? -1 : ( ia > ib ? 1 : 0 );
+}
+
+
+//
+// Function to form the structure of the factors of the reordered operators:
+// the elimination tree (Liu's algorithm with path compression), the rows of
+// the factors in parallel from their paths in the tree, the columns from the
+// rows, and the grouping of the columns by their height in the tree. Every
+// thread of the "nthr" marks the vertices of its rows in its own array.
+//
+static int incg_Geod_Symbolic( struct incg_geod_s* g, int nthr )
+{
+   const struct incg_adj_s *a = &( g->adj );
+   long int *parent=NULL, *anc=NULL, *mark=NULL, *cptr=NULL;
+   long int nv = g->nv, nnz, r, c, i;
+   int ierr=0;
+
+
+   parent = (long int *) malloc( ((size_t) nv) * sizeof( long int ) );
+   anc = (long int *) malloc( ((size_t) nv) * sizeof( long int ) );
+   mark = (long int *) malloc( ((size_t) (nthr*nv)) * sizeof( long int ) );
+   cptr = (long int *) malloc( ((size_t) (nv+1)) * sizeof( long int ) );
+   g->cofs = (long int *) malloc( ((size_t) (nv+1)) * sizeof( long int ) );
+   g->rofs = (long int *) malloc( ((size_t) (nv+1)) * sizeof( long int ) );
+   if( parent == NULL || anc == NULL || mark == NULL || cptr == NULL ||
+       g->cofs == NULL || g->rofs == NULL ) {
+      ierr = -1;
+      goto cleanup;
+   }
+
+   for(r=0;r<nv;++r) {
+      long int iv = g->perm[r], j;
+
+      parent[r] = -1;
+      anc[r] = -1;
+      for(j=a->eofs[iv];j<a->eofs[iv+1];++j) {
+         long int k = g->iperm[ a->vert[j] ];
+
+         while( k != -1 && k < r ) {
+            long int kn = anc[k];
+
+            anc[k] = r;
+            if( kn == -1 ) parent[k] = r;
+            k = kn;
+         }
+      }
+   }
+
+   // counts of the rows and of the columns (with their diagonal)
+#pragma omp parallel for
+   for(i=0;i<nthr*nv;++i) mark[i] = -1;
+#pragma omp parallel for
+   for(c=0;c<nv;++c) g->cofs[c] = 1;
+#pragma omp parallel num_threads( nthr )
+{  int ith=0;
+
+#ifdef _OPENMP
+   ith = omp_get_thread_num();
+#endif
+#pragma omp for schedule(dynamic,1024)
+   for(r=0;r<nv;++r) {
+      g->rofs[r] = incg_Geod_Reach( g, parent, r, &( mark[nv*ith] ),
+                                    NULL, g->cofs );
+   }
+}
+   g->rofs[nv] = incg_Sort_ScanExclusive( nv, g->rofs );
+   g->cofs[nv] = incg_Sort_ScanExclusive( nv, g->cofs );
+   nnz = g->cofs[nv];
+
+   g->rcol = (long int *) malloc( ((size_t) (g->rofs[nv]+1)) *
+                                  sizeof( long int ) );
+   g->rpos = (long int *) malloc( ((size_t) (g->rofs[nv]+1)) *
+                                  sizeof( long int ) );
+   g->crow = (long int *) malloc( ((size_t) nnz) * sizeof( long int ) );
+   if( g->rcol == NULL || g->rpos == NULL || g->crow == NULL ) {
+      ierr = -1;
+      goto cleanup;
+   }
+
+   // the rows, and the columns filled from them and sorted
+#pragma omp parallel for
+   for(i=0;i<nthr*nv;++i) mark[i] = -1;
+#pragma omp parallel for
+   for(c=0;c<nv;++c) {
+      g->crow[ g->cofs[c] ] = c;
+      cptr[c] = g->cofs[c] + 1;
+   }
+#pragma omp parallel num_threads( nthr )
+{  int ith=0;
+
+#ifdef _OPENMP
+   ith = omp_get_thread_num();
+#endif
+#pragma omp for schedule(dynamic,1024)
+   for(r=0;r<nv;++r) {
+      long int q;
+
+      (void) incg_Geod_Reach( g, parent, r, &( mark[nv*ith] ),
+                              &( g->rcol[ g->rofs[r] ] ), NULL );
+      for(q=g->rofs[r];q<g->rofs[r+1];++q) {
+         long int k = g->rcol[q], p;
+
+#pragma omp atomic capture
+         p = cptr[k]++;
+         g->crow[p] = r;
+      }
+   }
+}
+#pragma omp parallel for schedule(dynamic,1024)
+   for(c=0;c<nv;++c) {
+      qsort( &( g->crow[ g->cofs[c]+1 ] ),
+             (size_t) (g->cofs[c+1] - g->cofs[c] - 1),
+             sizeof( long int ), incg_Geod_CompareLong );
+   }
+#pragma omp parallel for schedule(dynamic,1024)
+   for(r=0;r<nv;++r) {
+      long int q;
+
+      for(q=g->rofs[r];q<g->rofs[r+1];++q) {
+         long int k = g->rcol[q], lo = g->cofs[k]+1, hi = g->cofs[k+1]-1;
+
+         while( lo < hi ) {
+            long int mid = (lo+hi)/2;
+            if( g->crow[mid] < r ) lo = mid+1;
+            else hi = mid;
+         }
+         g->rpos[q] = lo;
+      }
+   }
+
+   // heights in the tree (a parent follows its children), the columns by them
+   for(c=0;c<nv;++c) anc[c] = 0;
+   g->nlev = 1;
+   for(c=0;c<nv;++c) {
+      if( parent[c] >= 0 && anc[ parent[c] ] < anc[c] + 1 ) {
+         anc[ parent[c] ] = anc[c] + 1;
+      }
+      if( anc[c] + 1 > g->nlev ) g->nlev = anc[c] + 1;
+   }
+   g->lofs = (long int *) calloc( (size_t) (g->nlev+1), sizeof( long int ) );
+   g->lcol = (long int *) malloc( ((size_t) nv) * sizeof( long int ) );
+   if( g->lofs == NULL || g->lcol == NULL ) {
+      ierr = -1;
+      goto cleanup;
+   }
+   for(c=0;c<nv;++c) ++g->lofs[ anc[c] ];
+   g->lofs[g->nlev] = incg_Sort_ScanExclusive( g->nlev, g->lofs );
+   memcpy( cptr, g->lofs, ((size_t) g->nlev) * sizeof( long int ) );
+   for(c=0;c<nv;++c) g->lcol[ cptr[ anc[c] ]++ ] = c;
+
+cleanup:
+   if( parent != NULL ) free( parent );
+   if( anc != NULL ) free( anc );
+   if( mark != NULL ) free( mark );
+   if( cptr != NULL ) free( cptr );
+
+   return ierr;
+}
+
+
+//
+// Function to return the position of the entry of row r in column c of the
+// factors, for a row at or below the diagonal
+//
+static long int incg_Geod_Entry( const struct incg_geod_s* g,
+                                 long int r, long int c )
+{
+   long int lo = g->cofs[c], hi = g->cofs[c+1]-1;
+
+   while( lo < hi ) {
+      long int mid = (lo+hi)/2;
+      if( g->crow[mid] < r ) lo = mid+1;
+      else hi = mid;
+   }
+
+   return lo;
+}
+
+
+//
+// Function to assemble the reordered operators in the structure of their
+// factors: the heat operator M + t K and the Poisson operator K + eps M, where
+// K is the stiffness matrix of the linear functions (the cotangent Laplacian)
+// and M the lumped mass matrix. Every row gathers the terms of the triangles
+// of its vertex. A vertex without triangles has a unit diagonal.
+//
+static int incg_Geod_Assemble( struct incg_geod_s* g )
+{
+   const struct incg_adj_s *a = &( g->adj );
+   const double eps = INCG_GEOD_EPS/g->t;
+   long int nv = g->nv, nnz = g->cofs[nv], i;
+
+
+   g->lheat = (double *) calloc( (size_t) nnz, sizeof( double ) );
+   g->lpois = (double *) calloc( (size_t) nnz, sizeof( double ) );
+   if( g->lheat == NULL || g->lpois == NULL ) return -1;
+
+#pragma omp parallel for schedule(dynamic,1024)
+   for(i=0;i<nv;++i) {
+      long int r = g->iperm[i], d = g->cofs[r], j;
+      double mass = 0.0;
+
+      for(j=a->tofs[i];j<a->tofs[i+1];++j) {
+         long int it = a->tri[j];
+         int k = incg_Geod_Corner( g, it, i ), l;
+         const double *gk = &( g->tg[9*it+3*k] );
+
+         mass += g->ta[it]/3.0;
+         for(l=0;l<3;++l) {
+            const double *gl = &( g->tg[9*it+3*l] );
+            long int c = g->iperm[ g->tv[3*it+l] ], p;
+            double s;
+
+            if( c > r ) continue;
+            p = incg_Geod_Entry( g, r, c );
+            s = g->ta[it]*( gk[0]*gl[0] + gk[1]*gl[1] + gk[2]*gl[2] );
+            g->lheat[p] += g->t*s;
+            g->lpois[p] += s;
+         }
+      }
+      g->lheat[d] += mass;
+      g->lpois[d] += eps*mass;
+      if( g->lheat[d] == 0.0 ) g->lheat[d] = 1.0;
+      if( g->lpois[d] == 0.0 ) g->lpois[d] = 1.0;
+   }
+
+   return 0;
+}
+
+
+//
+// Function to factor a symmetric positive definite operator in place, as
+// L L^T, by columns (left-looking): a column gathers the updates of the
+// columns of its row and is scaled by its pivot. The columns of one height in
+// the elimination tree are factored in parallel, each thread of the "nthr"
+// scattering its columns in its own dense array.
+//
+static int incg_Geod_Factor( const struct incg_geod_s* g, int nthr,
+                             double* l )
+{
+   long int nv = g->nv;
+   double *w;
+   int ierr=0;
+
+
+   w = (double *) malloc( ((size_t) (nthr*nv)) * sizeof( double ) );
+   if( w == NULL ) return -1;
+
+#pragma omp parallel num_threads( nthr )
+{  double *wt = w;
+   long int h;
+
+#ifdef _OPENMP
+   wt = &( w[ nv*omp_get_thread_num() ] );
+#endif
+   for(h=0;h<g->nlev;++h) {
+      long int ic;
+
+#pragma omp for schedule(dynamic,16)
+      for(ic=g->lofs[h];ic<g->lofs[h+1];++ic) {
+         long int c = g->lcol[ic], c0 = g->cofs[c], c1 = g->cofs[c+1], p,q;
+         double d;
+
+         for(p=c0;p<c1;++p) wt[ g->crow[p] ] = l[p];
+         for(q=g->rofs[c];q<g->rofs[c+1];++q) {
+            long int k1 = g->cofs[ g->rcol[q]+1 ];
+            double lck = l[ g->rpos[q] ];
+
+            for(p=g->rpos[q];p<k1;++p) wt[ g->crow[p] ] -= l[p]*lck;
+         }
+         d = wt[c];
+         if( d <= 0.0 ) {
+#pragma omp atomic write
+            ierr = 5;
+            d = 1.0;
+         }
+         d = sqrt( d );
+         l[c0] = d;
+         for(p=c0+1;p<c1;++p) l[p] = wt[ g->crow[p] ]/d;
+      }
+   }
+}
+
+   free( w );
+
+   return ierr;
+}
+
+
+//
+// Function to solve with a factored operator for "ns" right-hand sides that
+// are interleaved (entry r of side s at ns*r+s), which share every pass over
+// the factor. The forward solve goes up the elimination tree and the backward
+// solve down it, over the columns of every height in parallel: a row of the
+// forward solve reads its columns, which are lower, and a row of the backward
+// solve the rows of its column, which are higher.
+//
+static void incg_Geod_Solve( const struct incg_geod_s* g, const double* l,
+                             int ns, double* y )
+{
+#pragma omp parallel
+{  long int h, ic;
+
+   for(h=0;h<g->nlev;++h) {
+#pragma omp for schedule(dynamic,64)
+      for(ic=g->lofs[h];ic<g->lofs[h+1];++ic) {
+         long int r = g->lcol[ic], q;
+         double *yr = &( y[ns*r] );
+         int s;
+
+         for(q=g->rofs[r];q<g->rofs[r+1];++q) {
+            const double *yk = &( y[ns*g->rcol[q]] );
+            double lrk = l[ g->rpos[q] ];
+
+            for(s=0;s<ns;++s) yr[s] -= lrk*yk[s];
+         }
+         for(s=0;s<ns;++s) yr[s] /= l[ g->cofs[r] ];
+      }
+   }
+
+   for(h=g->nlev-1;h>=0;--h) {
+#pragma omp for schedule(dynamic,64)
+      for(ic=g->lofs[h];ic<g->lofs[h+1];++ic) {
+         long int c = g->lcol[ic], p;
+         double *yc = &( y[ns*c] );
+         int s;
+
+         for(p=g->cofs[c]+1;p<g->cofs[c+1];++p) {
+            const double *yi = &( y[ns*g->crow[p]] );
+            double lic = l[p];
+
+            for(s=0;s<ns;++s) yc[s] -= lic*yi[s];
+         }
+         for(s=0;s<ns;++s) yc[s] /= l[ g->cofs[c] ];
+      }
+   }
+}
+}
+
+
+//
+// Function to prepare the geodesic distances on the surface of a mesh object:
+// the ordering of the vertices, and the assembly and factorization of the
+// operators. The time of the heat flow is "tfac" (1 when not positive) times
+// the square of the mean length of the edges (see struct incg_geod_s).
+//
+
+int incg_Geod_Build( const mesh_t* m, double tfac, struct incg_geod_s* g )
+{
+   long int nv,nt,i;
+   double h=0.0;
+   int nthr=1, ierr=0;
+
+
+   if( m == NULL || g == NULL ) return 1;
+   if( m->nv == 0 || m->ne == 0 || m->nt == 0 ) return 2;
+
+   memset( g, 0, sizeof(struct incg_geod_s) );
+   nv = m->nv;
+   nt = m->nt;
+   g->nv = nv;
+   g->nt = nt;
+
+#pragma omp parallel for reduction(+:h)
+   for(i=0;i<m->ne;++i) {
+      double dx = m->e[i].vb->x - m->e[i].va->x;
+      double dy = m->e[i].vb->y - m->e[i].va->y;
+      double dz = m->e[i].vb->z - m->e[i].va->z;
+
+      h += sqrt( dx*dx + dy*dy + dz*dz );
+   }
+   h /= (double) m->ne;
+   g->t = ( tfac > 0.0 ? tfac : 1.0 )*h*h;
+   if( g->t == 0.0 ) return 3;
+
+   ierr = incg_Adj_Build( m, &( g->adj ) );
+   if( ierr ) return ierr;
+
+   g->tv = (long int *) malloc( ((size_t) (3*nt)) * sizeof( long int ) );
+   g->ta = (double *) malloc( ((size_t) nt) * sizeof( double ) );
+   g->tg = (double *) malloc( ((size_t) (9*nt)) * sizeof( double ) );
+   g->perm = (long int *) malloc( ((size_t) nv) * sizeof( long int ) );
+   g->iperm = (long int *) malloc( ((size_t) nv) * sizeof( long int ) );
+   g->comp = (long int *) malloc( ((size_t) nv) * sizeof( long int ) );
+   if( g->tv == NULL || g->ta == NULL || g->tg == NULL ||
+       g->perm == NULL || g->iperm == NULL || g->comp == NULL ) {
+      ierr = -1;
+      goto cleanup;
+   }
+
+   incg_Geod_Triangles( m, g );
+   ierr = incg_Geod_Order( g );
+   if( ierr ) goto cleanup;
+#ifdef _OPENMP
+   nthr = omp_get_max_threads();
+#endif
+   ierr = incg_Geod_Symbolic( g, nthr );
+   if( ierr ) goto cleanup;
+   ierr = incg_Geod_Assemble( g );
+   if( ierr ) goto cleanup;
+   ierr = incg_Geod_Factor( g, nthr, g->lheat );
+   if( ierr ) goto cleanup;
+   ierr = incg_Geod_Factor( g, nthr, g->lpois );
+
+cleanup:
+   if( ierr ) (void) incg_Geod_Free( g );
+
+   return ierr;
+}
+
+
+//
+// Function to compute the geodesic distances from "nset" sets of sources, the
+// sources of set s being src[ sofs[s] ... sofs[s+1]-1 ]. The distances from
+// set s are stored in dist[ s*nv ... (s+1)*nv-1 ], measured from the mean of
+// the values at the sources of the same connected component; vertices of
+// components without sources are at a distance of -1. The boundaries of the
+// surface have the natural (Neumann) condition. All sets are solved together.
+//
+
+int incg_Geod_Distance( const struct incg_geod_s* g, int nset,
+                        const long int* sofs, const long int* src,
+                        double* dist )
+{
+   double *u=NULL, *x=NULL, *csum=NULL;
+   long int nv, nt, i;
+   int s, ierr=0;
+
+
+   if( g == NULL || g->lpois == NULL ) return 1;
+   if( nset <= 0 || sofs == NULL || src == NULL || dist == NULL ) return 2;
+
+   nv = g->nv;
+   nt = g->nt;
+   for(s=0;s<nset;++s) {
+      if( sofs[s+1] <= sofs[s] ) return 3;
+      for(i=sofs[s];i<sofs[s+1];++i) {
+         if( src[i] < 0 || src[i] >= nv ) return 3;
+      }
+   }
+
+   u = (double *) calloc( ((size_t) (nset*nv)), sizeof( double ) );
+   x = (double *) malloc( ((size_t) (3*nset*nt)) * sizeof( double ) );
+   csum = (double *) calloc( ((size_t) (2*g->ncomp)), sizeof( double ) );
+   if( u == NULL || x == NULL || csum == NULL ) {
+      ierr = -1;
+      goto cleanup;
+   }
+
+   // heat flow from the sources
+   for(s=0;s<nset;++s) {
+      for(i=sofs[s];i<sofs[s+1];++i) u[ nset*g->iperm[ src[i] ] + s ] = 1.0;
+   }
+   incg_Geod_Solve( g, g->lheat, nset, u );
+
+   // unit vectors against the gradient of the heat in the triangles
+#pragma omp parallel for
+   for(i=0;i<nt;++i) {
+      const double *gt = &( g->tg[9*i] );
+      int k,l,is;
+
+      for(is=0;is<nset;++is) {
+         double *xs = &( x[ 3*(nset*i+is) ] ), d;
+
+         xs[0] = 0.0;
+         xs[1] = 0.0;
+         xs[2] = 0.0;
+         for(k=0;k<3;++k) {
+            double uk = u[ nset*g->iperm[ g->tv[3*i+k] ] + is ];
+            for(l=0;l<3;++l) xs[l] -= uk*gt[3*k+l];
+         }
+         d = sqrt( xs[0]*xs[0] + xs[1]*xs[1] + xs[2]*xs[2] );
+         if( d > 0.0 ) for(l=0;l<3;++l) xs[l] /= d;
+      }
+   }
+
+   // their divergence, gathered at the vertices, into the Poisson problem
+#pragma omp parallel for schedule(dynamic,1024)
+   for(i=0;i<nv;++i) {
+      const struct incg_adj_s *a = &( g->adj );
+      double *ur = &( u[ nset*g->iperm[i] ] );
+      long int j;
+      int is;
+
+      for(is=0;is<nset;++is) ur[is] = 0.0;
+      for(j=a->tofs[i];j<a->tofs[i+1];++j) {
+         long int it = a->tri[j];
+         int k = incg_Geod_Corner( g, it, i );
+         const double *gk = &( g->tg[9*it+3*k] );
+
+         for(is=0;is<nset;++is) {
+            const double *xs = &( x[ 3*(nset*it+is) ] );
+            ur[is] += g->ta[it]*( gk[0]*xs[0] + gk[1]*xs[1] + gk[2]*xs[2] );
+         }
+      }
+   }
+   incg_Geod_Solve( g, g->lpois, nset, u );
+
+   // shift to the sources of every component
+   for(s=0;s<nset;++s) {
+      memset( csum, 0, ((size_t) (2*g->ncomp)) * sizeof( double ) );
+      for(i=sofs[s];i<sofs[s+1];++i) {
+         csum[ 2*g->comp[ src[i] ] ] += u[ nset*g->iperm[ src[i] ] + s ];
+         csum[ 2*g->comp[ src[i] ] + 1 ] += 1.0;
+      }
+#pragma omp parallel for
+      for(i=0;i<nv;++i) {
+         const double *cs = &( csum[ 2*g->comp[i] ] );
+
+         dist[ s*nv + i ] = cs[1] > 0.0 ?
+                            u[ nset*g->iperm[i] + s ] - cs[0]/cs[1] : -1.0;
+      }
+   }
+
+cleanup:
+   if( u != NULL ) free( u );
+   if( x != NULL ) free( x );
+   if( csum != NULL ) free( csum );
+
+   return ierr;
+}
+
+
+//
+// Function to release the memory of a geodesic-distance object
+//
+
+int incg_Geod_Free( struct incg_geod_s* g )
+{
+   if( g == NULL ) return 1;
+
+   if( g->tv != NULL ) free( g->tv );
+   if( g->ta != NULL ) free( g->ta );
+   if( g->tg != NULL ) free( g->tg );
+   if( g->perm != NULL ) free( g->perm );
+   if( g->iperm != NULL ) free( g->iperm );
+   if( g->comp != NULL ) free( g->comp );
+   if( g->cofs != NULL ) free( g->cofs );
+   if( g->crow != NULL ) free( g->crow );
+   if( g->rofs != NULL ) free( g->rofs );
+   if( g->rcol != NULL ) free( g->rcol );
+   if( g->rpos != NULL ) free( g->rpos );
+   if( g->lofs != NULL ) free( g->lofs );
+   if( g->lcol != NULL ) free( g->lcol );
+   if( g->lheat != NULL ) free( g->lheat );
+   if( g->lpois != NULL ) free( g->lpois );
+   (void) incg_Adj_Free( &( g->adj ) );
+   memset( g, 0, sizeof(struct incg_geod_s) );
+
+   return 0;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
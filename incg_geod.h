@@ -0,0 +1,67 @@
+
+#ifndef _INCG_GEOD_H_
+#define _INCG_GEOD_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "incg_mesh.h"
+#include "incg_adj.h"
+
+//
+// Geodesic distances on the surface of a mesh by the heat method (Crane et
+// al.): heat flows from the sources for a short time, its normalized gradient
+// gives the directions of the distance, and the distance is recovered by a
+// Poisson problem. Both linear operators are factored once, so that every set
+// of sources costs back-substitutions and a parallel pass over the triangles.
+//
+// Operators are over the vertices reordered by nested dissection (new index
+// r of vertex perm[r], iperm[] the inverse): every connected piece of the
+// surface is split by the middle level of a breadth-first visit, and the
+// separator is numbered after the two halves. Their Cholesky factors L are
+// sparse, with the diagonal first in every column: column c holds the rows
+// crow[ cofs[c] ... cofs[c+1]-1 ] in increasing order, and the entries of row
+// r left of the diagonal are in the columns rcol[ rofs[r] ... rofs[r+1]-1 ] at
+// the positions rpos[] of the factors. The fill of a surface of n vertices
+// grows as about n log n and the time of the factorization as about n^1.5.
+// Columns are grouped by their height in the elimination tree, in lcol[
+// lofs[h] ... lofs[h+1]-1 ] for the "nlev" heights; a column depends only on
+// the columns below it, so that the factorization and the triangular solves
+// run in parallel over the columns of every height. An iterative solver is
+// not a substitute for the factors: the heat decays as exp(-d^2/4t) away from
+// the sources, below any residual tolerance, and its direction is lost.
+// Triangles keep their vertices and areas, and the gradients of the linear
+// functions of their corners (3 vectors); the adjacency is kept to gather
+// over the triangles of every vertex. Vertices are grouped by the connected
+// components of the surface (comp[]).
+//
+struct incg_geod_s {
+   long int nv, nt;
+   double t;
+   long int *tv;
+   double *ta, *tg;
+   long int *perm, *iperm;
+   long int ncomp, *comp;
+   long int *cofs, *crow;
+   long int *rofs, *rcol, *rpos;
+   long int nlev, *lofs, *lcol;
+   double *lheat, *lpois;
+   struct incg_adj_s adj;
+};
+
+// -------------------- function prototypes/signatures --------------------
+
+int incg_Geod_Build( const mesh_t* m, double tfac, struct incg_geod_s* g );
+
+int incg_Geod_Distance( const struct incg_geod_s* g, int nset,
+                        const long int* sofs, const long int* src,
+                        double* dist );
+
+int incg_Geod_Free( struct incg_geod_s* g );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
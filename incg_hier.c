@@ -0,0 +1,336 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "incg_hier.h"
+#include "incg_sort.h"
+
+
+//
+// Function to check the arguments of a transfer between levels l and l+1
+//
+static int incg_Hier_Check( const struct incg_hier_s* h, int l, int nc,
+                            const double* a, const double* b )
+{
+   if( h == NULL || h->lev == NULL ) return 1;
+   if( l < 0 || l >= h->nlev ) return 2;
+   if( nc <= 0 ) return 3;
+   if( a == NULL || b == NULL ) return 4;
+
+   return 0;
+}
+
+
+//
+// Function that takes a pointer to a mesh object and refines it uniformly
+// "nlev" times while keeping every level in the hierarchy object. The arrays
+// of the incoming mesh become level 0 and the mesh object is emptied; it is
+// left as it was if the hierarchy cannot be made.
+//
+
+int incg_Hier_Build( mesh_t* m, int nlev, struct incg_hier_s* h )
+{
+   int l,ierr=0;
+
+
+   if( m == NULL || h == NULL ) return 1;
+   if( m->nv == 0 || m->ne == 0 || m->nt == 0 ) return 2;
+   if( nlev < 0 ) return 3;
+
+   memset( h, 0, sizeof(struct incg_hier_s) );
+   h->lev = (mesh_t *) malloc( ((size_t) (nlev+1)) * sizeof( mesh_t ) );
+   if( h->lev == NULL ) return -1;
+
+   h->lev[0] = *m;
+   for(l=1;l<=nlev;++l) {
+      ierr = incg_RefineMesh_UniformInto( &( h->lev[l-1] ), &( h->lev[l] ) );
+      if( ierr ) break;
+   }
+   if( ierr ) {
+      for(--l;l>0;--l) {
+         free( h->lev[l].v );
+         free( h->lev[l].e );
+         free( h->lev[l].t );
+      }
+      free( h->lev );
+      h->lev = NULL;
+      return ierr;
+   }
+
+   h->nlev = nlev;
+   memset( m, 0, sizeof(mesh_t) );
+
+   return 0;
+}
+
+
+//
+// Function to return the vertices of level l that vertex "iv" of level l+1
+// comes from: the same vertex twice, or the two vertices of the split edge.
+//
+
+int incg_Hier_Parent( const struct incg_hier_s* h, int l, long int iv,
+                      long int *ja, long int *jb )
+{
+   const mesh_t *mc;
+
+
+   if( h == NULL || h->lev == NULL ) return 1;
+   if( l < 0 || l >= h->nlev ) return 2;
+   if( ja == NULL || jb == NULL ) return 4;
+
+   mc = &( h->lev[l] );
+   if( iv < 0 || iv >= h->lev[l+1].nv ) return 3;
+
+   if( iv < mc->nv ) {
+      *ja = iv;
+      *jb = iv;
+   } else {
+      *ja = mc->e[ iv - mc->nv ].va->id;
+      *jb = mc->e[ iv - mc->nv ].vb->id;
+   }
+
+   return 0;
+}
+
+
+//
+// Function to prolongate a vertex field from level l to level l+1 by linear
+// interpolation: kept vertices take their values and new vertices the average
+// of the ends of their edge.
+//
+
+int incg_Hier_Prolong( const struct incg_hier_s* h, int l, int nc,
+                       const double* uc, double* uf )
+{
+   const mesh_t *mc;
+   long int nv,ne,i;
+   int ierr;
+
+
+   ierr = incg_Hier_Check( h, l, nc, uc, uf );
+   if( ierr ) return ierr;
+
+   mc = &( h->lev[l] );
+   nv = mc->nv;
+   ne = mc->ne;
+
+#pragma omp parallel for
+   for(i=0;i<nc*nv;++i) uf[i] = uc[i];
+#pragma omp parallel for
+   for(i=0;i<ne;++i) {
+      const double *ua = &( uc[ nc*mc->e[i].va->id ] );
+      const double *ub = &( uc[ nc*mc->e[i].vb->id ] );
+      double *u = &( uf[ nc*(nv+i) ] );
+      int k;
+
+      for(k=0;k<nc;++k) u[k] = 0.5*( ua[k] + ub[k] );
+   }
+
+   return 0;
+}
+
+
+//
+// Function to restrict a vertex field (a residual) from level l+1 to level l
+// by the transpose of the prolongation ("full weighting"): vertices gather
+// their own value and half of the values of the new vertices of their edges.
+// Every vertex gathers over a list of its edges in the order of their indices,
+// so the sums do not depend on the threads.
+//
+
+int incg_Hier_Restrict( const struct incg_hier_s* h, int l, int nc,
+                        const double* rf, double* rc )
+{
+   const mesh_t *mc;
+   long int nv,ne,i,*vofs,*vcur,*vedg;
+   int ierr;
+
+
+   ierr = incg_Hier_Check( h, l, nc, rf, rc );
+   if( ierr ) return ierr;
+
+   mc = &( h->lev[l] );
+   nv = mc->nv;
+   ne = mc->ne;
+
+   vofs = (long int *) malloc( ((size_t) (2*nv + 2*ne + 1)) *
+                               sizeof( long int ) );
+   if( vofs == NULL ) return -1;
+   vcur = &( vofs[nv+1] );
+   vedg = &( vcur[nv] );
+
+   // list the edges by vertex
+#pragma omp parallel for
+   for(i=0;i<=nv;++i) vofs[i] = 0;
+#pragma omp parallel for
+   for(i=0;i<ne;++i) {
+#pragma omp atomic
+      vofs[ mc->e[i].va->id ] += 1;
+#pragma omp atomic
+      vofs[ mc->e[i].vb->id ] += 1;
+   }
+   (void) incg_Sort_ScanExclusive( nv+1, vofs );
+#pragma omp parallel for
+   for(i=0;i<nv;++i) vcur[i] = vofs[i];
+#pragma omp parallel for
+   for(i=0;i<ne;++i) {
+      long int ja,jb;
+
+#pragma omp atomic capture
+      ja = vcur[ mc->e[i].va->id ]++;
+#pragma omp atomic capture
+      jb = vcur[ mc->e[i].vb->id ]++;
+      vedg[ja] = i;
+      vedg[jb] = i;
+   }
+
+#pragma omp parallel for schedule(dynamic,1024)
+   for(i=0;i<nv;++i) {
+      double *r = &( rc[ nc*i ] );
+      long int j,m;
+      int k;
+
+      // (the edges of a vertex are few: insertion sort)
+      for(j=vofs[i]+1;j<vofs[i+1];++j) {
+         long int ie = vedg[j];
+
+         for(m=j;m>vofs[i] && vedg[m-1]>ie;--m) vedg[m] = vedg[m-1];
+         vedg[m] = ie;
+      }
+
+      for(k=0;k<nc;++k) r[k] = rf[ nc*i + k ];
+      for(j=vofs[i];j<vofs[i+1];++j) {
+         const double *re = &( rf[ nc*(nv + vedg[j]) ] );
+
+         for(k=0;k<nc;++k) r[k] += 0.5*re[k];
+      }
+   }
+
+   free( vofs );
+
+   return 0;
+}
+
+
+//
+// Function to restrict a vertex field (a solution) from level l+1 to level l
+// by injection: vertices take their values on the finer level.
+//
+
+int incg_Hier_Inject( const struct incg_hier_s* h, int l, int nc,
+                      const double* uf, double* uc )
+{
+   long int n,i;
+   int ierr;
+
+
+   ierr = incg_Hier_Check( h, l, nc, uf, uc );
+   if( ierr ) return ierr;
+
+   n = nc*h->lev[l].nv;
+#pragma omp parallel for
+   for(i=0;i<n;++i) uc[i] = uf[i];
+
+   return 0;
+}
+
+
+//
+// Function to prolongate a triangle field from level l to level l+1: the
+// four children of a triangle take its values.
+//
+
+int incg_Hier_ProlongTris( const struct incg_hier_s* h, int l, int nc,
+                           const double* uc, double* uf )
+{
+   long int nt,i;
+   int ierr;
+
+
+   ierr = incg_Hier_Check( h, l, nc, uc, uf );
+   if( ierr ) return ierr;
+
+   nt = h->lev[l].nt;
+#pragma omp parallel for
+   for(i=0;i<nt;++i) {
+      int j,k;
+
+      for(j=0;j<4;++j) {
+         for(k=0;k<nc;++k) uf[ nc*(4*i+j) + k ] = uc[ nc*i + k ];
+      }
+   }
+
+   return 0;
+}
+
+
+//
+// Function to restrict a triangle field from level l+1 to level l by the
+// transpose of the prolongation: triangles take the sum of their four
+// children (divide by four for an average).
+//
+
+int incg_Hier_RestrictTris( const struct incg_hier_s* h, int l, int nc,
+                            const double* rf, double* rc )
+{
+   long int nt,i;
+   int ierr;
+
+
+   ierr = incg_Hier_Check( h, l, nc, rf, rc );
+   if( ierr ) return ierr;
+
+   nt = h->lev[l].nt;
+#pragma omp parallel for
+   for(i=0;i<nt;++i) {
+      const double *r = &( rf[ nc*4*i ] );
+      int k;
+
+      for(k=0;k<nc;++k) {
+         rc[ nc*i + k ] = r[k] + r[nc+k] + r[2*nc+k] + r[3*nc+k];
+      }
+   }
+
+   return 0;
+}
+
+
+//
+// Function to release the memory of all levels of a hierarchy
+//
+
+int incg_Hier_Free( struct incg_hier_s* h )
+{
+   int l;
+
+
+   if( h == NULL ) return 1;
+
+   if( h->lev != NULL ) {
+      for(l=0;l<=h->nlev;++l) {
+         if( h->lev[l].v != NULL ) free( h->lev[l].v );
+         if( h->lev[l].e != NULL ) free( h->lev[l].e );
+         if( h->lev[l].t != NULL ) free( h->lev[l].t );
+      }
+      free( h->lev );
+   }
+   memset( h, 0, sizeof(struct incg_hier_s) );
+
+   return 0;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
@@ -0,0 +1,53 @@
+
+#ifndef _INCG_HIER_H_
+#define _INCG_HIER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "incg_mesh.h"
+
+//
+// A hierarchy of meshes made by successive uniform refinements of a mesh,
+// with every level kept: lev[0] is the incoming mesh and lev[nlev] the finest.
+// The levels are related by the index scheme of the uniform refinement (see
+// incg_RefineMesh_UniformInto()), so no maps are stored: from level l to l+1
+// vertex i stays i, edge i makes vertex nv+i and edges 2*i+0 (at its vertex A)
+// and 2*i+1 (at its vertex B), and triangle i makes triangles 4*i+k. Fields
+// on the vertices or triangles of a level have "nc" interleaved components.
+//
+struct incg_hier_s {
+   int nlev;
+   mesh_t *lev;
+};
+
+// -------------------- function prototypes/signatures --------------------
+
+int incg_Hier_Build( mesh_t* m, int nlev, struct incg_hier_s* h );
+
+int incg_Hier_Parent( const struct incg_hier_s* h, int l, long int iv,
+                      long int *ja, long int *jb );
+
+int incg_Hier_Prolong( const struct incg_hier_s* h, int l, int nc,
+                       const double* uc, double* uf );
+
+int incg_Hier_Restrict( const struct incg_hier_s* h, int l, int nc,
+                        const double* rf, double* rc );
+
+int incg_Hier_Inject( const struct incg_hier_s* h, int l, int nc,
+                      const double* uf, double* uc );
+
+int incg_Hier_ProlongTris( const struct incg_hier_s* h, int l, int nc,
+                           const double* uc, double* uf );
+
+int incg_Hier_RestrictTris( const struct incg_hier_s* h, int l, int nc,
+                            const double* rf, double* rc );
+
+int incg_Hier_Free( struct incg_hier_s* h );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
@@ -0,0 +1,870 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "incg_isect.h"
+#include "incg_sort.h"
+
+// bits of a coordinate of a cell in its key
+#define INCG_ISECT_CBITS        20
+
+
+//
+// The grid of cells over the faces, the boxes of the faces (lo and hi corners
+// as structures of arrays) and their triangles; a quad is the two triangles
+// across its shorter diagonal, a triangle has the same one twice
+//
+struct incg_isect_grid_s {
+   double x0[3], h;
+   long int n[3];
+   double *lo[3], *hi[3];
+   long int *tri;
+};
+
+//
+// Pairs that a thread has found
+//
+struct incg_isect_buf_s {
+   long int n, nmax;
+   long int *pair;
+};
+
+
+//
+// Function to return the number of vertices of a face (3 or 4)
+//
+static int incg_Isect_FaceSize( const long int* f )
+{
+   return f[3] < 0 ? 3 : 4;
+}
+
+
+//
+// Function to return the cell of a coordinate along an axis
+//
+static long int incg_Isect_Cell( const struct incg_isect_grid_s* g, int k,
+                                 double x )
+{
+   long int i = (long int) floor( ( x - g->x0[k] )/g->h );
+
+   if( i < 0 ) i = 0;
+   if( i >= g->n[k] ) i = g->n[k] - 1;
+
+   return i;
+}
+
+
+//
+// Exact arithmetic of expansions (Shewchuk): a number is kept as a sum of
+// non-overlapping doubles in increasing magnitude, whose last non-zero term
+// has the sign of the sum. The sum and the difference of two doubles, and
+// their product (by a fused multiply-add), are exactly two doubles.
+//
+static void incg_Isect_TwoSum( double a, double b, double* x, double* y )
+{
+   double s = a + b, bv = s - a, av = s - bv;
+
+   *x = s;
+   *y = ( a - av ) + ( b - bv );
+}
+
+static void incg_Isect_TwoDiff( double a, double b, double* x, double* y )
+{
+   double s = a - b, bv = a - s, av = s + bv;
+
+   *x = s;
+   *y = ( a - av ) + ( bv - b );
+}
+
+static void incg_Isect_TwoProduct( double a, double b, double* x, double* y )
+{
+   double p = a*b;
+
+   *x = p;
+   *y = fma( a, b, -p );
+}
+
+//
+// Function to add the expansion "f" (of "nf" terms) to the expansion "e" (of
+// "ne" terms, with room for ne+nf) in place, dropping zero terms; the number
+// of terms is returned
+//
+static int incg_Isect_ExpAdd( int ne, double* e, int nf, const double* f )
+{
+   int i,j,n;
+
+   for(j=0;j<nf;++j) {
+      double q = f[j], h;
+
+      for(i=0,n=0;i<ne;++i) {
+         incg_Isect_TwoSum( q, e[i], &q, &h );
+         if( h != 0.0 ) e[n++] = h;
+      }
+      if( q != 0.0 ) e[n++] = q;
+      ne = n;
+   }
+
+   return ne;
+}
+
+//
+// Function to multiply the expansion "e" of "ne" terms by a double into "h"
+// (of 2 ne terms at most), dropping zero terms; the number of terms is
+// returned
+//
+static int incg_Isect_ExpScale( int ne, const double* e, double b, double* h )
+{
+   double p,pl,q,s;
+   int i,n=0;
+
+   if( ne == 0 ) return 0;
+   incg_Isect_TwoProduct( e[0], b, &q, &pl );
+   if( pl != 0.0 ) h[n++] = pl;
+   for(i=1;i<ne;++i) {
+      incg_Isect_TwoProduct( e[i], b, &p, &pl );
+      incg_Isect_TwoSum( q, pl, &s, &pl );
+      if( pl != 0.0 ) h[n++] = pl;
+      incg_Isect_TwoSum( p, s, &q, &pl );
+      if( pl != 0.0 ) h[n++] = pl;
+   }
+   if( q != 0.0 ) h[n++] = q;
+
+   return n;
+}
+
+//
+// Function to form the product of two expansions of two terms, with the sign
+// "sg", added to the expansion "e" of "ne" terms (with room for 8 more)
+//
+static int incg_Isect_ExpAddProduct( int ne, double* e, double sg,
+                                     const double* a, const double* b )
+{
+   double t[8];
+   int n;
+
+   n = incg_Isect_ExpScale( 2, a, sg*b[0], t );
+   ne = incg_Isect_ExpAdd( ne, e, n, t );
+   n = incg_Isect_ExpScale( 2, a, sg*b[1], t );
+
+   return incg_Isect_ExpAdd( ne, e, n, t );
+}
+
+//
+// Function to return the most significant term of an expansion (0 when empty)
+//
+static double incg_Isect_ExpTop( int ne, const double* e )
+{
+   return ne > 0 ? e[ne-1] : 0.0;
+}
+
+
+//
+// Orientation of a point relative to the plane of a triangle, and of a point
+// relative to a line in 2D, with the signs of the determinants exact: the
+// determinant in floating point is returned when its error bound (Shewchuk)
+// shows that its sign is right, otherwise the determinant is evaluated over
+// expansions from the exact differences of the coordinates, and a value of its
+// sign is returned. Both are positive when a, b, c turn counter-clockwise: in
+// the plane, or seen from above their plane with d below it.
+//
+static double incg_Isect_Orient3Exact( const double* a, const double* b,
+                                       const double* c, const double* d )
+{
+   double ad[3][2], bd[3][2], cd[3][2], m[16], e[192];
+   int k, nm, ne=0;
+
+   for(k=0;k<3;++k) {
+      incg_Isect_TwoDiff( a[k], d[k], &( ad[k][1] ), &( ad[k][0] ) );
+      incg_Isect_TwoDiff( b[k], d[k], &( bd[k][1] ), &( bd[k][0] ) );
+      incg_Isect_TwoDiff( c[k], d[k], &( cd[k][1] ), &( cd[k][0] ) );
+   }
+
+   // along the last column: the three minors of the first two
+   nm = incg_Isect_ExpAddProduct( 0, m, 1.0, bd[0], cd[1] );
+   nm = incg_Isect_ExpAddProduct( nm, m, -1.0, cd[0], bd[1] );
+   for(k=0;k<2;++k) {
+      double t[32];
+      int n = incg_Isect_ExpScale( nm, m, ad[2][k], t );
+      ne = incg_Isect_ExpAdd( ne, e, n, t );
+   }
+   nm = incg_Isect_ExpAddProduct( 0, m, 1.0, cd[0], ad[1] );
+   nm = incg_Isect_ExpAddProduct( nm, m, -1.0, ad[0], cd[1] );
+   for(k=0;k<2;++k) {
+      double t[32];
+      int n = incg_Isect_ExpScale( nm, m, bd[2][k], t );
+      ne = incg_Isect_ExpAdd( ne, e, n, t );
+   }
+   nm = incg_Isect_ExpAddProduct( 0, m, 1.0, ad[0], bd[1] );
+   nm = incg_Isect_ExpAddProduct( nm, m, -1.0, bd[0], ad[1] );
+   for(k=0;k<2;++k) {
+      double t[32];
+      int n = incg_Isect_ExpScale( nm, m, cd[2][k], t );
+      ne = incg_Isect_ExpAdd( ne, e, n, t );
+   }
+
+   return incg_Isect_ExpTop( ne, e );
+}
+
+static double incg_Isect_Orient3( const double* a, const double* b,
+                                  const double* c, const double* d )
+{
+   const double eps = 0.5*DBL_EPSILON, bound = ( 7.0 + 56.0*eps )*eps;
+   double adx = a[0] - d[0], ady = a[1] - d[1], adz = a[2] - d[2];
+   double bdx = b[0] - d[0], bdy = b[1] - d[1], bdz = b[2] - d[2];
+   double cdx = c[0] - d[0], cdy = c[1] - d[1], cdz = c[2] - d[2];
+   double bc = bdx*cdy, cb = cdx*bdy, ca = cdx*ady, ac = adx*cdy;
+   double ab = adx*bdy, ba = bdx*ady, det, perm;
+
+   det = adz*( bc - cb ) + bdz*( ca - ac ) + cdz*( ab - ba );
+   perm = ( fabs( bc ) + fabs( cb ) )*fabs( adz ) +
+          ( fabs( ca ) + fabs( ac ) )*fabs( bdz ) +
+          ( fabs( ab ) + fabs( ba ) )*fabs( cdz );
+   if( det > bound*perm || -det > bound*perm ) return det;
+
+   return incg_Isect_Orient3Exact( a, b, c, d );
+}
+
+static double incg_Isect_Orient2( const double* a, const double* b,
+                                  const double* c )
+{
+   const double eps = 0.5*DBL_EPSILON, bound = ( 3.0 + 16.0*eps )*eps;
+   double l = ( a[0] - c[0] )*( b[1] - c[1] );
+   double r = ( a[1] - c[1] )*( b[0] - c[0] );
+   double det = l - r, ac[2][2], bc[2][2], e[16];
+   int ne;
+
+   if( det > bound*( fabs( l ) + fabs( r ) ) ||
+       -det > bound*( fabs( l ) + fabs( r ) ) ) return det;
+
+   incg_Isect_TwoDiff( a[0], c[0], &( ac[0][1] ), &( ac[0][0] ) );
+   incg_Isect_TwoDiff( a[1], c[1], &( ac[1][1] ), &( ac[1][0] ) );
+   incg_Isect_TwoDiff( b[0], c[0], &( bc[0][1] ), &( bc[0][0] ) );
+   incg_Isect_TwoDiff( b[1], c[1], &( bc[1][1] ), &( bc[1][0] ) );
+   ne = incg_Isect_ExpAddProduct( 0, e, 1.0, ac[0], bc[1] );
+   ne = incg_Isect_ExpAddProduct( ne, e, -1.0, ac[1], bc[0] );
+
+   return incg_Isect_ExpTop( ne, e );
+}
+
+
+//
+// Function to test whether a point on the line of a segment is on it (2D)
+//
+static int incg_Isect_OnSeg2( const double* a, const double* b,
+                              const double* p )
+{
+   return ( p[0] >= ( a[0] < b[0] ? a[0] : b[0] ) ) &&
+          ( p[0] <= ( a[0] > b[0] ? a[0] : b[0] ) ) &&
+          ( p[1] >= ( a[1] < b[1] ? a[1] : b[1] ) ) &&
+          ( p[1] <= ( a[1] > b[1] ? a[1] : b[1] ) );
+}
+
+
+//
+// Function to test whether two segments meet (2D, touching included)
+//
+static int incg_Isect_SegSeg2( const double* a, const double* b,
+                               const double* c, const double* d )
+{
+   double d1 = incg_Isect_Orient2( a, b, c );
+   double d2 = incg_Isect_Orient2( a, b, d );
+   double d3 = incg_Isect_Orient2( c, d, a );
+   double d4 = incg_Isect_Orient2( c, d, b );
+
+   if( ( ( d1 > 0.0 && d2 < 0.0 ) || ( d1 < 0.0 && d2 > 0.0 ) ) &&
+       ( ( d3 > 0.0 && d4 < 0.0 ) || ( d3 < 0.0 && d4 > 0.0 ) ) ) return 1;
+   if( d1 == 0.0 && incg_Isect_OnSeg2( a, b, c ) ) return 1;
+   if( d2 == 0.0 && incg_Isect_OnSeg2( a, b, d ) ) return 1;
+   if( d3 == 0.0 && incg_Isect_OnSeg2( c, d, a ) ) return 1;
+   if( d4 == 0.0 && incg_Isect_OnSeg2( c, d, b ) ) return 1;
+
+   return 0;
+}
+
+
+//
+// Function to test whether a point is in a triangle (2D, edges included)
+//
+static int incg_Isect_PointTri2( const double* p, const double* a,
+                                 const double* b, const double* c )
+{
+   double s1 = incg_Isect_Orient2( a, b, p );
+   double s2 = incg_Isect_Orient2( b, c, p );
+   double s3 = incg_Isect_Orient2( c, a, p );
+
+   return ( s1 >= 0.0 && s2 >= 0.0 && s3 >= 0.0 ) ||
+          ( s1 <= 0.0 && s2 <= 0.0 && s3 <= 0.0 );
+}
+
+
+//
+// Function to test whether two coplanar triangles meet, in the plane of the
+// two axes other than that of the largest component of the normal
+//
+static int incg_Isect_Coplanar( const double* const p[3],
+                                const double* const q[3] )
+{
+   double n[3], u[3], v[3], a[3][2], b[3][2];
+   int i,j,k, i0,i1;
+
+   for(k=0;k<3;++k) {
+      u[k] = p[1][k] - p[0][k];
+      v[k] = p[2][k] - p[0][k];
+   }
+   n[0] = fabs( u[1]*v[2] - u[2]*v[1] );
+   n[1] = fabs( u[2]*v[0] - u[0]*v[2] );
+   n[2] = fabs( u[0]*v[1] - u[1]*v[0] );
+   k = n[0] > n[1] ? ( n[0] > n[2] ? 0 : 2 ) : ( n[1] > n[2] ? 1 : 2 );
+   i0 = (k+1)%3;
+   i1 = (k+2)%3;
+   for(i=0;i<3;++i) {
+      a[i][0] = p[i][i0];
+      a[i][1] = p[i][i1];
+      b[i][0] = q[i][i0];
+      b[i][1] = q[i][i1];
+   }
+
+   for(i=0;i<3;++i) {
+      for(j=0;j<3;++j) {
+         if( incg_Isect_SegSeg2( a[i], a[(i+1)%3], b[j], b[(j+1)%3] ) ) {
+            return 1;
+         }
+      }
+   }
+   if( incg_Isect_PointTri2( a[0], b[0], b[1], b[2] ) ) return 1;
+   if( incg_Isect_PointTri2( b[0], a[0], a[1], a[2] ) ) return 1;
+
+   return 0;
+}
+
+
+//
+// Function to test whether a segment crosses a triangle that is not in its
+// plane (touching included): its ends are not on the same side of the plane
+// and it passes on the same side of the three edges
+//
+static int incg_Isect_SegTri( const double* s0, const double* s1,
+                              const double* const t[3] )
+{
+   double o0 = incg_Isect_Orient3( t[0], t[1], t[2], s0 );
+   double o1 = incg_Isect_Orient3( t[0], t[1], t[2], s1 );
+   double e0,e1,e2;
+
+   if( ( o0 > 0.0 && o1 > 0.0 ) || ( o0 < 0.0 && o1 < 0.0 ) ) return 0;
+   if( o0 == 0.0 && o1 == 0.0 ) return 0;
+
+   e0 = incg_Isect_Orient3( s0, s1, t[0], t[1] );
+   e1 = incg_Isect_Orient3( s0, s1, t[1], t[2] );
+   e2 = incg_Isect_Orient3( s0, s1, t[2], t[0] );
+
+   return ( e0 >= 0.0 && e1 >= 0.0 && e2 >= 0.0 ) ||
+          ( e0 <= 0.0 && e1 <= 0.0 && e2 <= 0.0 );
+}
+
+
+//
+// Function to test whether two triangles meet (touching included) by the
+// signs of orientation determinants: when neither triangle is on one side of
+// the plane of the other, an edge of one of them crosses the other, or they
+// are coplanar.
+//
+static int incg_Isect_TriTri( const double* const p[3],
+                              const double* const q[3] )
+{
+   double op[3], oq[3];
+   int k;
+
+   for(k=0;k<3;++k) oq[k] = incg_Isect_Orient3( p[0], p[1], p[2], q[k] );
+   if( ( oq[0] > 0.0 && oq[1] > 0.0 && oq[2] > 0.0 ) ||
+       ( oq[0] < 0.0 && oq[1] < 0.0 && oq[2] < 0.0 ) ) return 0;
+   for(k=0;k<3;++k) op[k] = incg_Isect_Orient3( q[0], q[1], q[2], p[k] );
+   if( ( op[0] > 0.0 && op[1] > 0.0 && op[2] > 0.0 ) ||
+       ( op[0] < 0.0 && op[1] < 0.0 && op[2] < 0.0 ) ) return 0;
+
+   if( oq[0] == 0.0 && oq[1] == 0.0 && oq[2] == 0.0 ) {
+      if( op[0] != 0.0 || op[1] != 0.0 || op[2] != 0.0 ) return 0;
+      return incg_Isect_Coplanar( p, q );
+   }
+
+   for(k=0;k<3;++k) {
+      if( incg_Isect_SegTri( p[k], p[(k+1)%3], q ) ) return 1;
+      if( incg_Isect_SegTri( q[k], q[(k+1)%3], p ) ) return 1;
+   }
+
+   return 0;
+}
+
+
+//
+// Function to test whether two faces share a vertex
+//
+static int incg_Isect_Shared( const long int* f, const long int* g )
+{
+   int i,j, m = incg_Isect_FaceSize( f ), n = incg_Isect_FaceSize( g );
+
+   for(i=0;i<m;++i) for(j=0;j<n;++j) if( f[i] == g[j] ) return 1;
+
+   return 0;
+}
+
+
+//
+// Function to test whether two faces meet through any of their triangles
+//
+static int incg_Isect_FaceFace( const struct incg_isect_grid_s* g,
+                                const double* x, long int fa, long int fb )
+{
+   const long int *ta = &( g->tri[6*fa] ), *tb = &( g->tri[6*fb] );
+   int i,j,k;
+
+   for(i=0;i<2;++i) {
+      const double *p[3];
+
+      if( i == 1 && ta[3] == ta[0] ) break;
+      for(k=0;k<3;++k) p[k] = &( x[ 3*ta[3*i+k] ] );
+      for(j=0;j<2;++j) {
+         const double *q[3];
+
+         if( j == 1 && tb[3] == tb[0] ) break;
+         for(k=0;k<3;++k) q[k] = &( x[ 3*tb[3*j+k] ] );
+         if( incg_Isect_TriTri( p, q ) ) return 1;
+      }
+   }
+
+   return 0;
+}
+
+
+//
+// Function to append a pair to the buffer of a thread
+//
+static int incg_Isect_Push( struct incg_isect_buf_s* b, long int fa,
+                            long int fb )
+{
+   if( b->n == b->nmax ) {
+      long int nmax = b->nmax > 0 ? 2*b->nmax : 1024;
+      long int *p = (long int *) realloc( b->pair,
+                                  ((size_t) (2*nmax)) * sizeof( long int ) );
+      if( p == NULL ) return -1;
+      b->pair = p;
+      b->nmax = nmax;
+   }
+   b->pair[ 2*b->n ] = fa < fb ? fa : fb;
+   b->pair[ 2*b->n + 1 ] = fa < fb ? fb : fa;
+   ++b->n;
+
+   return 0;
+}
+
+
+//
+// Function to prepare the boxes and triangles of the faces and the grid: its
+// cells are cubes whose side is INCG_ISECT_CELLFAC times the mean of the
+// largest extents of the boxes, with no more than 2^INCG_ISECT_CBITS cells
+// along an axis
+//
+static int incg_Isect_Grid( const double* x, long int nf,
+                            const long int* faces,
+                            struct incg_isect_grid_s* g )
+{
+   double xmin[3] = { 1.0e300, 1.0e300, 1.0e300 };
+   double xmax[3] = { -1.0e300, -1.0e300, -1.0e300 };
+   double ext = 0.0, w;
+   long int i;
+   int k;
+
+
+   for(k=0;k<3;++k) {
+      g->lo[k] = (double *) malloc( ((size_t) nf) * sizeof( double ) );
+      g->hi[k] = (double *) malloc( ((size_t) nf) * sizeof( double ) );
+      if( g->lo[k] == NULL || g->hi[k] == NULL ) return -1;
+   }
+   g->tri = (long int *) malloc( ((size_t) (6*nf)) * sizeof( long int ) );
+   if( g->tri == NULL ) return -1;
+
+#pragma omp parallel for reduction(+:ext) \
+                         reduction(min:xmin[:3]) reduction(max:xmax[:3])
+   for(i=0;i<nf;++i) {
+      const long int *f = &( faces[4*i] );
+      long int *t = &( g->tri[6*i] );
+      int m = incg_Isect_FaceSize( f ), j, l;
+      double e = 0.0;
+
+      for(l=0;l<3;++l) {
+         double lo = x[ 3*f[0]+l ], hi = lo;
+
+         for(j=1;j<m;++j) {
+            double xj = x[ 3*f[j]+l ];
+            lo = xj < lo ? xj : lo;
+            hi = xj > hi ? xj : hi;
+         }
+         g->lo[l][i] = lo;
+         g->hi[l][i] = hi;
+         if( hi - lo > e ) e = hi - lo;
+         if( lo < xmin[l] ) xmin[l] = lo;
+         if( hi > xmax[l] ) xmax[l] = hi;
+      }
+      ext += e;
+
+      for(j=0;j<3;++j) {
+         t[j] = f[j];
+         t[3+j] = f[j];
+      }
+      if( m == 4 ) {
+         double d[2] = { 0.0, 0.0 };
+         int s;
+
+         for(l=0;l<3;++l) {
+            d[0] += ( x[ 3*f[2]+l ] - x[ 3*f[0]+l ] )*
+                    ( x[ 3*f[2]+l ] - x[ 3*f[0]+l ] );
+            d[1] += ( x[ 3*f[3]+l ] - x[ 3*f[1]+l ] )*
+                    ( x[ 3*f[3]+l ] - x[ 3*f[1]+l ] );
+         }
+         s = d[1] < d[0] ? 1 : 0;
+         t[0] = f[s];
+         t[1] = f[s+1];
+         t[2] = f[s+2];
+         t[3] = f[s];
+         t[4] = f[s+2];
+         t[5] = f[(s+3)%4];
+      }
+   }
+
+   w = 0.0;
+   for(k=0;k<3;++k) if( xmax[k] - xmin[k] > w ) w = xmax[k] - xmin[k];
+   g->h = INCG_ISECT_CELLFAC*ext/(double) nf;
+   if( g->h < w/(double) (1L << INCG_ISECT_CBITS) ) {
+      g->h = w/(double) (1L << INCG_ISECT_CBITS);
+   }
+   if( g->h <= 0.0 ) g->h = 1.0;
+   for(k=0;k<3;++k) {
+      g->x0[k] = xmin[k];
+      g->n[k] = (long int) floor( ( xmax[k] - xmin[k] )/g->h ) + 1;
+      if( g->n[k] > (1L << INCG_ISECT_CBITS) ) g->n[k] = 1L << INCG_ISECT_CBITS;
+   }
+
+   return 0;
+}
+
+
+//
+// Function to return the key of a cell
+//
+static unsigned long incg_Isect_Key( long int ix, long int iy, long int iz )
+{
+   return ( ((unsigned long) ix) << (2*INCG_ISECT_CBITS) ) |
+          ( ((unsigned long) iy) << INCG_ISECT_CBITS ) | (unsigned long) iz;
+}
+
+
+//
+// Function to find the pairs of intersecting faces (triangles and quads, as
+// with incg_MeshFile_WriteFaces()) of a set of vertices with coordinates "x".
+// The broad phase sorts the cells of a uniform grid that the boxes of the
+// faces span (by a radix sort of their keys) and tests the boxes of every
+// cell against each other as vectors; a pair is kept only in the cell of the
+// low corner of the overlap of its boxes, so that it is tested once. Cells
+// are shared among threads, and pairs of faces that share no vertex are
+// tested by the signs of determinants, which are exact (adaptive predicates);
+// quads are taken as two triangles across their shorter diagonal. The arrays of the
+// incoming object are allocated and the pairs are sorted, so the result does
+// not depend on the number of threads.
+//
+
+int incg_Isect_Faces( long int nv, const double* x,
+                      long int nf, const long int* faces,
+                      struct incg_isect_s* is )
+{
+   struct incg_isect_grid_s g;
+   struct incg_isect_buf_s *buf=NULL;
+   unsigned long *key=NULL;
+   long int *ofs=NULL, *val=NULL, nc, maxrun=0, npair, i;
+   int nthr=1, k, ierr=0;
+
+
+   if( nv <= 0 || nf <= 0 ) return 1;
+   if( x == NULL || faces == NULL || is == NULL ) return 2;
+
+   memset( is, 0, sizeof(struct incg_isect_s) );
+   memset( &g, 0, sizeof(struct incg_isect_grid_s) );
+#ifdef _OPENMP
+   nthr = omp_get_max_threads();
+#endif
+
+   ierr = incg_Isect_Grid( x, nf, faces, &g );
+   if( ierr ) goto cleanup;
+
+   // the cells of every face, counted and listed
+   ofs = (long int *) malloc( ((size_t) (nf+1)) * sizeof( long int ) );
+   buf = (struct incg_isect_buf_s *)
+         calloc( (size_t) nthr, sizeof(struct incg_isect_buf_s) );
+   if( ofs == NULL || buf == NULL ) {
+      ierr = -1;
+      goto cleanup;
+   }
+#pragma omp parallel for
+   for(i=0;i<nf;++i) {
+      int l;
+
+      ofs[i] = 1;
+      for(l=0;l<3;++l) {
+         ofs[i] *= incg_Isect_Cell( &g, l, g.hi[l][i] ) -
+                   incg_Isect_Cell( &g, l, g.lo[l][i] ) + 1;
+      }
+   }
+   nc = incg_Sort_ScanExclusive( nf, ofs );
+   ofs[nf] = nc;
+
+   key = (unsigned long *) malloc( ((size_t) nc) * sizeof( unsigned long ) );
+   val = (long int *) malloc( ((size_t) nc) * sizeof( long int ) );
+   if( key == NULL || val == NULL ) {
+      ierr = -1;
+      goto cleanup;
+   }
+#pragma omp parallel for
+   for(i=0;i<nf;++i) {
+      long int c0[3], c1[3], ix,iy,iz, j = ofs[i];
+      int l;
+
+      for(l=0;l<3;++l) {
+         c0[l] = incg_Isect_Cell( &g, l, g.lo[l][i] );
+         c1[l] = incg_Isect_Cell( &g, l, g.hi[l][i] );
+      }
+      for(ix=c0[0];ix<=c1[0];++ix) {
+         for(iy=c0[1];iy<=c1[1];++iy) {
+            for(iz=c0[2];iz<=c1[2];++iz) {
+               key[j] = incg_Isect_Key( ix, iy, iz );
+               val[j] = i;
+               ++j;
+            }
+         }
+      }
+   }
+   ierr = incg_Sort_RadixKeys( nc, key, val, 3*INCG_ISECT_CBITS );
+   if( ierr ) goto cleanup;
+
+   for(i=0;i<nc;) {
+      long int j = i+1;
+      while( j < nc && key[j] == key[i] ) ++j;
+      if( j - i > maxrun ) maxrun = j - i;
+      i = j;
+   }
+
+   // the faces of every cell, against each other
+#pragma omp parallel
+{  struct incg_isect_buf_s *b;
+   double *lo[3], *hi[3];
+   double *hit;
+   int it=0, l;
+
+#ifdef _OPENMP
+   it = omp_get_thread_num();
+#endif
+   b = &( buf[it] );
+   hit = (double *) malloc( ((size_t) maxrun) * sizeof( double ) );
+   for(l=0;l<3;++l) {
+      lo[l] = (double *) malloc( ((size_t) maxrun) * sizeof( double ) );
+      hi[l] = (double *) malloc( ((size_t) maxrun) * sizeof( double ) );
+   }
+   if( hit == NULL || lo[0] == NULL || lo[1] == NULL || lo[2] == NULL ||
+       hi[0] == NULL || hi[1] == NULL || hi[2] == NULL ) {
+#pragma omp atomic write
+      ierr = -1;
+   }
+#pragma omp barrier
+
+#pragma omp for schedule(dynamic,256)
+   for(i=0;i<nc;++i) {
+      long int n, ia, ib, c[3];
+
+      if( ierr || ( i > 0 && key[i] == key[i-1] ) ) continue;
+      for(n=1;i+n<nc && key[i+n] == key[i];++n);
+      if( n < 2 ) continue;
+
+      c[0] = (long int) ( key[i] >> (2*INCG_ISECT_CBITS) );
+      c[1] = (long int) ( ( key[i] >> INCG_ISECT_CBITS ) &
+                          ( (1UL << INCG_ISECT_CBITS) - 1 ) );
+      c[2] = (long int) ( key[i] & ( (1UL << INCG_ISECT_CBITS) - 1 ) );
+      for(ia=0;ia<n;++ia) {
+         for(l=0;l<3;++l) {
+            lo[l][ia] = g.lo[l][ val[i+ia] ];
+            hi[l][ia] = g.hi[l][ val[i+ia] ];
+         }
+      }
+
+      for(ia=0;ia<n-1;++ia) {
+         const double alx = lo[0][ia], aly = lo[1][ia], alz = lo[2][ia];
+         const double ahx = hi[0][ia], ahy = hi[1][ia], ahz = hi[2][ia];
+
+         // (flags of doubles, which are selected by the vector compares)
+#pragma omp simd
+         for(ib=ia+1;ib<n;++ib) {
+            hit[ib] = ( ( lo[0][ib] <= ahx ) & ( hi[0][ib] >= alx ) &
+                        ( lo[1][ib] <= ahy ) & ( hi[1][ib] >= aly ) &
+                        ( lo[2][ib] <= ahz ) & ( hi[2][ib] >= alz ) ) ?
+                      1.0 : 0.0;
+         }
+         for(ib=ia+1;ib<n;++ib) {
+            long int fa = val[i+ia], fb = val[i+ib];
+
+            if( hit[ib] == 0.0 ) continue;
+            if( incg_Isect_Cell( &g, 0, alx > lo[0][ib] ? alx : lo[0][ib] )
+                != c[0] ||
+                incg_Isect_Cell( &g, 1, aly > lo[1][ib] ? aly : lo[1][ib] )
+                != c[1] ||
+                incg_Isect_Cell( &g, 2, alz > lo[2][ib] ? alz : lo[2][ib] )
+                != c[2] ) continue;
+            if( incg_Isect_Shared( &( faces[4*fa] ), &( faces[4*fb] ) ) ) {
+               continue;
+            }
+            if( incg_Isect_FaceFace( &g, x, fa, fb ) ) {
+               if( incg_Isect_Push( b, fa, fb ) ) {
+#pragma omp atomic write
+                  ierr = -1;
+               }
+            }
+         }
+      }
+   }
+
+   if( hit != NULL ) free( hit );
+   for(l=0;l<3;++l) {
+      if( lo[l] != NULL ) free( lo[l] );
+      if( hi[l] != NULL ) free( hi[l] );
+   }
+}
+   if( ierr ) goto cleanup;
+
+   // the pairs of all threads, in order
+   npair = 0;
+   for(k=0;k<nthr;++k) npair += buf[k].n;
+   is->npair = npair;
+   if( npair == 0 ) goto cleanup;
+   is->pair = (long int *) malloc( ((size_t) (2*npair)) * sizeof( long int ) );
+   if( is->pair == NULL ) {
+      ierr = -1;
+      goto cleanup;
+   }
+   free( key );
+   free( val );
+   key = (unsigned long *) malloc( ((size_t) npair) * sizeof( unsigned long ) );
+   val = (long int *) malloc( ((size_t) npair) * sizeof( long int ) );
+   if( key == NULL || val == NULL ) {
+      ierr = -1;
+      goto cleanup;
+   }
+   npair = 0;
+   for(k=0;k<nthr;++k) {
+      for(i=0;i<buf[k].n;++i) {
+         key[npair] = (unsigned long) buf[k].pair[2*i] *
+                      (unsigned long) nf + (unsigned long) buf[k].pair[2*i+1];
+         val[npair] = npair;
+         ++npair;
+      }
+   }
+   ierr = incg_Sort_RadixKeys( npair, key, val,
+                 incg_Sort_NumBits( (unsigned long) nf*(unsigned long) nf ) );
+   if( ierr ) goto cleanup;
+#pragma omp parallel for
+   for(i=0;i<npair;++i) {
+      is->pair[2*i] = (long int) ( key[i]/(unsigned long) nf );
+      is->pair[2*i+1] = (long int) ( key[i]%(unsigned long) nf );
+   }
+
+cleanup:
+   if( buf != NULL ) {
+      for(k=0;k<nthr;++k) if( buf[k].pair != NULL ) free( buf[k].pair );
+      free( buf );
+   }
+   if( key != NULL ) free( key );
+   if( val != NULL ) free( val );
+   if( ofs != NULL ) free( ofs );
+   for(k=0;k<3;++k) {
+      if( g.lo[k] != NULL ) free( g.lo[k] );
+      if( g.hi[k] != NULL ) free( g.hi[k] );
+   }
+   if( g.tri != NULL ) free( g.tri );
+   if( ierr ) (void) incg_Isect_Free( is );
+
+   return ierr;
+}
+
+
+//
+// Function to find the pairs of intersecting triangles of a mesh object (see
+// incg_Isect_Faces())
+//
+
+int incg_Isect_Mesh( const mesh_t* m, struct incg_isect_s* is )
+{
+   double *x;
+   long int *faces, i;
+   int ierr;
+
+
+   if( m == NULL ) return 1;
+   if( m->nv == 0 || m->ne == 0 || m->nt == 0 ) return 2;
+
+   x = (double *) malloc( ((size_t) (3*m->nv)) * sizeof( double ) );
+   faces = (long int *) malloc( ((size_t) (4*m->nt)) * sizeof( long int ) );
+   if( x == NULL || faces == NULL ) {
+      if( x != NULL ) free( x );
+      if( faces != NULL ) free( faces );
+      return -1;
+   }
+
+#pragma omp parallel for
+   for(i=0;i<m->nv;++i) {
+      x[3*i+0] = m->v[i].x;
+      x[3*i+1] = m->v[i].y;
+      x[3*i+2] = m->v[i].z;
+   }
+#pragma omp parallel for
+   for(i=0;i<m->nt;++i) {
+      const triangle_t *t = &( m->t[i] );
+
+      faces[4*i+0] = ( t->d1 == 0 ? t->e1->va : t->e1->vb ) - m->v;
+      faces[4*i+1] = ( t->d2 == 0 ? t->e2->va : t->e2->vb ) - m->v;
+      faces[4*i+2] = ( t->d3 == 0 ? t->e3->va : t->e3->vb ) - m->v;
+      faces[4*i+3] = -1;
+   }
+
+   ierr = incg_Isect_Faces( m->nv, x, m->nt, faces, is );
+
+   free( x );
+   free( faces );
+
+   return ierr;
+}
+
+
+//
+// Function to release the memory of the pairs
+//
+
+int incg_Isect_Free( struct incg_isect_s* is )
+{
+   if( is == NULL ) return 1;
+
+   if( is->pair != NULL ) free( is->pair );
+   memset( is, 0, sizeof(struct incg_isect_s) );
+
+   return 0;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
@@ -0,0 +1,41 @@
+
+#ifndef _INCG_ISECT_H_
+#define _INCG_ISECT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "incg_mesh.h"
+
+//
+// Self-intersections of the surface of a mesh
+//
+
+// side of the cells of the broad phase over the mean extent of the faces
+#define INCG_ISECT_CELLFAC      1.0
+
+//
+// Pairs of faces that intersect, as pair[2*k] < pair[2*k+1] in ascending
+// order of the pairs; faces that share a vertex are not tested
+//
+struct incg_isect_s {
+   long int npair;
+   long int *pair;
+};
+
+// -------------------- function prototypes/signatures --------------------
+
+int incg_Isect_Mesh( const mesh_t* m, struct incg_isect_s* is );
+
+int incg_Isect_Faces( long int nv, const double* x,
+                      long int nf, const long int* faces,
+                      struct incg_isect_s* is );
+
+int incg_Isect_Free( struct incg_isect_s* is );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
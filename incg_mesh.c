@@ -4,11 +4,18 @@
 #include <unistd.h>
 #include <math.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 #include "incg_mesh.h"
+#include "incg_utils.h"
+#include "incg_sort.h"
+#include "incg_meshio.h"
 
 //
 // Function that takes a pointer to a mesh object and fills its internals
@@ -66,28 +73,8 @@ int incg_MakeMesh_OneTriangle( mesh_t* m )
    m->e = e;
    m->t = t;
 #ifdef _DEBUG_
-{  FILE *fp = fopen( "TRIANGLE.dat", "w");
-   fprintf( fp, "TITLE = \"Single triangle\" \n");
-   fprintf( fp, "VARIABLES = x y z \n");
-   fprintf( fp, "ZONE NODES=%ld, ELEMENTS=%ld \n", m->nv, m->nt );
-   fprintf( fp, "     ZONETYPE=FETRIANGLE, DATAPACKING=POINT \n");
-   for(i=0;i<(int) m->nv;++i) {
-      fprintf( fp, " %16.9e %16.9e %16.9e \n",
-                   m->v[i].x, m->v[i].y, m->v[i].z );
-   }
-   for(i=0;i<(int) m->nt;++i) {
-      if( t[i].d1 == 0 ) {
-         fprintf( fp, " %ld", t[i].e1->va->id +1 );
-      } else { fprintf( fp, " %ld", t[i].e1->vb->id +1 ); }
-      if( t[i].d2 == 0 ) {
-         fprintf( fp, " %ld", t[i].e2->va->id +1 );
-      } else { fprintf( fp, " %ld", t[i].e2->vb->id +1 ); }
-      if( t[i].d3 == 0 ) {
-         fprintf( fp, " %ld", t[i].e3->va->id +1 );
-      } else { fprintf( fp, " %ld", t[i].e3->vb->id +1 ); }
-      fprintf( fp, "\n");
-   }
-   fclose( fp ); }
+   (void) incg_MeshFile_Plot( m, INCG_PLOT_TECPLOT,
+                              "Single triangle", "TRIANGLE.dat" );
 #endif
    return 0;
 }
@@ -159,28 +146,8 @@ int incg_MakeMesh_TwoTriangles( mesh_t* m )
    m->e = e;
    m->t = t;
 #ifdef _DEBUG_
-{  FILE *fp = fopen( "TRIANGLES.dat", "w");
-   fprintf( fp, "TITLE = \"Two triangles\" \n");
-   fprintf( fp, "VARIABLES = x y z \n");
-   fprintf( fp, "ZONE NODES=%ld, ELEMENTS=%ld \n", m->nv, m->nt );
-   fprintf( fp, "     ZONETYPE=FETRIANGLE, DATAPACKING=POINT \n");
-   for(i=0;i<(int) m->nv;++i) {
-      fprintf( fp, " %16.9e %16.9e %16.9e \n",
-                   m->v[i].x, m->v[i].y, m->v[i].z );
-   }
-   for(i=0;i<(int) m->nt;++i) {
-      if( t[i].d1 == 0 ) {
-         fprintf( fp, " %ld", t[i].e1->va->id +1 );
-      } else { fprintf( fp, " %ld", t[i].e1->vb->id +1 ); }
-      if( t[i].d2 == 0 ) {
-         fprintf( fp, " %ld", t[i].e2->va->id +1 );
-      } else { fprintf( fp, " %ld", t[i].e2->vb->id +1 ); }
-      if( t[i].d3 == 0 ) {
-         fprintf( fp, " %ld", t[i].e3->va->id +1 );
-      } else { fprintf( fp, " %ld", t[i].e3->vb->id +1 ); }
-      fprintf( fp, "\n");
-   }
-   fclose( fp ); }
+   (void) incg_MeshFile_Plot( m, INCG_PLOT_TECPLOT,
+                              "Two triangles", "TRIANGLES.dat" );
 #endif
    return 0;
 }
@@ -345,80 +312,126 @@ int incg_MakeMesh_Cube( mesh_t* m )
    m->e = e;
    m->t = t;
 #ifdef _DEBUG_
-{  FILE *fp = fopen( "CUBE.dat", "w");
-   fprintf( fp, "TITLE = \"CUBE made of triangles\" \n");
-   fprintf( fp, "VARIABLES = x y z \n");
-   fprintf( fp, "ZONE NODES=%ld, ELEMENTS=%ld \n", m->nv, m->nt );
-   fprintf( fp, "     ZONETYPE=FETRIANGLE, DATAPACKING=POINT \n");
-   for(i=0;i<(int) m->nv;++i) {
-      fprintf( fp, " %16.9e %16.9e %16.9e \n",
-                   m->v[i].x, m->v[i].y, m->v[i].z );
-   }
-   for(i=0;i<(int) m->nt;++i) {
-      if( t[i].d1 == 0 ) {
-         fprintf( fp, " %ld", t[i].e1->va->id +1 );
-      } else { fprintf( fp, " %ld", t[i].e1->vb->id +1 ); }
-      if( t[i].d2 == 0 ) {
-         fprintf( fp, " %ld", t[i].e2->va->id +1 );
-      } else { fprintf( fp, " %ld", t[i].e2->vb->id +1 ); }
-      if( t[i].d3 == 0 ) {
-         fprintf( fp, " %ld", t[i].e3->va->id +1 );
-      } else { fprintf( fp, " %ld", t[i].e3->vb->id +1 ); }
-      fprintf( fp, "\n");
-   }
-
-   fclose( fp ); }
+   (void) incg_MeshFile_Plot( m, INCG_PLOT_TECPLOT,
+                              "CUBE made of triangles", "CUBE.dat" );
 #endif
    return 0;
 }
 
 
 //
-// Function that takes a pointer to a mesh object and performs uniform
-// subdivision of all its triangles by spliting all edges, resulting in four
-// times the number of triangles. (The function preserves node sharing of
-// triangles that have a common edge.)
+// Function to return the index of a vertex of a triangle (0,1,2) by following
+// the direction of its edges in the triangle's loop
 //
 
-int incg_RefineMesh_Uniform( mesh_t* m )
+static long int incg_Mesh_TriVertex( const triangle_t* t, int k )
 {
-   vertex_t *v;
-   edge_t *e;
-   triangle_t *t;
-   long int nt,ne,nv,i;
-   long int nt2,ne2,nv2;
+   const edge_t *e;
+   char d;
+
+   if( k == 0 ) {
+      e = t->e1; d = t->d1;
+   } else if( k == 1 ) {
+      e = t->e2; d = t->d2;
+   } else {
+      e = t->e3; d = t->d3;
+   }
 
+   if( d == 0 ) return e->va->id;
+   return e->vb->id;
+}
+
+
+//
+// Function to return the index of the vertex of a triangle that is opposite
+// one of its edges
+//
+
+static long int incg_Mesh_TriOpposite( const triangle_t* t, const edge_t* e )
+{
+   if( t->e1 == e ) return incg_Mesh_TriVertex( t, 2 );
+   if( t->e2 == e ) return incg_Mesh_TriVertex( t, 0 );
+   return incg_Mesh_TriVertex( t, 1 );
+}
+
+
+//
+// Internal options for placing the vertices made by a uniform refinement
+//
+
+#define INCG_REFINE_MIDPOINT   0
+#define INCG_REFINE_SPHERE     1
+#define INCG_REFINE_LOOP       2
+
+struct incg_refine_s {
+   int imode;             // placement of new vertices (one of the above)
+   double xc[3],r;        // centre and radius of a sphere for projection
+   long int *vring;       // Loop: scratch lists of the edges of the vertices
+                          // (offsets, cursors and ends; see the kernel)
+};
+
+
+//
+// Function to project a vertex radially on the sphere of the options
+//
+
+static void incg_RefineMesh_ProjectSphere( const struct incg_refine_s* opt,
+                                           vertex_t* v )
+{
+   double dx = v->x - opt->xc[0];
+   double dy = v->y - opt->xc[1];
+   double dz = v->z - opt->xc[2];
+   double s = opt->r / sqrt( dx*dx + dy*dy + dz*dz );
+
+   v->x = opt->xc[0] + s*dx;
+   v->y = opt->xc[1] + s*dy;
+   v->z = opt->xc[2] + s*dz;
+}
+
+
+//
+// Function that forms the uniform subdivision of the mesh object in the
+// arrays provided, which must have room for the new vertices, edges and
+// triangles (the incoming mesh is not modified). The vertices, edges and
+// triangles are each swept in parallel.
+// In the Loop mode the smoothed positions are formed during the same sweeps:
+// the "odd" vertices from the edge's vertices and the two opposite vertices,
+// and the "even" vertices from their neighbours. The edge sweep counts the
+// edges of every incoming vertex, and the edges are then listed per vertex
+// in the scratch array of the options (offsets, cursors, and the ends of the
+// edges as 2*edge+side) and put in ascending order, so that every vertex sums
+// its neighbours in the same order for any number of threads.
+//
+
+static int incg_RefineMesh_Kernel( const mesh_t* m,
+                                   vertex_t* v, edge_t* e, triangle_t* t,
+                                   const struct incg_refine_s* opt )
+{
+   long int nt,ne,nv,i;
+   long int *vofs=NULL, *vcur=NULL, *vend=NULL;
 
-   if( m == NULL ) return 1;
-   if( m->nv == 0 || m->ne == 0 || m->nt == 0 ) return 2;
 
    nv = m->nv;
    ne = m->ne;
    nt = m->nt;
 
-   // counts of new entities
-   nv2 = nv + ne;         // old plus a new vertex at each old edge's midpoint
-   ne2 = ne*2 + 3*nt;     // split edges and three edges inside a triangle
-   nt2 = 4*nt;            // each triangle is split into four
-
-   // allocate new structures
-   v = (vertex_t *)  malloc( ((size_t) nv2) * sizeof( vertex_t ) );
-   e = (edge_t *)    malloc( ((size_t) ne2) * sizeof( edge_t ) );
-   t = (triangle_t*) malloc( ((size_t) nt2) * sizeof( triangle_t ) );
-   if( v == NULL || e == NULL || t == NULL ) {
-      if( t != NULL ) free( t );
-      if( e != NULL ) free( e );
-      if( v != NULL ) free( v );
-      return -1;
-   }
-
    // copy the first batch of vertices
+#pragma omp parallel for
    for(i=0;i<nv;++i) {
       memcpy( &( v[i] ), &( m->v[i] ), sizeof( vertex_t ) );
    }
+   if( opt->imode == INCG_REFINE_LOOP ) {
+      vofs = opt->vring;
+      vcur = &( vofs[nv+1] );
+      vend = &( vcur[nv] );
+#pragma omp parallel for
+      for(i=0;i<=nv;++i) vofs[i] = 0;
+   }
    // In one sweep over edges...
    // 1. create new vertices (by sweeping over edges and splitting)
    // 2. create new edges (by splitting parent edges)
+   // (Every edge writes only to its own vertex and pair of edges.)
+#pragma omp parallel for
    for(i=0;i<ne;++i) {
       long int iv = nv + m->e[i].id;    // set index by order of parent edges
       long int ie = m->e[i].id * 2;     // index of (first) subdiv. edges
@@ -430,6 +443,27 @@ int incg_RefineMesh_Uniform( mesh_t* m )
       mpv->x = ( m->e[i].va->x + m->e[i].vb->x )*0.5;
       mpv->y = ( m->e[i].va->y + m->e[i].vb->y )*0.5;
       mpv->z = ( m->e[i].va->z + m->e[i].vb->z )*0.5;
+      if( opt->imode == INCG_REFINE_SPHERE ) {
+         incg_RefineMesh_ProjectSphere( opt, mpv );
+      } else if( opt->imode == INCG_REFINE_LOOP ) {
+         const vertex_t *va = m->e[i].va, *vb = m->e[i].vb;
+
+         if( m->e[i].tl != NULL && m->e[i].tr != NULL ) {
+            // interior edge: 3/8 of its vertices and 1/8 of the opposite ones
+            const vertex_t *vc, *vd;
+            vc = &( m->v[ incg_Mesh_TriOpposite( m->e[i].tl, &( m->e[i] ) ) ] );
+            vd = &( m->v[ incg_Mesh_TriOpposite( m->e[i].tr, &( m->e[i] ) ) ] );
+
+            mpv->x = 0.375*( va->x + vb->x ) + 0.125*( vc->x + vd->x );
+            mpv->y = 0.375*( va->y + vb->y ) + 0.125*( vc->y + vd->y );
+            mpv->z = 0.375*( va->z + vb->z ) + 0.125*( vc->z + vd->z );
+         }
+         // (a boundary edge keeps its midpoint)
+#pragma omp atomic
+         vofs[ va->id ] += 1;
+#pragma omp atomic
+         vofs[ vb->id ] += 1;
+      }
 
       ea->id = ie + 0;                   // id derived from parent edge index
       ea->va = &( v[ m->e[i].va->id ] ); // parent edge's vertex A (by index)
@@ -443,8 +477,69 @@ int incg_RefineMesh_Uniform( mesh_t* m )
       eb->tl = NULL;                     // edges made from splits need setting
       eb->tr = NULL;                     // edges made from splits need setting
    }
+   if( opt->imode == INCG_REFINE_LOOP ) {
+      // list the ends of the edges by vertex
+      (void) incg_Sort_ScanExclusive( nv+1, vofs );
+#pragma omp parallel for
+      for(i=0;i<nv;++i) vcur[i] = vofs[i];
+#pragma omp parallel for
+      for(i=0;i<ne;++i) {
+         long int ja,jb;
+
+#pragma omp atomic capture
+         ja = vcur[ m->e[i].va->id ]++;
+#pragma omp atomic capture
+         jb = vcur[ m->e[i].vb->id ]++;
+         vend[ja] = 2*i;
+         vend[jb] = 2*i + 1;
+      }
+
+      // smoothed positions of the incoming ("even") vertices
+#pragma omp parallel for schedule(dynamic,1024)
+      for(i=0;i<nv;++i) {
+         const vertex_t *vo = &( m->v[i] );
+         double w[8] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+         long int j,l;
+
+         // (the edges of a vertex are few: insertion sort)
+         for(j=vofs[i]+1;j<vofs[i+1];++j) {
+            long int k = vend[j];
+
+            for(l=j;l>vofs[i] && vend[l-1]>k;--l) vend[l] = vend[l-1];
+            vend[l] = k;
+         }
+
+         // sums of the interior-edge neighbours and their count, followed by
+         // those of the boundary-edge neighbours
+         for(j=vofs[i];j<vofs[i+1];++j) {
+            const edge_t *ep = &( m->e[ vend[j]/2 ] );
+            const vertex_t *vn = vend[j]%2 == 0 ? ep->vb : ep->va;
+            double *ws = ( ep->tl != NULL && ep->tr != NULL ) ? w : &( w[4] );
+
+            ws[0] += vn->x;
+            ws[1] += vn->y;
+            ws[2] += vn->z;
+            ws[3] += 1.0;
+         }
+
+         if( w[7] == 2.0 ) {
+            // boundary vertex: 3/4 of itself and 1/8 of its boundary neighbours
+            v[i].x = 0.75*vo->x + 0.125*w[4];
+            v[i].y = 0.75*vo->y + 0.125*w[5];
+            v[i].z = 0.75*vo->z + 0.125*w[6];
+         } else if( w[7] == 0.0 && w[3] > 0.0 ) {
+            // interior vertex: Loop's weights for its valence
+            double c = 0.375 + 0.25*cos( 2.0*M_PI/w[3] );
+            double b = ( 0.625 - c*c )/w[3];
+            v[i].x = ( 1.0 - w[3]*b )*vo->x + b*w[0];
+            v[i].y = ( 1.0 - w[3]*b )*vo->y + b*w[1];
+            v[i].z = ( 1.0 - w[3]*b )*vo->z + b*w[2];
+         }
+         // (corners of non-manifold boundaries are kept in place)
+      }
+   }
 #ifdef _DEBUG_
-   for(i=0;i<(int) nt2;++i) {
+   for(i=0;i<(int) (4*nt);++i) {
       t[i].d1 = 3; t[i].d2 = 3; t[i].d3 = 3;
       t[i].e1 = NULL; t[i].e2 = NULL; t[i].e3 = NULL;
    }
@@ -456,6 +551,8 @@ int incg_RefineMesh_Uniform( mesh_t* m )
    //     / __ \     Edges for triangles 3 & 4 formed as for triangle 1.
    //    /1\4 /2\    Parent triangle egdes are: bottom = 1, right = 2,...
    //   /___\/___\   (bad comments0
+   // (A split edge's "left" and "right" sides are set by different parents.)
+#pragma omp parallel for
    for(i=0;i<nt;++i) {
       triangle_t *tp = &( m->t[i] );     // parent triangle
       edge_t *ea=NULL, *eb=NULL;         // new edges that subdvd. a parent edge
@@ -630,60 +727,656 @@ int incg_RefineMesh_Uniform( mesh_t* m )
       e2->vb = ea->vb;     // "ray" pointing to node
       e3->va = ea->vb;     // "ray" leaving node
    }
+
+   return 0;
+}
+
+
+//
+// Function that computes the counts of entities of a mesh after a number of
+// uniform refinements
+//
+
+static void incg_RefineMesh_Counts( long int nv, long int ne, long int nt,
+                                    int nlev,
+                                    long int *nv2, long int *ne2,
+                                    long int *nt2 )
+{
+   int n;
+
+   for(n=0;n<nlev;++n) {
+      nv = nv + ne;
+      ne = ne*2 + 3*nt;
+      nt = 4*nt;
+   }
+
+   *nv2 = nv;
+   *ne2 = ne;
+   *nt2 = nt;
+}
+
+
+//
+// Function that forms the uniform subdivision of a mesh object in a new mesh
+// object, whose arrays are allocated; the incoming mesh is kept as it is. The
+// entities of the two meshes are related by their indices: triangle i is
+// split into triangles 4*i+k, edge i into edges 2*i+0 and 2*i+1, and edge i
+// makes vertex nv+i, while the incoming vertices keep their indices.
+//
+
+int incg_RefineMesh_UniformInto( const mesh_t* m, mesh_t* mf )
+{
+   vertex_t *v;
+   edge_t *e;
+   triangle_t *t;
+   long int nt,ne,nv;
+   long int nt2,ne2,nv2;
+   struct incg_refine_s opt = { INCG_REFINE_MIDPOINT,
+                                { 0.0, 0.0, 0.0 }, 0.0, NULL };
+
+
+   if( m == NULL || mf == NULL ) return 1;
+   if( m->nv == 0 || m->ne == 0 || m->nt == 0 ) return 2;
+
+   nv = m->nv;
+   ne = m->ne;
+   nt = m->nt;
+
+   // counts of new entities
+   nv2 = nv + ne;         // old plus a new vertex at each old edge's midpoint
+   ne2 = ne*2 + 3*nt;     // split edges and three edges inside a triangle
+   nt2 = 4*nt;            // each triangle is split into four
+
+   // allocate new structures
+   v = (vertex_t *)  malloc( ((size_t) nv2) * sizeof( vertex_t ) );
+   e = (edge_t *)    malloc( ((size_t) ne2) * sizeof( edge_t ) );
+   t = (triangle_t*) malloc( ((size_t) nt2) * sizeof( triangle_t ) );
+   if( v == NULL || e == NULL || t == NULL ) {
+      if( t != NULL ) free( t );
+      if( e != NULL ) free( e );
+      if( v != NULL ) free( v );
+      return -1;
+   }
+
+   (void) incg_RefineMesh_Kernel( m, v, e, t, &opt );
+
 #ifdef _DEBUG_
-{  FILE *fp = fopen( "NEW_EDGES.dat", "w");
-   fprintf( fp, "TITLE = \"Edges of parent triangles after split\" \n");
-   fprintf( fp, "VARIABLES = x y z \n");
-   fprintf( fp, "ZONE T=\"edges\", NODES=%ld, ELEMENTS=%ld \n", nv2, ne2 );
-   fprintf( fp, "     ZONETYPE=FELINESEG, DATAPACKING=POINT \n");
-   for(i=0;i<(int) nv2;++i) {
-      fprintf( fp, " %16.9e %16.9e %16.9e \n",
-                   v[i].x, v[i].y, v[i].z );
-   }
-   for(i=0;i<(int) ne2;++i) {
-      fprintf( fp, " %ld %ld \n", e[i].va->id +1, e[i].vb->id +1 );
-   }
-   fprintf( fp, "ZONE T=\"triangles\", NODES=%ld, ELEMENTS=%ld \n", nv2, nt2 );
-   fprintf( fp, "     ZONETYPE=FETRIANGLE, DATAPACKING=POINT \n");
-   for(i=0;i<(int) nv2;++i) {
-      fprintf( fp, " %16.9e %16.9e %16.9e \n",
-                   v[i].x, v[i].y, v[i].z );
-   }
-   for(i=0;i<(int) nt2;++i) {
-      if( t[i].d1 == 0 ) {
-         fprintf( fp, " %ld ", t[i].e1->va->id +1 );
-      } else {
-         fprintf( fp, " %ld ", t[i].e1->vb->id +1 );
+{  mesh_t mn = { nv2, ne2, nt2, v, e, t };
+   (void) incg_MeshFile_Plot( &mn, INCG_PLOT_TECPLOT,
+                              "Triangles after split", "NEW_EDGES.dat" ); }
+#endif
+
+   mf->v = v;
+   mf->nv = nv2;
+   mf->e = e;
+   mf->ne = ne2;
+   mf->t = t;
+   mf->nt = nt2;
+
+   return 0;
+}
+
+
+//
+// Function that takes a pointer to a mesh object and performs uniform
+// subdivision of all its triangles by spliting all edges, resulting in four
+// times the number of triangles. (The function preserves node sharing of
+// triangles that have a common edge.)
+//
+
+int incg_RefineMesh_Uniform( mesh_t* m )
+{
+   mesh_t mf;
+   int ierr;
+
+
+   ierr = incg_RefineMesh_UniformInto( m, &mf );
+   if( ierr ) return ierr;
+
+   // release memory from incoming mesh object and re-assign
+   free( m->v );
+   free( m->e );
+   free( m->t );
+   *m = mf;
+
+   return 0;
+}
+
+
+
+//
+// Function that performs a number of successive uniform refinements of a mesh
+// object. The memory of all levels is planned ahead: the final level and the
+// level before it are each given a single allocation of their final size and
+// the levels alternate between the two, such that no intermediate level is
+// allocated and released. The arrays of the incoming mesh are released.
+//
+
+static int incg_RefineMesh_Multilevel( mesh_t* m, int nlev,
+                                       const struct incg_refine_s* opt )
+{
+   mesh_t buf[2], src;
+   struct incg_refine_s lopt = *opt;
+   int n,ib;
+
+
+   if( m == NULL ) return 1;
+   if( m->nv == 0 || m->ne == 0 || m->nt == 0 ) return 2;
+   if( nlev < 0 ) return 3;
+   if( nlev == 0 ) return 0;
+
+   // buffer 0 holds the final level and buffer 1 holds the level before it
+   memset( buf, 0, 2*sizeof(mesh_t) );
+   for(ib=0;ib<2 && nlev-ib>0;++ib) {
+      long int nv2,ne2,nt2;
+
+      incg_RefineMesh_Counts( m->nv, m->ne, m->nt, nlev-ib, &nv2, &ne2, &nt2 );
+      buf[ib].v = (vertex_t *)  malloc( ((size_t) nv2) * sizeof( vertex_t ) );
+      buf[ib].e = (edge_t *)    malloc( ((size_t) ne2) * sizeof( edge_t ) );
+      buf[ib].t = (triangle_t*) malloc( ((size_t) nt2) * sizeof( triangle_t ) );
+      if( buf[ib].v == NULL || buf[ib].e == NULL || buf[ib].t == NULL ) {
+         for(n=0;n<=ib;++n) {
+            if( buf[n].t != NULL ) free( buf[n].t );
+            if( buf[n].e != NULL ) free( buf[n].e );
+            if( buf[n].v != NULL ) free( buf[n].v );
+         }
+         return -1;
       }
-      if( t[i].d2 == 0 ) {
-         fprintf( fp, " %ld ", t[i].e2->va->id +1 );
-      } else {
-         fprintf( fp, " %ld ", t[i].e2->vb->id +1 );
+   }
+
+   // Loop's lists of edges are kept for the largest incoming level
+   if( lopt.imode == INCG_REFINE_LOOP ) {
+      long int nv2,ne2,nt2;
+
+      incg_RefineMesh_Counts( m->nv, m->ne, m->nt, nlev-1, &nv2, &ne2, &nt2 );
+      lopt.vring = (long int *) malloc( ((size_t) (2*nv2+1 + 2*ne2)) *
+                                        sizeof( long int ) );
+      if( lopt.vring == NULL ) {
+         for(n=0;n<2;++n) {
+            if( buf[n].t != NULL ) free( buf[n].t );
+            if( buf[n].e != NULL ) free( buf[n].e );
+            if( buf[n].v != NULL ) free( buf[n].v );
+         }
+         return -1;
       }
-      if( t[i].d3 == 0 ) {
-         fprintf( fp, " %ld ", t[i].e3->va->id +1 );
+   }
+
+   // levels of the same parity as the final level are formed in buffer 0
+   src = *m;
+   for(n=1;n<=nlev;++n) {
+      mesh_t *dst = &( buf[ (nlev-n) % 2 ] );
+
+      incg_RefineMesh_Counts( src.nv, src.ne, src.nt, 1,
+                              &( dst->nv ), &( dst->ne ), &( dst->nt ) );
+      (void) incg_RefineMesh_Kernel( &src, dst->v, dst->e, dst->t, &lopt );
+
+      if( n == 1 ) {
+         free( m->v );
+         free( m->e );
+         free( m->t );
+      }
+      src = *dst;
+   }
+
+   if( buf[1].t != NULL ) free( buf[1].t );
+   if( buf[1].e != NULL ) free( buf[1].e );
+   if( buf[1].v != NULL ) free( buf[1].v );
+   if( lopt.vring != NULL ) free( lopt.vring );
+
+   *m = buf[0];
+
+   return 0;
+}
+
+
+//
+// Function that takes a pointer to a mesh object and performs a number of
+// successive uniform subdivisions of all its triangles. (The outcome is that
+// of as many calls to incg_RefineMesh_Uniform(), but with a single
+// allocation per level in the end.)
+//
+
+int incg_RefineMesh_UniformLevels( mesh_t* m, int nlev )
+{
+   struct incg_refine_s opt = { INCG_REFINE_MIDPOINT,
+                                { 0.0, 0.0, 0.0 }, 0.0, NULL };
+
+   return incg_RefineMesh_Multilevel( m, nlev, &opt );
+}
+
+
+//
+// Function that takes a pointer to a mesh object and performs a number of
+// successive Loop subdivisions; the topology is that of the uniform
+// refinement, and the vertices take their smoothed positions as they are
+// made. Edges without a triangle on one side form boundary curves, which are
+// refined on their own with the cubic B-spline rules of the Loop scheme.
+//
+
+int incg_RefineMesh_Loop( mesh_t* m, int nlev )
+{
+   struct incg_refine_s opt = { INCG_REFINE_LOOP,
+                                { 0.0, 0.0, 0.0 }, 0.0, NULL };
+
+   return incg_RefineMesh_Multilevel( m, nlev, &opt );
+}
+
+
+//
+// Function to form a mesh object of a (small) polyhedron given its vertices
+// and the vertex triplets of its triangles. Triangles are oriented such that
+// their normals point away from the origin.
+//
+
+static int incg_MakeMesh_Polyhedron( mesh_t* m,
+                                     int nv, const double xv[][3],
+                                     int nt, const int iv[][3] )
+{
+   struct ingeom_tris_s tris;
+   int icon[20*3];
+   int i,k;
+
+
+   for(i=0;i<nt;++i) {
+      double dx1[3],dx2[3],xn[3];
+
+      for(k=0;k<3;++k) {
+         dx1[k] = xv[iv[i][1]][k] - xv[iv[i][0]][k];
+         dx2[k] = xv[iv[i][2]][k] - xv[iv[i][0]][k];
+      }
+      incg_Vec_CrossProduct( dx1, dx2, xn );
+      icon[3*i+0] = iv[i][0];
+      if( incg_Vec_DotProduct( xn, xv[iv[i][0]] ) < 0.0 ) {
+         icon[3*i+1] = iv[i][2];
+         icon[3*i+2] = iv[i][1];
       } else {
-         fprintf( fp, " %ld ", t[i].e3->vb->id +1 );
+         icon[3*i+1] = iv[i][1];
+         icon[3*i+2] = iv[i][2];
       }
-      fprintf( fp, "\n" );
    }
-   fclose( fp ); }
+
+   tris.np = nv;
+   tris.nt = nt;
+   tris.icon = icon;
+   tris.x = (double *) xv;
+
+   return incg_MakeMesh_FromTris( m, &tris, NULL, NULL );
+}
+
+
+//
+// Function that generates a triangulated sphere by uniform refinement of a
+// base polyhedron (octahedron or icosahedron) "ns" times, with every new
+// vertex projected on the sphere as it is made. The caller sets "ns" and the
+// frame of the sphere in the object "s": x0 is the centre and x1,x2 are tips
+// of the first two axes; x1 sets the radius, x2 is only used for its
+// direction and x3 is set on return to complete a right-handed frame. (When x1
+// coincides with x0 a unit sphere aligned with the Cartesian axes is made.)
+// The arrays of vertex coordinates and connectivity (base-0) of "s" are
+// allocated and filled. The mesh object is filled when it is not null.
+//
+
+int incg_MakeMesh_Sphere( mesh_t* m, struct ingeom_sphere_s* s, int itype )
+{
+   const double f = 0.5*( 1.0 + sqrt( 5.0 ) );
+   const double xoct[6][3] = {
+      {  1.0, 0.0, 0.0 }, { -1.0, 0.0, 0.0 },
+      {  0.0, 1.0, 0.0 }, {  0.0,-1.0, 0.0 },
+      {  0.0, 0.0, 1.0 }, {  0.0, 0.0,-1.0 } };
+   const int ioct[8][3] = {
+      { 4, 0, 2 }, { 4, 2, 1 }, { 4, 1, 3 }, { 4, 3, 0 },
+      { 5, 2, 0 }, { 5, 1, 2 }, { 5, 3, 1 }, { 5, 0, 3 } };
+   const double xico[12][3] = {
+      { -1.0,    f, 0.0 }, {  1.0,    f, 0.0 },
+      { -1.0,   -f, 0.0 }, {  1.0,   -f, 0.0 },
+      {  0.0, -1.0,   f }, {  0.0,  1.0,   f },
+      {  0.0, -1.0,  -f }, {  0.0,  1.0,  -f },
+      {    f,  0.0,-1.0 }, {    f,  0.0, 1.0 },
+      {   -f,  0.0,-1.0 }, {   -f,  0.0, 1.0 } };
+   const int iico[20][3] = {
+      { 0,11, 5 }, { 0, 5, 1 }, { 0, 1, 7 }, { 0, 7,10 }, { 0,10,11 },
+      { 1, 5, 9 }, { 5,11, 4 }, {11,10, 2 }, {10, 7, 6 }, { 7, 1, 8 },
+      { 3, 9, 4 }, { 3, 4, 2 }, { 3, 2, 6 }, { 3, 6, 8 }, { 3, 8, 9 },
+      { 4, 9, 5 }, { 2, 4,11 }, { 6, 2,10 }, { 8, 6, 7 }, { 9, 8, 1 } };
+   double xb[12][3], u[3][3], r;
+   struct incg_refine_s opt = { INCG_REFINE_SPHERE,
+                                { 0.0, 0.0, 0.0 }, 0.0, NULL };
+   mesh_t mm, *mp;
+   int nv,nt,i,k,ierr;
+   long int n;
+
+
+   if( s == NULL ) return 1;
+   if( s->ns < 0 ) return 2;
+   if( itype != INCG_SPHERE_OCTAHEDRON &&
+       itype != INCG_SPHERE_ICOSAHEDRON ) return 3;
+
+   // form the frame of the sphere
+   for(k=0;k<3;++k) u[0][k] = s->x1[k] - s->x0[k];
+   r = sqrt( incg_Vec_DotProduct( u[0], u[0] ) );
+   if( r == 0.0 ) {
+      r = 1.0;
+      for(i=0;i<3;++i) for(k=0;k<3;++k) u[i][k] = ( i == k ? 1.0 : 0.0 );
+   } else {
+      double t;
+
+      incg_Vec_Normalize3( u[0] );
+      for(k=0;k<3;++k) u[1][k] = s->x2[k] - s->x0[k];
+      t = incg_Vec_DotProduct( u[0], u[1] );
+      for(k=0;k<3;++k) u[1][k] -= t*u[0][k];
+      if( incg_Vec_DotProduct( u[1], u[1] ) <= 1.0e-24*r*r ) {
+         // pick any direction normal to the first axis
+         u[1][0] = 0.0; u[1][1] = 0.0; u[1][2] = 0.0;
+         k = 0;
+         if( fabs( u[0][1] ) < fabs( u[0][k] ) ) k = 1;
+         if( fabs( u[0][2] ) < fabs( u[0][k] ) ) k = 2;
+         u[1][k] = 1.0;
+         t = incg_Vec_DotProduct( u[0], u[1] );
+         for(k=0;k<3;++k) u[1][k] -= t*u[0][k];
+      }
+      incg_Vec_Normalize3( u[1] );
+   }
+   incg_Vec_CrossProduct( u[0], u[1], u[2] );
+   for(k=0;k<3;++k) {
+      s->x1[k] = s->x0[k] + r*u[0][k];
+      s->x2[k] = s->x0[k] + r*u[1][k];
+      s->x3[k] = s->x0[k] + r*u[2][k];
+   }
+
+   // place the base polyhedron on the sphere (centred at the origin)
+   if( itype == INCG_SPHERE_OCTAHEDRON ) {
+      nv = 6;
+      nt = 8;
+   } else {
+      nv = 12;
+      nt = 20;
+   }
+   for(i=0;i<nv;++i) {
+      double xl[3];
+
+      for(k=0;k<3;++k) {
+         if( itype == INCG_SPHERE_OCTAHEDRON ) xl[k] = xoct[i][k];
+         else xl[k] = xico[i][k];
+      }
+      incg_Vec_Normalize3( xl );
+      for(k=0;k<3;++k) {
+         xb[i][k] = r*( xl[0]*u[0][k] + xl[1]*u[1][k] + xl[2]*u[2][k] );
+      }
+   }
+
+   mp = m;
+   if( mp == NULL ) mp = &mm;
+   if( itype == INCG_SPHERE_OCTAHEDRON ) {
+      ierr = incg_MakeMesh_Polyhedron( mp, nv, (const double (*)[3]) xb,
+                                       nt, ioct );
+   } else {
+      ierr = incg_MakeMesh_Polyhedron( mp, nv, (const double (*)[3]) xb,
+                                       nt, iico );
+   }
+   if( ierr ) return ierr;
+   for(i=0;i<nv;++i) {
+      mp->v[i].x += s->x0[0];
+      mp->v[i].y += s->x0[1];
+      mp->v[i].z += s->x0[2];
+   }
+
+   // refine with projection of the new vertices on the sphere
+   opt.imode = INCG_REFINE_SPHERE;
+   for(k=0;k<3;++k) opt.xc[k] = s->x0[k];
+   opt.r = r;
+   ierr = incg_RefineMesh_Multilevel( mp, s->ns, &opt );
+   if( ierr == 0 && ( mp->nv > 2147483647 || mp->nt > 2147483647/3 ) ) {
+      ierr = 4;
+   }
+   if( ierr == 0 ) {
+      s->x = (double *) malloc( ((size_t) (3*mp->nv)) * sizeof( double ) );
+      s->icon = (int *) malloc( ((size_t) (3*mp->nt)) * sizeof( int ) );
+      if( s->x == NULL || s->icon == NULL ) {
+         if( s->x != NULL ) free( s->x );
+         if( s->icon != NULL ) free( s->icon );
+         s->x = NULL;
+         s->icon = NULL;
+         ierr = -1;
+      }
+   }
+   if( ierr ) {
+      if( mp == &mm ) {
+         free( mm.v );
+         free( mm.e );
+         free( mm.t );
+      }
+      return ierr;
+   }
+
+   s->np = (int) mp->nv;
+   s->nt = (int) mp->nt;
+#pragma omp parallel for
+   for(n=0;n<mp->nv;++n) {
+      s->x[3*n+0] = mp->v[n].x;
+      s->x[3*n+1] = mp->v[n].y;
+      s->x[3*n+2] = mp->v[n].z;
+   }
+#pragma omp parallel for
+   for(n=0;n<mp->nt;++n) {
+      s->icon[3*n+0] = (int) incg_Mesh_TriVertex( &( mp->t[n] ), 0 );
+      s->icon[3*n+1] = (int) incg_Mesh_TriVertex( &( mp->t[n] ), 1 );
+      s->icon[3*n+2] = (int) incg_Mesh_TriVertex( &( mp->t[n] ), 2 );
+   }
+
+   if( mp == &mm ) {
+      free( mm.v );
+      free( mm.e );
+      free( mm.t );
+   }
+
+   return 0;
+}
+
+
+//
+// Function to return the number of edges to be formed from a run of triangle
+// sides with the same vertex pair (sorted by the index of the side): a single
+// edge for one side or for two sides running in opposite directions, and one
+// edge per side otherwise
+//
+
+static long int incg_MakeMesh_RunEdges( const int *icon,
+                                        const long int *val, long int nr )
+{
+   if( nr == 1 ) return 1;
+   if( nr == 2 && icon[ val[0] ] != icon[ val[1] ] ) return 1;
+   return nr;
+}
+
+
+//
+// Function to form a mesh object from the arrays of a triangle "soup" given
+// as the coordinates of its points and the connectivity (base-0) of its
+// triangles. The edges are discovered by a parallel radix sort of the (min,max)
+// vertex pairs of all triangle sides; sides with equal pairs form an edge.
+// An edge takes its vertex order from the lowest-indexed triangle among its
+// sides, which is placed on the "left" of it, and a second side that runs in
+// the opposite direction is placed on the "right". Edges that cannot be paired
+// this way (more than two sides, or two sides running in the same direction)
+// are made once for every side and reported as non-manifold: their count is
+// returned in "nbad" and, when "ibad" is not null, an array of their indices
+// is allocated and returned in it.
+//
+
+int incg_MakeMesh_FromTris( mesh_t* m, const struct ingeom_tris_s* s,
+                            long int *nbad, long int **ibad )
+{
+   vertex_t *v=NULL;
+   edge_t *e=NULL;
+   triangle_t *t=NULL;
+   unsigned long *key=NULL;
+   long int *val=NULL, *cnt=NULL, *ib=NULL;
+   long int nt,nv,ns,ne,nb,i;
+   int nbits,nchk=1,k,ierr=0;
+
+
+   if( m == NULL || s == NULL ) return 1;
+   if( s->np <= 0 || s->nt <= 0 ) return 2;
+   if( s->icon == NULL || s->x == NULL ) return 3;
+
+   nv = (long int) s->np;
+   nt = (long int) s->nt;
+   ns = 3*nt;
+   for(i=0;i<ns;++i) {
+      if( s->icon[i] < 0 || s->icon[i] >= s->np ) return 4;
+   }
+
+   // keys of the (min,max) vertex pairs of all triangle sides
+   nbits = incg_Sort_NumBits( (unsigned long) (nv-1) );
+   if( nbits == 0 ) nbits = 1;
+#ifdef _OPENMP
+   nchk = omp_get_max_threads();
 #endif
+   key = (unsigned long *) malloc( ((size_t) ns) * sizeof( unsigned long ) );
+   val = (long int *) malloc( ((size_t) ns) * sizeof( long int ) );
+   cnt = (long int *) malloc( ((size_t) (2*nchk+2)) * sizeof( long int ) );
+   if( key == NULL || val == NULL || cnt == NULL ) {
+      ierr = -1;
+      goto cleanup;
+   }
+#pragma omp parallel for
+   for(i=0;i<ns;++i) {
+      unsigned long ia = (unsigned long) s->icon[i];
+      unsigned long ib = (unsigned long) s->icon[ i - i%3 + (i%3+1)%3 ];
+      if( ia < ib ) key[i] = ( ia << nbits ) | ib;
+      else          key[i] = ( ib << nbits ) | ia;
+      val[i] = i;
+   }
+   ierr = incg_Sort_RadixKeys( ns, key, val, 2*nbits );
+   if( ierr ) goto cleanup;
+
+   // count the edges (and the non-manifold ones) of runs starting in chunks
+   // of the sorted sides; the chunks are fixed here, so that both passes see
+   // the same ones however many threads the runtime gives either of them
+#pragma omp parallel for schedule(static)
+   for(k=0;k<nchk;++k) {
+      long int i,i0,i1,n,nr;
+
+      i0 = (long int) ( ((double) ns) * k / nchk );
+      i1 = (long int) ( ((double) ns) * (k+1) / nchk );
+      if( k == nchk-1 ) i1 = ns;
+      cnt[2*k+0] = 0;
+      cnt[2*k+1] = 0;
+      for(i=i0;i<i1;++i) {
+         if( i > 0 && key[i] == key[i-1] ) continue;
+         for(nr=1;i+nr<ns && key[i+nr]==key[i];++nr);
+         n = incg_MakeMesh_RunEdges( s->icon, &( val[i] ), nr );
+         cnt[2*k+0] += n;
+         if( n > 1 ) cnt[2*k+1] += n;
+      }
+   }
+   {  long int off=0, offb=0, tmp;
 
-   // release memory from incoming mesh object and re-assign
-   free( m->v );
-   m->v = v;
-   m->nv = nv2;
+      for(k=0;k<nchk;++k) {
+         tmp = cnt[2*k+0]; cnt[2*k+0] = off; off += tmp;
+         tmp = cnt[2*k+1]; cnt[2*k+1] = offb; offb += tmp;
+      }
+      cnt[2*nchk+0] = off;
+      cnt[2*nchk+1] = offb;
+   }
+   ne = cnt[2*nchk+0];
+   nb = cnt[2*nchk+1];
 
-   free( m->e );
-   m->e = e;
-   m->ne = ne2;
+   v = (vertex_t *) malloc( ((size_t) nv) * sizeof( vertex_t ) );
+   e = (edge_t *) malloc( ((size_t) ne) * sizeof( edge_t ) );
+   t = (triangle_t*) malloc( ((size_t) nt) * sizeof( triangle_t ) );
+   if( nb > 0 ) ib = (long int *) malloc( ((size_t) nb) * sizeof( long int ) );
+   if( v == NULL || e == NULL || t == NULL || ( nb > 0 && ib == NULL ) ) {
+      ierr = -1;
+      goto cleanup;
+   }
 
-   free( m->t );
+#pragma omp parallel for
+   for(i=0;i<nv;++i) {
+      v[i].id = i;
+      v[i].x = s->x[3*i+0];
+      v[i].y = s->x[3*i+1];
+      v[i].z = s->x[3*i+2];
+   }
+
+   // form the edges from the same chunks of the sorted sides
+#pragma omp parallel for schedule(static)
+   for(k=0;k<nchk;++k) {
+      long int i,i0,i1,n,nr,j,ie,jb;
+
+      i0 = (long int) ( ((double) ns) * k / nchk );
+      i1 = (long int) ( ((double) ns) * (k+1) / nchk );
+      if( k == nchk-1 ) i1 = ns;
+      ie = cnt[2*k+0];
+      jb = cnt[2*k+1];
+      for(i=i0;i<i1;++i) {
+         if( i > 0 && key[i] == key[i-1] ) continue;
+         for(nr=1;i+nr<ns && key[i+nr]==key[i];++nr);
+         n = incg_MakeMesh_RunEdges( s->icon, &( val[i] ), nr );
+         for(j=0;j<nr;++j) {
+            long int is = val[i+j];           // side of a triangle
+            long int itr = is/3;
+            edge_t *ep;
+            char d=0;
+
+            if( n == 1 && j == 1 ) {
+               // second side of a manifold edge
+               ep = &( e[ie-1] );
+               ep->tr = &( t[itr] );
+               d = 1;
+            } else {
+               ep = &( e[ie] );
+               ep->id = ie;
+               ep->va = &( v[ s->icon[is] ] );
+               ep->vb = &( v[ s->icon[ is - is%3 + (is%3+1)%3 ] ] );
+               ep->tl = &( t[itr] );
+               ep->tr = NULL;
+               if( n > 1 ) ib[jb++] = ie;
+               ++ie;
+            }
+
+            if( is%3 == 0 ) {
+               t[itr].e1 = ep; t[itr].d1 = d;
+            } else if( is%3 == 1 ) {
+               t[itr].e2 = ep; t[itr].d2 = d;
+            } else {
+               t[itr].e3 = ep; t[itr].d3 = d;
+            }
+         }
+      }
+   }
+#pragma omp parallel for
+   for(i=0;i<nt;++i) {
+      t[i].id = i;
+      t[i].foo = 0;
+   }
+
+   m->nv = nv;
+   m->ne = ne;
+   m->nt = nt;
+   m->v = v;
+   m->e = e;
    m->t = t;
-   m->nt = nt2;
 
-   return 0;
+   if( nbad != NULL ) *nbad = nb;
+   if( ibad != NULL ) {
+      *ibad = ib;
+      ib = NULL;
+   }
+   v = NULL;
+   e = NULL;
+   t = NULL;
+
+cleanup:
+   if( key != NULL ) free( key );
+   if( val != NULL ) free( val );
+   if( cnt != NULL ) free( cnt );
+   if( ib != NULL ) free( ib );
+   if( t != NULL ) free( t );
+   if( e != NULL ) free( e );
+   if( v != NULL ) free( v );
+
+   return ierr;
 }
 
 
@@ -1,3 +1,5 @@
+#ifndef _INCG_MESH_H_
+#define _INCG_MESH_H_
 
 typedef struct {
    long int id;
@@ -40,6 +42,10 @@ struct ingeom_sphere_s {
    double x0[3],x1[3],x2[3],x3[3];
 };
 
+// base polyhedra for the generation of spheres
+#define INCG_SPHERE_OCTAHEDRON   0
+#define INCG_SPHERE_ICOSAHEDRON  1
+
 // -------------------- function prototypes/signatures --------------------
 
 int incg_MakeMesh_OneTriangle( mesh_t* m );
@@ -48,5 +54,17 @@ int incg_MakeMesh_TwoTriangles( mesh_t* m );
 
 int incg_MakeMesh_Cube( mesh_t* m );
 
+int incg_MakeMesh_FromTris( mesh_t* m, const struct ingeom_tris_s* s,
+                            long int *nbad, long int **ibad );
+
 int incg_RefineMesh_Uniform( mesh_t* m );
 
+int incg_RefineMesh_UniformInto( const mesh_t* m, mesh_t* mf );
+
+int incg_RefineMesh_UniformLevels( mesh_t* m, int nlev );
+
+int incg_RefineMesh_Loop( mesh_t* m, int nlev );
+
+int incg_MakeMesh_Sphere( mesh_t* m, struct ingeom_sphere_s* s, int itype );
+
+#endif
@@ -0,0 +1,883 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "incg_meshio.h"
+#include "incg_format.h"
+
+
+//
+// Entries of the write buffer; sections are streamed through it in blocks
+//
+#define INCG_MESHFILE_BUFSIZE   (1 << 20)
+
+
+//
+// Function to return the size of an entry of a kind of section (0 if unknown)
+//
+static unsigned int incg_MeshFile_EntrySize( unsigned int type )
+{
+   switch( type ) {
+    case INCG_MESHFILE_COORDS:   return 3*sizeof( double );
+    case INCG_MESHFILE_EDGEVERT: return 2*sizeof( long int );
+    case INCG_MESHFILE_EDGETRI:  return 2*sizeof( long int );
+    case INCG_MESHFILE_TRIEDGE:  return 3*sizeof( long int );
+    case INCG_MESHFILE_TRIDIR:   return 4*sizeof( char );
+    case INCG_MESHFILE_FACES:    return 4*sizeof( long int );
+   }
+   return 0;
+}
+
+
+//
+// Function to fill a block of entries of a section from a mesh object
+//
+static void incg_MeshFile_Fill( const mesh_t* m, unsigned int type,
+                                long int i0, long int n, void* buf )
+{
+   double *x = (double *) buf;
+   long int *l = (long int *) buf;
+   char *c = (char *) buf;
+   long int i;
+
+   switch( type ) {
+    case INCG_MESHFILE_COORDS:
+      for(i=0;i<n;++i) {
+         const vertex_t *v = &( m->v[i0+i] );
+         x[3*i+0] = v->x;
+         x[3*i+1] = v->y;
+         x[3*i+2] = v->z;
+      }
+      break;
+    case INCG_MESHFILE_EDGEVERT:
+      for(i=0;i<n;++i) {
+         const edge_t *e = &( m->e[i0+i] );
+         l[2*i+0] = e->va->id;
+         l[2*i+1] = e->vb->id;
+      }
+      break;
+    case INCG_MESHFILE_EDGETRI:
+      for(i=0;i<n;++i) {
+         const edge_t *e = &( m->e[i0+i] );
+         l[2*i+0] = e->tl != NULL ? e->tl->id : -1;
+         l[2*i+1] = e->tr != NULL ? e->tr->id : -1;
+      }
+      break;
+    case INCG_MESHFILE_TRIEDGE:
+      for(i=0;i<n;++i) {
+         const triangle_t *t = &( m->t[i0+i] );
+         l[3*i+0] = t->e1->id;
+         l[3*i+1] = t->e2->id;
+         l[3*i+2] = t->e3->id;
+      }
+      break;
+    case INCG_MESHFILE_TRIDIR:
+      for(i=0;i<n;++i) {
+         const triangle_t *t = &( m->t[i0+i] );
+         c[4*i+0] = t->d1;
+         c[4*i+1] = t->d2;
+         c[4*i+2] = t->d3;
+         c[4*i+3] = 0;
+      }
+      break;
+    case INCG_MESHFILE_FACES:
+      for(i=0;i<n;++i) {
+         const triangle_t *t = &( m->t[i0+i] );
+         l[4*i+0] = t->d1 == 0 ? t->e1->va->id : t->e1->vb->id;
+         l[4*i+1] = t->d2 == 0 ? t->e2->va->id : t->e2->vb->id;
+         l[4*i+2] = t->d3 == 0 ? t->e3->va->id : t->e3->vb->id;
+         l[4*i+3] = -1;
+      }
+      break;
+   }
+}
+
+
+//
+// Function to write a file from a list of sections. A section is written
+// directly from its array when one is given, or is filled in blocks from the
+// mesh object otherwise. Every section starts at a multiple of the alignment
+// and the gaps are padded with zeros.
+//
+static int incg_MeshFile_Write( const char* filename, unsigned int nsec,
+                                const unsigned int* type, const long int* n,
+                                const void** data, const mesh_t* m )
+{
+   struct incg_meshfile_head_s head;
+   char *buf;
+   FILE *fp;
+   long int off;
+   unsigned int k;
+   int ierr=0;
+
+
+   if( nsec > INCG_MESHFILE_MAXSEC ) return 1;
+
+   memset( &head, 0, sizeof(head) );
+   memcpy( head.magic, INCG_MESHFILE_MAGIC, 8 );
+   head.version = INCG_MESHFILE_VERSION;
+   head.endian = INCG_MESHFILE_ENDIAN;
+   head.nsec = nsec;
+   head.align = INCG_MESHFILE_ALIGN;
+
+   off = INCG_MESHFILE_ALIGN;
+   for(k=0;k<nsec;++k) {
+      head.sec[k].type = type[k];
+      head.sec[k].esize = incg_MeshFile_EntrySize( type[k] );
+      head.sec[k].n = n[k];
+      head.sec[k].offset = off;
+      off += n[k] * ((long int) head.sec[k].esize);
+      off = ( (off + INCG_MESHFILE_ALIGN-1) / INCG_MESHFILE_ALIGN )
+          * INCG_MESHFILE_ALIGN;
+   }
+
+   buf = (char *) malloc( INCG_MESHFILE_BUFSIZE );
+   if( buf == NULL ) return -1;
+   memset( buf, 0, INCG_MESHFILE_ALIGN );
+
+   fp = fopen( filename, "w" );
+   if( fp == NULL ) {
+      printf( "Could not open file \"%s\"\n", filename );
+      free( buf );
+      return 2;
+   }
+
+   off = 0;
+   if( fwrite( &head, sizeof(head), 1, fp ) != 1 ) ierr = 3;
+   off += (long int) sizeof(head);
+
+   for(k=0;k<nsec && ierr==0;++k) {
+      const long int es = (long int) head.sec[k].esize;
+      const long int nb = INCG_MESHFILE_BUFSIZE / es;
+      long int i0;
+
+      // pad up to the start of the section
+      if( off < head.sec[k].offset ) {
+         memset( buf, 0, INCG_MESHFILE_ALIGN );
+         if( fwrite( buf, 1, head.sec[k].offset - off, fp ) !=
+             (size_t) (head.sec[k].offset - off) ) ierr = 3;
+         off = head.sec[k].offset;
+      }
+
+      if( data[k] != NULL ) {
+         if( n[k] > 0 &&
+             fwrite( data[k], es, n[k], fp ) != (size_t) n[k] ) ierr = 3;
+      } else {
+         for(i0=0;i0<n[k] && ierr==0;i0+=nb) {
+            long int nn = n[k] - i0 < nb ? n[k] - i0 : nb;
+            incg_MeshFile_Fill( m, type[k], i0, nn, buf );
+            if( fwrite( buf, es, nn, fp ) != (size_t) nn ) ierr = 3;
+         }
+      }
+      off += n[k]*es;
+   }
+
+   // pad the end such that the last section is whole pages
+   if( ierr == 0 && off % INCG_MESHFILE_ALIGN != 0 ) {
+      long int np = INCG_MESHFILE_ALIGN - off % INCG_MESHFILE_ALIGN;
+      memset( buf, 0, INCG_MESHFILE_ALIGN );
+      if( fwrite( buf, 1, np, fp ) != (size_t) np ) ierr = 3;
+   }
+
+   if( fclose( fp ) != 0 && ierr == 0 ) ierr = 3;
+   free( buf );
+   if( ierr ) printf( "Could not write file \"%s\"\n", filename );
+
+   return ierr;
+}
+
+
+//
+// Function to write a mesh object to a binary file with its coordinates,
+// connectivity and adjacency, as well as its triangles as faces
+//
+
+int incg_MeshFile_WriteMesh( const mesh_t* m, const char* filename )
+{
+   unsigned int type[6] = { INCG_MESHFILE_COORDS,
+                            INCG_MESHFILE_EDGEVERT,
+                            INCG_MESHFILE_EDGETRI,
+                            INCG_MESHFILE_TRIEDGE,
+                            INCG_MESHFILE_TRIDIR,
+                            INCG_MESHFILE_FACES };
+   const void *data[6] = { NULL, NULL, NULL, NULL, NULL, NULL };
+   long int n[6];
+
+
+   if( m == NULL || filename == NULL ) return 1;
+
+   n[0] = m->nv;
+   n[1] = m->ne;
+   n[2] = m->ne;
+   n[3] = m->nt;
+   n[4] = m->nt;
+   n[5] = m->nt;
+
+   return incg_MeshFile_Write( filename, 6, type, n, data, m );
+}
+
+
+//
+// Function to write a file with only vertices and faces. The coordinates are
+// three doubles per vertex and the faces are four indices (base-0), with the
+// fourth negative for a triangle.
+//
+
+int incg_MeshFile_WriteFaces( long int nv, const double* x,
+                              long int nf, const long int* faces,
+                              const char* filename )
+{
+   unsigned int type[2] = { INCG_MESHFILE_COORDS, INCG_MESHFILE_FACES };
+   const void *data[2];
+   long int n[2];
+
+
+   if( x == NULL || faces == NULL || filename == NULL ) return 1;
+   if( nv < 0 || nf < 0 ) return 1;
+
+   n[0] = nv;
+   n[1] = nf;
+   data[0] = x;
+   data[1] = faces;
+
+   return incg_MeshFile_Write( filename, 2, type, n, data, NULL );
+}
+
+
+//
+// Function to map a file to memory (read-only and shared, such that processes
+// share the page cache) and to point at its arrays in place. Nothing is read
+// until it is accessed. Absent sections have null pointers and zero counts.
+// The header is checked: every section lies within the file, and the sections
+// of the edges and of the triangles have as many entries as their pairs.
+//
+
+int incg_MeshFile_Open( const char* filename, struct incg_meshfile_s* f )
+{
+   const struct incg_meshfile_head_s *h;
+   struct stat st;
+   void *p;
+   unsigned int k;
+   int fd;
+
+
+   if( filename == NULL || f == NULL ) return 1;
+   memset( f, 0, sizeof(struct incg_meshfile_s) );
+
+   fd = open( filename, O_RDONLY );
+   if( fd == -1 ) {
+      printf( "Could not open file \"%s\"\n", filename );
+      return 2;
+   }
+   if( fstat( fd, &st ) == -1 ||
+       st.st_size < (off_t) sizeof(struct incg_meshfile_head_s) ) {
+      close( fd );
+      return 3;
+   }
+
+   p = mmap( NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+   close( fd );
+   if( p == MAP_FAILED ) return 3;
+
+   f->base = p;
+   f->size = (size_t) st.st_size;
+   h = (const struct incg_meshfile_head_s *) p;
+
+   // sanity checks of the header and of its sections
+   if( memcmp( h->magic, INCG_MESHFILE_MAGIC, 8 ) != 0 ||
+       h->version != INCG_MESHFILE_VERSION ||
+       h->endian != INCG_MESHFILE_ENDIAN ||
+       h->align == 0 || h->nsec > INCG_MESHFILE_MAXSEC ) {
+      printf( "File \"%s\" is not a mesh file of this build\n", filename );
+      incg_MeshFile_Close( f );
+      return 4;
+   }
+   for(k=0;k<h->nsec;++k) {
+      const struct incg_meshfile_sec_s *s = &( h->sec[k] );
+      if( s->esize == 0 || s->esize != incg_MeshFile_EntrySize( s->type ) ||
+          s->n < 0 || s->offset < 0 || s->offset % h->align != 0 ||
+          s->offset > (long int) f->size ||
+          s->n > ( ((long int) f->size) - s->offset )/((long int) s->esize) ) {
+         printf( "File \"%s\" has a bad section %d\n", filename, k );
+         incg_MeshFile_Close( f );
+         return 5;
+      }
+   }
+   f->head = h;
+
+   f->x = (const double *)
+          incg_MeshFile_Section( f, INCG_MESHFILE_COORDS, &( f->nv ) );
+   f->ev = (const long int *)
+           incg_MeshFile_Section( f, INCG_MESHFILE_EDGEVERT, &( f->ne ) );
+   f->et = (const long int *)
+           incg_MeshFile_Section( f, INCG_MESHFILE_EDGETRI, NULL );
+   f->te = (const long int *)
+           incg_MeshFile_Section( f, INCG_MESHFILE_TRIEDGE, &( f->nt ) );
+   f->td = (const char *)
+           incg_MeshFile_Section( f, INCG_MESHFILE_TRIDIR, NULL );
+   f->faces = (const long int *)
+              incg_MeshFile_Section( f, INCG_MESHFILE_FACES, &( f->nf ) );
+   {  long int net, ntd;
+
+      (void) incg_MeshFile_Section( f, INCG_MESHFILE_EDGETRI, &net );
+      (void) incg_MeshFile_Section( f, INCG_MESHFILE_TRIDIR, &ntd );
+      if( ( f->et != NULL && ( f->ev == NULL || net != f->ne ) ) ||
+          ( f->td != NULL && ( f->te == NULL || ntd != f->nt ) ) ) {
+         printf( "File \"%s\" has sections of mismatched sizes\n", filename );
+         incg_MeshFile_Close( f );
+         return 6;
+      }
+   }
+
+   return 0;
+}
+
+
+//
+// Function to return a pointer to the first section of a kind in a mapped
+// file and the number of its entries (null and zero when there is none)
+//
+
+const void* incg_MeshFile_Section( const struct incg_meshfile_s* f,
+                                   unsigned int type, long int *n )
+{
+   unsigned int k;
+
+   if( n != NULL ) *n = 0;
+   if( f == NULL || f->head == NULL ) return NULL;
+
+   for(k=0;k<f->head->nsec;++k) {
+      if( f->head->sec[k].type == type ) {
+         if( n != NULL ) *n = f->head->sec[k].n;
+         return (const void *) ( ((const char *) f->base) +
+                                 f->head->sec[k].offset );
+      }
+   }
+
+   return NULL;
+}
+
+
+//
+// Function to form a mesh object from a mapped file that has the adjacency
+// sections. Unlike the arrays of the mapped file, the mesh object is a copy
+// because of the pointers of its entities. Every index of the file is checked
+// to be in range first (return 3 otherwise).
+//
+
+int incg_MeshFile_MakeMesh( const struct incg_meshfile_s* f, mesh_t* m )
+{
+   vertex_t *v;
+   edge_t *e;
+   triangle_t *t;
+   long int i;
+
+
+   if( f == NULL || m == NULL ) return 1;
+   if( f->x == NULL || f->ev == NULL || f->et == NULL ||
+       f->te == NULL || f->td == NULL ) return 2;
+
+   // indices of vertices, triangles (or -1), edges and directions in range
+   {  long int nbad=0;
+
+#pragma omp parallel for reduction(+:nbad)
+      for(i=0;i<f->ne;++i) {
+         if( f->ev[2*i+0] < 0 || f->ev[2*i+0] >= f->nv ||
+             f->ev[2*i+1] < 0 || f->ev[2*i+1] >= f->nv ||
+             f->et[2*i+0] < -1 || f->et[2*i+0] >= f->nt ||
+             f->et[2*i+1] < -1 || f->et[2*i+1] >= f->nt ) ++nbad;
+      }
+#pragma omp parallel for reduction(+:nbad)
+      for(i=0;i<f->nt;++i) {
+         int k;
+         for(k=0;k<3;++k) {
+            if( f->te[3*i+k] < 0 || f->te[3*i+k] >= f->ne ||
+                ( f->td[4*i+k] != 0 && f->td[4*i+k] != 1 ) ) ++nbad;
+         }
+      }
+      if( nbad ) return 3;
+   }
+
+   v = (vertex_t *) malloc( ((size_t) f->nv) * sizeof( vertex_t ) );
+   e = (edge_t *) malloc( ((size_t) f->ne) * sizeof( edge_t ) );
+   t = (triangle_t*) malloc( ((size_t) f->nt) * sizeof( triangle_t ) );
+   if( v == NULL || e == NULL || t == NULL ) {
+      if( v != NULL ) free( v );
+      if( e != NULL ) free( e );
+      if( t != NULL ) free( t );
+      return -1;
+   }
+
+#pragma omp parallel for
+   for(i=0;i<f->nv;++i) {
+      v[i].id = i;
+      v[i].x = f->x[3*i+0];
+      v[i].y = f->x[3*i+1];
+      v[i].z = f->x[3*i+2];
+   }
+
+#pragma omp parallel for
+   for(i=0;i<f->ne;++i) {
+      e[i].id = i;
+      e[i].va = &( v[ f->ev[2*i+0] ] );
+      e[i].vb = &( v[ f->ev[2*i+1] ] );
+      e[i].tl = f->et[2*i+0] >= 0 ? &( t[ f->et[2*i+0] ] ) : NULL;
+      e[i].tr = f->et[2*i+1] >= 0 ? &( t[ f->et[2*i+1] ] ) : NULL;
+   }
+
+#pragma omp parallel for
+   for(i=0;i<f->nt;++i) {
+      t[i].id = i;
+      t[i].e1 = &( e[ f->te[3*i+0] ] );
+      t[i].e2 = &( e[ f->te[3*i+1] ] );
+      t[i].e3 = &( e[ f->te[3*i+2] ] );
+      t[i].d1 = f->td[4*i+0];
+      t[i].d2 = f->td[4*i+1];
+      t[i].d3 = f->td[4*i+2];
+      t[i].foo = 0;
+   }
+
+   m->nv = f->nv;
+   m->ne = f->ne;
+   m->nt = f->nt;
+   m->v = v;
+   m->e = e;
+   m->t = t;
+
+   return 0;
+}
+
+
+//
+// Function to unmap a file; its pointers become invalid
+//
+
+int incg_MeshFile_Close( struct incg_meshfile_s* f )
+{
+   int ierr=0;
+
+   if( f == NULL ) return 1;
+   if( f->base != NULL ) {
+      if( munmap( f->base, f->size ) == -1 ) ierr = 2;
+   }
+   memset( f, 0, sizeof(struct incg_meshfile_s) );
+
+   return ierr;
+}
+
+
+//
+// Vertices and faces of a plot, from either a mesh object or arrays
+//
+struct incg_plot_s {
+   const mesh_t *m;
+   const double *x;       // 3 per vertex (without a mesh object)
+   const long int *f;     // 4 per face, the 4th negative for a triangle
+   long int nv,nf;
+   long int nq;           // number of quadrilaterals
+   long int ibase;        // index of the first vertex in the file
+};
+
+// items formatted by a thread at a time and the longest text of an item
+#define INCG_PLOT_CHUNK   16384
+#define INCG_PLOT_ITEMLEN (4*INCG_FORMAT_MAXLEN+8)
+
+
+//
+// Function to return the vertices of a face and their number (3 or 4)
+//
+static int incg_Plot_Face( const struct incg_plot_s* p, long int i,
+                           long int* f )
+{
+   if( p->m != NULL ) {
+      const triangle_t *t = &( p->m->t[i] );
+      f[0] = t->d1 == 0 ? t->e1->va->id : t->e1->vb->id;
+      f[1] = t->d2 == 0 ? t->e2->va->id : t->e2->vb->id;
+      f[2] = t->d3 == 0 ? t->e3->va->id : t->e3->vb->id;
+      f[3] = -1;
+      return 3;
+   }
+
+   f[0] = p->f[4*i+0];
+   f[1] = p->f[4*i+1];
+   f[2] = p->f[4*i+2];
+   f[3] = p->f[4*i+3];
+   if( f[3] < 0 ) return 3;
+   return 4;
+}
+
+
+//
+// Function to return the coordinates of a vertex
+//
+static void incg_Plot_Vertex( const struct incg_plot_s* p, long int i,
+                              double* x )
+{
+   if( p->m != NULL ) {
+      x[0] = p->m->v[i].x;
+      x[1] = p->m->v[i].y;
+      x[2] = p->m->v[i].z;
+   } else {
+      x[0] = p->x[3*i+0];
+      x[1] = p->x[3*i+1];
+      x[2] = p->x[3*i+2];
+   }
+}
+
+
+//
+// Functions to format a line of text of an item; they return its length
+//
+static int incg_Plot_TextVertex( const struct incg_plot_s* p, long int i,
+                                 char* buf )
+{
+   double x[3];
+   int k,n=0;
+
+   incg_Plot_Vertex( p, i, x );
+   for(k=0;k<3;++k) {
+      buf[n++] = ' ';
+      n += incg_Format_Double( &( buf[n] ), x[k] );
+   }
+   buf[n++] = '\n';
+
+   return n;
+}
+
+static int incg_Plot_TextTecplotFace( const struct incg_plot_s* p, long int i,
+                                      char* buf )
+{
+   long int f[4];
+   int k,n=0;
+
+   // triangles in a zone of quadrilaterals repeat their last vertex
+   if( incg_Plot_Face( p, i, f ) == 3 ) f[3] = f[2];
+   for(k=0;k<(p->nq > 0 ? 4 : 3);++k) {
+      buf[n++] = ' ';
+      n += incg_Format_Long( &( buf[n] ), f[k] + p->ibase );
+   }
+   buf[n++] = '\n';
+
+   return n;
+}
+
+static int incg_Plot_TextVTKCell( const struct incg_plot_s* p, long int i,
+                                  char* buf )
+{
+   long int f[4];
+   int k,nk,n=0;
+
+   nk = incg_Plot_Face( p, i, f );
+   buf[n++] = (char) ('0' + nk);
+   for(k=0;k<nk;++k) {
+      buf[n++] = ' ';
+      n += incg_Format_Long( &( buf[n] ), f[k] + p->ibase );
+   }
+   buf[n++] = '\n';
+
+   return n;
+}
+
+static int incg_Plot_TextVTKType( const struct incg_plot_s* p, long int i,
+                                  char* buf )
+{
+   long int f[4];
+
+   if( incg_Plot_Face( p, i, f ) == 3 ) {
+      buf[0] = '5';
+   } else {
+      buf[0] = '9';
+   }
+   buf[1] = '\n';
+
+   return 2;
+}
+
+
+//
+// Function to write a line of text for every one of a number of items. Chunks
+// of items are formatted by the threads concurrently, each in its own buffer,
+// and the buffers are written in order with one large write each.
+//
+static int incg_Plot_Text( FILE* fp, const struct incg_plot_s* p, long int n,
+                           int (*fmt)( const struct incg_plot_s*, long int,
+                                       char* ) )
+{
+   char *buf;
+   long int *len,i0;
+   int nthr=1,k,ierr=0;
+
+#ifdef _OPENMP
+   nthr = omp_get_max_threads();
+#endif
+   buf = (char *) malloc( ((size_t) nthr) *
+                          INCG_PLOT_CHUNK * INCG_PLOT_ITEMLEN );
+   len = (long int *) malloc( ((size_t) nthr) * sizeof( long int ) );
+   if( buf == NULL || len == NULL ) {
+      if( buf != NULL ) free( buf );
+      if( len != NULL ) free( len );
+      return -1;
+   }
+
+   for(i0=0;i0<n && ierr==0;i0+=nthr*INCG_PLOT_CHUNK) {
+#pragma omp parallel for schedule(static,1) num_threads( nthr )
+      for(k=0;k<nthr;++k) {
+         char *b = &( buf[ ((size_t) k) * INCG_PLOT_CHUNK*INCG_PLOT_ITEMLEN ] );
+         long int i, i1, l=0;
+
+         i = i0 + ((long int) k)*INCG_PLOT_CHUNK;
+         i1 = i + INCG_PLOT_CHUNK;
+         if( i1 > n ) i1 = n;
+         for(;i<i1;++i) l += fmt( p, i, &( b[l] ) );
+         len[k] = l;
+      }
+
+      for(k=0;k<nthr && ierr==0;++k) {
+         const char *b = &( buf[ ((size_t) k) *
+                                 INCG_PLOT_CHUNK*INCG_PLOT_ITEMLEN ] );
+         if( len[k] > 0 &&
+             fwrite( b, 1, len[k], fp ) != (size_t) len[k] ) ierr = 3;
+      }
+   }
+
+   free( len );
+   free( buf );
+
+   return ierr;
+}
+
+
+//
+// Function to write the arrays of a VTK XML file as raw appended data; each
+// array is preceded by its size in bytes as a 64-bit integer
+//
+static int incg_Plot_Appended( FILE* fp, const struct incg_plot_s* p )
+{
+   unsigned long long nb;
+   double *x;
+   long int *l, i0, i, ioff=0;
+   unsigned char *c;
+   void *buf;
+   int ierr=0;
+
+   buf = malloc( INCG_PLOT_CHUNK * 4*sizeof( double ) );
+   if( buf == NULL ) return -1;
+   x = (double *) buf;
+   l = (long int *) buf;
+   c = (unsigned char *) buf;
+
+   nb = (unsigned long long) ( 3*p->nv * sizeof( double ) );
+   if( fwrite( &nb, sizeof(nb), 1, fp ) != 1 ) ierr = 3;
+   if( p->m == NULL ) {
+      if( ierr == 0 && fwrite( p->x, 3*sizeof( double ), p->nv, fp ) !=
+                       (size_t) p->nv ) ierr = 3;
+   } else {
+      for(i0=0;i0<p->nv && ierr==0;i0+=INCG_PLOT_CHUNK) {
+         long int n = p->nv - i0 < INCG_PLOT_CHUNK ? p->nv - i0 :
+                                                     INCG_PLOT_CHUNK;
+         for(i=0;i<n;++i) incg_Plot_Vertex( p, i0+i, &( x[3*i] ) );
+         if( fwrite( x, 3*sizeof( double ), n, fp ) != (size_t) n ) ierr = 3;
+      }
+   }
+
+   // connectivity
+   nb = (unsigned long long) ( (3*p->nf + p->nq) * sizeof( long int ) );
+   if( ierr == 0 && fwrite( &nb, sizeof(nb), 1, fp ) != 1 ) ierr = 3;
+   for(i0=0;i0<p->nf && ierr==0;i0+=INCG_PLOT_CHUNK) {
+      long int n = p->nf - i0 < INCG_PLOT_CHUNK ? p->nf - i0 : INCG_PLOT_CHUNK;
+      long int j=0;
+      for(i=0;i<n;++i) j += incg_Plot_Face( p, i0+i, &( l[j] ) );
+      if( fwrite( l, sizeof( long int ), j, fp ) != (size_t) j ) ierr = 3;
+   }
+
+   // offsets of the ends of the cells in the connectivity
+   nb = (unsigned long long) ( p->nf * sizeof( long int ) );
+   if( ierr == 0 && fwrite( &nb, sizeof(nb), 1, fp ) != 1 ) ierr = 3;
+   for(i0=0;i0<p->nf && ierr==0;i0+=INCG_PLOT_CHUNK) {
+      long int n = p->nf - i0 < INCG_PLOT_CHUNK ? p->nf - i0 : INCG_PLOT_CHUNK;
+      long int f[4];
+      for(i=0;i<n;++i) {
+         ioff += incg_Plot_Face( p, i0+i, f );
+         l[i] = ioff;
+      }
+      if( fwrite( l, sizeof( long int ), n, fp ) != (size_t) n ) ierr = 3;
+   }
+
+   // types of the cells
+   nb = (unsigned long long) p->nf;
+   if( ierr == 0 && fwrite( &nb, sizeof(nb), 1, fp ) != 1 ) ierr = 3;
+   for(i0=0;i0<p->nf && ierr==0;i0+=INCG_PLOT_CHUNK) {
+      long int n = p->nf - i0 < INCG_PLOT_CHUNK ? p->nf - i0 : INCG_PLOT_CHUNK;
+      long int f[4];
+      for(i=0;i<n;++i) c[i] = incg_Plot_Face( p, i0+i, f ) == 3 ? 5 : 9;
+      if( fwrite( c, 1, n, fp ) != (size_t) n ) ierr = 3;
+   }
+
+   free( buf );
+
+   return ierr;
+}
+
+
+//
+// Function to write a plot file of the vertices and faces in a format
+//
+static int incg_Plot_Write( struct incg_plot_s* p, int iformat,
+                            const char* title, const char* filename )
+{
+   const unsigned int one = 1;
+   unsigned long long o1,o2,o3;
+   FILE *fp;
+   int ierr=0;
+
+
+   if( iformat < INCG_PLOT_TECPLOT || iformat > INCG_PLOT_VTU ) return 1;
+   if( title == NULL ) title = "INCG mesh";
+
+   fp = fopen( filename, "w" );
+   if( fp == NULL ) {
+      printf( "Could not open file \"%s\"\n", filename );
+      return 2;
+   }
+
+   if( iformat == INCG_PLOT_TECPLOT ) {
+      p->ibase = 1;
+      fprintf( fp, "TITLE = \"%s\" \n", title );
+      fprintf( fp, "VARIABLES = x y z \n" );
+      fprintf( fp, "ZONE NODES=%ld, ELEMENTS=%ld \n", p->nv, p->nf );
+      fprintf( fp, "     ZONETYPE=%s, DATAPACKING=POINT \n",
+               p->nq > 0 ? "FEQUADRILATERAL" : "FETRIANGLE" );
+      ierr = incg_Plot_Text( fp, p, p->nv, incg_Plot_TextVertex );
+      if( ierr == 0 )
+         ierr = incg_Plot_Text( fp, p, p->nf, incg_Plot_TextTecplotFace );
+
+   } else if( iformat == INCG_PLOT_VTK ) {
+      p->ibase = 0;
+      fprintf( fp, "# vtk DataFile Version 3.0\n" );
+      fprintf( fp, "%.255s\n", title );
+      fprintf( fp, "ASCII\n" );
+      fprintf( fp, "DATASET UNSTRUCTURED_GRID\n" );
+      fprintf( fp, "POINTS %ld double\n", p->nv );
+      ierr = incg_Plot_Text( fp, p, p->nv, incg_Plot_TextVertex );
+      if( ierr == 0 ) {
+         fprintf( fp, "CELLS %ld %ld\n", p->nf, 4*p->nf + p->nq );
+         ierr = incg_Plot_Text( fp, p, p->nf, incg_Plot_TextVTKCell );
+      }
+      if( ierr == 0 ) {
+         fprintf( fp, "CELL_TYPES %ld\n", p->nf );
+         ierr = incg_Plot_Text( fp, p, p->nf, incg_Plot_TextVTKType );
+      }
+
+   } else {
+      // offsets of the arrays in the appended data, past their sizes
+      o1 = 8 + 3*p->nv * sizeof( double );
+      o2 = o1 + 8 + (3*p->nf + p->nq) * sizeof( long int );
+      o3 = o2 + 8 + p->nf * sizeof( long int );
+      fprintf( fp, "<?xml version=\"1.0\"?>\n" );
+      fprintf( fp, "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" "
+                   "byte_order=\"%s\" header_type=\"UInt64\">\n",
+               *((const unsigned char *) &one) == 1 ? "LittleEndian" :
+                                                      "BigEndian" );
+      fprintf( fp, "<UnstructuredGrid>\n" );
+      fprintf( fp, "<Piece NumberOfPoints=\"%ld\" NumberOfCells=\"%ld\">\n",
+               p->nv, p->nf );
+      fprintf( fp, "<Points>\n" );
+      fprintf( fp, "<DataArray type=\"Float64\" NumberOfComponents=\"3\" "
+                   "format=\"appended\" offset=\"0\"/>\n" );
+      fprintf( fp, "</Points>\n" );
+      fprintf( fp, "<Cells>\n" );
+      fprintf( fp, "<DataArray type=\"Int64\" Name=\"connectivity\" "
+                   "format=\"appended\" offset=\"%llu\"/>\n", o1 );
+      fprintf( fp, "<DataArray type=\"Int64\" Name=\"offsets\" "
+                   "format=\"appended\" offset=\"%llu\"/>\n", o2 );
+      fprintf( fp, "<DataArray type=\"UInt8\" Name=\"types\" "
+                   "format=\"appended\" offset=\"%llu\"/>\n", o3 );
+      fprintf( fp, "</Cells>\n" );
+      fprintf( fp, "</Piece>\n" );
+      fprintf( fp, "</UnstructuredGrid>\n" );
+      fprintf( fp, "<AppendedData encoding=\"raw\">\n_" );
+      ierr = incg_Plot_Appended( fp, p );
+      fprintf( fp, "\n</AppendedData>\n" );
+      fprintf( fp, "</VTKFile>\n" );
+   }
+
+   if( fclose( fp ) != 0 && ierr == 0 ) ierr = 3;
+   if( ierr ) printf( "Could not write file \"%s\"\n", filename );
+
+   return ierr;
+}
+
+
+//
+// Function to write a plot file of a mesh object in one of the formats:
+// Tecplot (ASCII, triangles), VTK legacy (ASCII) or VTK XML (".vtu" with the
+// arrays appended as raw binary data). Numbers are written in their shortest
+// text that reads back exactly.
+//
+
+int incg_MeshFile_Plot( const mesh_t* m, int iformat,
+                        const char* title, const char* filename )
+{
+   struct incg_plot_s p;
+
+   if( m == NULL || filename == NULL ) return 1;
+
+   memset( &p, 0, sizeof(p) );
+   p.m = m;
+   p.nv = m->nv;
+   p.nf = m->nt;
+
+   return incg_Plot_Write( &p, iformat, title, filename );
+}
+
+
+//
+// Function to write a plot file of vertices and faces given as arrays like
+// those of incg_MeshFile_WriteFaces(). The faces may mix triangles and
+// quadrilaterals; Tecplot then has a zone of quadrilaterals in which the
+// triangles repeat their last vertex.
+//
+
+int incg_MeshFile_PlotFaces( long int nv, const double* x,
+                             long int nf, const long int* faces,
+                             int iformat,
+                             const char* title, const char* filename )
+{
+   struct incg_plot_s p;
+   long int i,nq=0;
+
+   if( x == NULL || faces == NULL || filename == NULL ) return 1;
+   if( nv < 0 || nf < 0 ) return 1;
+
+#pragma omp parallel for reduction(+:nq)
+   for(i=0;i<nf;++i) {
+      if( faces[4*i+3] >= 0 ) ++nq;
+   }
+
+   memset( &p, 0, sizeof(p) );
+   p.x = x;
+   p.f = faces;
+   p.nv = nv;
+   p.nf = nf;
+   p.nq = nq;
+
+   return incg_Plot_Write( &p, iformat, title, filename );
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
@@ -0,0 +1,98 @@
+
+#ifndef _INCG_MESHIO_H_
+#define _INCG_MESHIO_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "incg_mesh.h"
+
+//
+// Binary mesh file: a header followed by sections of arrays, each starting at
+// a page boundary such that a mapped file is used in place. Integers are
+// native 64-bit and reals are native doubles; the header carries a byte-order
+// mark and a version.
+//
+
+#define INCG_MESHFILE_MAGIC     "INCGMESH"
+#define INCG_MESHFILE_VERSION   1
+#define INCG_MESHFILE_ENDIAN    0x01020304
+#define INCG_MESHFILE_ALIGN     4096
+#define INCG_MESHFILE_MAXSEC    16
+
+// kinds of sections (entries of each)
+#define INCG_MESHFILE_COORDS    1   // x,y,z of a vertex (as node_t)
+#define INCG_MESHFILE_EDGEVERT  2   // vertices a,b of an edge
+#define INCG_MESHFILE_EDGETRI   3   // triangles left,right of an edge (or -1)
+#define INCG_MESHFILE_TRIEDGE   4   // edges 1,2,3 of a triangle
+#define INCG_MESHFILE_TRIDIR    5   // directions d1,d2,d3 of a triangle (+pad)
+#define INCG_MESHFILE_FACES     6   // four vertices of a face (as face_t)
+
+struct incg_meshfile_sec_s {
+   unsigned int type;            // kind of section
+   unsigned int esize;           // bytes per entry
+   long int n;                   // number of entries
+   long int offset;              // start in the file (aligned)
+};
+
+struct incg_meshfile_head_s {
+   char magic[8];
+   unsigned int version;
+   unsigned int endian;
+   unsigned int nsec;
+   unsigned int align;
+   struct incg_meshfile_sec_s sec[INCG_MESHFILE_MAXSEC];
+};
+
+// a mapped file with pointers to its arrays (null when absent)
+struct incg_meshfile_s {
+   void *base;
+   size_t size;
+   const struct incg_meshfile_head_s *head;
+   long int nv,ne,nt,nf;
+   const double *x;              // 3 per vertex
+   const long int *ev;           // 2 per edge
+   const long int *et;           // 2 per edge
+   const long int *te;           // 3 per triangle
+   const char *td;               // 4 per triangle
+   const long int *faces;        // 4 per face
+};
+
+// formats of plot files
+#define INCG_PLOT_TECPLOT       0   // Tecplot ASCII (FE triangles or quads)
+#define INCG_PLOT_VTK           1   // VTK legacy ASCII
+#define INCG_PLOT_VTU           2   // VTK XML with raw appended binary data
+
+// -------------------- function prototypes/signatures --------------------
+
+int incg_MeshFile_WriteMesh( const mesh_t* m, const char* filename );
+
+int incg_MeshFile_WriteFaces( long int nv, const double* x,
+                              long int nf, const long int* faces,
+                              const char* filename );
+
+int incg_MeshFile_Open( const char* filename, struct incg_meshfile_s* f );
+
+const void* incg_MeshFile_Section( const struct incg_meshfile_s* f,
+                                   unsigned int type, long int *n );
+
+int incg_MeshFile_MakeMesh( const struct incg_meshfile_s* f, mesh_t* m );
+
+int incg_MeshFile_Close( struct incg_meshfile_s* f );
+
+int incg_MeshFile_Plot( const mesh_t* m, int iformat,
+                        const char* title, const char* filename );
+
+int incg_MeshFile_PlotFaces( long int nv, const double* x,
+                             long int nf, const long int* faces,
+                             int iformat,
+                             const char* title, const char* filename );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
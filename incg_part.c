@@ -0,0 +1,1481 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "incg_part.h"
+#include "incg_sort.h"
+
+// size of the coarsest graph of the multilevel partitioner (per part), and
+// the largest number of its levels
+#define INCG_PART_COARSEST      32
+#define INCG_PART_MAXLEVEL      64
+
+// rounds of the parallel matching and passes of the parallel refinement
+#define INCG_PART_NMATCH        8
+#define INCG_PART_NPASS         8
+
+// bits of the quantized coordinates sorted by the coordinate bisection
+#define INCG_PART_NBITS         22
+
+
+//
+// A graph (the dual graph of a mesh, or one of its coarsenings) in CSR form
+// with weights of its vertices and edges, and the centroids of its vertices
+//
+struct incg_part_graph_s {
+   long int n;
+   long int *xadj, *adj, *ew;
+   long int *vw;
+   double *xc;
+};
+
+
+//
+// A range of points and the range of parts that it is split into
+//
+struct incg_part_range_s {
+   long int i0,i1;
+   int p0,np;
+};
+
+
+//
+// Function to release the arrays of a graph
+//
+static void incg_Part_FreeGraph( struct incg_part_graph_s* g )
+{
+   if( g->xadj != NULL ) free( g->xadj );
+   if( g->adj != NULL ) free( g->adj );
+   if( g->ew != NULL ) free( g->ew );
+   if( g->vw != NULL ) free( g->vw );
+   if( g->xc != NULL ) free( g->xc );
+   memset( g, 0, sizeof(struct incg_part_graph_s) );
+}
+
+
+//
+// Function to allocate the arrays of a graph of "n" vertices, except for the
+// adjacency
+//
+static int incg_Part_AllocGraph( struct incg_part_graph_s* g, long int n )
+{
+   memset( g, 0, sizeof(struct incg_part_graph_s) );
+   g->n = n;
+   g->xadj = (long int *) malloc( ((size_t) n+1) * sizeof( long int ) );
+   g->vw = (long int *) malloc( ((size_t) n+1) * sizeof( long int ) );
+   g->xc = (double *) malloc( ((size_t) 3*n+1) * sizeof( double ) );
+   if( g->xadj == NULL || g->vw == NULL || g->xc == NULL ) {
+      incg_Part_FreeGraph( g );
+      return -1;
+   }
+
+   return 0;
+}
+
+
+//
+// Function to turn the counts of the rows of a graph into offsets and to
+// allocate its adjacency
+//
+static int incg_Part_AllocAdj( struct incg_part_graph_s* g )
+{
+   long int na;
+
+   na = incg_Sort_ScanExclusive( g->n, g->xadj );
+   g->xadj[ g->n ] = na;
+   g->adj = (long int *) malloc( ((size_t) na+1) * sizeof( long int ) );
+   g->ew = (long int *) malloc( ((size_t) na+1) * sizeof( long int ) );
+   if( g->adj == NULL || g->ew == NULL ) return -1;
+
+   return 0;
+}
+
+
+//
+// Function to sort the rows of a graph, to merge repeated neighbours (adding
+// their weights) and to drop self-references, and to compact the adjacency
+//
+static int incg_Part_MergeRows( struct incg_part_graph_s* g )
+{
+   long int n = g->n, *cnt, *adj, *ew, i;
+
+
+   cnt = (long int *) malloc( ((size_t) n+1) * sizeof( long int ) );
+   if( cnt == NULL ) return -1;
+
+#pragma omp parallel for schedule(dynamic,4096)
+   for(i=0;i<n;++i) {
+      long int j0 = g->xadj[i], j1 = g->xadj[i+1], j,k,m=0;
+
+      // (rows are short)
+      for(j=j0+1;j<j1;++j) {
+         long int a = g->adj[j], w = g->ew[j];
+         for(k=j-1;k>=j0 && g->adj[k] > a;--k) {
+            g->adj[k+1] = g->adj[k];
+            g->ew[k+1] = g->ew[k];
+         }
+         g->adj[k+1] = a;
+         g->ew[k+1] = w;
+      }
+      for(j=j0;j<j1;++j) {
+         if( g->adj[j] == i ) continue;
+         if( m > 0 && g->adj[j0+m-1] == g->adj[j] ) {
+            g->ew[j0+m-1] += g->ew[j];
+         } else {
+            g->adj[j0+m] = g->adj[j];
+            g->ew[j0+m] = g->ew[j];
+            ++m;
+         }
+      }
+      cnt[i] = m;
+   }
+   cnt[n] = incg_Sort_ScanExclusive( n, cnt );
+
+   adj = (long int *) malloc( ((size_t) cnt[n]+1) * sizeof( long int ) );
+   ew = (long int *) malloc( ((size_t) cnt[n]+1) * sizeof( long int ) );
+   if( adj == NULL || ew == NULL ) {
+      if( adj != NULL ) free( adj );
+      if( ew != NULL ) free( ew );
+      free( cnt );
+      return -1;
+   }
+#pragma omp parallel for schedule(dynamic,4096)
+   for(i=0;i<n;++i) {
+      long int k, j0 = g->xadj[i];
+      for(k=0;k<cnt[i+1]-cnt[i];++k) {
+         adj[ cnt[i]+k ] = g->adj[ j0+k ];
+         ew[ cnt[i]+k ] = g->ew[ j0+k ];
+      }
+   }
+   free( g->xadj );
+   free( g->adj );
+   free( g->ew );
+   g->xadj = cnt;
+   g->adj = adj;
+   g->ew = ew;
+
+   return 0;
+}
+
+
+//
+// Function to return the corners of the triangles of a mesh object as an
+// array of four vertices per element (the fourth is -1)
+//
+static long int* incg_Part_MeshCorners( const mesh_t* m )
+{
+   long int *ev, i;
+
+   ev = (long int *) malloc( ((size_t) 4*m->nt+1) * sizeof( long int ) );
+   if( ev == NULL ) return NULL;
+
+#pragma omp parallel for
+   for(i=0;i<m->nt;++i) {
+      const triangle_t *t = &( m->t[i] );
+      ev[4*i+0] = t->d1 == 0 ? t->e1->va->id : t->e1->vb->id;
+      ev[4*i+1] = t->d2 == 0 ? t->e2->va->id : t->e2->vb->id;
+      ev[4*i+2] = t->d3 == 0 ? t->e3->va->id : t->e3->vb->id;
+      ev[4*i+3] = -1;
+   }
+
+   return ev;
+}
+
+
+//
+// Function to form the dual graph of a mesh object: triangles are its
+// vertices, and the edges with triangles on both sides are its edges
+//
+static int incg_Part_DualMesh( const mesh_t* m, struct incg_part_graph_s* g )
+{
+   long int nt = m->nt, i;
+
+
+   if( incg_Part_AllocGraph( g, nt ) ) return -1;
+
+#pragma omp parallel for
+   for(i=0;i<nt;++i) {
+      const triangle_t *t = &( m->t[i] );
+      const vertex_t *v[3];
+      int k;
+
+      g->xadj[i] = ( t->e1->tr != NULL ) + ( t->e2->tr != NULL ) +
+                   ( t->e3->tr != NULL );
+      g->vw[i] = 1;
+      v[0] = t->d1 == 0 ? t->e1->va : t->e1->vb;
+      v[1] = t->d2 == 0 ? t->e2->va : t->e2->vb;
+      v[2] = t->d3 == 0 ? t->e3->va : t->e3->vb;
+      for(k=0;k<3;++k) g->xc[3*i+k] = 0.0;
+      for(k=0;k<3;++k) {
+         g->xc[3*i+0] += v[k]->x / 3.0;
+         g->xc[3*i+1] += v[k]->y / 3.0;
+         g->xc[3*i+2] += v[k]->z / 3.0;
+      }
+   }
+   if( incg_Part_AllocAdj( g ) ) {
+      incg_Part_FreeGraph( g );
+      return -1;
+   }
+
+#pragma omp parallel for
+   for(i=0;i<nt;++i) {
+      const triangle_t *t = &( m->t[i] );
+      const edge_t *e[3] = { t->e1, t->e2, t->e3 };
+      long int j = g->xadj[i];
+      int k;
+
+      for(k=0;k<3;++k) {
+         if( e[k]->tr == NULL ) continue;
+         g->adj[j] = ( e[k]->tl == t ? e[k]->tr : e[k]->tl ) - m->t;
+         g->ew[j] = 1;
+         ++j;
+      }
+   }
+
+   return 0;
+}
+
+
+//
+// Function to form the dual graph of a list of faces (triangles, or quads
+// when the fourth node is not negative) with its vertices' coordinates. Sides
+// of faces are matched by a radix sort of their (min,max) node pairs, and the
+// faces along a side are all connected to each other.
+//
+static int incg_Part_DualFaces( long int nv, const double* x,
+                                long int nf, const long int* faces,
+                                struct incg_part_graph_s* g )
+{
+   unsigned long *key=NULL, kend;
+   long int *val=NULL, *pos=NULL, ns,i;
+   int nbits,ierr=0;
+
+
+   if( incg_Part_AllocGraph( g, nf ) ) return -1;
+
+   // keys of all sides; the unused fourth sides of triangles go last
+   ns = 4*nf;
+   nbits = incg_Sort_NumBits( (unsigned long) nv );
+   kend = ( ((unsigned long) nv) << nbits ) | ((unsigned long) nv);
+   key = (unsigned long *) malloc( ((size_t) ns) * sizeof( unsigned long ) );
+   val = (long int *) malloc( ((size_t) ns) * sizeof( long int ) );
+   pos = (long int *) malloc( ((size_t) nf+1) * sizeof( long int ) );
+   if( key == NULL || val == NULL || pos == NULL ) {
+      ierr = -1;
+      goto cleanup;
+   }
+#pragma omp parallel for
+   for(i=0;i<nf;++i) {
+      int k, nk = faces[4*i+3] < 0 ? 3 : 4;
+
+      g->xadj[i] = 0;
+      g->vw[i] = 1;
+      g->xc[3*i+0] = 0.0;
+      g->xc[3*i+1] = 0.0;
+      g->xc[3*i+2] = 0.0;
+      for(k=0;k<4;++k) {
+         key[4*i+k] = kend;
+         val[4*i+k] = 4*i+k;
+      }
+      for(k=0;k<nk;++k) {
+         unsigned long ia = (unsigned long) faces[4*i+k];
+         unsigned long ib = (unsigned long) faces[4*i+(k+1)%nk];
+         if( ia < ib ) key[4*i+k] = ( ia << nbits ) | ib;
+         else          key[4*i+k] = ( ib << nbits ) | ia;
+         g->xc[3*i+0] += x[3*ia+0] / nk;
+         g->xc[3*i+1] += x[3*ia+1] / nk;
+         g->xc[3*i+2] += x[3*ia+2] / nk;
+      }
+   }
+   ierr = incg_Sort_RadixKeys( ns, key, val, 2*nbits );
+   if( ierr ) goto cleanup;
+
+   // count, allocate and fill the rows from the runs of equal sides
+#pragma omp parallel for schedule(dynamic,4096)
+   for(i=0;i<ns;++i) {
+      long int nr,k;
+      if( key[i] == kend || ( i > 0 && key[i] == key[i-1] ) ) continue;
+      for(nr=1;i+nr<ns && key[i+nr]==key[i];++nr);
+      for(k=0;k<nr;++k) {
+#pragma omp atomic
+         g->xadj[ val[i+k]/4 ] += nr-1;
+      }
+   }
+   if( incg_Part_AllocAdj( g ) ) {
+      ierr = -1;
+      goto cleanup;
+   }
+#pragma omp parallel for
+   for(i=0;i<nf;++i) pos[i] = g->xadj[i];
+#pragma omp parallel for schedule(dynamic,4096)
+   for(i=0;i<ns;++i) {
+      long int nr,k,l,j;
+      if( key[i] == kend || ( i > 0 && key[i] == key[i-1] ) ) continue;
+      for(nr=1;i+nr<ns && key[i+nr]==key[i];++nr);
+      for(k=0;k<nr;++k) {
+         for(l=0;l<nr;++l) {
+            if( l == k ) continue;
+#pragma omp atomic capture
+            j = pos[ val[i+k]/4 ]++;
+            g->adj[j] = val[i+l]/4;
+            g->ew[j] = 1;
+         }
+      }
+   }
+   ierr = incg_Part_MergeRows( g );
+
+cleanup:
+   if( key != NULL ) free( key );
+   if( val != NULL ) free( val );
+   if( pos != NULL ) free( pos );
+   if( ierr ) incg_Part_FreeGraph( g );
+
+   return ierr;
+}
+
+
+//
+// Function to partition (weighted) points by recursive coordinate bisection.
+// Ranges of the points are split across the longest side of their bounding
+// box, at the weighted fraction of the parts that go to each side, after a
+// (parallel) radix sort of the quantized coordinates. Weights may be null.
+//
+static int incg_Part_RCB( long int n, const double* xc, const long int* vw,
+                          int npart, int* part )
+{
+   struct incg_part_range_s *work=NULL;
+   unsigned long *key=NULL;
+   long int *idx=NULL, *w=NULL, i;
+   int nw=0, iw, ierr=0;
+
+
+   work = (struct incg_part_range_s *)
+          malloc( ((size_t) 2*npart) * sizeof( struct incg_part_range_s ) );
+   key = (unsigned long *) malloc( ((size_t) n+1) * sizeof( unsigned long ) );
+   idx = (long int *) malloc( ((size_t) n+1) * sizeof( long int ) );
+   w = (long int *) malloc( ((size_t) n+1) * sizeof( long int ) );
+   if( work == NULL || key == NULL || idx == NULL || w == NULL ) {
+      ierr = -1;
+      goto cleanup;
+   }
+
+#pragma omp parallel for
+   for(i=0;i<n;++i) idx[i] = i;
+   work[0].i0 = 0;
+   work[0].i1 = n;
+   work[0].p0 = 0;
+   work[0].np = npart;
+   nw = 1;
+
+   for(iw=0;iw<nw;++iw) {
+      long int i0 = work[iw].i0, i1 = work[iw].i1, nr = i1 - i0, s;
+      int p0 = work[iw].p0, np = work[iw].np, nl = np/2, ia=0;
+      double lo[3] = { 1.0e300, 1.0e300, 1.0e300 };
+      double hi[3] = { -1.0e300, -1.0e300, -1.0e300 };
+      double xl=lo[0],yl=lo[1],zl=lo[2],xh=hi[0],yh=hi[1],zh=hi[2];
+      double wt;
+
+      if( np == 1 ) {
+#pragma omp parallel for
+         for(i=i0;i<i1;++i) part[ idx[i] ] = p0;
+         continue;
+      }
+
+      // bounding box of the range and its longest side
+#pragma omp parallel for reduction(min:xl,yl,zl) reduction(max:xh,yh,zh)
+      for(i=i0;i<i1;++i) {
+         const double *p = &( xc[ 3*idx[i] ] );
+         if( p[0] < xl ) xl = p[0];
+         if( p[1] < yl ) yl = p[1];
+         if( p[2] < zl ) zl = p[2];
+         if( p[0] > xh ) xh = p[0];
+         if( p[1] > yh ) yh = p[1];
+         if( p[2] > zh ) zh = p[2];
+      }
+      lo[0] = xl; lo[1] = yl; lo[2] = zl;
+      hi[0] = xh; hi[1] = yh; hi[2] = zh;
+      if( hi[1] - lo[1] > hi[ia] - lo[ia] ) ia = 1;
+      if( hi[2] - lo[2] > hi[ia] - lo[ia] ) ia = 2;
+
+      // sort the range by the coordinate and scan its weights
+      wt = hi[ia] > lo[ia] ?
+           ( (double) ( (1L << INCG_PART_NBITS) - 1 ) ) / ( hi[ia] - lo[ia] ) :
+           0.0;
+#pragma omp parallel for
+      for(i=i0;i<i1;++i) {
+         key[i] = (unsigned long) ( ( xc[ 3*idx[i] + ia ] - lo[ia] ) * wt );
+      }
+      ierr = incg_Sort_RadixKeys( nr, &( key[i0] ), &( idx[i0] ),
+                                  INCG_PART_NBITS );
+      if( ierr ) goto cleanup;
+#pragma omp parallel for
+      for(i=i0;i<i1;++i) w[i] = vw != NULL ? vw[ idx[i] ] : 1;
+      wt = (double) incg_Sort_ScanExclusive( nr, &( w[i0] ) );
+
+      // the split is where the scan is nearest the left side's share
+      wt = wt * nl / np;
+      {  long int a=0, b=nr;
+         while( a < b ) {
+            long int c = (a+b)/2;
+            if( w[i0+c] < wt ) a = c+1;
+            else b = c;
+         }
+         s = a;
+      }
+      if( s > 0 && s < nr && wt - w[i0+s-1] < w[i0+s] - wt ) --s;
+
+      work[nw].i0 = i0;
+      work[nw].i1 = i0+s;
+      work[nw].p0 = p0;
+      work[nw].np = nl;
+      ++nw;
+      work[nw].i0 = i0+s;
+      work[nw].i1 = i1;
+      work[nw].p0 = p0+nl;
+      work[nw].np = np-nl;
+      ++nw;
+   }
+
+cleanup:
+   if( work != NULL ) free( work );
+   if( key != NULL ) free( key );
+   if( idx != NULL ) free( idx );
+   if( w != NULL ) free( w );
+
+   return ierr;
+}
+
+
+//
+// Function to return a pseudo-random priority of an edge of a graph (used to
+// break ties in the matching without a bias to the numbering)
+//
+static unsigned long incg_Part_Hash( long int a, long int b )
+{
+   unsigned long h;
+
+   if( a > b ) {
+      long int t = a;
+      a = b;
+      b = t;
+   }
+   h = ((unsigned long) a) * 0x9E3779B97F4A7C15UL ^ ((unsigned long) b);
+   h ^= h >> 31;
+   h *= 0xBF58476D1CE4E5B9UL;
+   h ^= h >> 29;
+
+   return h;
+}
+
+
+//
+// Function to coarsen a graph by a parallel heavy-edge matching: in rounds,
+// every unmatched vertex proposes to its unmatched neighbour across its
+// heaviest edge (that keeps the merged weight under "maxvw"), and mutual
+// proposals are matched. Matched pairs become the vertices of the coarse
+// graph, which are numbered in the order of their lower vertex; "cmap" maps
+// the vertices to them. Returns the size of the coarse graph (or -1).
+//
+static long int incg_Part_Coarsen( const struct incg_part_graph_s* g,
+                                   long int maxvw, long int* cmap,
+                                   struct incg_part_graph_s* gc )
+{
+   long int n = g->n, *match=NULL, *prop=NULL, *first=NULL, nc=-1,i;
+   int ir;
+
+
+   match = (long int *) malloc( ((size_t) n+1) * sizeof( long int ) );
+   prop = (long int *) malloc( ((size_t) n+1) * sizeof( long int ) );
+   if( match == NULL || prop == NULL ) goto cleanup;
+
+#pragma omp parallel for
+   for(i=0;i<n;++i) match[i] = -1;
+
+   for(ir=0;ir<INCG_PART_NMATCH;++ir) {
+      long int nm=0;
+
+#pragma omp parallel for schedule(dynamic,4096)
+      for(i=0;i<n;++i) {
+         unsigned long hb=0, h;
+         long int j,u,wb=0;
+
+         prop[i] = -1;
+         if( match[i] >= 0 ) continue;
+         for(j=g->xadj[i];j<g->xadj[i+1];++j) {
+            u = g->adj[j];
+            if( match[u] >= 0 || g->vw[i] + g->vw[u] > maxvw ) continue;
+            h = incg_Part_Hash( i, u );
+            if( g->ew[j] > wb || ( g->ew[j] == wb && h > hb ) ) {
+               wb = g->ew[j];
+               hb = h;
+               prop[i] = u;
+            }
+         }
+      }
+#pragma omp parallel for reduction(+:nm)
+      for(i=0;i<n;++i) {
+         if( prop[i] >= 0 && prop[ prop[i] ] == i ) {
+            match[i] = prop[i];
+            ++nm;
+         }
+      }
+      if( nm == 0 ) break;
+   }
+
+   // number the coarse vertices by their lower vertex
+#pragma omp parallel for
+   for(i=0;i<n;++i) {
+      if( match[i] < 0 ) match[i] = i;
+      prop[i] = match[i] >= i ? 1 : 0;
+   }
+   nc = incg_Sort_ScanExclusive( n, prop );
+#pragma omp parallel for
+   for(i=0;i<n;++i) {
+      cmap[i] = prop[ match[i] < i ? match[i] : i ];
+   }
+
+   // the coarse graph
+   if( incg_Part_AllocGraph( gc, nc ) ) {
+      nc = -1;
+      goto cleanup;
+   }
+   first = (long int *) malloc( ((size_t) nc+1) * sizeof( long int ) );
+   if( first == NULL ) {
+      incg_Part_FreeGraph( gc );
+      nc = -1;
+      goto cleanup;
+   }
+#pragma omp parallel for
+   for(i=0;i<n;++i) {
+      if( match[i] >= i ) first[ cmap[i] ] = i;
+   }
+#pragma omp parallel for
+   for(i=0;i<nc;++i) {
+      long int a = first[i], b = match[a];
+      double wa = (double) g->vw[a], wb = 0.0;
+      int k;
+
+      gc->xadj[i] = g->xadj[a+1] - g->xadj[a];
+      gc->vw[i] = g->vw[a];
+      if( b != a ) {
+         gc->xadj[i] += g->xadj[b+1] - g->xadj[b];
+         gc->vw[i] += g->vw[b];
+         wb = (double) g->vw[b];
+      }
+      for(k=0;k<3;++k) {
+         gc->xc[3*i+k] = ( wa*g->xc[3*a+k] + wb*g->xc[3*b+k] ) / ( wa + wb );
+      }
+   }
+   if( incg_Part_AllocAdj( gc ) ) {
+      incg_Part_FreeGraph( gc );
+      nc = -1;
+      goto cleanup;
+   }
+#pragma omp parallel for
+   for(i=0;i<nc;++i) {
+      long int a = first[i], b = match[a], j, k = gc->xadj[i];
+
+      for(j=g->xadj[a];j<g->xadj[a+1];++j,++k) {
+         gc->adj[k] = cmap[ g->adj[j] ];
+         gc->ew[k] = g->ew[j];
+      }
+      if( b == a ) continue;
+      for(j=g->xadj[b];j<g->xadj[b+1];++j,++k) {
+         gc->adj[k] = cmap[ g->adj[j] ];
+         gc->ew[k] = g->ew[j];
+      }
+   }
+   if( incg_Part_MergeRows( gc ) ) {
+      incg_Part_FreeGraph( gc );
+      nc = -1;
+   }
+
+cleanup:
+   if( match != NULL ) free( match );
+   if( prop != NULL ) free( prop );
+   if( first != NULL ) free( first );
+
+   return nc;
+}
+
+
+//
+// Function to refine a partition of a graph by parallel greedy passes over
+// its vertices. A vertex at a boundary moves to the neighbouring part that it
+// is most connected to when that reduces the cut (or the imbalance without
+// increasing the cut, or relieves an overweight part) and the receiving part
+// stays under "maxw". Moves are decided against the partition of the previous
+// pass, and only towards higher parts in odd passes and lower parts in even
+// passes, so that two neighbours cannot swap over the same cut edge.
+//
+static int incg_Part_Refine( const struct incg_part_graph_s* g, int npart,
+                             long int maxw, int* part, int* pnew,
+                             long int* pw, long int* conn )
+{
+   long int n = g->n, i;
+   int ip,nthr=1;
+
+
+#ifdef _OPENMP
+   nthr = omp_get_max_threads();
+#endif
+   // weights of the parts (with the scratch of the threads, left zeroed)
+   for(ip=0;ip<npart;++ip) pw[ip] = 0;
+#pragma omp parallel num_threads( nthr )
+{  long int *c = conn;
+   int it=0, k;
+
+#ifdef _OPENMP
+   it = omp_get_thread_num();
+#endif
+   c = &( conn[ ((long int) it)*npart ] );
+#pragma omp for
+   for(i=0;i<n;++i) c[ part[i] ] += g->vw[i];
+#pragma omp critical
+   for(k=0;k<npart;++k) {
+      pw[k] += c[k];
+      c[k] = 0;
+   }
+}
+
+   for(ip=0;ip<INCG_PART_NPASS;++ip) {
+      long int nmove=0;
+
+#pragma omp parallel num_threads( nthr )
+{     long int *c = conn;
+      int it=0;
+
+#ifdef _OPENMP
+      it = omp_get_thread_num();
+#endif
+      c = &( conn[ ((long int) it)*npart ] );
+
+#pragma omp for schedule(dynamic,4096) reduction(+:nmove)
+      for(i=0;i<n;++i) {
+         long int j, w = g->vw[i], gain, pp, pq, nq;
+         int p = part[i], q = -1, ok;
+
+         pnew[i] = p;
+         for(j=g->xadj[i];j<g->xadj[i+1];++j) {
+            c[ part[ g->adj[j] ] ] += g->ew[j];
+         }
+         for(j=g->xadj[i];j<g->xadj[i+1];++j) {
+            int r = part[ g->adj[j] ];
+            if( r == p ) continue;
+            if( q < 0 || c[r] > c[q] || ( c[r] == c[q] && r < q ) ) q = r;
+         }
+         if( q >= 0 && ( ip % 2 == 0 ? q < p : q > p ) ) {
+            gain = c[q] - c[p];
+#pragma omp atomic read
+            pp = pw[p];
+#pragma omp atomic read
+            pq = pw[q];
+            ok = 0;
+            if( gain > 0 ) ok = 1;
+            if( gain == 0 && pq + w < pp ) ok = 1;
+            if( pp > maxw ) ok = 1;
+            if( ok ) {
+#pragma omp atomic capture
+               nq = pw[q] += w;
+               if( nq > maxw && !( pp > maxw && nq < pp ) ) {
+#pragma omp atomic
+                  pw[q] -= w;
+               } else {
+#pragma omp atomic
+                  pw[p] -= w;
+                  pnew[i] = q;
+                  ++nmove;
+               }
+            }
+         }
+         for(j=g->xadj[i];j<g->xadj[i+1];++j) c[ part[ g->adj[j] ] ] = 0;
+         c[p] = 0;
+      }
+
+#pragma omp for
+      for(i=0;i<n;++i) part[i] = pnew[i];
+}
+      if( nmove == 0 && ip % 2 == 1 ) break;
+   }
+
+   return 0;
+}
+
+
+//
+// Function to partition a graph by multilevel recursive coarsening, a
+// partition of the coarsest graph by (weighted) coordinate bisection of its
+// vertices, and refinement of the partition at every level on the way back
+//
+static int incg_Part_Multilevel( const struct incg_part_graph_s* g0,
+                                 int npart, int* part )
+{
+   struct incg_part_graph_s gl[INCG_PART_MAXLEVEL];
+   long int *cmap[INCG_PART_MAXLEVEL];
+   int *pl[INCG_PART_MAXLEVEL];
+   long int *pw=NULL, *conn=NULL, maxvw, maxw, i;
+   int *pnew=NULL, nl=1, l, nthr=1, ierr=0;
+
+
+#ifdef _OPENMP
+   nthr = omp_get_max_threads();
+#endif
+   memset( gl, 0, sizeof( gl ) );
+   memset( cmap, 0, sizeof( cmap ) );
+   memset( pl, 0, sizeof( pl ) );
+   gl[0] = *g0;
+   pl[0] = part;
+
+   // coarsen (total weight is the number of elements)
+   maxvw = (long int) ( 1.5 * g0->n / ( (double) INCG_PART_COARSEST*npart ) );
+   if( maxvw < 2 ) maxvw = 2;
+   while( gl[nl-1].n > INCG_PART_COARSEST*npart && nl < INCG_PART_MAXLEVEL ) {
+      long int nc;
+
+      cmap[nl-1] = (long int *) malloc( ((size_t) gl[nl-1].n+1) *
+                                        sizeof( long int ) );
+      if( cmap[nl-1] == NULL ) {
+         ierr = -1;
+         goto cleanup;
+      }
+      nc = incg_Part_Coarsen( &( gl[nl-1] ), maxvw, cmap[nl-1], &( gl[nl] ) );
+      if( nc < 0 ) {
+         ierr = -1;
+         goto cleanup;
+      }
+      if( nc > 0.95 * gl[nl-1].n ) {
+         incg_Part_FreeGraph( &( gl[nl] ) );
+         break;
+      }
+      pl[nl] = (int *) malloc( ((size_t) nc+1) * sizeof( int ) );
+      ++nl;
+      if( pl[nl-1] == NULL ) {
+         ierr = -1;
+         goto cleanup;
+      }
+   }
+
+   pnew = (int *) malloc( ((size_t) g0->n+1) * sizeof( int ) );
+   pw = (long int *) malloc( ((size_t) npart) * sizeof( long int ) );
+   conn = (long int *) calloc( ((size_t) nthr)*npart, sizeof( long int ) );
+   if( pnew == NULL || pw == NULL || conn == NULL ) {
+      ierr = -1;
+      goto cleanup;
+   }
+   maxw = (long int) ( ( 1.0 + INCG_PART_TOLERANCE ) * g0->n / npart ) + 1;
+
+   // partition the coarsest graph and refine it back
+   ierr = incg_Part_RCB( gl[nl-1].n, gl[nl-1].xc, gl[nl-1].vw, npart,
+                         pl[nl-1] );
+   if( ierr ) goto cleanup;
+   for(l=nl-1;l>=0;--l) {
+      if( l < nl-1 ) {
+#pragma omp parallel for
+         for(i=0;i<gl[l].n;++i) pl[l][i] = pl[l+1][ cmap[l][i] ];
+      }
+      (void) incg_Part_Refine( &( gl[l] ), npart, maxw, pl[l], pnew, pw, conn );
+   }
+
+cleanup:
+   for(l=1;l<INCG_PART_MAXLEVEL;++l) {
+      incg_Part_FreeGraph( &( gl[l] ) );
+      if( pl[l] != NULL ) free( pl[l] );
+   }
+   for(l=0;l<INCG_PART_MAXLEVEL;++l) if( cmap[l] != NULL ) free( cmap[l] );
+   if( pnew != NULL ) free( pnew );
+   if( pw != NULL ) free( pw );
+   if( conn != NULL ) free( conn );
+
+   return ierr;
+}
+
+
+//
+// Function to partition a dual graph by a method and to measure the quality
+// of the partition
+//
+static int incg_Part_Graph( const struct incg_part_graph_s* g, int npart,
+                            int method, struct incg_part_s* p )
+{
+   long int *cnt=NULL, cut=0, nmax=0, i;
+   int nthr=1, ierr=0;
+
+
+   memset( p, 0, sizeof(struct incg_part_s) );
+   p->nel = g->n;
+   p->npart = npart;
+#ifdef _OPENMP
+   nthr = omp_get_max_threads();
+#endif
+   p->part = (int *) malloc( ((size_t) g->n+1) * sizeof( int ) );
+   p->nelp = (long int *) malloc( ((size_t) npart) * sizeof( long int ) );
+   cnt = (long int *) calloc( ((size_t) nthr)*npart, sizeof( long int ) );
+   if( p->part == NULL || p->nelp == NULL || cnt == NULL ) {
+      ierr = -1;
+      goto cleanup;
+   }
+
+   if( method == INCG_PART_RCB ) {
+      ierr = incg_Part_RCB( g->n, g->xc, NULL, npart, p->part );
+   } else {
+      ierr = incg_Part_Multilevel( g, npart, p->part );
+   }
+   if( ierr ) goto cleanup;
+
+   // sizes of the parts and the cut
+#pragma omp parallel num_threads( nthr )
+{  long int *c = cnt;
+   int it=0;
+
+#ifdef _OPENMP
+   it = omp_get_thread_num();
+#endif
+   c = &( cnt[ ((long int) it)*npart ] );
+#pragma omp for reduction(+:cut)
+   for(i=0;i<g->n;++i) {
+      long int j;
+      c[ p->part[i] ] += 1;
+      for(j=g->xadj[i];j<g->xadj[i+1];++j) {
+         if( g->adj[j] > i && p->part[ g->adj[j] ] != p->part[i] ) {
+            cut += g->ew[j];
+         }
+      }
+   }
+}
+   for(i=0;i<npart;++i) {
+      int k;
+      p->nelp[i] = 0;
+      for(k=0;k<nthr;++k) p->nelp[i] += cnt[ ((long int) k)*npart + i ];
+      if( p->nelp[i] > nmax ) nmax = p->nelp[i];
+   }
+   p->edgecut = cut;
+   p->imbalance = g->n > 0 ? ((double) nmax) * npart / ((double) g->n) : 0.0;
+
+cleanup:
+   if( cnt != NULL ) free( cnt );
+   if( ierr ) incg_Part_Free( p );
+
+   return ierr;
+}
+
+
+//
+// Function to partition the triangles of a mesh object into "npart" parts by
+// a method (INCG_PART_*): recursive coordinate bisection of the triangles'
+// centroids, or multilevel partitioning of the dual graph (triangles joined
+// across their edges) with parts balanced to within INCG_PART_TOLERANCE
+//
+
+int incg_Part_Mesh( const mesh_t* m, int npart, int method,
+                    struct incg_part_s* p )
+{
+   struct incg_part_graph_s g;
+   int ierr;
+
+
+   if( m == NULL || p == NULL ) return 1;
+   if( m->nt <= 0 || npart <= 0 ) return 2;
+   if( method != INCG_PART_RCB && method != INCG_PART_GRAPH ) return 3;
+
+   ierr = incg_Part_DualMesh( m, &g );
+   if( ierr ) return ierr;
+   ierr = incg_Part_Graph( &g, npart, method, p );
+   incg_Part_FreeGraph( &g );
+
+   return ierr;
+}
+
+
+//
+// Function to partition a list of faces (triangles, or quads when the fourth
+// node is not negative, as in incg_MeshFile_WriteFaces()) into parts as in
+// incg_Part_Mesh(); faces are joined in the dual graph across shared sides
+//
+
+int incg_Part_Faces( long int nv, const double* x,
+                     long int nf, const long int* faces,
+                     int npart, int method, struct incg_part_s* p )
+{
+   struct incg_part_graph_s g;
+   long int i, nbad=0;
+   int ierr;
+
+
+   if( x == NULL || faces == NULL || p == NULL ) return 1;
+   if( nv <= 0 || nf <= 0 || npart <= 0 ) return 2;
+   if( method != INCG_PART_RCB && method != INCG_PART_GRAPH ) return 3;
+#pragma omp parallel for reduction(+:nbad)
+   for(i=0;i<nf;++i) {
+      int k, nk = faces[4*i+3] < 0 ? 3 : 4;
+      for(k=0;k<nk;++k) {
+         if( faces[4*i+k] < 0 || faces[4*i+k] >= nv ) ++nbad;
+      }
+   }
+   if( nbad ) return 4;
+
+   ierr = incg_Part_DualFaces( nv, x, nf, faces, &g );
+   if( ierr ) return ierr;
+   ierr = incg_Part_Graph( &g, npart, method, p );
+   incg_Part_FreeGraph( &g );
+
+   return ierr;
+}
+
+
+//
+// Function to compare two long integers (or the first of pairs of them) for
+// sorting with qsort()
+//
+static int incg_Part_CompareLong( const void* a, const void* b )
+{
+   long int x = *((const long int *) a), y = *((const long int *) b);
+
+   return ( x > y ) - ( x < y );
+}
+
+
+//
+// Function to sort a list and drop its repetitions; returns its new length
+//
+static long int incg_Part_SortUnique( long int n, long int* a )
+{
+   long int i,m=0;
+
+   if( n <= 0 ) return 0;
+   qsort( a, (size_t) n, sizeof( long int ), incg_Part_CompareLong );
+   for(i=0;i<n;++i) if( m == 0 || a[m-1] != a[i] ) a[m++] = a[i];
+
+   return m;
+}
+
+
+//
+// Function to return the position of a value in a sorted list (or -1)
+//
+static long int incg_Part_Search( long int n, const long int* a, long int x )
+{
+   long int lo=0, hi=n;
+
+   while( lo < hi ) {
+      long int c = (lo+hi)/2;
+      if( a[c] < x ) lo = c+1;
+      else hi = c;
+   }
+   if( lo < n && a[lo] == x ) return lo;
+
+   return -1;
+}
+
+
+//
+// Function to append a value to a list that grows as needed
+//
+static int incg_Part_Push( long int** a, long int* n, long int* nmax,
+                           long int x )
+{
+   if( *n == *nmax ) {
+      long int nn = 2*(*nmax) + 1024, *b;
+      b = (long int *) realloc( *a, ((size_t) nn) * sizeof( long int ) );
+      if( b == NULL ) return -1;
+      *a = b;
+      *nmax = nn;
+   }
+   (*a)[ (*n)++ ] = x;
+
+   return 0;
+}
+
+
+//
+// Function to form the local view of one part: its elements layer by layer
+// (the first ghost layer is only searched from vertices shared by parts),
+// its vertices, and its ghosts grouped by their owners in the receive lists
+// (with the owners as its neighbours, until the send lists are known)
+//
+static int incg_Part_Local( long int nel, const long int* ev,
+                            const long int* vofs, const long int* vel,
+                            const char* vshr, const int* part,
+                            long int nown, const long int* pel,
+                            int ip, int nlayer, struct incg_partmap_s* mp )
+{
+   long int *l=NULL, *vl=NULL, *rk=NULL, nl, nlmax, nvl=0, ng, i,j,k;
+   int il, ierr=0;
+
+
+   memset( mp, 0, sizeof(struct incg_partmap_s) );
+   mp->ipart = ip;
+   mp->nlayer = nlayer;
+   mp->nown = nown;
+   nlmax = nown + 1024;
+   mp->lofs = (long int *) malloc( ((size_t) nlayer+2) * sizeof( long int ) );
+   l = (long int *) malloc( ((size_t) nlmax) * sizeof( long int ) );
+   if( mp->lofs == NULL || l == NULL ) {
+      ierr = -1;
+      goto cleanup;
+   }
+   memcpy( l, pel, ((size_t) nown) * sizeof( long int ) );
+   nl = nown;
+   mp->lofs[0] = 0;
+   mp->lofs[1] = nown;
+
+   // layers of ghosts
+   for(il=1;il<=nlayer;++il) {
+      long int f0 = mp->lofs[il-1], f1 = mp->lofs[il];
+
+      for(i=f0;i<f1;++i) {
+         for(k=0;k<4;++k) {
+            long int v = ev[ 4*l[i] + k ];
+            if( v < 0 || ( il == 1 && vshr[v] == 0 ) ) continue;
+            for(j=vofs[v];j<vofs[v+1];++j) {
+               long int f = vel[j];
+               int m, is=0;
+
+               if( part[f] == ip ) continue;
+               for(m=1;m<il && is==0;++m) {
+                  if( incg_Part_Search( mp->lofs[m+1] - mp->lofs[m],
+                                        &( l[ mp->lofs[m] ] ), f ) >= 0 ) is=1;
+               }
+               if( is ) continue;
+               if( incg_Part_Push( &l, &nl, &nlmax, f ) ) {
+                  ierr = -1;
+                  goto cleanup;
+               }
+            }
+         }
+      }
+      nl = f1 + incg_Part_SortUnique( nl - f1, &( l[f1] ) );
+      mp->lofs[il+1] = nl;
+   }
+   mp->nel = nl;
+
+   // vertices
+   vl = (long int *) malloc( ((size_t) 4*nl+1) * sizeof( long int ) );
+   if( vl == NULL ) {
+      ierr = -1;
+      goto cleanup;
+   }
+   for(i=0;i<nl;++i) {
+      for(k=0;k<4;++k) if( ev[ 4*l[i] + k ] >= 0 ) vl[nvl++] = ev[ 4*l[i] + k ];
+   }
+   nvl = incg_Part_SortUnique( nvl, vl );
+   mp->nv = nvl;
+
+   // ghosts by owner and then by global ID
+   ng = nl - nown;
+   rk = (long int *) malloc( ((size_t) 2*ng+1) * sizeof( long int ) );
+   mp->recv = (long int *) malloc( ((size_t) ng+1) * sizeof( long int ) );
+   mp->nbr = (int *) malloc( ((size_t) ng+1) * sizeof( int ) );
+   mp->rofs = (long int *) malloc( ((size_t) ng+2) * sizeof( long int ) );
+   if( rk == NULL || mp->recv == NULL || mp->nbr == NULL || mp->rofs == NULL ) {
+      ierr = -1;
+      goto cleanup;
+   }
+   for(i=0;i<ng;++i) {
+      rk[2*i+0] = ((long int) part[ l[nown+i] ])*nel + l[nown+i];
+      rk[2*i+1] = nown+i;
+   }
+   qsort( rk, (size_t) ng, 2*sizeof( long int ), incg_Part_CompareLong );
+   for(i=0;i<ng;++i) {
+      int ipo = (int) ( rk[2*i] / nel );
+      mp->recv[i] = rk[2*i+1];
+      if( mp->nnbr == 0 || mp->nbr[ mp->nnbr-1 ] != ipo ) {
+         mp->nbr[ mp->nnbr ] = ipo;
+         mp->rofs[ mp->nnbr ] = i;
+         ++(mp->nnbr);
+      }
+   }
+   mp->rofs[ mp->nnbr ] = ng;
+
+cleanup:
+   if( rk != NULL ) free( rk );
+   if( ierr ) {
+      if( l != NULL ) free( l );
+      if( vl != NULL ) free( vl );
+      return ierr;
+   }
+   mp->l2g = l;
+   mp->vl2g = vl;
+
+   return 0;
+}
+
+
+//
+// Function to complete the local view of a part with its send lists, given
+// the ghosts of all parts sorted by (owner,part) in "key" (as owner*npart +
+// part) with their global IDs in "val", and to make the neighbours the union
+// of the parts that it sends to and receives from
+//
+static int incg_Part_Send( int npart, long int n0, long int n1,
+                           const unsigned long* key, const long int* val,
+                           struct incg_partmap_s* mp )
+{
+   long int *rofs=NULL, *sofs=NULL, *send=NULL, i;
+   int *nbr=NULL, ir=0, is=0, nn=0;
+
+
+   nbr = (int *) malloc( ((size_t) (mp->nnbr + (n1-n0)) + 1) * sizeof( int ) );
+   rofs = (long int *) malloc( ((size_t) (mp->nnbr + (n1-n0)) + 2) *
+                               sizeof( long int ) );
+   sofs = (long int *) malloc( ((size_t) (mp->nnbr + (n1-n0)) + 2) *
+                               sizeof( long int ) );
+   send = (long int *) malloc( ((size_t) (n1-n0)+1) * sizeof( long int ) );
+   if( nbr == NULL || rofs == NULL || sofs == NULL || send == NULL ) {
+      if( nbr != NULL ) free( nbr );
+      if( rofs != NULL ) free( rofs );
+      if( sofs != NULL ) free( sofs );
+      if( send != NULL ) free( send );
+      return -1;
+   }
+
+   // merge the sorted lists of parts to receive from and to send to
+   i = n0;
+   while( ir < mp->nnbr || i < n1 ) {
+      int qr = ir < mp->nnbr ? mp->nbr[ir] : npart;
+      int qs = i < n1 ? (int) ( key[i] % npart ) : npart;
+      int q = qr < qs ? qr : qs;
+
+      nbr[nn] = q;
+      rofs[nn] = mp->rofs[ir];       // (an empty range if not receiving)
+      sofs[nn] = is;
+      if( q == qr ) ++ir;
+      while( i < n1 && (int) ( key[i] % npart ) == q ) {
+         send[is++] = incg_Part_Search( mp->nown, mp->l2g, val[i] );
+         ++i;
+      }
+      ++nn;
+   }
+   rofs[nn] = mp->rofs[ mp->nnbr ];
+   sofs[nn] = is;
+
+   free( mp->nbr );
+   free( mp->rofs );
+   mp->nnbr = nn;
+   mp->nbr = nbr;
+   mp->rofs = rofs;
+   mp->sofs = sofs;
+   mp->send = send;
+
+   return 0;
+}
+
+
+//
+// Function to form the local views of all parts of a partition of elements
+// given by their vertices (four per element; negative when absent). The
+// elements of every vertex and the elements of every part are listed (the
+// latter by a radix sort of the parts), the parts are processed in parallel,
+// and the ghosts of all parts are sorted by owner to give the send lists.
+//
+static int incg_Part_Halo( long int nv, long int nel, const long int* ev,
+                           const struct incg_part_s* p, int nlayer,
+                           struct incg_partmap_s* maps )
+{
+   unsigned long *key=NULL;
+   long int *vofs=NULL, *vel=NULL, *pos=NULL, *pel=NULL, *pofs=NULL;
+   long int *gofs=NULL, *val=NULL, ng, i;
+   char *vshr=NULL;
+   int npart = p->npart, ip, ierr=0;
+
+
+   for(ip=0;ip<npart;++ip) memset( &( maps[ip] ), 0, sizeof(maps[ip]) );
+   vofs = (long int *) malloc( ((size_t) nv+1) * sizeof( long int ) );
+   pos = (long int *) malloc( ((size_t) nv+1) * sizeof( long int ) );
+   vel = (long int *) malloc( ((size_t) 4*nel+1) * sizeof( long int ) );
+   vshr = (char *) malloc( ((size_t) nv+1) * sizeof( char ) );
+   key = (unsigned long *) malloc( ((size_t) nel+1) * sizeof( unsigned long ) );
+   pel = (long int *) malloc( ((size_t) nel+1) * sizeof( long int ) );
+   pofs = (long int *) malloc( ((size_t) npart+1) * sizeof( long int ) );
+   gofs = (long int *) malloc( ((size_t) npart+1) * sizeof( long int ) );
+   if( vofs == NULL || pos == NULL || vel == NULL || vshr == NULL ||
+       key == NULL || pel == NULL || pofs == NULL || gofs == NULL ) {
+      ierr = -1;
+      goto cleanup;
+   }
+
+   // elements of the vertices (in no particular order)
+#pragma omp parallel for
+   for(i=0;i<nv;++i) vofs[i] = 0;
+#pragma omp parallel for
+   for(i=0;i<nel;++i) {
+      int k;
+      for(k=0;k<4;++k) {
+         if( ev[4*i+k] < 0 ) continue;
+#pragma omp atomic
+         vofs[ ev[4*i+k] ] += 1;
+      }
+   }
+   vofs[nv] = incg_Sort_ScanExclusive( nv, vofs );
+#pragma omp parallel for
+   for(i=0;i<nv;++i) pos[i] = vofs[i];
+#pragma omp parallel for
+   for(i=0;i<nel;++i) {
+      long int j;
+      int k;
+      for(k=0;k<4;++k) {
+         if( ev[4*i+k] < 0 ) continue;
+#pragma omp atomic capture
+         j = pos[ ev[4*i+k] ]++;
+         vel[j] = i;
+      }
+   }
+
+   // vertices shared by parts
+#pragma omp parallel for
+   for(i=0;i<nv;++i) {
+      long int j;
+      vshr[i] = 0;
+      for(j=vofs[i]+1;j<vofs[i+1];++j) {
+         if( p->part[ vel[j] ] != p->part[ vel[vofs[i]] ] ) vshr[i] = 1;
+      }
+   }
+
+   // elements of the parts in ascending order
+#pragma omp parallel for
+   for(i=0;i<nel;++i) {
+      key[i] = (unsigned long) p->part[i];
+      pel[i] = i;
+   }
+   ierr = incg_Sort_RadixKeys( nel, key, pel,
+                               incg_Sort_NumBits( (unsigned long) npart ) );
+   if( ierr ) goto cleanup;
+   for(ip=0;ip<npart;++ip) pofs[ip] = p->nelp[ip];
+   pofs[npart] = incg_Sort_ScanExclusive( npart, pofs );
+
+#pragma omp parallel for schedule(dynamic,1)
+   for(ip=0;ip<npart;++ip) {
+      int ie = incg_Part_Local( nel, ev, vofs, vel, vshr, p->part,
+                                pofs[ip+1] - pofs[ip], &( pel[ pofs[ip] ] ),
+                                ip, nlayer, &( maps[ip] ) );
+      if( ie ) {
+#pragma omp atomic write
+         ierr = ie;
+      }
+   }
+   if( ierr ) goto cleanup;
+
+   // ghosts of all parts sorted by (owner,part); within every pair the global
+   // IDs keep the ascending order of the receive lists
+   for(ip=0;ip<npart;++ip) gofs[ip] = maps[ip].nel - maps[ip].nown;
+   ng = incg_Sort_ScanExclusive( npart, gofs );
+   gofs[npart] = ng;
+   free( key );
+   key = (unsigned long *) malloc( ((size_t) ng+1) * sizeof( unsigned long ) );
+   val = (long int *) malloc( ((size_t) ng+1) * sizeof( long int ) );
+   if( key == NULL || val == NULL ) {
+      ierr = -1;
+      goto cleanup;
+   }
+#pragma omp parallel for schedule(dynamic,1)
+   for(ip=0;ip<npart;++ip) {
+      const struct incg_partmap_s *mp = &( maps[ip] );
+      long int j,k=gofs[ip];
+
+      for(j=0;j<mp->nel-mp->nown;++j,++k) {
+         val[k] = mp->l2g[ mp->recv[j] ];
+         key[k] = ((unsigned long) p->part[ val[k] ])*npart + ip;
+      }
+   }
+   ierr = incg_Sort_RadixKeys( ng, key, val, incg_Sort_NumBits(
+                                ((unsigned long) npart)*npart ) );
+   if( ierr ) goto cleanup;
+   for(ip=0;ip<=npart;++ip) {    // (offsets of the owners)
+      long int a=0, b=ng;
+      while( a < b ) {
+         long int c = (a+b)/2;
+         if( key[c] < ((unsigned long) ip)*npart ) a = c+1;
+         else b = c;
+      }
+      pofs[ip] = a;
+   }
+#pragma omp parallel for schedule(dynamic,1)
+   for(ip=0;ip<npart;++ip) {
+      int ie = incg_Part_Send( npart, pofs[ip], pofs[ip+1], key, val,
+                               &( maps[ip] ) );
+      if( ie ) {
+#pragma omp atomic write
+         ierr = ie;
+      }
+   }
+
+cleanup:
+   if( vofs != NULL ) free( vofs );
+   if( pos != NULL ) free( pos );
+   if( vel != NULL ) free( vel );
+   if( vshr != NULL ) free( vshr );
+   if( key != NULL ) free( key );
+   if( val != NULL ) free( val );
+   if( pel != NULL ) free( pel );
+   if( pofs != NULL ) free( pofs );
+   if( gofs != NULL ) free( gofs );
+   if( ierr ) incg_Part_FreeMaps( npart, maps );
+
+   return ierr;
+}
+
+
+//
+// Function to check that a partition fits a number of elements
+//
+static int incg_Part_Valid( const struct incg_part_s* p, long int nel )
+{
+   long int i, nbad=0;
+
+   if( p->nel != nel || p->npart <= 0 ) return 0;
+   if( p->part == NULL || p->nelp == NULL ) return 0;
+#pragma omp parallel for reduction(+:nbad)
+   for(i=0;i<nel;++i) {
+      if( p->part[i] < 0 || p->part[i] >= p->npart ) ++nbad;
+   }
+
+   return nbad == 0 ? 1 : 0;
+}
+
+
+//
+// Function to form the local views of the parts of a partition of the
+// triangles of a mesh object, with "nlayer" layers of ghosts (triangles that
+// share a vertex with the previous layer). Global IDs are the indices of the
+// triangles and the vertices. The array "maps" has one entry for every part.
+//
+
+int incg_Part_HaloMesh( const mesh_t* m, const struct incg_part_s* p,
+                        int nlayer, struct incg_partmap_s* maps )
+{
+   long int *ev;
+   int ierr;
+
+
+   if( m == NULL || p == NULL || maps == NULL ) return 1;
+   if( nlayer < 0 ) return 2;
+   if( incg_Part_Valid( p, m->nt ) == 0 ) return 3;
+
+   ev = incg_Part_MeshCorners( m );
+   if( ev == NULL ) return -1;
+   ierr = incg_Part_Halo( m->nv, m->nt, ev, p, nlayer, maps );
+   free( ev );
+
+   return ierr;
+}
+
+
+//
+// Function to form the local views of the parts of a partition of a list of
+// faces (as in incg_Part_Faces()); global IDs are the indices of the faces
+// and of the nodes
+//
+
+int incg_Part_HaloFaces( long int nv, long int nf, const long int* faces,
+                         const struct incg_part_s* p,
+                         int nlayer, struct incg_partmap_s* maps )
+{
+   long int i, nbad=0;
+
+
+   if( faces == NULL || p == NULL || maps == NULL ) return 1;
+   if( nlayer < 0 || nv <= 0 ) return 2;
+   if( incg_Part_Valid( p, nf ) == 0 ) return 3;
+#pragma omp parallel for reduction(+:nbad)
+   for(i=0;i<4*nf;++i) {
+      if( faces[i] >= nv || ( faces[i] < 0 && i%4 != 3 ) ) ++nbad;
+   }
+   if( nbad ) return 4;
+
+   return incg_Part_Halo( nv, nf, faces, p, nlayer, maps );
+}
+
+
+//
+// Function to report the quality of a partition (and the sizes of the local
+// views of its parts when they are given)
+//
+
+int incg_Part_Report( const struct incg_part_s* p,
+                      const struct incg_partmap_s* maps )
+{
+   long int nmin, nmax, gmin=0, gmax=0, gsum=0;
+   int ip, nnbr=0;
+
+
+   if( p == NULL || p->nelp == NULL ) return 1;
+
+   nmin = nmax = p->nelp[0];
+   for(ip=1;ip<p->npart;++ip) {
+      if( p->nelp[ip] < nmin ) nmin = p->nelp[ip];
+      if( p->nelp[ip] > nmax ) nmax = p->nelp[ip];
+   }
+   printf( "Partition: %d parts of %ld elements \n", p->npart, p->nel );
+   printf( "   part sizes %ld to %ld, imbalance %.4f \n",
+           nmin, nmax, p->imbalance );
+   printf( "   edge cut %ld \n", p->edgecut );
+
+   if( maps != NULL ) {
+      for(ip=0;ip<p->npart;++ip) {
+         long int ng = maps[ip].nel - maps[ip].nown;
+         if( ip == 0 || ng < gmin ) gmin = ng;
+         if( ip == 0 || ng > gmax ) gmax = ng;
+         gsum += ng;
+         if( maps[ip].nnbr > nnbr ) nnbr = maps[ip].nnbr;
+      }
+      printf( "   %d ghost layers: %ld ghosts (%ld to %ld per part), "
+              "up to %d neighbours \n", maps[0].nlayer, gsum, gmin, gmax,
+              nnbr );
+   }
+
+   return 0;
+}
+
+
+//
+// Function to release the arrays of a partition
+//
+
+int incg_Part_Free( struct incg_part_s* p )
+{
+   if( p == NULL ) return 1;
+   if( p->part != NULL ) free( p->part );
+   if( p->nelp != NULL ) free( p->nelp );
+   memset( p, 0, sizeof(struct incg_part_s) );
+
+   return 0;
+}
+
+
+//
+// Function to release the arrays of the local views of the parts
+//
+
+int incg_Part_FreeMaps( int npart, struct incg_partmap_s* maps )
+{
+   int ip;
+
+   if( maps == NULL ) return 1;
+   for(ip=0;ip<npart;++ip) {
+      struct incg_partmap_s *mp = &( maps[ip] );
+      if( mp->lofs != NULL ) free( mp->lofs );
+      if( mp->l2g != NULL ) free( mp->l2g );
+      if( mp->vl2g != NULL ) free( mp->vl2g );
+      if( mp->nbr != NULL ) free( mp->nbr );
+      if( mp->sofs != NULL ) free( mp->sofs );
+      if( mp->send != NULL ) free( mp->send );
+      if( mp->rofs != NULL ) free( mp->rofs );
+      if( mp->recv != NULL ) free( mp->recv );
+      memset( mp, 0, sizeof(struct incg_partmap_s) );
+   }
+
+   return 0;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
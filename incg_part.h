@@ -0,0 +1,81 @@
+
+#ifndef _INCG_PART_H_
+#define _INCG_PART_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "incg_mesh.h"
+
+// methods of partitioning
+#define INCG_PART_RCB           0   // recursive coordinate bisection
+#define INCG_PART_GRAPH         1   // multilevel partitioning of dual graph
+
+// allowed imbalance of the parts of the graph partitioner
+#define INCG_PART_TOLERANCE     0.03
+
+//
+// A partition of the elements (triangles or faces) of a mesh into parts, and
+// its quality: the number of element sides (edges of the dual graph) that are
+// cut, and the ratio of the largest part to the average part
+//
+struct incg_part_s {
+   long int nel;
+   int npart;
+   int *part;
+   long int *nelp;
+   long int edgecut;
+   double imbalance;
+};
+
+//
+// The local view of one part of a partition with its layers of ghost
+// elements (elements of other parts sharing a vertex with the previous
+// layer). Local elements are the owned elements and then the ghosts layer by
+// layer, each in ascending global ID; layer k is l2g[ lofs[k] ... lofs[k+1]-1 ]
+// with layer 0 the owned ones. Local vertices are those of the local elements
+// in ascending global ID. The elements to send to (receive from) neighbour
+// part nbr[k] are local indices send[ sofs[k] ... sofs[k+1]-1 ] (recv[] over
+// rofs[]), and the lists of two neighbours match in order.
+//
+struct incg_partmap_s {
+   int ipart, nlayer;
+   long int nown, nel;
+   long int *lofs, *l2g;
+   long int nv;
+   long int *vl2g;
+   int nnbr;
+   int *nbr;
+   long int *sofs, *send;
+   long int *rofs, *recv;
+};
+
+// -------------------- function prototypes/signatures --------------------
+
+int incg_Part_Mesh( const mesh_t* m, int npart, int method,
+                    struct incg_part_s* p );
+
+int incg_Part_Faces( long int nv, const double* x,
+                     long int nf, const long int* faces,
+                     int npart, int method, struct incg_part_s* p );
+
+int incg_Part_HaloMesh( const mesh_t* m, const struct incg_part_s* p,
+                        int nlayer, struct incg_partmap_s* maps );
+
+int incg_Part_HaloFaces( long int nv, long int nf, const long int* faces,
+                         const struct incg_part_s* p,
+                         int nlayer, struct incg_partmap_s* maps );
+
+int incg_Part_Report( const struct incg_part_s* p,
+                      const struct incg_partmap_s* maps );
+
+int incg_Part_Free( struct incg_part_s* p );
+
+int incg_Part_FreeMaps( int npart, struct incg_partmap_s* maps );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
@@ -0,0 +1,470 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "incg_qual.h"
+
+
+// ranges of the histograms of the metrics
+static const double incg_qual_lo[INCG_QUAL_NMETRIC] =
+                                       {   0.0,   0.0, 1.0, 0.0, -1.0,  0.0 };
+static const double incg_qual_hi[INCG_QUAL_NMETRIC] =
+                                       { 180.0, 180.0, 5.0, 1.0,  1.0, 90.0 };
+
+static const char *incg_qual_name[INCG_QUAL_NMETRIC] =
+   { "min. angle", "max. angle", "aspect", "skewness", "Jacobian", "warpage" };
+
+//
+// A tile of elements of the same kind, with the coordinates of their corners
+// and their metrics as structures of arrays over the elements
+//
+struct incg_qual_tile_s {
+   int n;
+   long int id[INCG_QUAL_TILE];
+   double x[4][INCG_QUAL_TILE], y[4][INCG_QUAL_TILE], z[4][INCG_QUAL_TILE];
+   double v[INCG_QUAL_NMETRIC][INCG_QUAL_TILE];
+};
+
+
+//
+// Function to prepare the statistics for accumulation
+//
+static void incg_Qual_Init( struct incg_qual_s* q )
+{
+   int k;
+
+   memset( q, 0, sizeof(struct incg_qual_s) );
+   for(k=0;k<INCG_QUAL_NMETRIC;++k) {
+      q->vmin[k] = HUGE_VAL;
+      q->vmax[k] = -HUGE_VAL;
+      q->lo[k] = incg_qual_lo[k];
+      q->hi[k] = incg_qual_hi[k];
+   }
+}
+
+
+//
+// Function to return a key that increases with the angle of a corner (over
+// [0,360) degrees) from its (scaled) cosine and sine, and the inverse
+//
+static inline double incg_Qual_AngleKey( double c, double s )
+{
+   return s >= 0.0 ? 1.0 - c : 3.0 + c;
+}
+
+static double incg_Qual_KeyAngle( double k )
+{
+   const double r2d = 180.0/M_PI;
+
+   k = k < 0.0 ? 0.0 : ( k > 4.0 ? 4.0 : k );
+   return k <= 2.0 ? acos( 1.0 - k ) * r2d : 360.0 - acos( k - 3.0 ) * r2d;
+}
+
+
+//
+// Function to compute the metrics of a tile of triangles. The arithmetic is
+// done over the elements as vectors (with square roots only), and leaves the
+// keys of the extreme angles to be turned to degrees in a short pass.
+//
+static void incg_Qual_TriTile( struct incg_qual_tile_s* t )
+{
+   const double s60 = 2.0/sqrt(3.0);
+   double *kmin = t->v[INCG_QUAL_MINANGLE], *kmax = t->v[INCG_QUAL_MAXANGLE];
+   int i;
+
+#pragma omp simd
+   for(i=0;i<t->n;++i) {
+      double ax,ay,az, bx,by,bz, cx,cy,cz, nx,ny,nz;
+      double la,lb,lc, s2, c0,c1,c2, lmin,lmax, p, pi, r, a;
+
+      // edges out of the corners 0,1,2 and the (doubled) area
+      ax = t->x[1][i] - t->x[0][i];
+      ay = t->y[1][i] - t->y[0][i];
+      az = t->z[1][i] - t->z[0][i];
+      bx = t->x[2][i] - t->x[1][i];
+      by = t->y[2][i] - t->y[1][i];
+      bz = t->z[2][i] - t->z[1][i];
+      cx = t->x[0][i] - t->x[2][i];
+      cy = t->y[0][i] - t->y[2][i];
+      cz = t->z[0][i] - t->z[2][i];
+      nx = ay*bz - az*by;
+      ny = az*bx - ax*bz;
+      nz = ax*by - ay*bx;
+      s2 = sqrt( nx*nx + ny*ny + nz*nz );
+      la = sqrt( ax*ax + ay*ay + az*az );
+      lb = sqrt( bx*bx + by*by + bz*bz );
+      lc = sqrt( cx*cx + cy*cy + cz*cz );
+
+      // cosines of the corners (the angles are ordered by them); divisions
+      // are by safe values, and branches only select, for the sake of SIMD
+      p = la*lb*lc;
+      pi = 1.0 / ( p > 0.0 ? p : 1.0 );
+      c0 = -( ax*cx + ay*cy + az*cz ) * lb * pi;
+      c1 = -( bx*ax + by*ay + bz*az ) * lc * pi;
+      c2 = -( cx*bx + cy*by + cz*bz ) * la * pi;
+      c0 = p > 0.0 ? c0 : 1.0;
+      c1 = p > 0.0 ? c1 : 1.0;
+      c2 = p > 0.0 ? c2 : 1.0;
+      a = c0 > c1 ? ( c0 > c2 ? c0 : c2 ) : ( c1 > c2 ? c1 : c2 );
+      kmin[i] = 1.0 - a;
+      a = c0 < c1 ? ( c0 < c2 ? c0 : c2 ) : ( c1 < c2 ? c1 : c2 );
+      kmax[i] = 1.0 - a;
+
+      lmin = la < lb ? ( la < lc ? la : lc ) : ( lb < lc ? lb : lc );
+      lmax = la > lb ? ( la > lc ? la : lc ) : ( lb > lc ? lb : lc );
+      r = la + lb + lc;
+      r = s2 / ( r > 0.0 ? r : 1.0 );  // radius of the inscribed circle
+      a = lmax / ( 2.0*sqrt(3.0)*( r > 0.0 ? r : 1.0 ) );
+      t->v[INCG_QUAL_ASPECT][i] = r > 0.0 ? a : 1.0e30;
+      // (the smallest sine is at the corner between the longest edges)
+      t->v[INCG_QUAL_JACOBIAN][i] = s60 * s2 * lmin * pi;
+      t->v[INCG_QUAL_WARPAGE][i] = 0.0;
+   }
+
+   for(i=0;i<t->n;++i) {
+      double amin = incg_Qual_KeyAngle( kmin[i] );
+      double amax = incg_Qual_KeyAngle( kmax[i] );
+
+      kmin[i] = amin;
+      kmax[i] = amax;
+      t->v[INCG_QUAL_SKEW][i] = ( amax - 60.0 )/120.0 > ( 60.0 - amin )/60.0 ?
+                                ( amax - 60.0 )/120.0 : ( 60.0 - amin )/60.0;
+   }
+}
+
+
+//
+// Function to compute the cosine and sine (signed by a unit normal) of the
+// corner between two edges, and the key of its angle
+//
+static inline double incg_Qual_Corner( double ux, double uy, double uz,
+                                       double vx, double vy, double vz,
+                                       double nx, double ny, double nz,
+                                       double lp, double* sn )
+{
+   double li = 1.0 / ( lp > 0.0 ? lp : 1.0 );
+   double c = ( ux*vx + uy*vy + uz*vz ) * li;
+   double s = ( ( uy*vz - uz*vy )*nx + ( uz*vx - ux*vz )*ny +
+                ( ux*vy - uy*vx )*nz ) * li;
+
+   c = lp > 0.0 ? c : 1.0;
+   s = lp > 0.0 ? s : -1.0;
+   *sn = s;
+
+   return incg_Qual_AngleKey( c, s );
+}
+
+
+//
+// Function to return the cosine of the fold between the triangles (0,1,2)
+// and (0,2,3) of four corners, from the edges out of corner 0
+//
+static inline double incg_Qual_Fold( double ax, double ay, double az,
+                                     double bx, double by, double bz,
+                                     double cx, double cy, double cz )
+{
+   double ux = ay*bz - az*by, uy = az*bx - ax*bz, uz = ax*by - ay*bx;
+   double vx = by*cz - bz*cy, vy = bz*cx - bx*cz, vz = bx*cy - by*cx;
+   double p = sqrt( ( ux*ux + uy*uy + uz*uz )*( vx*vx + vy*vy + vz*vz ) );
+   double c = ( ux*vx + uy*vy + uz*vz ) / ( p > 0.0 ? p : 1.0 );
+
+   return p > 0.0 ? c : 1.0;
+}
+
+
+//
+// Function to compute the metrics of a tile of quads. Corners turning against
+// the normal of the product of the diagonals are reflex (their angles are
+// over 180 degrees). As for triangles, the arithmetic is
+// done as vectors, and the angles are formed from their keys afterwards.
+//
+static void incg_Qual_QuadTile( struct incg_qual_tile_s* t )
+{
+   const double r2d = 180.0/M_PI;
+   double *kmin = t->v[INCG_QUAL_MINANGLE], *kmax = t->v[INCG_QUAL_MAXANGLE];
+   double *cw = t->v[INCG_QUAL_WARPAGE];
+   int i;
+
+#pragma omp simd
+   for(i=0;i<t->n;++i) {
+      double x0 = t->x[0][i], x1 = t->x[1][i], x2 = t->x[2][i], x3 = t->x[3][i];
+      double y0 = t->y[0][i], y1 = t->y[1][i], y2 = t->y[2][i], y3 = t->y[3][i];
+      double z0 = t->z[0][i], z1 = t->z[1][i], z2 = t->z[2][i], z3 = t->z[3][i];
+      double l0,l1,l2,l3, nx,ny,nz, s, k0,k1,k2,k3, s0,s1,s2,s3, c, d;
+
+      l0 = sqrt( (x1-x0)*(x1-x0) + (y1-y0)*(y1-y0) + (z1-z0)*(z1-z0) );
+      l1 = sqrt( (x2-x1)*(x2-x1) + (y2-y1)*(y2-y1) + (z2-z1)*(z2-z1) );
+      l2 = sqrt( (x3-x2)*(x3-x2) + (y3-y2)*(y3-y2) + (z3-z2)*(z3-z2) );
+      l3 = sqrt( (x0-x3)*(x0-x3) + (y0-y3)*(y0-y3) + (z0-z3)*(z0-z3) );
+
+      // unit normal from the product of the diagonals
+      nx = (y2-y0)*(z3-z1) - (z2-z0)*(y3-y1);
+      ny = (z2-z0)*(x3-x1) - (x2-x0)*(z3-z1);
+      nz = (x2-x0)*(y3-y1) - (y2-y0)*(x3-x1);
+      c = sqrt( nx*nx + ny*ny + nz*nz );
+      s = 1.0 / ( c > 0.0 ? c : 1.0 );
+      s = c > 0.0 ? s : 0.0;
+      nx *= s;
+      ny *= s;
+      nz *= s;
+
+      // corner k is between the edges to corners k+1 and k-1
+      k0 = incg_Qual_Corner( x1-x0, y1-y0, z1-z0, x3-x0, y3-y0, z3-z0,
+                             nx,ny,nz, l0*l3, &s0 );
+      k1 = incg_Qual_Corner( x2-x1, y2-y1, z2-z1, x0-x1, y0-y1, z0-z1,
+                             nx,ny,nz, l1*l0, &s1 );
+      k2 = incg_Qual_Corner( x3-x2, y3-y2, z3-z2, x1-x2, y1-y2, z1-z2,
+                             nx,ny,nz, l2*l1, &s2 );
+      k3 = incg_Qual_Corner( x0-x3, y0-y3, z0-z3, x2-x3, y2-y3, z2-z3,
+                             nx,ny,nz, l3*l2, &s3 );
+      kmin[i] = k0 < k1 ? ( k0 < k2 ? k0 : k2 ) : ( k1 < k2 ? k1 : k2 );
+      kmin[i] = kmin[i] < k3 ? kmin[i] : k3;
+      kmax[i] = k0 > k1 ? ( k0 > k2 ? k0 : k2 ) : ( k1 > k2 ? k1 : k2 );
+      kmax[i] = kmax[i] > k3 ? kmax[i] : k3;
+      s = s0 < s1 ? ( s0 < s2 ? s0 : s2 ) : ( s1 < s2 ? s1 : s2 );
+      t->v[INCG_QUAL_JACOBIAN][i] = s < s3 ? s : s3;
+
+      s = l0 < l1 ? ( l0 < l2 ? l0 : l2 ) : ( l1 < l2 ? l1 : l2 );
+      s = s < l3 ? s : l3;
+      c = l0 > l1 ? ( l0 > l2 ? l0 : l2 ) : ( l1 > l2 ? l1 : l2 );
+      c = c > l3 ? c : l3;
+      d = c / ( s > 0.0 ? s : 1.0 );
+      t->v[INCG_QUAL_ASPECT][i] = s > 0.0 ? d : 1.0e30;
+
+      // fold between the two triangles on either diagonal
+      c = incg_Qual_Fold( x1-x0, y1-y0, z1-z0, x2-x0, y2-y0, z2-z0,
+                          x3-x0, y3-y0, z3-z0 );
+      d = incg_Qual_Fold( x2-x1, y2-y1, z2-z1, x3-x1, y3-y1, z3-z1,
+                          x0-x1, y0-y1, z0-z1 );
+      cw[i] = c < d ? c : d;
+   }
+
+   for(i=0;i<t->n;++i) {
+      double amin = incg_Qual_KeyAngle( kmin[i] );
+      double amax = incg_Qual_KeyAngle( kmax[i] );
+      double c = cw[i] < -1.0 ? -1.0 : ( cw[i] > 1.0 ? 1.0 : cw[i] );
+
+      kmin[i] = amin;
+      kmax[i] = amax;
+      t->v[INCG_QUAL_SKEW][i] = ( amax - 90.0 )/90.0 > ( 90.0 - amin )/90.0 ?
+                                ( amax - 90.0 )/90.0 : ( 90.0 - amin )/90.0;
+      cw[i] = acos( c ) * r2d;
+   }
+}
+
+
+//
+// Function to compute the metrics of a tile and add them to the statistics
+// (and to the array of the metrics of the elements when it is not null)
+//
+static void incg_Qual_Flush( struct incg_qual_tile_s* t, int nc,
+                             struct incg_qual_s* q, double* emet )
+{
+   int nm = nc == 3 ? INCG_QUAL_WARPAGE : INCG_QUAL_NMETRIC;
+   int i,k;
+
+
+   if( t->n == 0 ) return;
+   if( nc == 3 ) {
+      incg_Qual_TriTile( t );
+      q->ntri += t->n;
+   } else {
+      incg_Qual_QuadTile( t );
+      q->nquad += t->n;
+   }
+
+   for(k=0;k<nm;++k) {
+      const double *v = t->v[k];
+      double s = INCG_QUAL_NBIN / ( q->hi[k] - q->lo[k] );
+
+      for(i=0;i<t->n;++i) {
+         int ib = (int) ( ( v[i] - q->lo[k] ) * s );
+
+         ib = ib < 0 ? 0 : ( ib >= INCG_QUAL_NBIN ? INCG_QUAL_NBIN-1 : ib );
+         ++q->hist[k][ib];
+         if( v[i] < q->vmin[k] ) q->vmin[k] = v[i];
+         if( v[i] > q->vmax[k] ) q->vmax[k] = v[i];
+         q->vsum[k] += v[i];
+      }
+      q->n[k] += t->n;
+   }
+
+   if( emet != NULL ) {
+      for(i=0;i<t->n;++i) {
+         for(k=0;k<INCG_QUAL_NMETRIC;++k) {
+            emet[ INCG_QUAL_NMETRIC*t->id[i] + k ] = t->v[k][i];
+         }
+      }
+   }
+
+   t->n = 0;
+}
+
+
+//
+// Function to add the statistics of a thread to the total
+//
+static void incg_Qual_Merge( const struct incg_qual_s* ql,
+                             struct incg_qual_s* q )
+{
+   int i,k;
+
+   q->ntri += ql->ntri;
+   q->nquad += ql->nquad;
+   for(k=0;k<INCG_QUAL_NMETRIC;++k) {
+      q->n[k] += ql->n[k];
+      if( ql->vmin[k] < q->vmin[k] ) q->vmin[k] = ql->vmin[k];
+      if( ql->vmax[k] > q->vmax[k] ) q->vmax[k] = ql->vmax[k];
+      q->vsum[k] += ql->vsum[k];
+      for(i=0;i<INCG_QUAL_NBIN;++i) q->hist[k][i] += ql->hist[k][i];
+   }
+}
+
+
+//
+// Function to compute the quality metrics of the faces (triangles and quads,
+// as with incg_MeshFile_WriteFaces()) of a set of vertices with coordinates
+// "x", and their statistics. The metrics of every face are stored in "emet"
+// (INCG_QUAL_NMETRIC per face) when it is not null; triangles have zero
+// warpage. Every thread gathers the corners of its faces in tiles of
+// triangles and of quads, which are computed as vectors when full. The
+// statistics are formed in the same parallel pass.
+//
+
+int incg_Qual_Faces( long int nv, const double* x,
+                     long int nf, const long int* faces,
+                     double* emet, struct incg_qual_s* q )
+{
+   long int i, nbad=0;
+
+
+   if( x == NULL || faces == NULL || q == NULL ) return 1;
+   if( nv <= 0 || nf <= 0 ) return 2;
+
+#pragma omp parallel for reduction(+:nbad)
+   for(i=0;i<nf;++i) {
+      const long int *f = &( faces[4*i] );
+      int k;
+
+      for(k=0;k<3;++k) if( f[k] < 0 || f[k] >= nv ) ++nbad;
+      if( f[3] >= nv ) ++nbad;
+   }
+   if( nbad ) return 3;
+
+   incg_Qual_Init( q );
+#pragma omp parallel
+{  struct incg_qual_tile_s tt, tq;
+   struct incg_qual_s ql;
+
+   incg_Qual_Init( &ql );
+   tt.n = 0;
+   tq.n = 0;
+#pragma omp for schedule(static)
+   for(i=0;i<nf;++i) {
+      const long int *f = &( faces[4*i] );
+      struct incg_qual_tile_s *t = f[3] < 0 ? &tt : &tq;
+      int nc = f[3] < 0 ? 3 : 4, k;
+
+      t->id[ t->n ] = i;
+      for(k=0;k<nc;++k) {
+         t->x[k][ t->n ] = x[ 3*f[k]+0 ];
+         t->y[k][ t->n ] = x[ 3*f[k]+1 ];
+         t->z[k][ t->n ] = x[ 3*f[k]+2 ];
+      }
+      if( ++t->n == INCG_QUAL_TILE ) incg_Qual_Flush( t, nc, &ql, emet );
+   }
+   incg_Qual_Flush( &tt, 3, &ql, emet );
+   incg_Qual_Flush( &tq, 4, &ql, emet );
+#pragma omp critical
+   incg_Qual_Merge( &ql, q );
+}
+
+   return 0;
+}
+
+
+//
+// Function to compute the quality metrics of the triangles of a mesh object
+// and their statistics, as incg_Qual_Faces() does
+//
+
+int incg_Qual_Mesh( const mesh_t* m, double* emet, struct incg_qual_s* q )
+{
+   long int i;
+
+
+   if( m == NULL || q == NULL ) return 1;
+   if( m->nv == 0 || m->ne == 0 || m->nt == 0 ) return 2;
+
+   incg_Qual_Init( q );
+#pragma omp parallel
+{  struct incg_qual_tile_s tt;
+   struct incg_qual_s ql;
+
+   incg_Qual_Init( &ql );
+   tt.n = 0;
+#pragma omp for schedule(static)
+   for(i=0;i<m->nt;++i) {
+      const triangle_t *t = &( m->t[i] );
+      const vertex_t *v[3];
+      int k;
+
+      v[0] = t->d1 == 0 ? t->e1->va : t->e1->vb;
+      v[1] = t->d2 == 0 ? t->e2->va : t->e2->vb;
+      v[2] = t->d3 == 0 ? t->e3->va : t->e3->vb;
+      tt.id[ tt.n ] = i;
+      for(k=0;k<3;++k) {
+         tt.x[k][ tt.n ] = v[k]->x;
+         tt.y[k][ tt.n ] = v[k]->y;
+         tt.z[k][ tt.n ] = v[k]->z;
+      }
+      if( ++tt.n == INCG_QUAL_TILE ) incg_Qual_Flush( &tt, 3, &ql, emet );
+   }
+   incg_Qual_Flush( &tt, 3, &ql, emet );
+#pragma omp critical
+   incg_Qual_Merge( &ql, q );
+}
+
+   return 0;
+}
+
+
+//
+// Function to print the statistics of the metrics and their histograms
+//
+
+int incg_Qual_Report( const struct incg_qual_s* q )
+{
+   int i,k;
+
+
+   if( q == NULL ) return 1;
+
+   printf("Quality: %ld triangles, %ld quads \n", q->ntri, q->nquad );
+   for(k=0;k<INCG_QUAL_NMETRIC;++k) {
+      if( q->n[k] == 0 ) continue;
+      printf("   %-10s  min %10.4lf  mean %10.4lf  max %10.4lf \n",
+             incg_qual_name[k], q->vmin[k], q->vsum[k]/q->n[k], q->vmax[k] );
+      printf("      [%g,%g]:", q->lo[k], q->hi[k] );
+      for(i=0;i<INCG_QUAL_NBIN;++i) printf(" %ld", q->hist[k][i] );
+      printf(" \n");
+   }
+
+   return 0;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
@@ -0,0 +1,61 @@
+
+#ifndef _INCG_QUAL_H_
+#define _INCG_QUAL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "incg_mesh.h"
+
+//
+// Quality metrics of the elements (triangles and quads) of a mesh
+//
+
+// metrics
+#define INCG_QUAL_MINANGLE      0   // smallest angle (degrees)
+#define INCG_QUAL_MAXANGLE      1   // largest angle (degrees)
+#define INCG_QUAL_ASPECT        2   // aspect ratio (1 at best)
+#define INCG_QUAL_SKEW          3   // equiangular skewness (0 at best)
+#define INCG_QUAL_JACOBIAN      4   // smallest scaled Jacobian (1 at best)
+#define INCG_QUAL_WARPAGE       5   // fold across a diagonal (quads, degrees)
+#define INCG_QUAL_NMETRIC       6
+
+// bins of the histograms, and elements in a tile of the computation
+#define INCG_QUAL_NBIN          20
+#define INCG_QUAL_TILE          64
+
+//
+// Statistics of the metrics over the elements: the number of elements that
+// have each metric, its extremes and sum, and a histogram with equal bins
+// over [lo,hi] (values outside go to the end bins). The aspect ratio of a
+// triangle is its longest edge over the diameter of its inscribed circle and
+// over sqrt(3), and of a quad its longest edge over its shortest one. The
+// scaled Jacobian is the smallest sine of the corners' angles (of a triangle
+// over the sine of 60 degrees), signed by the normal of the quad. Triangles
+// have no warpage.
+//
+struct incg_qual_s {
+   long int ntri, nquad;
+   long int n[INCG_QUAL_NMETRIC];
+   double vmin[INCG_QUAL_NMETRIC], vmax[INCG_QUAL_NMETRIC];
+   double vsum[INCG_QUAL_NMETRIC];
+   double lo[INCG_QUAL_NMETRIC], hi[INCG_QUAL_NMETRIC];
+   long int hist[INCG_QUAL_NMETRIC][INCG_QUAL_NBIN];
+};
+
+// -------------------- function prototypes/signatures --------------------
+
+int incg_Qual_Mesh( const mesh_t* m, double* emet, struct incg_qual_s* q );
+
+int incg_Qual_Faces( long int nv, const double* x,
+                     long int nf, const long int* faces,
+                     double* emet, struct incg_qual_s* q );
+
+int incg_Qual_Report( const struct incg_qual_s* q );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
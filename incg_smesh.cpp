@@ -1,20 +1,167 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#include <limits.h>
 #include <unistd.h>
+#include <new>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "incg_smesh.h"
 #include "incg_smesh_uid_factory.h"
+#include "incg_meshio.h"
+#include "incg_check.h"
+#include "incg_part.h"
+#include "incg_smooth.h"
+#include "incg_qual.h"
+#include "incg_curv.h"
+#include "incg_isect.h"
+#include "incg_sort.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+//----------------------------------------------------------------------------
+
+//
+// Functions to place an object in the table of its type at its UID, growing
+// the table (with null entries) as needed
+//
+
+static void smesh_put_node( nodetab_t & t, sMesh_Node* p )
+{
+   size_t n = (size_t) p->getUID();
+   if( n >= t.size() ) t.resize( n+1, NULL );
+   t[n] = p;
+}
+
+static void smesh_put_edge( edgetab_t & t, sMesh_Edge* p )
+{
+   size_t n = (size_t) p->getUID();
+   if( n >= t.size() ) t.resize( n+1, NULL );
+   t[n] = p;
+}
+
+static void smesh_put_quad( quadtab_t & t, sMesh_Quad* p )
+{
+   size_t n = (size_t) p->getUID();
+   if( n >= t.size() ) t.resize( n+1, NULL );
+   t[n] = p;
+}
+
+static void smesh_put_tri( tritab_t & t, sMesh_Tri* p )
+{
+   size_t n = (size_t) p->getUID();
+   if( n >= t.size() ) t.resize( n+1, NULL );
+   t[n] = p;
+}
+
+//
+// Functions to add and remove references of a node or an edge: the first
+// "nin" are kept in the object ("rin") and the rest spill to an array from
+// "pool" ("more") of capacity "cap" that doubles as needed. References keep
+// the order in which they were added; removal drops every copy of a reference
+// and gives the array back when all fit in the object again, unless there is
+// no pool (as in destructors, for the pool goes with the factory).
+//
+
+static int smesh_refs_add( smesh_ref_t rin[], unsigned int nin,
+                           unsigned int & n, unsigned int & cap,
+                           smesh_ref_t* & more, smesh_ref_t r,
+                           sMesh_RefPool* pool )
+{
+   if( n < nin ) {
+      rin[n++] = r;
+      return 0;
+   }
+
+   if( n - nin == cap ) {
+      unsigned int c = cap == 0 ? INCG_SMESH_SPILL : 2*cap;
+      smesh_ref_t* p = pool->take( c );
+      if( p == NULL ) return -1;
+      if( more != NULL ) {
+         memcpy( p, more, cap*sizeof(smesh_ref_t) );
+         pool->give( more, cap );
+      }
+      more = p;
+      cap = c;
+   }
+   more[ n - nin ] = r;
+   ++n;
+
+   return 0;
+}
+
+static void smesh_refs_remove( smesh_ref_t rin[], unsigned int nin,
+                               unsigned int & n, unsigned int & cap,
+                               smesh_ref_t* & more, smesh_ref_t r,
+                               sMesh_RefPool* pool )
+{
+   unsigned int j=0;
+   for(unsigned int k=0;k<n;++k) {
+      smesh_ref_t q = k < nin ? rin[k] : more[ k - nin ];
+      if( q == r ) continue;
+      if( j < nin ) rin[j] = q;
+      else more[ j - nin ] = q;
+      ++j;
+   }
+   n = j;
+
+   if( n <= nin && more != NULL && pool != NULL ) {
+      pool->give( more, cap );
+      more = NULL;
+      cap = 0;
+   }
+}
+
+
 //
-// A global variable to handle a singleton-style factory
+// Functions to make an object with a UID from factory "f" in the storage of a
+// slab, or by "new" when there is no slab; they return null when the storage
+// cannot be allocated
 //
 
-sMesh_uid_factory* global_UID_factory = NULL;
+static sMesh_Node* smesh_new_node( sMesh_uid_factory* f, sMesh_Slab* s )
+{
+   if( s == NULL ) return new sMesh_Node( f );
+   void* p = s->alloc();
+   if( p == NULL ) return NULL;
+   return new (p) sMesh_Node( f );
+}
+
+static sMesh_Edge* smesh_new_edge( sMesh_uid_factory* f, sMesh_Slab* s,
+                                   sMesh_Node* np1, sMesh_Node* np2 )
+{
+   if( s == NULL ) return new sMesh_Edge( f, np1, np2 );
+   void* p = s->alloc();
+   if( p == NULL ) return NULL;
+   return new (p) sMesh_Edge( f, np1, np2 );
+}
+
+static sMesh_Quad* smesh_new_quad( sMesh_uid_factory* f, sMesh_Slab* s,
+                                   sMesh_Edge* ep1, sMesh_Edge* ep2,
+                                   sMesh_Edge* ep3, sMesh_Edge* ep4,
+                                   unsigned char dirs )
+{
+   if( s == NULL ) return new sMesh_Quad( f, ep1, ep2, ep3, ep4, dirs );
+   void* p = s->alloc();
+   if( p == NULL ) return NULL;
+   return new (p) sMesh_Quad( f, ep1, ep2, ep3, ep4, dirs );
+}
+
+static sMesh_Tri* smesh_new_tri( sMesh_uid_factory* f, sMesh_Slab* s,
+                                 sMesh_Edge* ep1, sMesh_Edge* ep2,
+                                 sMesh_Edge* ep3, unsigned char dirs )
+{
+   if( s == NULL ) return new sMesh_Tri( f, ep1, ep2, ep3, dirs );
+   void* p = s->alloc();
+   if( p == NULL ) return NULL;
+   return new (p) sMesh_Tri( f, ep1, ep2, ep3, dirs );
+}
 
 //----------------------------------------------------------------------------
 
@@ -37,15 +184,352 @@ int set_edge_uid( edgeid_t & euid,
 }
 
 
+//----------------------------------------------------------------------------
+
+//
+// Methods for the hash table of edges
+//
+
+#define SMESH_HASH_EMPTY   (~0UL)      // key of a free slot
+#define SMESH_HASH_AHEAD   8           // keys ahead to prefetch the slot of
+
+sMesh_EdgeHash::sMesh_EdgeHash()
+{
+   mask = 0;
+   nbits = 0;
+   count = 0;
+}
+
+sMesh_EdgeHash::~sMesh_EdgeHash()
+{
+
+}
+
+// The key of the edge of two node indices (less than 2^32-1) in either order:
+// the lower index in the high 32 bits and the higher one in the low 32 bits
+unsigned long sMesh_EdgeHash::makeKey( unsigned long i, unsigned long j )
+{
+   if( i < j ) return (i << 32) | j;
+   return (j << 32) | i;
+}
+
+// Fibonacci hashing: the high bits of the product with 2^64 over golden ratio
+unsigned long sMesh_EdgeHash::slot( unsigned long key ) const
+{
+   return ( key * 0x9E3779B97F4A7C15UL ) >> (64 - nbits);
+}
+
+// Makes room for "n" keys in all (at most half the slots are used); the table
+// is emptied
+int sMesh_EdgeHash::reserve( long n )
+{
+   if( n < 0 ) return 1;
+
+   nbits = 4;
+   while( (1L << nbits) < 2*n ) ++nbits;
+   mask = (1UL << nbits) - 1;
+   count = 0;
+   keys.assign( mask+1, SMESH_HASH_EMPTY );
+   vals.assign( mask+1, -1 );
+
+   return 0;
+}
+
+void sMesh_EdgeHash::clear()
+{
+   keys.clear();
+   vals.clear();
+   mask = 0;
+   nbits = 0;
+   count = 0;
+}
+
+long sMesh_EdgeHash::size() const
+{
+   return count;
+}
+
+// Returns the value of a key, or -1 when the key is not in the table
+long sMesh_EdgeHash::find( unsigned long key ) const
+{
+   if( keys.size() == 0 ) return -1;
+
+   unsigned long h = slot( key );
+   while( keys[h] != SMESH_HASH_EMPTY ) {
+      if( keys[h] == key ) return vals[h];
+      h = (h + 1) & mask;
+   }
+   return -1;
+}
+
+// Inserts a key with its value; returns 1 if the key was present (and keeps
+// its value) and -1 if the table is full
+int sMesh_EdgeHash::insert( unsigned long key, long val )
+{
+   if( 2*(count+1) > (long) keys.size() ) return -1;
+
+   unsigned long h = slot( key );
+   while( keys[h] != SMESH_HASH_EMPTY ) {
+      if( keys[h] == key ) return 1;
+      h = (h + 1) & mask;
+   }
+   keys[h] = key;
+   vals[h] = val;
+   ++count;
+   return 0;
+}
+
+// Inserts an array of keys with their values, in order; on return "vals"
+// holds the value in the table of every key (its own value for a key that
+// was inserted, and that of the first insertion for a repeated key). Returns
+// the number of keys inserted, or -1 if the table would be over half full.
+long sMesh_EdgeHash::insertBulk( long n, const unsigned long keys_[],
+                                 long vals_[] )
+{
+   if( 2*(count+n) > (long) keys.size() ) return -1;
+
+   long ni = 0;
+   for(long i=0;i<n;++i) {
+#ifdef __GNUC__
+      if( i + SMESH_HASH_AHEAD < n ) {
+         unsigned long ha = slot( keys_[ i + SMESH_HASH_AHEAD ] );
+         __builtin_prefetch( &( keys[ha] ), 0, 1 );
+         __builtin_prefetch( &( vals[ha] ), 1, 1 );
+      }
+#endif
+      unsigned long key = keys_[i];
+      unsigned long h = slot( key );
+      while( keys[h] != SMESH_HASH_EMPTY && keys[h] != key ) {
+         h = (h + 1) & mask;
+      }
+      if( keys[h] == key ) {
+         vals_[i] = vals[h];
+      } else {
+         keys[h] = key;
+         vals[h] = vals_[i];
+         ++ni;
+      }
+   }
+   count += ni;
+
+   return ni;
+}
+
+
+//
+// Functions to get and set the UID of an object of a kind (INCG_SMESH_REF_*)
+//
+
+static long smesh_obj_uid( int kind, const void* p )
+{
+   if( kind == INCG_SMESH_REF_NODE ) return ((const sMesh_Node*) p)->getUID();
+   if( kind == INCG_SMESH_REF_EDGE ) return ((const sMesh_Edge*) p)->getUID();
+   if( kind == INCG_SMESH_REF_QUAD ) return ((const sMesh_Quad*) p)->getUID();
+   return ((const sMesh_Tri*) p)->getUID();
+}
+
+static void smesh_obj_setuid( int kind, void* p, long uid,
+                              ChildSetToken& token )
+{
+   if( kind == INCG_SMESH_REF_NODE ) ((sMesh_Node*) p)->setUID( uid, token );
+   if( kind == INCG_SMESH_REF_EDGE ) ((sMesh_Edge*) p)->setUID( uid, token );
+   if( kind == INCG_SMESH_REF_QUAD ) ((sMesh_Quad*) p)->setUID( uid, token );
+   if( kind == INCG_SMESH_REF_TRI ) ((sMesh_Tri*) p)->setUID( uid, token );
+}
+
+//----------------------------------------------------------------------------
+
+//
+// Methods for the slab allocator
+//
+
+sMesh_Slab::sMesh_Slab( size_t size_ )
+{
+   size = size_;
+   next = NULL;
+   nfree = 0;
+   count = 0;
+}
+
+sMesh_Slab::~sMesh_Slab()
+{
+   release();
+}
+
+// Returns storage for one object, or null if a slab cannot be allocated
+void* sMesh_Slab::alloc()
+{
+   return allocBlock( 1 );
+}
+
+// Returns contiguous storage for "n" objects after those allocated last, or
+// in a new slab when the last one does not have room for them
+void* sMesh_Slab::allocBlock( long n )
+{
+   if( n <= 0 ) return NULL;
+
+   if( n > nfree ) {
+      long m = n > INCG_SMESH_SLAB ? n : INCG_SMESH_SLAB;
+      char* p = (char*) malloc( ((size_t) m) * size );
+      if( p == NULL ) return NULL;
+      slabs.push_back( p );
+      next = p;
+      nfree = m;
+   }
+
+   char* p = next;
+   next += ((size_t) n) * size;
+   nfree -= n;
+   count += n;
+   return (void*) p;
+}
+
+long sMesh_Slab::getCount() const
+{
+   return count;
+}
+
+// Releases all slabs at once; objects in them are not destroyed
+void sMesh_Slab::release()
+{
+   for(size_t n=0;n<slabs.size();++n) free( slabs[n] );
+   slabs.clear();
+   next = NULL;
+   nfree = 0;
+   count = 0;
+}
+
+// Takes over the slabs of another allocator, which is left empty; objects are
+// allocated next in a new slab
+void sMesh_Slab::adopt( sMesh_Slab & other )
+{
+   slabs.insert( slabs.end(), other.slabs.begin(), other.slabs.end() );
+   count += other.count;
+   next = NULL;
+   nfree = 0;
+
+   other.slabs.clear();
+   other.next = NULL;
+   other.nfree = 0;
+   other.count = 0;
+}
+
+
+//----------------------------------------------------------------------------
+
+//
+// Methods for the pool of spilled references
+//
+
+sMesh_RefPool::sMesh_RefPool()
+{
+   int na = omp_get_max_threads();
+   if( omp_get_num_procs() > na ) na = omp_get_num_procs();
+
+   arena.resize( na+1 );
+   for(size_t n=0;n<arena.size();++n) {
+      arena[n].next = NULL;
+      arena[n].nfree = 0;
+      for(int k=0;k<INCG_SMESH_POOL_NCLASS;++k) arena[n].head[k] = NULL;
+   }
+}
+
+sMesh_RefPool::~sMesh_RefPool()
+{
+   release();
+}
+
+// Returns an array of "cap" references, a power of two, or null if a block
+// cannot be allocated
+smesh_ref_t* sMesh_RefPool::take( unsigned int cap )
+{
+   smesh_ref_t* p;
+   int it = omp_get_thread_num();
+
+   if( it < (int) arena.size() - 1 ) return takeFrom( arena[it], cap );
+
+   #pragma omp critical (smesh_refpool)
+   p = takeFrom( arena.back(), cap );
+   return p;
+}
+
+// Gives back an array of "cap" references that was taken from the pool
+void sMesh_RefPool::give( smesh_ref_t* p, unsigned int cap )
+{
+   int it = omp_get_thread_num();
+
+   if( it < (int) arena.size() - 1 ) {
+      giveTo( arena[it], p, cap );
+   } else {
+      #pragma omp critical (smesh_refpool)
+      giveTo( arena.back(), p, cap );
+   }
+}
+
+// Releases all blocks at once; arrays taken from them are then invalid
+void sMesh_RefPool::release()
+{
+   for(size_t n=0;n<arena.size();++n) {
+      struct arena_s & a = arena[n];
+      for(size_t m=0;m<a.blocks.size();++m) free( a.blocks[m] );
+      a.blocks.clear();
+      a.next = NULL;
+      a.nfree = 0;
+      for(int k=0;k<INCG_SMESH_POOL_NCLASS;++k) a.head[k] = NULL;
+   }
+}
+
+static int smesh_refpool_class( unsigned int cap )
+{
+   int k=0;
+   while( (1u << k) < cap ) ++k;
+   return k;
+}
+
+smesh_ref_t* sMesh_RefPool::takeFrom( struct arena_s & a, unsigned int cap )
+{
+   int k = smesh_refpool_class( cap );
+   smesh_ref_t* p = a.head[k];
+
+   if( p != NULL ) {
+      a.head[k] = (smesh_ref_t*) p[0];
+      return p;
+   }
+
+   if( (long) cap > a.nfree ) {
+      long m = cap > INCG_SMESH_POOL_BLOCK ? cap : INCG_SMESH_POOL_BLOCK;
+      p = (smesh_ref_t*) malloc( ((size_t) m)*sizeof(smesh_ref_t) );
+      if( p == NULL ) return NULL;
+      a.blocks.push_back( p );
+      a.next = p;
+      a.nfree = m;
+   }
+
+   p = a.next;
+   a.next += cap;
+   a.nfree -= cap;
+   return p;
+}
+
+void sMesh_RefPool::giveTo( struct arena_s & a, smesh_ref_t* p,
+                            unsigned int cap )
+{
+   int k = smesh_refpool_class( cap );
+
+   p[0] = (smesh_ref_t) a.head[k];
+   a.head[k] = p;
+}
+
+
 //----------------------------------------------------------------------------
 
 //
 // Methods for the node object
 //
 
-sMesh_Node::sMesh_Node()
+sMesh_Node::sMesh_Node( sMesh_uid_factory* f )
 {
-   uid = global_UID_factory->getNewNodeUID( this );
+   uid = f->getNewNodeUID( this );
 
    flags = 0x00;
    x = -9.9e+99;
@@ -53,9 +537,22 @@ sMesh_Node::sMesh_Node()
    z = -9.9e+99;
 }
 
-sMesh_Node::~sMesh_Node()
+// Constructor of a node of a UID that was reserved in a block (the factory is
+// not told of the node when it is null)
+sMesh_Node::sMesh_Node( sMesh_uid_factory* f, long uid_ )
 {
+   uid = uid_;
+   if( f != NULL ) f->setNodePtr( uid, this );
 
+   flags = 0x00;
+   x = -9.9e+99;
+   y = -9.9e+99;
+   z = -9.9e+99;
+}
+
+// The references that spilled are left to the pool of the factory
+sMesh_Node::~sMesh_Node()
+{
 }
 
 long sMesh_Node::getUID() const
@@ -63,21 +560,43 @@ long sMesh_Node::getUID() const
    return uid;
 }
 
-int sMesh_Node::addRef( void *p )
+int sMesh_Node::addRef( smesh_ref_t r, sMesh_RefPool* pool )
 {
-   refs.push_back( p );
-   return 0;
+   return smesh_refs_add( rin, INCG_SMESH_NODE_NREF, nref, ncap, rmore, r,
+                          pool );
 }
 
-int sMesh_Node::removeRef( void *p )
+int sMesh_Node::removeRef( smesh_ref_t r, sMesh_RefPool* pool )
 {
-   refs.remove( p );   // ERROR TRAP
+   smesh_refs_remove( rin, INCG_SMESH_NODE_NREF, nref, ncap, rmore, r,
+                      pool );
    return 0;
 }
 
 unsigned int sMesh_Node::getNumRefs() const
 {
-   return( (unsigned int) refs.size() );
+   return nref;
+}
+
+smesh_ref_t sMesh_Node::getRef( unsigned int k ) const
+{
+   return k < INCG_SMESH_NODE_NREF ? rin[k] : rmore[ k - INCG_SMESH_NODE_NREF ];
+}
+
+int sMesh_Node::setUID( long uid_, ChildSetToken& token )
+{
+   uid = uid_;
+   return 0;
+}
+
+// Drops all references, giving those that spilled back to "pool", without a
+// word to the objects referred to (for the teardown of the whole mesh)
+void sMesh_Node::dropRefs( ChildSetToken& token, sMesh_RefPool* pool )
+{
+   if( rmore != NULL ) pool->give( rmore, ncap );
+   rmore = NULL;
+   nref = 0;
+   ncap = 0;
 }
 
 
@@ -85,9 +604,32 @@ unsigned int sMesh_Node::getNumRefs() const
 // Methods for the edge object
 //
 
-sMesh_Edge::sMesh_Edge( sMesh_Node * np1_, sMesh_Node * np2_ )
+sMesh_Edge::sMesh_Edge( sMesh_uid_factory* f,
+                        sMesh_Node * np1_, sMesh_Node * np2_ )
+{
+   uid = f->getNewEdgeUID( this );
+
+   flags = 0x00;
+   if( np1_->getUID() < np2_->getUID() ) {
+      np1 = np1_;
+      np2 = np2_;
+   } else {
+      np1 = np2_;
+      np2 = np1_;
+   }
+   np1->addRef( smesh_ref_make( this, INCG_SMESH_REF_EDGE ),
+                f->getRefPool() );
+   np2->addRef( smesh_ref_make( this, INCG_SMESH_REF_EDGE ),
+                f->getRefPool() );
+}
+
+// Constructor of an edge of a UID that was reserved in a block; the nodes are
+// not given the reference of the edge, which is left to the caller
+sMesh_Edge::sMesh_Edge( sMesh_uid_factory* f, long uid_,
+                        sMesh_Node * np1_, sMesh_Node * np2_ )
 {
-   uid = global_UID_factory->getNewEdgeUID( this );
+   uid = uid_;
+   if( f != NULL ) f->setEdgePtr( uid, this );
 
    flags = 0x00;
    if( np1_->getUID() < np2_->getUID() ) {
@@ -97,14 +639,12 @@ sMesh_Edge::sMesh_Edge( sMesh_Node * np1_, sMesh_Node * np2_ )
       np1 = np2_;
       np2 = np1_;
    }
-   np1->addRef( (void*) this );
-   np2->addRef( (void*) this );
 }
 
 sMesh_Edge::~sMesh_Edge()
 {
-   np1->removeRef( (void*) this );
-   np2->removeRef( (void*) this );
+   np1->removeRef( smesh_ref_make( this, INCG_SMESH_REF_EDGE ), NULL );
+   np2->removeRef( smesh_ref_make( this, INCG_SMESH_REF_EDGE ), NULL );
 }
 
 long sMesh_Edge::getUID() const
@@ -112,21 +652,27 @@ long sMesh_Edge::getUID() const
    return uid;
 }
 
-int sMesh_Edge::addRef( void *p )
+int sMesh_Edge::addRef( smesh_ref_t r, sMesh_RefPool* pool )
 {
-   refs.push_back( p );
-   return 0;
+   return smesh_refs_add( rin, INCG_SMESH_EDGE_NREF, nref, ncap, rmore, r,
+                          pool );
 }
 
-int sMesh_Edge::removeRef( void *p )
+int sMesh_Edge::removeRef( smesh_ref_t r, sMesh_RefPool* pool )
 {
-   refs.remove( p );   // ERROR TRAP
+   smesh_refs_remove( rin, INCG_SMESH_EDGE_NREF, nref, ncap, rmore, r,
+                      pool );
    return 0;
 }
 
 unsigned int sMesh_Edge::getNumRefs() const
 {
-   return( (unsigned int) refs.size() );
+   return nref;
+}
+
+smesh_ref_t sMesh_Edge::getRef( unsigned int k ) const
+{
+   return k < INCG_SMESH_EDGE_NREF ? rin[k] : rmore[ k - INCG_SMESH_EDGE_NREF ];
 }
 
 sMesh_Node* sMesh_Edge::getNodePtr( int which_one ) const
@@ -177,17 +723,19 @@ int sMesh_Edge::isSplit() const
    return 1;
 }
 
-int sMesh_Edge::split( uidmap_t* node_uid, ptrmap_t* node_ptr,
-                       uidmap_t* edge_uid, ptrmap_t* edge_ptr )
+// The new node and edges take their UIDs from factory "f" and are made in the
+// slabs when these are given.
+int sMesh_Edge::split( sMesh_uid_factory* f,
+                       nodetab_t* nodes, edgetab_t* edges,
+                       sMesh_Slab* node_slab, sMesh_Slab* edge_slab )
 {
    if( isSplit() ) return 1;
-   sMesh_Node* mnp = new sMesh_Node();
+   sMesh_Node* mnp = smesh_new_node( f, node_slab );
    if( mnp == NULL ) {
       FPRINTF( stdout, " [Error]  Could not create node object \n" );
       return -1;
    }
-   if( node_uid != NULL ) (*node_uid)[ mnp->getUID() ] = mnp;
-   if( node_ptr != NULL ) (*node_ptr)[ mnp ] = mnp->getUID();
+   if( nodes != NULL ) smesh_put_node( *nodes, mnp );
    mnp->flags |= (0x01 << 7);
 
    // (The node order should be with the new node's UID being largest.)
@@ -200,21 +748,19 @@ int sMesh_Edge::split( uidmap_t* node_uid, ptrmap_t* node_ptr,
    mnp->z = 0.5*( np1->z + np2->z );
 
    // form two new edges (the order is 1st edge shares node 1)
-   sMesh_Edge* sep1 = new sMesh_Edge( np1, mnp );
+   sMesh_Edge* sep1 = smesh_new_edge( f, edge_slab, np1, mnp );
    if( sep1 == NULL ) {
       FPRINTF( stdout, " [Error]  Could not create edge object \n" );
       return -2;
    }
-   if( edge_uid != NULL ) (*edge_uid)[ sep1->getUID() ] = sep1;
-   if( edge_ptr != NULL ) (*edge_ptr)[ sep1 ] = sep1->getUID();
+   if( edges != NULL ) smesh_put_edge( *edges, sep1 );
 
-   sMesh_Edge* sep2 = new sMesh_Edge( np2, mnp );
+   sMesh_Edge* sep2 = smesh_new_edge( f, edge_slab, np2, mnp );
    if( sep2 == NULL ) {
       FPRINTF( stdout, " [Error]  Could not create edge object \n" );
       return -3;
    }
-   if( edge_uid != NULL ) (*edge_uid)[ sep2->getUID() ] = sep2;
-   if( edge_ptr != NULL ) (*edge_ptr)[ sep2 ] = sep2->getUID();
+   if( edges != NULL ) smesh_put_edge( *edges, sep2 );
 
    // assign splitting edge child pointers; convention is N1 -CE1- M -CE2- N2
    cp1 = sep1;
@@ -223,32 +769,141 @@ int sMesh_Edge::split( uidmap_t* node_uid, ptrmap_t* node_ptr,
    return 0;
 }
 
+// Splits the edge with objects of a worker, which are not yet known to the
+// mesh; the caller must own the split (see claim())
+int sMesh_Edge::split( sMesh_Worker* w )
+{
+   if( isSplit() ) return 1;
+   sMesh_Node* mnp = w->newNode();
+   if( mnp == NULL ) {
+      FPRINTF( stdout, " [Error]  Could not create node object \n" );
+      return -1;
+   }
+   mnp->flags |= (0x01 << 7);
+   mnp->x = 0.5*( np1->x + np2->x );
+   mnp->y = 0.5*( np1->y + np2->y );
+   mnp->z = 0.5*( np1->z + np2->z );
 
-//
-// Methods for the quadrilateral object
-//
+   sMesh_Edge* sep1 = w->newEdge( np1, mnp );
+   if( sep1 == NULL ) {
+      FPRINTF( stdout, " [Error]  Could not create edge object \n" );
+      return -2;
+   }
+   sMesh_Edge* sep2 = w->newEdge( np2, mnp );
+   if( sep2 == NULL ) {
+      FPRINTF( stdout, " [Error]  Could not create edge object \n" );
+      return -3;
+   }
 
-// Constructor requires pointers to edge objects and 4 bits indicating the
-// direction of each edge compared to the counter-clockwise convention of the
-// quadrilateral.
-sMesh_Quad::sMesh_Quad( sMesh_Edge * ne1_, sMesh_Edge * ne2_,
-                        sMesh_Edge * ne3_, sMesh_Edge * ne4_,
-                        unsigned char dirs_ )
-{
-   uid = global_UID_factory->getNewQuadUID( this );
+   cp1 = sep1;
+   cp2 = sep2;
 
-   eptr[0] = ne1_;
-   eptr[1] = ne2_;
-   eptr[2] = ne3_;
-   eptr[3] = ne4_;
-   eattr = dirs_ & 0xF0;     // copy the first 4 bits [XXXX ____] as directions
-                             // for the faces indexed [1234 ____]
-   for(int k=0;k<4;++k) eptr[k]->addRef( (void*) this );
+   return 0;
 }
 
-sMesh_Quad::~sMesh_Quad()
+// Claims the split of the edge with a ticket; claims may be made by many
+// threads at once, and the least ticket is kept (atomically). Returns 1 when
+// the ticket is the least so far.
+int sMesh_Edge::claim( unsigned long ticket_ )
 {
-   for(int k=0;k<4;++k) eptr[k]->removeRef( (void*) this );
+   unsigned long t = __atomic_load_n( &ticket, __ATOMIC_RELAXED );
+   while( ticket_ < t ) {
+      if( __atomic_compare_exchange_n( &ticket, &t, ticket_, 0,
+                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED ) )
+         return 1;
+   }
+   return 0;
+}
+
+unsigned long sMesh_Edge::getClaim() const
+{
+   return ticket;
+}
+
+int sMesh_Edge::setUID( long uid_, ChildSetToken& token )
+{
+   uid = uid_;
+   return 0;
+}
+
+// Restores the order of the nodes by their UIDs after these have changed: the
+// nodes, the children and the side bits are swapped. Returns 1 when the edge
+// was turned, in which case its faces must flip their direction for it.
+int sMesh_Edge::reorient( ChildSetToken& token )
+{
+   if( np1->getUID() < np2->getUID() ) return 0;
+
+   sMesh_Node* np = np1;
+   np1 = np2;
+   np2 = np;
+   sMesh_Edge* cp = cp1;
+   cp1 = cp2;
+   cp2 = cp;
+   flags = (flags & 0xFC) | ((flags & 0x01) << 1) | ((flags & 0x02) >> 1);
+
+   return 1;
+}
+
+// Drops all references, giving those that spilled back to "pool", without a
+// word to the objects referred to (for the teardown of the whole mesh)
+void sMesh_Edge::dropRefs( ChildSetToken& token, sMesh_RefPool* pool )
+{
+   if( rmore != NULL ) pool->give( rmore, ncap );
+   rmore = NULL;
+   nref = 0;
+   ncap = 0;
+}
+
+
+//
+// Methods for the quadrilateral object
+//
+
+// Constructor requires pointers to edge objects and 4 bits indicating the
+// direction of each edge compared to the counter-clockwise convention of the
+// quadrilateral.
+sMesh_Quad::sMesh_Quad( sMesh_uid_factory* f,
+                        sMesh_Edge * ne1_, sMesh_Edge * ne2_,
+                        sMesh_Edge * ne3_, sMesh_Edge * ne4_,
+                        unsigned char dirs_ )
+{
+   uid = f->getNewQuadUID( this );
+
+   eptr[0] = ne1_;
+   eptr[1] = ne2_;
+   eptr[2] = ne3_;
+   eptr[3] = ne4_;
+   eattr = dirs_ & 0xF0;     // copy the first 4 bits [XXXX ____] as directions
+                             // for the faces indexed [1234 ____]
+   for(int k=0;k<4;++k) {
+      eptr[k]->addRef( smesh_ref_make( this, INCG_SMESH_REF_QUAD ),
+                       f->getRefPool() );
+   }
+}
+
+// Constructor of a quadrilateral of a UID that was reserved in a block; the
+// edges are not given the reference of the quadrilateral
+sMesh_Quad::sMesh_Quad( sMesh_uid_factory* f, long uid_,
+                        sMesh_Edge * ne1_, sMesh_Edge * ne2_,
+                        sMesh_Edge * ne3_, sMesh_Edge * ne4_,
+                        unsigned char dirs_ )
+{
+   uid = uid_;
+   if( f != NULL ) f->setQuadPtr( uid, this );
+
+   eptr[0] = ne1_;
+   eptr[1] = ne2_;
+   eptr[2] = ne3_;
+   eptr[3] = ne4_;
+   eattr = dirs_ & 0xF0;
+}
+
+sMesh_Quad::~sMesh_Quad()
+{
+   for(int k=0;k<4;++k) {
+      eptr[k]->removeRef( smesh_ref_make( this, INCG_SMESH_REF_QUAD ),
+                          NULL );
+   }
 }
 
 long sMesh_Quad::getUID() const
@@ -298,6 +953,24 @@ sMesh_Quad* sMesh_Quad::getChildPtr( int index ) const
    return child[ index ];
 }
 
+int sMesh_Quad::setUID( long uid_, ChildSetToken& token )
+{
+   uid = uid_;
+   return 0;
+}
+
+// Reverses the direction bit of an edge (after the edge was turned)
+int sMesh_Quad::flipEdge( const sMesh_Edge* ep, ChildSetToken& token )
+{
+   for(int k=0;k<4;++k) {
+      if( eptr[k] == ep ) {
+         eattr ^= (0x01 << (7 - k));
+         return 0;
+      }
+   }
+   return 1;
+}
+
 
 
 //
@@ -307,22 +980,44 @@ sMesh_Quad* sMesh_Quad::getChildPtr( int index ) const
 // Constructor requires pointers to edge objects and 3 bits indicating the
 // direction of each edge compared to the counter-clockwise convention of the
 // triangle.
-sMesh_Tri::sMesh_Tri( sMesh_Edge * ne1_, sMesh_Edge * ne2_, sMesh_Edge * ne3_,
+sMesh_Tri::sMesh_Tri( sMesh_uid_factory* f,
+                      sMesh_Edge * ne1_, sMesh_Edge * ne2_, sMesh_Edge * ne3_,
                       unsigned char dirs_ )
 {
-   uid = global_UID_factory->getNewTriUID( this );
+   uid = f->getNewTriUID( this );
 
    eptr[0] = ne1_;
    eptr[1] = ne2_;
    eptr[2] = ne3_;
    eattr = dirs_ & 0xE0;     // copy the first 3 bits [XXX_ ____] as directions
                              // for the faces indexed [123__ ___]
-   for(int k=0;k<3;++k) eptr[k]->addRef( (void*) this );
+   for(int k=0;k<3;++k) {
+      eptr[k]->addRef( smesh_ref_make( this, INCG_SMESH_REF_TRI ),
+                       f->getRefPool() );
+   }
+}
+
+// Constructor of a triangle of a UID that was reserved in a block; the edges
+// are not given the reference of the triangle
+sMesh_Tri::sMesh_Tri( sMesh_uid_factory* f, long uid_,
+                      sMesh_Edge * ne1_, sMesh_Edge * ne2_, sMesh_Edge * ne3_,
+                      unsigned char dirs_ )
+{
+   uid = uid_;
+   if( f != NULL ) f->setTriPtr( uid, this );
+
+   eptr[0] = ne1_;
+   eptr[1] = ne2_;
+   eptr[2] = ne3_;
+   eattr = dirs_ & 0xE0;
 }
 
 sMesh_Tri::~sMesh_Tri()
 {
-   for(int k=0;k<3;++k) eptr[k]->removeRef( (void*) this );
+   for(int k=0;k<3;++k) {
+      eptr[k]->removeRef( smesh_ref_make( this, INCG_SMESH_REF_TRI ),
+                          NULL );
+   }
 }
 
 long sMesh_Tri::getUID() const
@@ -397,191 +1092,2077 @@ int sMesh_Tri::computeHeuristics( unsigned char & attr_, double & len_max )
    if( angle_cos[1] < 0.0 ) hattr |= 0x02;
    if( angle_cos[2] < 0.0 ) hattr |= 0x01;
 
-   attr_ = hattr;
+   attr_ = hattr;
+
+   return 0;
+}
+
+
+int sMesh_Tri::setChildren( int index, void* p, ChildSetToken& token )
+{
+   if( index < 0 || 2 < index ) return 1;
+
+   child[ index ] = p;
+
+   if( index == 0 )      sattr |= 0x04;
+   else if( index == 1 ) sattr |= 0x02;
+   else if( index == 2 ) sattr |= 0x01;
+
+   return 0;
+}
+
+
+void* sMesh_Tri::getChildPtr( int index ) const
+{
+   if( index < 0 || 2 < index ) return NULL;
+   return child[ index ];
+}
+
+
+int sMesh_Tri::setSubdivision( unsigned char n, ChildSetToken& token )
+{
+   unsigned char tmp = (sattr & 0xF0) >> 4;
+   if( tmp ) return 1;
+   if( n > 4 ) return 2;
+
+   sattr |= (n << 4);
+   return 0;
+}
+
+int sMesh_Tri::setUID( long uid_, ChildSetToken& token )
+{
+   uid = uid_;
+   return 0;
+}
+
+// Reverses the direction bit of an edge (after the edge was turned)
+int sMesh_Tri::flipEdge( const sMesh_Edge* ep, ChildSetToken& token )
+{
+   for(int k=0;k<3;++k) {
+      if( eptr[k] == ep ) {
+         eattr ^= (0x01 << (7 - k));
+         return 0;
+      }
+   }
+   return 1;
+}
+
+
+//
+// Methods for the worker object
+//
+
+sMesh_Worker::sMesh_Worker( sMesh_uid_factory* f ) :
+   node_slab( sizeof(sMesh_Node) ), edge_slab( sizeof(sMesh_Edge) ),
+   quad_slab( sizeof(sMesh_Quad) ), tri_slab( sizeof(sMesh_Tri) )
+{
+   factory = f;
+   key = 0;
+   for(int k=0;k<4;++k) {
+      uid_next[k] = 0;
+      uid_end[k] = -1;
+   }
+}
+
+// Objects that were not published are destroyed with the worker
+sMesh_Worker::~sMesh_Worker()
+{
+   std::vector< void* > *o = objs;
+
+   for(size_t n=0;n<o[INCG_SMESH_REF_TRI].size();++n)
+      ((sMesh_Tri*) o[INCG_SMESH_REF_TRI][n])->~sMesh_Tri();
+   for(size_t n=0;n<o[INCG_SMESH_REF_QUAD].size();++n)
+      ((sMesh_Quad*) o[INCG_SMESH_REF_QUAD][n])->~sMesh_Quad();
+   for(size_t n=0;n<o[INCG_SMESH_REF_EDGE].size();++n)
+      ((sMesh_Edge*) o[INCG_SMESH_REF_EDGE][n])->~sMesh_Edge();
+   for(size_t n=0;n<o[INCG_SMESH_REF_NODE].size();++n)
+      ((sMesh_Node*) o[INCG_SMESH_REF_NODE][n])->~sMesh_Node();
+}
+
+// Sets the key of the objects that are made next
+void sMesh_Worker::setKey( unsigned long key_ )
+{
+   key = key_;
+}
+
+// Returns the next UID of a kind from the block of the worker, reserving a
+// new block when it is used up
+long sMesh_Worker::takeUID( int kind )
+{
+   if( uid_next[kind] > uid_end[kind] ) {
+      long n = INCG_SMESH_UID_BLOCK, u=0;
+      if( kind == INCG_SMESH_REF_NODE ) u = factory->reserveNodeUIDs( n );
+      if( kind == INCG_SMESH_REF_EDGE ) u = factory->reserveEdgeUIDs( n );
+      if( kind == INCG_SMESH_REF_QUAD ) u = factory->reserveQuadUIDs( n );
+      if( kind == INCG_SMESH_REF_TRI ) u = factory->reserveTriUIDs( n );
+      uid_next[kind] = u;
+      uid_end[kind] = u + n - 1;
+   }
+   return uid_next[kind]++;
+}
+
+// Forgets the objects made and the blocks of UIDs (after publishing)
+void sMesh_Worker::clear()
+{
+   for(int k=0;k<4;++k) {
+      keys[k].clear();
+      objs[k].clear();
+      uid_next[k] = 0;
+      uid_end[k] = -1;
+   }
+}
+
+long sMesh_Worker::getCount( int kind ) const
+{
+   if( kind < 0 || 3 < kind ) return 0;
+   return (long) objs[kind].size();
+}
+
+sMesh_Node* sMesh_Worker::newNode()
+{
+   void* p = node_slab.alloc();
+   if( p == NULL ) return NULL;
+   sMesh_Node* np = new (p) sMesh_Node( (sMesh_uid_factory*) NULL,
+                                        takeUID( INCG_SMESH_REF_NODE ) );
+   keys[ INCG_SMESH_REF_NODE ].push_back( key );
+   objs[ INCG_SMESH_REF_NODE ].push_back( np );
+   return np;
+}
+
+sMesh_Edge* sMesh_Worker::newEdge( sMesh_Node * np1_, sMesh_Node * np2_ )
+{
+   void* p = edge_slab.alloc();
+   if( p == NULL ) return NULL;
+   sMesh_Edge* ep = new (p) sMesh_Edge( (sMesh_uid_factory*) NULL,
+                                        takeUID( INCG_SMESH_REF_EDGE ),
+                                        np1_, np2_ );
+   keys[ INCG_SMESH_REF_EDGE ].push_back( key );
+   objs[ INCG_SMESH_REF_EDGE ].push_back( ep );
+   return ep;
+}
+
+sMesh_Quad* sMesh_Worker::newQuad( sMesh_Edge * ne1_, sMesh_Edge * ne2_,
+                                   sMesh_Edge * ne3_, sMesh_Edge * ne4_,
+                                   unsigned char dirs_ )
+{
+   void* p = quad_slab.alloc();
+   if( p == NULL ) return NULL;
+   sMesh_Quad* qp = new (p) sMesh_Quad( (sMesh_uid_factory*) NULL,
+                                        takeUID( INCG_SMESH_REF_QUAD ),
+                                        ne1_, ne2_, ne3_, ne4_, dirs_ );
+   keys[ INCG_SMESH_REF_QUAD ].push_back( key );
+   objs[ INCG_SMESH_REF_QUAD ].push_back( qp );
+   return qp;
+}
+
+sMesh_Tri* sMesh_Worker::newTri( sMesh_Edge * ne1_, sMesh_Edge * ne2_,
+                                 sMesh_Edge * ne3_, unsigned char dirs_ )
+{
+   void* p = tri_slab.alloc();
+   if( p == NULL ) return NULL;
+   sMesh_Tri* tp = new (p) sMesh_Tri( (sMesh_uid_factory*) NULL,
+                                      takeUID( INCG_SMESH_REF_TRI ),
+                                      ne1_, ne2_, ne3_, dirs_ );
+   keys[ INCG_SMESH_REF_TRI ].push_back( key );
+   objs[ INCG_SMESH_REF_TRI ].push_back( tp );
+   return tp;
+}
+
+
+//
+// Methods for the mesh object
+//
+
+sMesh_Core::sMesh_Core() :
+   factory( new sMesh_uid_factory() ), own_factory( 1 ),
+   node_slab( sizeof(sMesh_Node) ), edge_slab( sizeof(sMesh_Edge) ),
+   quad_slab( sizeof(sMesh_Quad) ), tri_slab( sizeof(sMesh_Tri) )
+{
+
+}
+
+// Constructor of a mesh that takes the UIDs of its objects from a factory
+// of the caller (which may be shared by meshes that are used in one thread);
+// the factory is not deleted with the mesh
+sMesh_Core::sMesh_Core( sMesh_uid_factory* f ) :
+   factory( f ), own_factory( 0 ),
+   node_slab( sizeof(sMesh_Node) ), edge_slab( sizeof(sMesh_Edge) ),
+   quad_slab( sizeof(sMesh_Quad) ), tri_slab( sizeof(sMesh_Tri) )
+{
+   if( factory == NULL ) {
+      factory = new sMesh_uid_factory();
+      own_factory = 1;
+   }
+}
+
+sMesh_Core::~sMesh_Core()
+{
+   ChildSetToken token;
+   long nn = (long) node_table.size(), ne = (long) edge_table.size();
+
+   // the whole mesh goes at once, so the references among its objects are not
+   // kept up (removing one is a scan of the object referred to): the faces
+   // hold nothing of their own and the slabs release the storage of all
+   // objects; the references that spilled from nodes and edges go with the
+   // pool of a factory of the mesh, or are given back to a shared one
+   if( own_factory ) {
+      delete factory;
+      return;
+   }
+
+   sMesh_RefPool* pool = factory->getRefPool();
+#pragma omp parallel for schedule(dynamic,4096)
+   for(long n=0;n<nn;++n) {
+      if( node_table[n] != NULL ) node_table[n]->dropRefs( token, pool );
+   }
+#pragma omp parallel for schedule(dynamic,4096)
+   for(long n=0;n<ne;++n) {
+      if( edge_table[n] != NULL ) edge_table[n]->dropRefs( token, pool );
+   }
+}
+
+sMesh_uid_factory* sMesh_Core::getFactory() const
+{
+   return factory;
+}
+
+
+//
+// Public method to receive arrays of node and element data (that is provided
+// in a conventional sparse format) and generate the internals of a mesh
+// object.
+// NOTE: Quadrilaterals need to have a proper winding order. The order can be
+// clockwise or counter-clockwise, but there has to be a winding order.
+//
+
+int sMesh_Core::loadData( int nno, const node_t nodes[],
+                          int nel, const face_t faces[] )
+{
+   if( nno <= 0 || nel <= 0 ) {
+      FPRINTF( stdout, " [Error]  Sizes (%d,%d) cannot be zero\n", nno, nel );
+      return 1;
+   }
+
+   if( nodes == NULL || faces == NULL ) {
+      FPRINTF( stdout, " [Error]  Pointers (%p,%p) cannot be null\n", nodes, faces );
+      return 2;
+   }
+
+   // count triangles and quadrilaterals
+   int ntri=0, nquad=0;
+   for(int n=0;n<nel;++n) {
+      if( faces[n].nodes[3] < 0 ) ++ntri;
+      else ++nquad;
+   }
+
+
+   // continuation needs to trap individual object allocations
+   int ierr=0;
+
+   std::vector< sMesh_Node* > nodes_ptr( nno, NULL );
+   for(int n=0;n<nno;++n) {
+      sMesh_Node* np = smesh_new_node( factory, &node_slab );
+      if( np == NULL ) { ierr=-111; break; }
+
+      np->x = nodes[n].x;
+      np->y = nodes[n].y;
+      np->z = nodes[n].z;
+      smesh_put_node( node_table, np );
+      nodes_ptr[n] = np;
+   }
+
+   // the edges of the faces in the order of the faces, found by their keys
+   // in a hash table, where the first use of an edge allocates the edge
+   std::vector< unsigned long > edge_keys;
+   std::vector< long > edge_first;
+   int ibad=0;
+   edge_keys.reserve( 4*((size_t) nel) );
+   for(int n=0;n<nel;++n) {
+      int ic = faces[n].nodes[3] < 0 ? 3 : 4;
+      for(int k=0;k<ic;++k) {
+         if( faces[n].nodes[k] < 0 || faces[n].nodes[k] >= nno ) ibad=1;
+         edge_keys.push_back( sMesh_EdgeHash::makeKey(
+                                 (unsigned long) faces[n].nodes[k],
+                                 (unsigned long) faces[n].nodes[(k+1)%ic] ) );
+         edge_first.push_back( (long) edge_first.size() );
+      }
+   }
+   if( ibad ) {
+      FPRINTF( stdout, " [Error]  Faces refer to nodes that do not exist \n" );
+      return 3;
+   }
+   sMesh_EdgeHash edge_hash;
+   long nkeys = (long) edge_keys.size();
+   if( ierr == 0 ) ierr = edge_hash.reserve( nkeys );
+   if( ierr == 0 && edge_hash.insertBulk( nkeys, edge_keys.data(),
+                                          edge_first.data() ) < 0 ) ierr=-122;
+   std::vector< sMesh_Edge* > edge_ptrs( nkeys, NULL );
+
+   nquad=0; ntri=0;
+   long nk = 0;
+   for(int n=0;n<nel && ierr==0;++n) {
+      char ic=4;
+      if( faces[n].nodes[3] < 0 ) ic=3;
+
+      long node_pairs[4][2] = {{-2,-2},{-2,-2},{-2,-2},{-2,-2}};
+      for(int k=0;k<4;++k) {
+         node_pairs[k][0] = faces[n].nodes[k];
+         node_pairs[k][1] = faces[n].nodes[0];
+         if( ic == 4 ) {
+            if( k < 3 ) node_pairs[k][1] = faces[n].nodes[k+1];
+         } else {
+            if( k < 2 ) node_pairs[k][1] = faces[n].nodes[k+1];
+         }
+      }
+
+      // allocate edges individually
+      sMesh_Edge* edges_ptr[4] = {NULL, NULL, NULL, NULL};
+      unsigned char edges_dir[4] = {9,9,9,9};
+      for(int k=0;k<ic && ierr==0;++k,++nk) {
+         edgeid_t eid;
+         int idir = set_edge_uid( eid, (unsigned long) node_pairs[k][0],
+                                       (unsigned long) node_pairs[k][1] );
+         edges_dir[k] = (unsigned char) idir;
+         if( edge_first[nk] == nk ) {
+            sMesh_Node* np1 = nodes_ptr[ eid.ids.i ];
+            sMesh_Node* np2 = nodes_ptr[ eid.ids.j ];
+            sMesh_Edge* ep = smesh_new_edge( factory, &edge_slab, np1, np2 );
+            if( ep == NULL ) { ierr=-121; break; }
+
+            ep->computeLength();
+            smesh_put_edge( edge_table, ep );
+            edge_ptrs[nk] = ep;
+         }
+         edges_ptr[k] = edge_ptrs[ edge_first[nk] ];
+
+         // set side bits
+         if( idir == 1 ) edges_ptr[k]->flags |= 0x01;
+         else            edges_ptr[k]->flags |= 0x02;
+      }
+
+      // create the face object
+      unsigned dirs_=0x00;
+      for(int k=0;k<ic;++k) if( edges_dir[k] == 2 ) dirs_ |= 0x01 << (3 - k);
+      if( ic==4 ) {
+         sMesh_Quad* qp = smesh_new_quad( factory, &quad_slab,
+                                          edges_ptr[0], edges_ptr[1],
+                                          edges_ptr[2], edges_ptr[3],
+                                          dirs_ << 4 );
+         if( qp == NULL ) { ierr=-131; break; }
+         smesh_put_quad( quad_table, qp );
+      } else {
+         sMesh_Tri* tp = smesh_new_tri( factory, &tri_slab,
+                                        edges_ptr[0], edges_ptr[1],
+                                        edges_ptr[2], dirs_ << 4 );
+         if( tp == NULL ) { ierr=-131; break; }
+         smesh_put_tri( tri_table, tp );
+      }
+   }
+   if( ierr ) {
+      FPRINTF( stdout, " [Error]  Something went really wrong... \n" );
+      return ierr;
+   }
+
+   return 0;
+}
+
+
+//
+// Public method to generate the internals of a mesh object from the arrays of
+// loadData() in parallel, with the same objects, UIDs and order of references
+// as loadData(). The sides of all faces are sorted by their pair of nodes, so
+// that every run of sides is an edge; edges are numbered by the first side in
+// the order of the faces, and faces by their kind. UIDs are reserved in
+// blocks so that the objects are made by many threads, after which the
+// references are added per node and per edge in the order of the faces.
+//
+
+int sMesh_Core::loadDataParallel( int nno, const node_t nodes[],
+                                  int nel, const face_t faces[] )
+{
+   if( nno <= 0 || nel <= 0 ) {
+      FPRINTF( stdout, " [Error]  Sizes (%d,%d) cannot be zero\n", nno, nel );
+      return 1;
+   }
+
+   if( nodes == NULL || faces == NULL ) {
+      FPRINTF( stdout, " [Error]  Pointers (%p,%p) cannot be null\n", nodes, faces );
+      return 2;
+   }
+
+   // offsets of the sides of the faces, and the rank of triangles
+   std::vector< long > cofs( nel+1, 0 ), trank( nel+1, 0 );
+   int ibad=0;
+#pragma omp parallel for reduction(|:ibad)
+   for(int n=0;n<nel;++n) {
+      int ic = faces[n].nodes[3] < 0 ? 3 : 4;
+      for(int k=0;k<ic;++k) {
+         if( faces[n].nodes[k] < 0 || faces[n].nodes[k] >= nno ) ibad=1;
+      }
+      cofs[n] = ic;
+      trank[n] = ic == 3 ? 1 : 0;
+   }
+   if( ibad ) {
+      FPRINTF( stdout, " [Error]  Faces refer to nodes that do not exist \n" );
+      return 3;
+   }
+   long nc = incg_Sort_ScanExclusive( nel+1, cofs.data() );
+   long ntri = incg_Sort_ScanExclusive( nel+1, trank.data() );
+   long nquad = nel - ntri;
+
+   int ierr=0;
+
+   // (objects of a kind are contiguous in a block of their slab)
+   sMesh_Node* nb = (sMesh_Node*) node_slab.allocBlock( nno );
+   if( nb == NULL ) {
+      FPRINTF( stdout, " [Error]  Could not create node objects \n" );
+      return -111;
+   }
+   long n0 = factory->getNewNodeUIDs( nno );
+   if( (long) node_table.size() < n0 + nno ) node_table.resize( n0 + nno );
+   std::vector< sMesh_Node* > nodes_ptr( nno, NULL );
+#pragma omp parallel for
+   for(int n=0;n<nno;++n) {
+      sMesh_Node* np = new ( nb + n ) sMesh_Node( factory, n0 + n );
+
+      np->x = nodes[n].x;
+      np->y = nodes[n].y;
+      np->z = nodes[n].z;
+      node_table[ n0 + n ] = np;
+      nodes_ptr[n] = np;
+   }
+
+   // sides keyed by their nodes and sorted stably (as "2*side + reversed"),
+   // with the number of the edge of every run at its first side in the order
+   // of the faces
+   std::vector< unsigned long > key( nc );
+   std::vector< long > side( nc ), sface( nc ), erank( nc+1, 0 );
+#pragma omp parallel for
+   for(int n=0;n<nel;++n) {
+      int ic = (int) ( cofs[n+1] - cofs[n] );
+      for(int k=0;k<ic;++k) {
+         unsigned long a = (unsigned long) faces[n].nodes[k];
+         unsigned long b = (unsigned long) faces[n].nodes[(k+1)%ic];
+         key[ cofs[n]+k ] = a < b ? a*nno + b : b*nno + a;
+         side[ cofs[n]+k ] = 2*( cofs[n]+k ) + ( a < b ? 0 : 1 );
+         sface[ cofs[n]+k ] = n;
+      }
+   }
+   ierr = incg_Sort_RadixKeys( nc, key.data(), side.data(),
+              incg_Sort_NumBits( ((unsigned long) nno)*nno - 1 ) );
+   if( ierr ) {
+      FPRINTF( stdout, " [Error]  Could not sort the sides of the faces \n" );
+      return -122;
+   }
+#pragma omp parallel for
+   for(long j=0;j<nc;++j) {
+      if( j == 0 || key[j] != key[j-1] ) erank[ side[j]/2 ] = 1;
+   }
+   long ne = incg_Sort_ScanExclusive( nc+1, erank.data() );
+
+   // edges are made in the order of their UIDs from the start of their run
+   std::vector< long > estart( ne+1 );
+#pragma omp parallel for
+   for(long j=0;j<nc;++j) {
+      if( j == 0 || key[j] != key[j-1] ) estart[ erank[ side[j]/2 ] ] = j;
+   }
+   estart[ne] = nc;
+
+   sMesh_Edge* eb = (sMesh_Edge*) edge_slab.allocBlock( ne );
+   if( eb == NULL ) {
+      FPRINTF( stdout, " [Error]  Could not create edge objects \n" );
+      return -121;
+   }
+   long e0 = factory->getNewEdgeUIDs( ne );
+   if( (long) edge_table.size() < e0 + ne ) edge_table.resize( e0 + ne );
+   std::vector< sMesh_Edge* > sedge( nc, NULL );
+#pragma omp parallel for
+   for(long i=0;i<ne;++i) {
+      long j = estart[i];
+      sMesh_Edge* ep = new ( eb + i ) sMesh_Edge( factory, e0 + i,
+                                                  nodes_ptr[ key[j]/nno ],
+                                                  nodes_ptr[ key[j]%nno ] );
+
+      ep->computeLength();
+      for(long l=j;l<nc && key[l]==key[j];++l) {
+         ep->flags |= ( side[l] & 0x01 ) ? 0x02 : 0x01;
+         sedge[ side[l]/2 ] = ep;
+      }
+      edge_table[ e0 + i ] = ep;
+   }
+
+   sMesh_Tri* tb = NULL;
+   sMesh_Quad* qb = NULL;
+   if( ntri > 0 ) tb = (sMesh_Tri*) tri_slab.allocBlock( ntri );
+   if( nquad > 0 ) qb = (sMesh_Quad*) quad_slab.allocBlock( nquad );
+   if( ( ntri > 0 && tb == NULL ) || ( nquad > 0 && qb == NULL ) ) {
+      FPRINTF( stdout, " [Error]  Could not create face objects \n" );
+      return -131;
+   }
+   long t0 = factory->getNewTriUIDs( ntri );
+   long q0 = factory->getNewQuadUIDs( nquad );
+   if( (long) tri_table.size() < t0 + ntri ) tri_table.resize( t0 + ntri );
+   if( (long) quad_table.size() < q0 + nquad ) quad_table.resize( q0 + nquad );
+   std::vector< smesh_ref_t > fref( nel, 0 );
+#pragma omp parallel for
+   for(int n=0;n<nel;++n) {
+      sMesh_Edge** e = &( sedge[ cofs[n] ] );
+      int ic = (int) ( cofs[n+1] - cofs[n] );
+
+      unsigned dirs_=0x00;
+      for(int k=0;k<ic;++k) {
+         if( faces[n].nodes[k] >= faces[n].nodes[(k+1)%ic] ) {
+            dirs_ |= 0x01 << (3 - k);
+         }
+      }
+      if( ic==4 ) {
+         sMesh_Quad* qp = new ( qb + n - trank[n] )
+                             sMesh_Quad( factory, q0 + n - trank[n],
+                                         e[0], e[1], e[2], e[3], dirs_ << 4 );
+         quad_table[ qp->getUID() ] = qp;
+         fref[n] = smesh_ref_make( qp, INCG_SMESH_REF_QUAD );
+      } else {
+         sMesh_Tri* tp = new ( tb + trank[n] )
+                            sMesh_Tri( factory, t0 + trank[n],
+                                       e[0], e[1], e[2], dirs_ << 4 );
+         tri_table[ tp->getUID() ] = tp;
+         fref[n] = smesh_ref_make( tp, INCG_SMESH_REF_TRI );
+      }
+   }
+
+   // references of the edges to their faces, in the order of the faces
+   sMesh_RefPool* pool = factory->getRefPool();
+#pragma omp parallel for
+   for(long i=0;i<ne;++i) {
+      sMesh_Edge* ep = edge_table[ e0 + i ];
+      for(long l=estart[i];l<nc && key[l]==key[ estart[i] ];++l) {
+         ep->addRef( fref[ sface[ side[l]/2 ] ], pool );
+      }
+   }
+
+   // references of the nodes to their edges, in the order of the edges
+   key.resize( 2*ne );
+   side.resize( 2*ne );
+#pragma omp parallel for
+   for(long i=0;i<ne;++i) {
+      const sMesh_Edge* ep = edge_table[ e0 + i ];
+      key[2*i+0] = (unsigned long) ( ep->getNodePtr(1)->getUID() - n0 );
+      key[2*i+1] = (unsigned long) ( ep->getNodePtr(2)->getUID() - n0 );
+      side[2*i+0] = i;
+      side[2*i+1] = i;
+   }
+   ierr = incg_Sort_RadixKeys( 2*ne, key.data(), side.data(),
+                               incg_Sort_NumBits( (unsigned long) nno ) );
+   if( ierr ) {
+      FPRINTF( stdout, " [Error]  Could not sort the nodes of the edges \n" );
+      return -122;
+   }
+#pragma omp parallel for
+   for(long j=0;j<2*ne;++j) {
+      if( j > 0 && key[j] == key[j-1] ) continue;
+      for(long l=j;l<2*ne && key[l]==key[j];++l) {
+         nodes_ptr[ key[l] ]->addRef(
+            smesh_ref_make( edge_table[ e0 + side[l] ], INCG_SMESH_REF_EDGE ),
+            pool );
+      }
+   }
+
+   return 0;
+}
+
+
+//
+// Public method to generate the internals of a mesh object from a mesh
+// object of triangles (mesh_t). Its edges and the orientation of its
+// triangles are taken as they are, so no edge is searched for; nodes, edges
+// and triangles are made in the order of the vertices, edges and triangles.
+//
+
+int sMesh_Core::loadMesh( const mesh_t* m )
+{
+   const unsigned char bit3 = 0x01 << 3;          // picks flags for face 0
+
+   if( m == NULL ) {
+      FPRINTF( stdout, " [Error]  Pointer to mesh cannot be null\n" );
+      return 2;
+   }
+   if( m->nv <= 0 || m->ne <= 0 || m->nt <= 0 ) {
+      FPRINTF( stdout, " [Error]  Sizes (%ld,%ld,%ld) cannot be zero\n",
+               m->nv, m->ne, m->nt );
+      return 1;
+   }
+
+   // continuation needs to trap individual object allocations
+   int ierr=0;
+
+   std::vector< sMesh_Node* > nodes( m->nv, NULL );
+   for(long n=0;n<m->nv;++n) {
+      sMesh_Node* np = smesh_new_node( factory, &node_slab );
+      if( np == NULL ) { ierr=-111; break; }
+
+      np->x = m->v[n].x;
+      np->y = m->v[n].y;
+      np->z = m->v[n].z;
+      smesh_put_node( node_table, np );
+      nodes[n] = np;
+   }
+
+   // edges run from the node of the lower UID; the sides that have
+   // triangles are set from the sense in which the triangles go along them
+   std::vector< sMesh_Edge* > edges( m->ne, NULL );
+   for(long n=0;n<m->ne && ierr==0;++n) {
+      sMesh_Node* npa = nodes[ m->e[n].va - m->v ];
+      sMesh_Node* npb = nodes[ m->e[n].vb - m->v ];
+      int ifwd = npa->getUID() < npb->getUID() ? 1 : 0;
+
+      sMesh_Edge* ep = ifwd ? smesh_new_edge( factory, &edge_slab, npa, npb ) :
+                              smesh_new_edge( factory, &edge_slab, npb, npa );
+      if( ep == NULL ) { ierr=-121; break; }
+
+      ep->computeLength();
+      if( m->e[n].tl != NULL ) ep->flags |= ifwd ? 0x01 : 0x02;
+      if( m->e[n].tr != NULL ) ep->flags |= ifwd ? 0x02 : 0x01;
+      smesh_put_edge( edge_table, ep );
+      edges[n] = ep;
+   }
+
+   for(long n=0;n<m->nt && ierr==0;++n) {
+      const triangle_t* t = &( m->t[n] );
+      const edge_t* te[3] = { t->e1, t->e2, t->e3 };
+      const char td[3] = { t->d1, t->d2, t->d3 };
+
+      // an edge is reversed when the triangle starts it at its second node
+      sMesh_Edge* edges_ptr[3];
+      unsigned dirs_=0x00;
+      for(int k=0;k<3;++k) {
+         const vertex_t* vs = td[k] == 0 ? te[k]->va : te[k]->vb;
+         edges_ptr[k] = edges[ te[k] - m->e ];
+         if( edges_ptr[k]->getNodePtr(2) == nodes[ vs - m->v ] ) {
+            dirs_ |= bit3 >> k;
+         }
+      }
+
+      sMesh_Tri* tp = smesh_new_tri( factory, &tri_slab,
+                                     edges_ptr[0], edges_ptr[1],
+                                     edges_ptr[2], dirs_ << 4 );
+      if( tp == NULL ) { ierr=-131; break; }
+      smesh_put_tri( tri_table, tp );
+   }
+   if( ierr ) {
+      FPRINTF( stdout, " [Error]  Something went really wrong... \n" );
+      return ierr;
+   }
+
+   return 0;
+}
+
+
+//
+// Public method to export the leaf elements of the mesh to a mesh object of
+// triangles (mesh_t), whose arrays are allocated. Vertices are the nodes in
+// the order of their UIDs, and edges are the leaf edges that leaf elements
+// use, in the order of their UIDs. Quadrilaterals are split in two triangles
+// across their shorter diagonal, which makes an edge after all the others.
+// Leaf triangles with split edges (hanging nodes), and edges with more than
+// one element on a side, cannot be exported.
+//
+
+int sMesh_Core::exportMesh( mesh_t* m ) const
+{
+   const unsigned char bit7 = 0x01 << 7;          // picks flags for face 0
+
+   if( m == NULL ) {
+      FPRINTF( stdout, " [Error]  Pointer to mesh cannot be null\n" );
+      return 2;
+   }
+
+   // the leaf elements (as lists of their edges) and the edges they use
+   std::vector< long > node_index( node_table.size(), -1 );
+   std::vector< void* > leaf_faces;
+   std::vector< int > leaf_sizes;
+   long nv = 0;
+   for(size_t k=0;k<node_table.size();++k) {
+      if( node_table[k] != NULL ) node_index[k] = nv++;
+   }
+   for(size_t k=0;k<tri_table.size();++k) {
+      sMesh_Tri* tp = tri_table[k];
+      if( tp == NULL || (tp->getSubdivAttr() & 0x0F) != 0 ) continue;
+      leaf_faces.push_back( tp );
+      leaf_sizes.push_back( 3 );
+   }
+   long nquad = 0;
+   for(size_t k=0;k<quad_table.size();++k) {
+      sMesh_Quad* qp = quad_table[k];
+      if( qp == NULL ) continue;
+      if( qp->getChildPtr(0) != NULL || qp->getChildPtr(1) != NULL ||
+          qp->getChildPtr(2) != NULL || qp->getChildPtr(3) != NULL ) continue;
+      leaf_faces.push_back( qp );
+      leaf_sizes.push_back( 4 );
+      ++nquad;
+   }
+   if( nv == 0 || leaf_faces.size() == 0 ) {
+      FPRINTF( stdout, " [Error]  There is nothing to export \n" );
+      return 1;
+   }
+
+   // edges of the elements: their index in the UID order, and direction bit
+   long nf = (long) leaf_faces.size();
+   std::vector< long > face_edges( 4*nf, -1 );
+   std::vector< long > edge_index( edge_table.size(), -1 );
+   for(long n=0;n<nf;++n) {
+      sMesh_Tri* tp = (sMesh_Tri*) leaf_faces[n];
+      sMesh_Quad* qp = (sMesh_Quad*) leaf_faces[n];
+      unsigned char eattr = leaf_sizes[n] == 3 ? tp->getEdgeAttr() :
+                                                 qp->getEdgeAttr();
+
+      for(int k=0;k<leaf_sizes[n];++k) {
+         sMesh_Edge* ep = leaf_sizes[n] == 3 ? tp->getEdgePtr(k) :
+                                               qp->getEdgePtr(k);
+         if( ep->isSplit() ) {
+            FPRINTF( stdout, " [Error]  Element has a hanging node \n" );
+            return 3;
+         }
+         long ie = ep->getUID();
+         edge_index[ie] = 0;
+         face_edges[4*n+k] = 2*ie + ( (eattr & (bit7 >> k)) ? 1 : 0 );
+      }
+   }
+   long ne = 0;
+   for(size_t n=0;n<edge_index.size();++n) {
+      if( edge_index[n] == 0 ) edge_index[n] = ne++;
+   }
+
+   long nt = nf + nquad;
+   ne += nquad;
+   vertex_t* v = (vertex_t*) malloc( ((size_t) nv) * sizeof( vertex_t ) );
+   edge_t* e = (edge_t*) malloc( ((size_t) ne) * sizeof( edge_t ) );
+   triangle_t* t = (triangle_t*) malloc( ((size_t) nt) * sizeof( triangle_t ) );
+   if( v == NULL || e == NULL || t == NULL ) {
+      if( t != NULL ) free( t );
+      if( e != NULL ) free( e );
+      if( v != NULL ) free( v );
+      FPRINTF( stdout, " [Error]  Could not allocate the mesh \n" );
+      return -1;
+   }
+
+   long n = 0;
+   for(size_t k=0;k<node_table.size();++k) {
+      sMesh_Node* np = node_table[k];
+      if( np == NULL ) continue;
+      n = node_index[k];
+      v[n].id = n;
+      v[n].x = np->x;
+      v[n].y = np->y;
+      v[n].z = np->z;
+   }
+   for(size_t k=0;k<edge_index.size();++k) {
+      if( edge_index[k] < 0 ) continue;
+      edge_t* ee = &( e[ edge_index[k] ] );
+      long uid1 = edge_table[k]->getNodePtr(1)->getUID();
+      long uid2 = edge_table[k]->getNodePtr(2)->getUID();
+      ee->id = edge_index[k];
+      ee->va = &( v[ node_index[uid1] ] );
+      ee->vb = &( v[ node_index[uid2] ] );
+      ee->tl = NULL;
+      ee->tr = NULL;
+   }
+
+   // triangles: the edges of an element in its loop (with their senses) and
+   // for a quad the diagonal, on which both of its triangles are formed
+   int ierr = 0;
+   long it_ = 0, id_ = ne - nquad;
+   for(n=0;n<nf && ierr==0;++n) {
+      edge_t* le[4];
+      char ld[4];
+      vertex_t* lv[4];
+      for(int k=0;k<leaf_sizes[n];++k) {
+         long fe = face_edges[4*n+k];
+         le[k] = &( e[ edge_index[ fe/2 ] ] );
+         ld[k] = (char) ( fe % 2 );
+         lv[k] = ld[k] == 0 ? le[k]->va : le[k]->vb;
+      }
+
+      edge_t* te[2][3];
+      char td[2][3];
+      int ntri = 1;
+      if( leaf_sizes[n] == 3 ) {
+         for(int k=0;k<3;++k) { te[0][k] = le[k]; td[0][k] = ld[k]; }
+      } else {
+         // start at the corner of the shorter diagonal
+         double d[2];
+         for(int k=0;k<2;++k) {
+            double dx = lv[k+2]->x - lv[k]->x;
+            double dy = lv[k+2]->y - lv[k]->y;
+            double dz = lv[k+2]->z - lv[k]->z;
+            d[k] = dx*dx + dy*dy + dz*dz;
+         }
+         int s = d[1] < d[0] ? 1 : 0;
+         edge_t* ed = &( e[ id_ ] );
+         ed->id = id_++;
+         ed->va = lv[s];
+         ed->vb = lv[s+2];
+         ed->tl = NULL;
+         ed->tr = NULL;
+
+         te[0][0] = le[s];         td[0][0] = ld[s];
+         te[0][1] = le[s+1];       td[0][1] = ld[s+1];
+         te[0][2] = ed;            td[0][2] = 1;
+         te[1][0] = ed;            td[1][0] = 0;
+         te[1][1] = le[s+2];       td[1][1] = ld[s+2];
+         te[1][2] = le[(s+3)%4];   td[1][2] = ld[(s+3)%4];
+         ntri = 2;
+      }
+
+      for(int j=0;j<ntri && ierr==0;++j) {
+         triangle_t* tt = &( t[ it_ ] );
+         tt->id = it_++;
+         tt->e1 = te[j][0];   tt->d1 = td[j][0];
+         tt->e2 = te[j][1];   tt->d2 = td[j][1];
+         tt->e3 = te[j][2];   tt->d3 = td[j][2];
+         tt->foo = 0;
+         for(int k=0;k<3;++k) {
+            triangle_t** side = td[j][k] == 0 ? &( te[j][k]->tl ) :
+                                                &( te[j][k]->tr );
+            if( *side != NULL ) ierr = 4;
+            *side = tt;
+         }
+      }
+   }
+   if( ierr ) {
+      free( t );
+      free( e );
+      free( v );
+      FPRINTF( stdout, " [Error]  An edge has two elements on a side \n" );
+      return ierr;
+   }
+
+   m->nv = nv;
+   m->ne = ne;
+   m->nt = nt;
+   m->v = v;
+   m->e = e;
+   m->t = t;
+
+   return 0;
+}
+
+
+//
+// Public method to make the objects of workers (see sMesh_Worker) part of the
+// mesh once the workers are done. Objects are placed in the tables of the
+// factory and of the mesh at their UIDs in parallel (the UIDs are distinct, so
+// no lock is needed), and the objects they use are given their references;
+// these are sorted by the UIDs of the objects that receive them, and every
+// thread adds those of its own runs of UIDs, in the order of the new objects.
+// The storage of the objects passes to the mesh and the workers are emptied
+// (their blocks of UIDs are dropped).
+// When "irenum" is not zero, the objects of every kind are first renumbered
+// densely from the first UID that the workers reserved, in ascending order of
+// their keys and, for a key, in the order in which they were made. The UIDs do
+// not then depend on the threads or their scheduling, provided that all the
+// objects of a key are made by one worker and that all the workers that made
+// objects since the first reservation are published together. Objects should
+// not have keys smaller than those of the objects they are made from (so that
+// split edges keep their children); edges that join two new nodes may change
+// the order of their nodes and are turned (see sMesh_Edge::reorient()).
+//
+
+int sMesh_Core::publish( int nw, sMesh_Worker* w[], int irenum )
+{
+   if( nw <= 0 || w == NULL ) {
+      FPRINTF( stdout, " [Error]  There are no workers to publish \n" );
+      return 1;
+   }
+   for(int i=0;i<nw;++i) {
+      if( w[i] == NULL || w[i]->factory != factory ) {
+         FPRINTF( stdout, " [Error]  Worker %d is not of this mesh \n", i );
+         return 2;
+      }
+   }
+
+   // objects of every kind, worker after worker
+   std::vector< void* > objs[4];
+   for(int k=0;k<4;++k) {
+      size_t m=0;
+      for(int i=0;i<nw;++i) m += w[i]->objs[k].size();
+      objs[k].reserve( m );
+      for(int i=0;i<nw;++i) {
+         objs[k].insert( objs[k].end(),
+                         w[i]->objs[k].begin(), w[i]->objs[k].end() );
+      }
+   }
+
+   ChildSetToken token;
+   if( irenum ) {
+      long last[4];
+      last[ INCG_SMESH_REF_NODE ] = factory->getLastNodeUID();
+      last[ INCG_SMESH_REF_EDGE ] = factory->getLastEdgeUID();
+      last[ INCG_SMESH_REF_QUAD ] = factory->getLastQuadUID();
+      last[ INCG_SMESH_REF_TRI ] = factory->getLastTriUID();
+
+      for(int k=0;k<4;++k) {
+         long m = (long) objs[k].size();
+         if( m == 0 ) continue;
+
+         // (a stable sort by the keys keeps the order of the objects of a key)
+         std::vector< unsigned long > key( m );
+         std::vector< long > val( m );
+         long j=0;
+         for(int i=0;i<nw;++i) {
+            std::copy( w[i]->keys[k].begin(), w[i]->keys[k].end(),
+                       key.begin() + j );
+            j += (long) w[i]->keys[k].size();
+         }
+         long base = last[k];
+         unsigned long kmax = 0;
+#pragma omp parallel for reduction(min:base) reduction(max:kmax)
+         for(long i=0;i<m;++i) {
+            long u = smesh_obj_uid( k, objs[k][i] );
+            if( u < base ) base = u;
+            if( key[i] > kmax ) kmax = key[i];
+            val[i] = i;
+         }
+         int ierr = incg_Sort_RadixKeys( m, key.data(), val.data(),
+                                         incg_Sort_NumBits( kmax ) );
+         if( ierr ) {
+            FPRINTF( stdout, " [Error]  Could not sort the objects \n" );
+            return -1;
+         }
+
+         std::vector< void* > sorted( m );
+#pragma omp parallel for
+         for(long i=0;i<m;++i) {
+            sorted[i] = objs[k][ val[i] ];
+            smesh_obj_setuid( k, sorted[i], base + i, token );
+         }
+         objs[k].swap( sorted );
+         last[k] = base + m - 1;
+      }
+
+      factory->setLastNodeUID( last[ INCG_SMESH_REF_NODE ] );
+      factory->setLastEdgeUID( last[ INCG_SMESH_REF_EDGE ] );
+      factory->setLastQuadUID( last[ INCG_SMESH_REF_QUAD ] );
+      factory->setLastTriUID( last[ INCG_SMESH_REF_TRI ] );
+   }
+   factory->growTables();
+
+   if( (long) node_table.size() < factory->sizeNodes() )
+      node_table.resize( factory->sizeNodes(), NULL );
+   if( (long) edge_table.size() < factory->sizeEdges() )
+      edge_table.resize( factory->sizeEdges(), NULL );
+   if( (long) quad_table.size() < factory->sizeQuads() )
+      quad_table.resize( factory->sizeQuads(), NULL );
+   if( (long) tri_table.size() < factory->sizeTris() )
+      tri_table.resize( factory->sizeTris(), NULL );
+
+   std::vector< void* > & on = objs[ INCG_SMESH_REF_NODE ];
+   std::vector< void* > & oe = objs[ INCG_SMESH_REF_EDGE ];
+   std::vector< void* > & oq = objs[ INCG_SMESH_REF_QUAD ];
+   std::vector< void* > & ot = objs[ INCG_SMESH_REF_TRI ];
+#pragma omp parallel
+   {
+#pragma omp for
+      for(size_t n=0;n<on.size();++n) {
+         sMesh_Node* np = (sMesh_Node*) on[n];
+         factory->setNodePtr( np->getUID(), np );
+         node_table[ np->getUID() ] = np;
+      }
+#pragma omp for
+      for(size_t n=0;n<oe.size();++n) {
+         sMesh_Edge* ep = (sMesh_Edge*) oe[n];
+         factory->setEdgePtr( ep->getUID(), ep );
+         edge_table[ ep->getUID() ] = ep;
+      }
+#pragma omp for
+      for(size_t n=0;n<oq.size();++n) {
+         sMesh_Quad* qp = (sMesh_Quad*) oq[n];
+         factory->setQuadPtr( qp->getUID(), qp );
+         quad_table[ qp->getUID() ] = qp;
+      }
+#pragma omp for
+      for(size_t n=0;n<ot.size();++n) {
+         sMesh_Tri* tp = (sMesh_Tri*) ot[n];
+         factory->setTriPtr( tp->getUID(), tp );
+         tri_table[ tp->getUID() ] = tp;
+      }
+   }
+
+   // edges whose nodes swapped their order are turned, and so are their faces
+   if( irenum ) {
+      std::vector< unsigned char > turned( edge_table.size(), 0 );
+#pragma omp parallel
+      {
+#pragma omp for
+         for(size_t n=0;n<oe.size();++n) {
+            sMesh_Edge* ep = (sMesh_Edge*) oe[n];
+            if( ep->reorient( token ) ) turned[ ep->getUID() ] = 1;
+         }
+#pragma omp for
+         for(size_t n=0;n<oq.size();++n) {
+            sMesh_Quad* qp = (sMesh_Quad*) oq[n];
+            for(int k=0;k<4;++k) {
+               sMesh_Edge* ep = qp->getEdgePtr(k);
+               if( turned[ ep->getUID() ] ) qp->flipEdge( ep, token );
+            }
+         }
+#pragma omp for
+         for(size_t n=0;n<ot.size();++n) {
+            sMesh_Tri* tp = (sMesh_Tri*) ot[n];
+            for(int k=0;k<3;++k) {
+               sMesh_Edge* ep = tp->getEdgePtr(k);
+               if( turned[ ep->getUID() ] ) tp->flipEdge( ep, token );
+            }
+         }
+      }
+   }
+
+   // references of the nodes to the new edges and of the edges to the new
+   // faces, sorted by the UIDs of the objects that receive them (the sort is
+   // stable, so they keep the order of the new objects); every thread adds
+   // those of the runs of UIDs that start in its range
+   sMesh_RefPool* pool = factory->getRefPool();
+   long ne = (long) oe.size();
+   long nt = (long) ot.size(), nf = 3*nt + 4*(long) oq.size();
+   std::vector< unsigned long > key( 2*ne > nf ? 2*ne : nf );
+   std::vector< long > val( key.size() );
+
+#pragma omp parallel for
+   for(long n=0;n<ne;++n) {
+      const sMesh_Edge* ep = (const sMesh_Edge*) oe[n];
+      for(int k=0;k<2;++k) {
+         key[2*n+k] = (unsigned long) ep->getNodePtr(k+1)->getUID();
+         val[2*n+k] = 2*n+k;
+      }
+   }
+   int nbits = incg_Sort_NumBits( (unsigned long) node_table.size() );
+   int ierr = incg_Sort_RadixKeys( 2*ne, key.data(), val.data(), nbits );
+   if( ierr ) {
+      FPRINTF( stdout, " [Error]  Could not sort the nodes of the edges \n" );
+      return -1;
+   }
+#pragma omp parallel for
+   for(long j=0;j<2*ne;++j) {
+      if( j > 0 && key[j] == key[j-1] ) continue;
+      for(long l=j;l<2*ne && key[l]==key[j];++l) {
+         sMesh_Edge* ep = (sMesh_Edge*) oe[ val[l]/2 ];
+         ep->getNodePtr( 1 + (int) (val[l]%2) )->addRef(
+            smesh_ref_make( ep, INCG_SMESH_REF_EDGE ), pool );
+      }
+   }
+
+#pragma omp parallel for
+   for(long n=0;n<nf;++n) {
+      const sMesh_Edge* ep;
+      if( n < 3*nt ) {
+         ep = ((const sMesh_Tri*) ot[n/3])->getEdgePtr( (int) (n%3) );
+      } else {
+         ep = ((const sMesh_Quad*) oq[(n-3*nt)/4])->getEdgePtr(
+                                                   (int) ((n-3*nt)%4) );
+      }
+      key[n] = (unsigned long) ep->getUID();
+      val[n] = n;
+   }
+   nbits = incg_Sort_NumBits( (unsigned long) edge_table.size() );
+   ierr = incg_Sort_RadixKeys( nf, key.data(), val.data(), nbits );
+   if( ierr ) {
+      FPRINTF( stdout, " [Error]  Could not sort the edges of the faces \n" );
+      return -1;
+   }
+#pragma omp parallel for
+   for(long j=0;j<nf;++j) {
+      if( j > 0 && key[j] == key[j-1] ) continue;
+      for(long l=j;l<nf && key[l]==key[j];++l) {
+         long n = val[l];
+         if( n < 3*nt ) {
+            sMesh_Tri* tp = (sMesh_Tri*) ot[n/3];
+            tp->getEdgePtr( (int) (n%3) )->addRef(
+               smesh_ref_make( tp, INCG_SMESH_REF_TRI ), pool );
+         } else {
+            sMesh_Quad* qp = (sMesh_Quad*) oq[(n-3*nt)/4];
+            qp->getEdgePtr( (int) ((n-3*nt)%4) )->addRef(
+               smesh_ref_make( qp, INCG_SMESH_REF_QUAD ), pool );
+         }
+      }
+   }
+
+   for(int i=0;i<nw;++i) {
+      node_slab.adopt( w[i]->node_slab );
+      edge_slab.adopt( w[i]->edge_slab );
+      quad_slab.adopt( w[i]->quad_slab );
+      tri_slab.adopt( w[i]->tri_slab );
+      w[i]->clear();
+   }
+
+   return 0;
+}
+
+
+//
+// Public method to receive arrays of node and element data (that is provided
+// in a conventional sparse format) and generate the internals of a mesh
+// object.
+//
+
+int sMesh_Core::quadify()
+{
+   // elements to subdivide are gathered first, in the order of their UIDs
+   std::vector< sMesh_Tri* > tri_rules;
+   std::vector< unsigned char > tri_attrs;
+   for(size_t n=0;n<tri_table.size();++n) {
+      sMesh_Tri* tp = tri_table[n];
+      if( tp == NULL ) continue;
+      unsigned char attr;
+      double tmp=0.0;
+      tp->computeHeuristics( attr, tmp );
+      // when any of the angles is obtuse
+      if( attr & 0x07 ) {
+         tri_rules.push_back( tp );
+         tri_attrs.push_back( attr );
+      }
+   }
+
+   int ierr=0;
+   for(size_t n=0;n<tri_rules.size();++n) {
+
+      // find out which edge needs to be subdivided
+      unsigned char attr = tri_attrs[n];
+      int index=-2;
+      if( attr & 0x04 ) index=0;
+      if( attr & 0x02 ) { if( index==-2 ) { index=1; } else { index=-1; } }
+      if( attr & 0x01 ) { if( index==-2 ) { index=2; } else { index=-1; } }
+      // Should return an index {0,1,2}
+      // "-1" is an error of duplicate obtuse angle!
+      if( index < 0 ) {
+         FPRINTF( stdout, " [Error]  Invalid Rule 3 index %d \n", ierr );
+         ierr=999;
+         break;
+      } else {
+         ierr=subdivideByRule3( tri_rules[n], index, NULL, 0 );
+      }
+   }
+   if( ierr ) {
+      FPRINTF( stdout, " [Error]  Something went really wrong... \n" );
+      return 1;
+   }
+   tri_rules.clear();
+
+   for(size_t n=0;n<tri_table.size();++n) {
+      sMesh_Tri* tp = tri_table[n];
+      if( tp == NULL ) continue;
+      if( (tp->getSubdivAttr() & 0x0F) == 0  ) tri_rules.push_back( tp );
+   }
+
+   for(size_t n=0;n<tri_rules.size();++n) {
+      ierr=subdivideByRule1( tri_rules[n], NULL, 0 );
+      if( ierr ) break;
+   }
+   if( ierr ) {
+      FPRINTF( stdout, " [Error]  Something went really wrong... \n" );
+      return 1;
+   }
+   tri_rules.clear();
+
+   char ic=1;     // iteration
+   while( ic && ierr==0 ) {
+
+      std::vector< sMesh_Quad* > quad_rules;
+      std::vector< unsigned char > quad_attrs;
+      for(size_t n=0;n<quad_table.size();++n) {
+         sMesh_Quad* qp = quad_table[n];
+         if( qp == NULL ) continue;
+         unsigned char uc = (unsigned char) qp->needsSubdivision();
+         if( uc ) {
+            quad_rules.push_back( qp );
+            quad_attrs.push_back( uc );
+         }
+      }
+      if( quad_rules.size() == 0 ) ic=0;    // iteration termination
+
+      for(size_t n=0;n<quad_rules.size();++n) {
+         sMesh_Quad* qp = quad_rules[n];
+         if( quad_attrs[n] == 1 ) {
+            ierr=subdivideByRule2u( qp, NULL, 0 );
+         } else if( quad_attrs[n] == 2 ) {
+            ierr=subdivideByRule2v( qp, NULL, 0 );
+         } else if( quad_attrs[n] == 3 ) {
+            // We will force a "u-subdivision" and allow the iteration to pick
+            // up the subdivisions of the child quads in the next epoch.
+            ierr=subdivideByRule2u( qp, NULL, 0 );
+         } else {
+            ierr=999;
+         }
+         if( ierr ) {
+            ic=0;
+            break;
+         }
+      }
+
+#ifdef _DEBUG_
+      dumpEdges( "edges.dat", 1 );
+#endif
+   }
+   if( ierr ) {
+      FPRINTF( stdout, " [Error]  Something went really wrong... \n" );
+      return 1;
+   }
+
+   return 0;
+}
+
+
+//
+// Function to release the workers of a parallel subdivision that failed
+//
+
+static int smesh_quadify_fail( int nw, sMesh_Worker* w[] )
+{
+   FPRINTF( stdout, " [Error]  Something went really wrong... \n" );
+   for(int i=0;i<nw;++i) delete w[i];
+   return 1;
+}
+
+
+//
+// Public method to subdivide the mesh as quadify() does with the work of every
+// phase (rule 3, rule 1, and every iteration of rule 2) spread over threads.
+// A phase takes the elements that quadify() takes, in the same order, and
+// makes three parallel passes over them: the elements claim the edges they
+// split with tickets of their index and step (see sMesh_Edge::claim()), every
+// edge is split by its least claim, and the elements are then subdivided with
+// their edges split; the passes are scheduled statically, so that a thread
+// takes the same elements in all three. Objects are made by workers (one per
+// thread) with keys of the same index and step, and are published with
+// renumbering at the end of the phase, so that the mesh, UIDs included, is that
+// of quadify() for any number of threads. With a single thread it is quadify()
+// itself.
+//
+
+int sMesh_Core::quadifyParallel()
+{
+   int nw=1;
+#ifdef _OPENMP
+   nw = omp_get_max_threads();
+#endif
+   if( nw == 1 ) return quadify();
+
+   std::vector< sMesh_Worker* > w( nw, NULL );
+   for(int i=0;i<nw;++i) w[i] = new sMesh_Worker( factory );
+
+   // rule 3: the edge opposite the obtuse angle is split (tickets 2n)
+   long ntri = (long) tri_table.size();
+   std::vector< unsigned char > tri_attrs( ntri, 0x00 );
+#pragma omp parallel for
+   for(long n=0;n<ntri;++n) {
+      sMesh_Tri* tp = tri_table[n];
+      if( tp == NULL ) continue;
+      double tmp=0.0;
+      tp->computeHeuristics( tri_attrs[n], tmp );
+   }
+
+   std::vector< sMesh_Tri* > tri_rules;
+   std::vector< int > tri_index;
+   long nerr=0;
+   for(long n=0;n<ntri;++n) {
+      unsigned char attr = tri_attrs[n];
+      if( tri_table[n] == NULL || (attr & 0x07) == 0 ) continue;
+      int index=-2;
+      if( attr & 0x04 ) index=0;
+      if( attr & 0x02 ) { if( index==-2 ) { index=1; } else { index=-1; } }
+      if( attr & 0x01 ) { if( index==-2 ) { index=2; } else { index=-1; } }
+      if( index < 0 ) {
+         FPRINTF( stdout, " [Error]  Invalid Rule 3 index %d \n", index );
+         return smesh_quadify_fail( nw, w.data() );
+      }
+      tri_rules.push_back( tri_table[n] );
+      tri_index.push_back( index );
+   }
+
+   long nr = (long) tri_rules.size();
+#pragma omp parallel
+   {
+      sMesh_Worker* me = w[0];
+#ifdef _OPENMP
+      me = w[ omp_get_thread_num() ];
+#endif
+#pragma omp for schedule(static)
+      for(long n=0;n<nr;++n) {
+         sMesh_Edge* ep = tri_rules[n]->getEdgePtr( tri_index[n] );
+         if( !ep->isSplit() ) ep->claim( 2*n );
+      }
+#pragma omp for schedule(static) reduction(+:nerr)
+      for(long n=0;n<nr;++n) {
+         sMesh_Edge* ep = tri_rules[n]->getEdgePtr( tri_index[n] );
+         if( ep->getClaim() == (unsigned long) (2*n) && !ep->isSplit() ) {
+            me->setKey( 2*n );
+            if( splitEdge( me, ep ) ) ++nerr;
+         }
+      }
+#pragma omp for schedule(static) reduction(+:nerr)
+      for(long n=0;n<nr;++n) {
+         if( subdivideByRule3( tri_rules[n], tri_index[n], me, 2*n ) ) ++nerr;
+      }
+   }
+   if( nerr == 0 ) nerr = publish( nw, w.data(), 1 );
+   if( nerr ) return smesh_quadify_fail( nw, w.data() );
+   tri_rules.clear();
+
+   // rule 1: triangles become three quadrilaterals (tickets 8n+1+2k)
+   for(size_t n=0;n<tri_table.size();++n) {
+      sMesh_Tri* tp = tri_table[n];
+      if( tp == NULL ) continue;
+      if( (tp->getSubdivAttr() & 0x0F) == 0  ) tri_rules.push_back( tp );
+   }
+
+   nr = (long) tri_rules.size();
+#pragma omp parallel
+   {
+      sMesh_Worker* me = w[0];
+#ifdef _OPENMP
+      me = w[ omp_get_thread_num() ];
+#endif
+#pragma omp for schedule(static)
+      for(long n=0;n<nr;++n) {
+         for(int k=0;k<3;++k) {
+            sMesh_Edge* ep = tri_rules[n]->getEdgePtr(k);
+            if( !ep->isSplit() ) ep->claim( 8*n + 1 + 2*k );
+         }
+      }
+#pragma omp for schedule(static) reduction(+:nerr)
+      for(long n=0;n<nr;++n) {
+         for(int k=0;k<3;++k) {
+            sMesh_Edge* ep = tri_rules[n]->getEdgePtr(k);
+            unsigned long t = 8*n + 1 + 2*k;
+            if( ep->getClaim() == t && !ep->isSplit() ) {
+               me->setKey( t );
+               if( splitEdge( me, ep ) ) ++nerr;
+            }
+         }
+      }
+#pragma omp for schedule(static) reduction(+:nerr)
+      for(long n=0;n<nr;++n) {
+         if( subdivideByRule1( tri_rules[n], me, 8*n ) ) ++nerr;
+      }
+   }
+   if( nerr == 0 ) nerr = publish( nw, w.data(), 1 );
+   if( nerr ) return smesh_quadify_fail( nw, w.data() );
+   tri_rules.clear();
+
+   // rule 2: quadrilaterals with split edges are halved until none is left;
+   // the "u" split takes edges 0 and 2, the "v" split edges 3 and 1 (tickets
+   // 4n and 4n+1)
+   while( 1 ) {
+
+      std::vector< sMesh_Quad* > quad_rules;
+      std::vector< unsigned char > quad_attrs;
+      for(size_t n=0;n<quad_table.size();++n) {
+         sMesh_Quad* qp = quad_table[n];
+         if( qp == NULL ) continue;
+         unsigned char uc = (unsigned char) qp->needsSubdivision();
+         if( uc ) {
+            quad_rules.push_back( qp );
+            quad_attrs.push_back( uc );
+         }
+      }
+      if( quad_rules.size() == 0 ) break;    // iteration termination
+
+      nr = (long) quad_rules.size();
+#pragma omp parallel
+      {
+         sMesh_Worker* me = w[0];
+#ifdef _OPENMP
+         me = w[ omp_get_thread_num() ];
+#endif
+#pragma omp for schedule(static)
+         for(long n=0;n<nr;++n) {
+            for(int k=0;k<2;++k) {
+               int ie = quad_attrs[n] == 2 ? 3 - 2*k : 2*k;
+               sMesh_Edge* ep = quad_rules[n]->getEdgePtr( ie );
+               if( !ep->isSplit() ) ep->claim( 4*n + k );
+            }
+         }
+#pragma omp for schedule(static) reduction(+:nerr)
+         for(long n=0;n<nr;++n) {
+            for(int k=0;k<2;++k) {
+               int ie = quad_attrs[n] == 2 ? 3 - 2*k : 2*k;
+               sMesh_Edge* ep = quad_rules[n]->getEdgePtr( ie );
+               unsigned long t = 4*n + k;
+               if( ep->getClaim() == t && !ep->isSplit() ) {
+                  me->setKey( t );
+                  if( splitEdge( me, ep ) ) ++nerr;
+               }
+            }
+         }
+#pragma omp for schedule(static) reduction(+:nerr)
+         for(long n=0;n<nr;++n) {
+            int iret=999;
+            // (a split both ways is "u" first, as in quadify())
+            if( quad_attrs[n] == 1 || quad_attrs[n] == 3 ) {
+               iret=subdivideByRule2u( quad_rules[n], me, 4*n );
+            } else if( quad_attrs[n] == 2 ) {
+               iret=subdivideByRule2v( quad_rules[n], me, 4*n );
+            }
+            if( iret ) ++nerr;
+         }
+      }
+      if( nerr == 0 ) nerr = publish( nw, w.data(), 1 );
+      if( nerr ) return smesh_quadify_fail( nw, w.data() );
+
+#ifdef _DEBUG_
+      dumpEdges( "edges.dat", 1 );
+#endif
+   }
+
+   for(int i=0;i<nw;++i) delete w[i];
+
+   return 0;
+}
+
+
+//
+// Public method to export the leaf elements of the mesh as arrays of node and
+// face data in the sparse format of loadData(). Nodes are placed in the order
+// of their UIDs, followed by the triangles and then by the quadrilaterals that
+// are not subdivided; triangles have a negative fourth node index.
+//
+
+int sMesh_Core::exportData( std::vector< node_t > & nodes,
+                            std::vector< face_t > & faces ) const
+{
+   const unsigned char bit7 = 0x01 << 7;          // picks flags for face 0
+
+   nodes.clear();
+   faces.clear();
+
+   std::vector< long > node_index( node_table.size(), -1 );
+   nodes.reserve( node_table.size() );
+   for(size_t n=0;n<node_table.size();++n) {
+      sMesh_Node* np = node_table[n];
+      if( np == NULL ) continue;
+      node_index[n] = (long) nodes.size();
+      nodes.push_back( { np->x, np->y, np->z } );
+   }
+
+   for(size_t n=0;n<tri_table.size();++n) {
+      sMesh_Tri* tp = tri_table[n];
+      if( tp == NULL || (tp->getSubdivAttr() & 0x0F) != 0 ) continue;
+
+      unsigned char eattr = tp->getEdgeAttr();
+      face_t f = {{ -1, -1, -1, -1 }};
+      for(int k=0;k<3;++k) {   // the face's loop starts every edge
+         sMesh_Edge* ep = tp->getEdgePtr(k);
+         sMesh_Node* np = ep->getNodePtr( (eattr & (bit7 >> k)) ? 2 : 1 );
+         f.nodes[k] = node_index[ np->getUID() ];
+      }
+      faces.push_back( f );
+   }
+
+   for(size_t n=0;n<quad_table.size();++n) {
+      sMesh_Quad* qp = quad_table[n];
+      if( qp == NULL ) continue;
+      int ic=0;
+      for(int k=0;k<4;++k) if( qp->getChildPtr(k) != NULL ) ++ic;
+      if( ic ) continue;
+
+      unsigned char eattr = qp->getEdgeAttr();
+      face_t f;
+      for(int k=0;k<4;++k) {
+         sMesh_Edge* ep = qp->getEdgePtr(k);
+         sMesh_Node* np = ep->getNodePtr( (eattr & (bit7 >> k)) ? 2 : 1 );
+         f.nodes[k] = node_index[ np->getUID() ];
+      }
+      faces.push_back( f );
+   }
+
+   return 0;
+}
+
+
+//
+// Public method to write the leaf elements of the mesh to a binary mesh file
+//
+
+int sMesh_Core::writeBinary( const char filename[] ) const
+{
+   std::vector< node_t > nodes;
+   std::vector< face_t > faces;
+
+   exportData( nodes, faces );
+   if( nodes.size() == 0 || faces.size() == 0 ) {
+      FPRINTF( stdout, " [Error]  There is nothing to write \n" );
+      return 1;
+   }
+
+   int ierr = incg_MeshFile_WriteFaces( (long) nodes.size(),
+                                        (const double*) nodes.data(),
+                                        (long) faces.size(),
+                                        (const long*) faces.data(),
+                                        filename );
+   if( ierr ) {
+      FPRINTF( stdout, " [Error]  Could not write file \"%s\" \n", filename );
+      return 2;
+   }
+
+   return 0;
+}
+
+
+//
+// Public method to write the leaf elements of the mesh to a plot file in one
+// of the formats of incg_MeshFile_PlotFaces() (INCG_PLOT_*)
+//
+
+int sMesh_Core::writePlot( const char filename[], int iformat ) const
+{
+   std::vector< node_t > nodes;
+   std::vector< face_t > faces;
+
+   exportData( nodes, faces );
+   if( nodes.size() == 0 || faces.size() == 0 ) {
+      FPRINTF( stdout, " [Error]  There is nothing to write \n" );
+      return 1;
+   }
+
+   int ierr = incg_MeshFile_PlotFaces( (long) nodes.size(),
+                                       (const double*) nodes.data(),
+                                       (long) faces.size(),
+                                       (const long*) faces.data(),
+                                       iformat, "sMesh", filename );
+   if( ierr ) {
+      FPRINTF( stdout, " [Error]  Could not write file \"%s\" \n", filename );
+      return 2;
+   }
+
+   return 0;
+}
+
+
+//
+// Public method to load a binary mesh file. The file is mapped to memory and
+// its arrays are given to loadData() in place, without parsing or copying.
+// Files with more nodes or faces than loadData() can index are rejected.
+//
+
+int sMesh_Core::loadBinary( const char filename[] )
+{
+   struct incg_meshfile_s f;
+
+   if( sizeof(node_t) != 3*sizeof(double) ||
+       sizeof(face_t) != 4*sizeof(long) ) {
+      FPRINTF( stdout, " [Error]  Node and face types are padded \n" );
+      return 1;
+   }
+
+   int ierr = incg_MeshFile_Open( filename, &f );
+   if( ierr ) {
+      FPRINTF( stdout, " [Error]  Could not map file \"%s\" \n", filename );
+      return 2;
+   }
+   if( f.x == NULL || f.faces == NULL ) {
+      FPRINTF( stdout, " [Error]  File \"%s\" has no faces \n", filename );
+      incg_MeshFile_Close( &f );
+      return 3;
+   }
+   if( f.nv > INT_MAX || f.nf > INT_MAX ) {
+      FPRINTF( stdout, " [Error]  File \"%s\" is too large to load \n",
+               filename );
+      incg_MeshFile_Close( &f );
+      return 4;
+   }
+
+   ierr = loadData( (int) f.nv, (const node_t*) f.x,
+                    (int) f.nf, (const face_t*) f.faces );
+   incg_MeshFile_Close( &f );
+
+   return ierr;
+}
+
+
+//
+// Functions to tell whether an object is in the table of its kind at the entry
+// of its UID; as objects live in the slabs of the mesh until it is destroyed,
+// any pointer that was once given to an object of the mesh can be read
+//
+
+static int smesh_check_node( const nodetab_t & tab, const sMesh_Node* p )
+{
+   if( p == NULL ) return 0;
+   long uid = p->getUID();
+   return ( uid >= 0 && uid < (long) tab.size() && tab[uid] == p ) ? 1 : 0;
+}
+
+static int smesh_check_edge( const edgetab_t & tab, const sMesh_Edge* p )
+{
+   if( p == NULL ) return 0;
+   long uid = p->getUID();
+   return ( uid >= 0 && uid < (long) tab.size() && tab[uid] == p ) ? 1 : 0;
+}
+
+static int smesh_check_tri( const tritab_t & tab, const sMesh_Tri* p )
+{
+   if( p == NULL ) return 0;
+   long uid = p->getUID();
+   return ( uid >= 0 && uid < (long) tab.size() && tab[uid] == p ) ? 1 : 0;
+}
+
+static int smesh_check_quad( const quadtab_t & tab, const sMesh_Quad* p )
+{
+   if( p == NULL ) return 0;
+   long uid = p->getUID();
+   return ( uid >= 0 && uid < (long) tab.size() && tab[uid] == p ) ? 1 : 0;
+}
+
+
+//
+// Function to check a face given its edges and the direction bits of its loop
+// and to return the flags of its violations
+//
+
+static unsigned int smesh_check_face( sMesh_Edge* const e[], int n,
+                                      unsigned char eattr, int leaf,
+                                      const edgetab_t & edges )
+{
+   const unsigned char bit7 = 0x01 << 7;          // picks flags for face 0
+   const sMesh_Node *na[4], *nb[4];
+   unsigned int f=0;
+   int k;
+
+   for(k=0;k<n;++k) {
+      if( smesh_check_edge( edges, e[k] ) == 0 ) return INCG_CHECK_LINK;
+      na[k] = e[k]->getNodePtr( (eattr & (bit7 >> k)) ? 2 : 1 );
+      nb[k] = e[k]->getNodePtr( (eattr & (bit7 >> k)) ? 1 : 2 );
+      if( na[k] == NULL || nb[k] == NULL ) return INCG_CHECK_LINK;
+   }
+   for(k=0;k<n;++k) {
+      if( nb[k] != na[(k+1)%n] ) f |= INCG_CHECK_LOOP;
+      if( leaf && e[k]->isSplit() ) f |= INCG_CHECK_HANGING;
+   }
+   if( f & INCG_CHECK_LOOP ) return f;
+
+   // repeated nodes, or zero area by the (Newell) normal of the loop
+   double v[3] = { 0.0, 0.0, 0.0 }, s=0.0;
+   for(k=0;k<n;++k) {
+      const sMesh_Node *p = na[k], *q = na[(k+1)%n];
+      for(int j=k+1;j<n;++j) if( na[j] == p ) f |= INCG_CHECK_DEGENERATE;
+      v[0] += ( p->y - q->y )*( p->z + q->z );
+      v[1] += ( p->z - q->z )*( p->x + q->x );
+      v[2] += ( p->x - q->x )*( p->y + q->y );
+      s += ( q->x - p->x )*( q->x - p->x ) + ( q->y - p->y )*( q->y - p->y ) +
+           ( q->z - p->z )*( q->z - p->z );
+   }
+   if( v[0]*v[0] + v[1]*v[1] + v[2]*v[2] <= 1.0e-24*s*s ) {
+      f |= INCG_CHECK_DEGENERATE;
+   }
+
+   return f;
+}
+
+
+//
+// Function to check the faces that reference an edge: they are faces of the
+// mesh that have the edge, and the edge is used by at most two leaf faces, in
+// opposite directions
+//
+
+static unsigned int smesh_check_uses( const sMesh_Edge* ep,
+                                      const tritab_t & tris,
+                                      const quadtab_t & quads )
+{
+   unsigned int f=0;
+   int nuse[2] = { 0, 0 };
+
+   for(unsigned int n=0;n<ep->getNumRefs();++n) {
+      smesh_ref_t r = ep->getRef(n);
+      int nk=0, leaf=1, k;
+      unsigned char eattr;
+      sMesh_Edge* e[4];
+
+      if( smesh_ref_kind( r ) == INCG_SMESH_REF_TRI ) {
+         const sMesh_Tri* tp = (const sMesh_Tri*) smesh_ref_ptr( r );
+         if( smesh_check_tri( tris, tp ) == 0 ) return INCG_CHECK_LINK;
+         for(k=0;k<3;++k) e[k] = tp->getEdgePtr(k);
+         nk = 3;
+         eattr = tp->getEdgeAttr();
+         if( (tp->getSubdivAttr() & 0x0F) != 0 ) leaf = 0;
+      } else if( smesh_ref_kind( r ) == INCG_SMESH_REF_QUAD ) {
+         const sMesh_Quad* qp = (const sMesh_Quad*) smesh_ref_ptr( r );
+         if( smesh_check_quad( quads, qp ) == 0 ) return INCG_CHECK_LINK;
+         for(k=0;k<4;++k) {
+            e[k] = qp->getEdgePtr(k);
+            if( qp->getChildPtr(k) != NULL ) leaf = 0;
+         }
+         nk = 4;
+         eattr = qp->getEdgeAttr();
+      } else {
+         return INCG_CHECK_LINK;
+      }
+
+      for(k=0;k<nk && e[k] != ep;++k);
+      if( k == nk ) return INCG_CHECK_LINK;
+      if( leaf ) nuse[ (eattr >> (7-k)) & 0x01 ] += 1;
+   }
+   if( nuse[0] > 1 || nuse[1] > 1 ) f |= INCG_CHECK_MANIFOLD;
+
+   return f;
+}
 
-   return 0;
+
+//
+// Public method to check the mesh and to return its violations by UID in the
+// lists of a check (see incg_Check_Mesh()):
+//  - every object is in the table of its kind once, at the entry of its UID;
+//  - edges have two distinct nodes of the mesh in the order of their UIDs, and
+//    split edges have two children that share the new node;
+//  - the edges of every face form a closed loop by their direction bits, and
+//    faces have distinct nodes and non-zero area;
+//  - leaf faces do not have split edges ("hanging" nodes);
+//  - the references of nodes and edges are to objects of the mesh that have
+//    them, and edges are used by at most two leaf faces, in opposite
+//    directions;
+//  - nodes and edges are referenced by some object.
+//
+
+int sMesh_Core::check( struct incg_check_s* c ) const
+{
+   return checkSample( c, 1, 0 );
 }
 
 
-int sMesh_Tri::setChildren( int index, void* p, ChildSetToken& token )
+//
+// Public method to check a sample of the objects of the mesh: part "ioff" of
+// "nstride" equal and contiguous parts of the table of every kind (see
+// check()). Every object is checked in parallel from its own links and
+// references, so the cost is that of the sample; successive checks of parts
+// 0 ... nstride-1 cover all objects.
+//
+
+int sMesh_Core::checkSample( struct incg_check_s* c,
+                             long nstride, long ioff ) const
 {
-   if( index < 0 || 2 < index ) return 1;
+   std::vector< unsigned int > flags[4];
+   std::vector< long > ids[4];
+   long ns[4], ntab[4];
+   int ierr=0;
 
-   child[ index ] = p;
+   if( c == NULL || nstride < 1 || ioff < 0 || ioff >= nstride ) return 1;
+   memset( c, 0, sizeof(struct incg_check_s) );
+
+   ntab[0] = (long) node_table.size();
+   ntab[1] = (long) edge_table.size();
+   ntab[2] = (long) tri_table.size();
+   ntab[3] = (long) quad_table.size();
+   for(int k=0;k<4;++k) {
+      long i0 = ntab[k]*ioff/nstride;
+      ns[k] = ntab[k]*(ioff+1)/nstride - i0;
+      flags[k].assign( ns[k], 0 );
+      ids[k].resize( ns[k] );
+#pragma omp parallel for
+      for(long j=0;j<ns[k];++j) ids[k][j] = i0 + j;
+   }
 
-   if( index == 0 )      sattr |= 0x04;
-   else if( index == 1 ) sattr |= 0x02;
-   else if( index == 2 ) sattr |= 0x01;
+   // nodes
+#pragma omp parallel for schedule(dynamic,1024)
+   for(long j=0;j<ns[0];++j) {
+      const sMesh_Node* np = node_table[ ids[0][j] ];
+      if( np == NULL ) continue;
+      unsigned int f=0;
+
+      if( np->getUID() != ids[0][j] ) f |= INCG_CHECK_ID;
+      if( np->getNumRefs() == 0 ) f |= INCG_CHECK_FREE;
+      for(unsigned int n=0;n<np->getNumRefs();++n) {
+         smesh_ref_t r = np->getRef(n);
+         const sMesh_Edge* ep = (const sMesh_Edge*) smesh_ref_ptr( r );
+         if( smesh_ref_kind( r ) != INCG_SMESH_REF_EDGE ||
+             smesh_check_edge( edge_table, ep ) == 0 ||
+             ( ep->getNodePtr(1) != np && ep->getNodePtr(2) != np ) ) {
+            f |= INCG_CHECK_LINK;
+            break;
+         }
+      }
+      flags[0][j] = f;
+   }
 
-   return 0;
-}
+   // edges
+#pragma omp parallel for schedule(dynamic,1024)
+   for(long j=0;j<ns[1];++j) {
+      const sMesh_Edge* ep = edge_table[ ids[1][j] ];
+      if( ep == NULL ) continue;
+      unsigned int f=0;
+
+      if( ep->getUID() != ids[1][j] ) f |= INCG_CHECK_ID;
+      const sMesh_Node *np1 = ep->getNodePtr(1), *np2 = ep->getNodePtr(2);
+      if( smesh_check_node( node_table, np1 ) == 0 ||
+          smesh_check_node( node_table, np2 ) == 0 ) {
+         flags[1][j] = f | INCG_CHECK_LINK;
+         continue;
+      }
+      if( np1 == np2 ||
+          ( np1->x == np2->x && np1->y == np2->y && np1->z == np2->z ) ) {
+         f |= INCG_CHECK_DEGENERATE;
+      } else if( np1->getUID() > np2->getUID() ) {
+         f |= INCG_CHECK_ID;
+      }
 
+      if( ep->isSplit() ) {
+         const sMesh_Edge *cp1 = ep->getChildPtr(1), *cp2 = ep->getChildPtr(2);
+         if( smesh_check_edge( edge_table, cp1 ) == 0 ||
+             smesh_check_edge( edge_table, cp2 ) == 0 ) {
+            f |= INCG_CHECK_LINK;
+         } else if( cp1->getNodePtr(1) != np1 || cp2->getNodePtr(1) != np2 ||
+                    cp1->getNodePtr(2) != cp2->getNodePtr(2) ) {
+            f |= INCG_CHECK_LINK;
+         }
+      }
+      if( ep->getNumRefs() == 0 ) f |= INCG_CHECK_FREE;
+      f |= smesh_check_uses( ep, tri_table, quad_table );
+      flags[1][j] = f;
+   }
 
-void* sMesh_Tri::getChildPtr( int index ) const
-{
-   if( index < 0 || 2 < index ) return NULL;
-   return child[ index ];
+   // faces
+#pragma omp parallel for schedule(dynamic,1024)
+   for(long j=0;j<ns[2];++j) {
+      const sMesh_Tri* tp = tri_table[ ids[2][j] ];
+      if( tp == NULL ) continue;
+
+      sMesh_Edge* e[3];
+      for(int k=0;k<3;++k) e[k] = tp->getEdgePtr(k);
+      int leaf = (tp->getSubdivAttr() & 0x0F) == 0 ? 1 : 0;
+      flags[2][j] = smesh_check_face( e, 3, tp->getEdgeAttr(), leaf,
+                                      edge_table );
+      if( tp->getUID() != ids[2][j] ) flags[2][j] |= INCG_CHECK_ID;
+   }
+#pragma omp parallel for schedule(dynamic,1024)
+   for(long j=0;j<ns[3];++j) {
+      const sMesh_Quad* qp = quad_table[ ids[3][j] ];
+      if( qp == NULL ) continue;
+
+      sMesh_Edge* e[4];
+      int leaf=1;
+      for(int k=0;k<4;++k) {
+         e[k] = qp->getEdgePtr(k);
+         if( qp->getChildPtr(k) != NULL ) leaf = 0;
+      }
+      flags[3][j] = smesh_check_face( e, 4, qp->getEdgeAttr(), leaf,
+                                      edge_table );
+      if( qp->getUID() != ids[3][j] ) flags[3][j] |= INCG_CHECK_ID;
+   }
+
+   for(int k=0;k<4 && ierr==0;++k) {
+      ierr = incg_Check_Collect( c, k, ns[k], flags[k].data(),
+                                 ids[k].data() );
+   }
+   if( ierr ) {
+      FPRINTF( stdout, " [Error]  Could not gather the violations \n" );
+      incg_Check_Free( c );
+   }
+
+   return ierr;
 }
 
 
-int sMesh_Tri::setSubdivision( unsigned char n, ChildSetToken& token )
+//
+// Public method to take a compressed (CSR) copy of the references of the
+// nodes and the edges of the mesh (see struct incg_smesh_refs_s), for phases
+// that read them many times; the copy is freed by incg_Smesh_FreeRefs()
+//
+
+int sMesh_Core::snapshotRefs( struct incg_smesh_refs_s* r ) const
 {
-   unsigned char tmp = (sattr & 0xF0) >> 4;
-   if( tmp ) return 1;
-   if( n > 4 ) return 2;
+   if( r == NULL ) return 1;
+   memset( r, 0, sizeof(struct incg_smesh_refs_s) );
+
+   long nn = (long) node_table.size(), ne = (long) edge_table.size();
+   r->nofs = (long*) malloc( ((size_t) (nn+1)) * sizeof(long) );
+   r->eofs = (long*) malloc( ((size_t) (ne+1)) * sizeof(long) );
+   if( r->nofs == NULL || r->eofs == NULL ) {
+      incg_Smesh_FreeRefs( r );
+      return -1;
+   }
+   r->nn = nn;
+   r->ne = ne;
+
+#pragma omp parallel for
+   for(long i=0;i<nn;++i) {
+      r->nofs[i] = node_table[i] == NULL ? 0 : node_table[i]->getNumRefs();
+   }
+#pragma omp parallel for
+   for(long i=0;i<ne;++i) {
+      r->eofs[i] = edge_table[i] == NULL ? 0 : edge_table[i]->getNumRefs();
+   }
+   r->nofs[nn] = 0;
+   r->eofs[ne] = 0;
+   long nr = incg_Sort_ScanExclusive( nn+1, r->nofs );
+   long er = incg_Sort_ScanExclusive( ne+1, r->eofs );
+
+   r->nref = (smesh_ref_t*) malloc( ((size_t) (nr+1)) * sizeof(smesh_ref_t) );
+   r->eref = (smesh_ref_t*) malloc( ((size_t) (er+1)) * sizeof(smesh_ref_t) );
+   if( r->nref == NULL || r->eref == NULL ) {
+      incg_Smesh_FreeRefs( r );
+      return -1;
+   }
+
+#pragma omp parallel for
+   for(long i=0;i<nn;++i) {
+      for(long j=r->nofs[i];j<r->nofs[i+1];++j) {
+         r->nref[j] = node_table[i]->getRef( (unsigned int) (j - r->nofs[i]) );
+      }
+   }
+#pragma omp parallel for
+   for(long i=0;i<ne;++i) {
+      for(long j=r->eofs[i];j<r->eofs[i+1];++j) {
+         r->eref[j] = edge_table[i]->getRef( (unsigned int) (j - r->eofs[i]) );
+      }
+   }
 
-   sattr |= (n << 4);
    return 0;
 }
 
 
 //
-// Methods for the mesh object
+// Function to free the arrays of a copy of the references of a mesh
 //
 
-sMesh_Core::sMesh_Core()
+int incg_Smesh_FreeRefs( struct incg_smesh_refs_s* r )
 {
+   if( r == NULL ) return 1;
+
+   if( r->nofs != NULL ) free( r->nofs );
+   if( r->eofs != NULL ) free( r->eofs );
+   if( r->nref != NULL ) free( r->nref );
+   if( r->eref != NULL ) free( r->eref );
+   memset( r, 0, sizeof(struct incg_smesh_refs_s) );
 
+   return 0;
 }
 
-sMesh_Core::~sMesh_Core()
+//
+// Public method to partition the leaf elements of the mesh into "npart" parts
+// by one of the methods of incg_Part_Faces() (INCG_PART_*), and to build the
+// local view of every part with "nlayer" layers of ghost elements. The array
+// of maps has "npart" entries. Elements and vertices are identified by their
+// indices in the arrays of exportData(), not by UIDs.
+//
+
+int sMesh_Core::partition( int npart, int method, int nlayer,
+                           struct incg_part_s* p,
+                           struct incg_partmap_s* maps ) const
 {
-   for(ptrmap_it pit = tri_ptr_map.begin(); pit != tri_ptr_map.end(); ++pit) {
-      delete ((sMesh_Tri*) pit->first);
-   }
-   for(ptrmap_it pit = quad_ptr_map.begin(); pit != quad_ptr_map.end(); ++pit) {
-      delete ((sMesh_Quad*) pit->first);
+   std::vector< node_t > nodes;
+   std::vector< face_t > faces;
+
+   exportData( nodes, faces );
+   if( nodes.size() == 0 || faces.size() == 0 ) {
+      FPRINTF( stdout, " [Error]  There is nothing to partition \n" );
+      return 1;
    }
-   for(ptrmap_it pit = edge_ptr_map.begin(); pit != edge_ptr_map.end(); ++pit) {
-      delete ((sMesh_Edge*) pit->first);
+
+   int ierr = incg_Part_Faces( (long) nodes.size(),
+                               (const double*) nodes.data(),
+                               (long) faces.size(),
+                               (const long*) faces.data(),
+                               npart, method, p );
+   if( ierr ) {
+      FPRINTF( stdout, " [Error]  Could not partition the mesh \n" );
+      return 2;
    }
-   for(ptrmap_it pit = node_ptr_map.begin(); pit != node_ptr_map.end(); ++pit) {
-      delete ((sMesh_Node*) pit->first);
+
+   ierr = incg_Part_HaloFaces( (long) nodes.size(),
+                               (long) faces.size(),
+                               (const long*) faces.data(),
+                               p, nlayer, maps );
+   if( ierr ) {
+      FPRINTF( stdout, " [Error]  Could not build the ghost layers \n" );
+      incg_Part_Free( p );
+      return 3;
    }
+
+   return 0;
 }
 
 
 //
-// Public method to receive arrays of node and element data (that is provided
-// in a conventional sparse format) and generate the internals of a mesh
-// object.
-// NOTE: Quadrilaterals need to have a proper winding order. The order can be
-// clockwise or counter-clockwise, but there has to be a winding order.
+// Public method to smooth the nodes of the leaf elements of the mesh by one of
+// the methods of incg_Smooth_Faces() (INCG_SMOOTH_*). The nodes of leaf edges
+// on the boundary, and nodes where the leaf elements do not form a manifold,
+// are held fixed. The lengths of all edges are computed anew.
 //
 
-int sMesh_Core::loadData( int nno, const node_t nodes[],
-                          int nel, const face_t faces[] )
+int sMesh_Core::smooth( const struct incg_smooth_s* opt )
 {
-   if( nno <= 0 || nel <= 0 ) {
-      FPRINTF( stdout, " [Error]  Sizes (%d,%d) cannot be zero\n", nno, nel );
+   std::vector< node_t > nodes;
+   std::vector< face_t > faces;
+
+   exportData( nodes, faces );
+   if( nodes.size() == 0 || faces.size() == 0 ) {
+      FPRINTF( stdout, " [Error]  There is nothing to smooth \n" );
       return 1;
    }
 
-   if( nodes == NULL || faces == NULL ) {
-      FPRINTF( stdout, " [Error]  Pointers (%p,%p) cannot be null\n", nodes, faces );
-      return 2;
+   // nodes are exported in the order of their UIDs
+   std::vector< long > node_index( node_table.size(), -1 );
+   long n = 0;
+   for(size_t k=0;k<node_table.size();++k) {
+      if( node_table[k] != NULL ) node_index[k] = n++;
    }
+   std::vector< char > fixed( nodes.size(), 0 );
+   for(size_t k=0;k<edge_table.size();++k) {
+      sMesh_Edge* ep = edge_table[k];
+      if( ep == NULL || ep->isSplit() || !ep->isBoundary() ) continue;
 
-   // count triangles and quadrilaterals
-   int ntri=0, nquad=0;
-   for(int n=0;n<nel;++n) {
-      if( faces[n].nodes[3] < 0 ) ++ntri;
-      else ++nquad;
+      for(int j=1;j<=2;++j) {
+         fixed[ node_index[ ep->getNodePtr(j)->getUID() ] ] = 1;
+      }
    }
 
+   int ierr = incg_Smooth_Faces( (long) nodes.size(), (double*) nodes.data(),
+                                 (long) faces.size(),
+                                 (const long*) faces.data(),
+                                 fixed.data(), opt );
+   if( ierr ) {
+      FPRINTF( stdout, " [Error]  Could not smooth the mesh \n" );
+      return 2;
+   }
 
-   // continuation needs to trap individual object allocations
-   int ierr=0;
-
-   node_uid_map.clear();
-   node_ptr_map.clear();
-   for(int n=0;n<nno;++n) {
-      sMesh_Node* np = new sMesh_Node();
-      if( np == NULL ) { ierr=-111; break; }
-
+   for(size_t k=0;k<node_table.size();++k) {
+      sMesh_Node* np = node_table[k];
+      if( np == NULL ) continue;
+      n = node_index[k];
       np->x = nodes[n].x;
       np->y = nodes[n].y;
       np->z = nodes[n].z;
-      node_uid_map[ np->getUID() ] = np;
-      node_ptr_map[ np ] = np->getUID();
+   }
+   for(size_t k=0;k<edge_table.size();++k) {
+      if( edge_table[k] != NULL ) edge_table[k]->computeLength();
    }
 
-   // allocate the edges (derived from the faces)
-   edge_uid_map.clear();
-   edge_ptr_map.clear();
-
-   nquad=0; ntri=0;
-   for(int n=0;n<nel && ierr==0;++n) {
-      char ic=4;
-      if( faces[n].nodes[3] < 0 ) ic=3;
-
-      long node_pairs[4][2] = {{-2,-2},{-2,-2},{-2,-2},{-2,-2}};
-      for(int k=0;k<4;++k) {
-         node_pairs[k][0] = faces[n].nodes[k];
-         node_pairs[k][1] = faces[n].nodes[0];
-         if( ic == 4 ) {
-            if( k < 3 ) node_pairs[k][1] = faces[n].nodes[k+1];
-         } else {
-            if( k < 2 ) node_pairs[k][1] = faces[n].nodes[k+1];
-         }
-      }
+   return 0;
+}
 
-      // allocate edges individually
-      sMesh_Edge* edges_ptr[4] = {NULL, NULL, NULL, NULL};
-      unsigned char edges_dir[4] = {9,9,9,9};
-      for(int k=0;k<ic && ierr==0;++k) {
-         edgeid_t eid;
-         int idir = set_edge_uid( eid, (unsigned long) node_pairs[k][0],
-                                       (unsigned long) node_pairs[k][1] );
-         edges_dir[k] = (unsigned char) idir;
-         edgeid_map_it eit;
-         if( (eit = edgeid_map.find( eid )) == edgeid_map.end() ) {
-            long nid1 = node_pairs[k][0];
-            long nid2 = node_pairs[k][1];
-            if( nid1 > nid2 ) {
-               nid2 = node_pairs[k][0];
-               nid1 = node_pairs[k][1];
-            }
-            sMesh_Node* np1 = (sMesh_Node*) node_uid_map[ nid1 ];
-            sMesh_Node* np2 = (sMesh_Node*) node_uid_map[ nid2 ];
-            sMesh_Edge* ep = new sMesh_Edge( np1, np2 );
-            if( ep == NULL ) { ierr=-121; break; }
 
-            ep->computeLength();
-            edge_uid_map[ ep->getUID() ] = ep;
-            edge_ptr_map[ ep ] = ep->getUID();
-            edgeid_map[ eid ] = ep;
-            edges_ptr[k] = ep;
-         } else {
-            edges_ptr[k] = (sMesh_Edge*) eit->second;
-         }
+//
+// Public method to compute the quality metrics of the leaf elements of the
+// mesh and their statistics (see incg_Qual_Faces()). The metrics of every
+// element are stored in "emet" when it is not null, in the order of the
+// elements of exportData().
+//
 
-         // set side bits
-         if( idir == 1 ) edges_ptr[k]->flags |= 0x01;
-         else            edges_ptr[k]->flags |= 0x02;
-      }
+int sMesh_Core::quality( double* emet, struct incg_qual_s* q ) const
+{
+   std::vector< node_t > nodes;
+   std::vector< face_t > faces;
 
-      // create the face object
-      unsigned dirs_=0x00;
-      for(int k=0;k<ic;++k) if( edges_dir[k] == 2 ) dirs_ |= 0x01 << (3 - k);
-      if( ic==4 ) {
-         sMesh_Quad* qp = new sMesh_Quad( edges_ptr[0], edges_ptr[1],
-                                          edges_ptr[2], edges_ptr[3],
-                                          dirs_ << 4 );
-         if( qp == NULL ) { ierr=-131; break; }
-         quad_uid_map[ qp->getUID() ] = qp;
-         quad_ptr_map[ qp ] = qp->getUID();
-      } else {
-         sMesh_Tri* tp = new sMesh_Tri( edges_ptr[0], edges_ptr[1],
-                                        edges_ptr[2], dirs_ << 4 );
-         if( tp == NULL ) { ierr=-131; break; }
-         tri_uid_map[ tp->getUID() ] = tp;
-         tri_ptr_map[ tp ] = tp->getUID();
-      }
+   exportData( nodes, faces );
+   if( nodes.size() == 0 || faces.size() == 0 ) {
+      FPRINTF( stdout, " [Error]  There is nothing to measure \n" );
+      return 1;
    }
+
+   int ierr = incg_Qual_Faces( (long) nodes.size(),
+                               (const double*) nodes.data(),
+                               (long) faces.size(),
+                               (const long*) faces.data(), emet, q );
    if( ierr ) {
-      FPRINTF( stdout, " [Error]  Something went really wrong... \n" );
-      return ierr;
+      FPRINTF( stdout, " [Error]  Could not measure the mesh \n" );
+      return 2;
    }
 
    return 0;
@@ -589,119 +3170,131 @@ int sMesh_Core::loadData( int nno, const node_t nodes[],
 
 
 //
-// Public method to receive arrays of node and element data (that is provided
-// in a conventional sparse format) and generate the internals of a mesh
-// object.
+// Public method to compute the normals, areas and curvatures of the nodes of
+// the leaf elements of the mesh (see incg_Curv_Faces()), in the order of the
+// nodes of exportData(); quads are taken as two triangles.
 //
 
-int sMesh_Core::quadify()
+int sMesh_Core::curvature( int iweight,
+                           double* vn, double* va, double* vk ) const
 {
-   struct trih_s { unsigned char attr; double s; };
-   std::map< sMesh_Tri*, struct trih_s > tri_map_rules;
-   for(ptrmap_it it=tri_ptr_map.begin(); it!=tri_ptr_map.end();++it) {
-      sMesh_Tri* tp = (sMesh_Tri*) it->first;
-      unsigned char attr;
-      double tmp=0.0;
-      tp->computeHeuristics( attr, tmp );
-      // when any of the angles is obtuse
-      if( attr & 0x07 ) {
-         tri_map_rules[ tp ] = { attr, tmp };
-      }
-   }
-
-   int ierr=0;
-   std::map< sMesh_Tri*, struct trih_s > :: const_iterator it;
-   for( it=tri_map_rules.begin(); it!=tri_map_rules.end(); ++it) {
+   std::vector< node_t > nodes;
+   std::vector< face_t > faces;
 
-      // find out which edge needs to be subdivided
-      unsigned char attr = it->second.attr;
-      int index=-2;
-      if( attr & 0x04 ) index=0;
-      if( attr & 0x02 ) { if( index==-2 ) { index=1; } else { index=-1; } }
-      if( attr & 0x01 ) { if( index==-2 ) { index=2; } else { index=-1; } }
-      // Should return an index {0,1,2}
-      // "-1" is an error of duplicate obtuse angle!
-      if( index < 0 ) {
-         FPRINTF( stdout, " [Error]  Invalid Rule 3 index %d \n", ierr );
-         ierr=999;
-         break;
-      } else {
-         ierr=subdivideByRule3( it->first, index );
-      }
-   }
-   if( ierr ) {
-      FPRINTF( stdout, " [Error]  Something went really wrong... \n" );
+   exportData( nodes, faces );
+   if( nodes.size() == 0 || faces.size() == 0 ) {
+      FPRINTF( stdout, " [Error]  There is nothing to measure \n" );
       return 1;
    }
-   tri_map_rules.clear();
 
-   for(ptrmap_it it=tri_ptr_map.begin(); it!=tri_ptr_map.end();++it) {
-      sMesh_Tri* tp = (sMesh_Tri*) it->first;
-      unsigned char sattr = tp->getSubdivAttr();
-      if( (sattr & 0x0F) == 0  ) {
-         tri_map_rules[ tp ] = { sattr, 0.0 };
-      }
-   }
-
-   for( it=tri_map_rules.begin(); it!=tri_map_rules.end(); ++it) {
-      ierr=subdivideByRule1( it->first );
-      if( ierr ) break;
-   }
+   int ierr = incg_Curv_Faces( (long) nodes.size(),
+                               (const double*) nodes.data(),
+                               (long) faces.size(),
+                               (const long*) faces.data(), iweight,
+                               vn, va, vk );
    if( ierr ) {
-      FPRINTF( stdout, " [Error]  Something went really wrong... \n" );
-      return 1;
+      FPRINTF( stdout, " [Error]  Could not measure the mesh \n" );
+      return 2;
    }
-   tri_map_rules.clear();
 
-   char ic=1;     // iteration
-   while( ic && ierr==0 ) {
+   return 0;
+}
 
-      std::map< sMesh_Quad*, unsigned char > quad_map_rules;
-      for(ptrmap_it it=quad_ptr_map.begin(); it!=quad_ptr_map.end();++it) {
-         sMesh_Quad* qp = (sMesh_Quad*) it->first;
-         unsigned char uc = (unsigned char) qp->needsSubdivision();
-         if( uc ) quad_map_rules[ qp ] = uc;
-      }
-      if( quad_map_rules.size() == 0 ) ic=0;    // iteration termination
-
-      for(std::map< sMesh_Quad*, unsigned char > :: const_iterator
-         it=quad_map_rules.begin(); it!=quad_map_rules.end();++it) {
-         sMesh_Quad* qp = (sMesh_Quad*) it->first;
-         if( it->second == 1 ) {
-            ierr=subdivideByRule2u( qp );
-         } else if( it->second == 2 ) {
-            ierr=subdivideByRule2v( qp );
-         } else if( it->second == 3 ) {
-            // We will force a "u-subdivision" and allow the iteration to pick
-            // up the subdivisions of the child quads in the next epoch.
-            ierr=subdivideByRule2u( qp );
-         } else {
-            ierr=999;
-         }
-         if( ierr ) {
-            ic=0;
-            break;
-         }
-      }
 
-#ifdef _DEBUG_
-      dumpEdges( "edges.dat", 1 );
-#endif
+//
+// Public method to find the pairs of leaf elements of the mesh that intersect
+// (see incg_Isect_Faces()), as indices of the elements of exportData()
+//
+
+int sMesh_Core::intersect( struct incg_isect_s* is ) const
+{
+   std::vector< node_t > nodes;
+   std::vector< face_t > faces;
+
+   exportData( nodes, faces );
+   if( nodes.size() == 0 || faces.size() == 0 ) {
+      FPRINTF( stdout, " [Error]  There is nothing to test \n" );
+      return 1;
    }
+
+   int ierr = incg_Isect_Faces( (long) nodes.size(),
+                                (const double*) nodes.data(),
+                                (long) faces.size(),
+                                (const long*) faces.data(), is );
    if( ierr ) {
-      FPRINTF( stdout, " [Error]  Something went really wrong... \n" );
-      return 1;
+      FPRINTF( stdout, " [Error]  Could not test the mesh \n" );
+      return 2;
    }
 
    return 0;
 }
 
 
+//
+// Functions to make the objects of a subdivision: in the mesh, or by a worker
+// when one is given (see quadifyParallel()). The subdivision functions then
+// set the key of the worker from "key" by the step that makes the objects, so
+// that keys order the objects as a subdivision in series makes them.
+//
+
+sMesh_Node* sMesh_Core::makeNode( sMesh_Worker* w )
+{
+   if( w != NULL ) return w->newNode();
+
+   sMesh_Node* np = smesh_new_node( factory, &node_slab );
+   if( np != NULL ) smesh_put_node( node_table, np );
+   return np;
+}
+
+sMesh_Edge* sMesh_Core::makeEdge( sMesh_Worker* w,
+                                  sMesh_Node* np1, sMesh_Node* np2 )
+{
+   if( w != NULL ) return w->newEdge( np1, np2 );
+
+   sMesh_Edge* ep = smesh_new_edge( factory, &edge_slab, np1, np2 );
+   if( ep != NULL ) smesh_put_edge( edge_table, ep );
+   return ep;
+}
+
+sMesh_Quad* sMesh_Core::makeQuad( sMesh_Worker* w,
+                                  sMesh_Edge* ep1, sMesh_Edge* ep2,
+                                  sMesh_Edge* ep3, sMesh_Edge* ep4,
+                                  unsigned char dirs )
+{
+   if( w != NULL ) return w->newQuad( ep1, ep2, ep3, ep4, dirs );
+
+   sMesh_Quad* qp = smesh_new_quad( factory, &quad_slab,
+                                    ep1, ep2, ep3, ep4, dirs );
+   if( qp != NULL ) smesh_put_quad( quad_table, qp );
+   return qp;
+}
+
+sMesh_Tri* sMesh_Core::makeTri( sMesh_Worker* w,
+                                sMesh_Edge* ep1, sMesh_Edge* ep2,
+                                sMesh_Edge* ep3, unsigned char dirs )
+{
+   if( w != NULL ) return w->newTri( ep1, ep2, ep3, dirs );
+
+   sMesh_Tri* tp = smesh_new_tri( factory, &tri_slab, ep1, ep2, ep3, dirs );
+   if( tp != NULL ) smesh_put_tri( tri_table, tp );
+   return tp;
+}
+
+int sMesh_Core::splitEdge( sMesh_Worker* w, sMesh_Edge* ep )
+{
+   if( w != NULL ) return ep->split( w );
+
+   return ep->split( factory, &node_table, &edge_table,
+                     &node_slab, &edge_slab );
+}
+
+
 //
 // Function that performs subdivision by "rule 3" given an angle index
 //
 
-int sMesh_Core::subdivideByRule3( sMesh_Tri* p, int index )
+int sMesh_Core::subdivideByRule3( sMesh_Tri* p, int index,
+                                   sMesh_Worker* w, unsigned long key )
 {
    if( p == NULL ) {
       FPRINTF( stdout, " [Error]  Triangle pointer is null \n" );
@@ -788,8 +3381,7 @@ int sMesh_Core::subdivideByRule3( sMesh_Tri* p, int index )
    sMesh_Edge *sep1=NULL,*sep2=NULL;    // new edges splitting the original one
    if( sep->isSplit() ) {
    } else {
-      int iret = sep->split( &node_uid_map, &node_ptr_map,
-                             &edge_uid_map, &edge_ptr_map );
+      int iret = splitEdge( w, sep );
       if( iret ) {
          FPRINTF( stdout, " [Error]  Fatal in splitting edge attempt \n" );
          return 4;
@@ -821,13 +3413,12 @@ int sMesh_Core::subdivideByRule3( sMesh_Tri* p, int index )
    }
 
    // create bisecting edge
-   sMesh_Edge* bep = new sMesh_Edge( np, mnp ); // new bisecting edge
-   if( mnp == NULL ) {
+   if( w != NULL ) w->setKey( key + 1 );
+   sMesh_Edge* bep = makeEdge( w, np, mnp );
+   if( bep == NULL ) {
       FPRINTF( stdout, " [Error]  Could not create edge object \n" );
       return -4;
    }
-   edge_uid_map[ bep->getUID() ] = bep;
-   edge_ptr_map[ bep ] = bep->getUID();
    // setting edge attribute of this edge for the triangles
    if( bep->getNodePtr(2) == np ) {
       dirs[1] |= bit7;
@@ -838,22 +3429,16 @@ int sMesh_Core::subdivideByRule3( sMesh_Tri* p, int index )
    // create two triangles
    sMesh_Tri *tp1=NULL, *tp2=NULL;
    if( sdir ) {
-      tp1 = new sMesh_Tri( oep1, sep2, bep,  dirs[0] );
-      tp2 = new sMesh_Tri( bep,  sep1, oep2, dirs[1] );
+      tp1 = makeTri( w, oep1, sep2, bep,  dirs[0] );
+      tp2 = makeTri( w, bep,  sep1, oep2, dirs[1] );
    } else {
-      tp1 = new sMesh_Tri( oep1, sep1, bep,  dirs[0] );
-      tp2 = new sMesh_Tri( bep,  sep2, oep2, dirs[1] );
+      tp1 = makeTri( w, oep1, sep1, bep,  dirs[0] );
+      tp2 = makeTri( w, bep,  sep2, oep2, dirs[1] );
    }
    if( tp1 == NULL || tp2 == NULL ) {
       FPRINTF( stdout, " [Error]  Could not create triangle object \n" );
-      if( tp1 != NULL ) delete tp1;
-      if( tp2 != NULL ) delete tp2;
       return -5;
    }
-   tri_uid_map[ tp1->getUID() ] = tp1;
-   tri_ptr_map[ tp1 ] = tp1->getUID();
-   tri_uid_map[ tp2->getUID() ] = tp2;
-   tri_ptr_map[ tp2 ] = tp2->getUID();
 
    // Area elements pointer assignments
    unsigned char sa = 1;
@@ -872,7 +3457,8 @@ int sMesh_Core::subdivideByRule3( sMesh_Tri* p, int index )
 // Function that performs subdivision by "rule 1"
 //
 
-int sMesh_Core::subdivideByRule1( sMesh_Tri* p )
+int sMesh_Core::subdivideByRule1( sMesh_Tri* p,
+                                   sMesh_Worker* w, unsigned long key )
 {
    if( p == NULL ) {
       FPRINTF( stdout, " [Error]  Triangle pointer is null \n" );
@@ -884,13 +3470,12 @@ int sMesh_Core::subdivideByRule1( sMesh_Tri* p )
    const unsigned char bit5 = 0x01 << 5;          // picks flags for face 2
    const unsigned char bit4 = 0x01 << 4;          // picks flags for face 3
 
-   sMesh_Node* cnp = new sMesh_Node();      // "centroid" node
+   if( w != NULL ) w->setKey( key );
+   sMesh_Node* cnp = makeNode( w );            // "centroid" node
    if( cnp == NULL ) {
       FPRINTF( stdout, " [Error]  Could not create node object \n" );
       return -1;
    }
-   node_uid_map[ cnp->getUID() ] = cnp;
-   node_ptr_map[ cnp ] = cnp->getUID();
    cnp->x = 0.0; cnp->y = 0.0; cnp->z = 0.0;
    cnp->flags |= bit7;
 
@@ -919,8 +3504,7 @@ int sMesh_Core::subdivideByRule1( sMesh_Tri* p )
 
       if( sep->isSplit() ) {
       } else {
-         int iret = sep->split( &node_uid_map, &node_ptr_map,
-                                &edge_uid_map, &edge_ptr_map );
+         int iret = splitEdge( w, sep );
          if( iret ) {
             FPRINTF( stdout, " [Error]  Fatal in splitting edge attempt \n" );
             return 2;
@@ -954,13 +3538,12 @@ int sMesh_Core::subdivideByRule1( sMesh_Tri* p )
       }
 
       // create mid-point connecting edge
-      sMesh_Edge* tmp = new sMesh_Edge( cnp, mnp );
+      if( w != NULL ) w->setKey( key + 2 + 2*k );
+      sMesh_Edge* tmp = makeEdge( w, cnp, mnp );
       if( tmp == NULL ) {
          FPRINTF( stdout, " [Error]  Could not create edge object \n" );
          return -2;
       }
-      edge_uid_map[ tmp->getUID() ] = tmp;
-      edge_ptr_map[ tmp ] = tmp->getUID();
 
       // store pointers to new edge
       qep[eqA][1] = tmp;
@@ -974,14 +3557,17 @@ int sMesh_Core::subdivideByRule1( sMesh_Tri* p )
 
    // create three quadrilaterals
    for(int k=0;k<3;++k) {
-      sMesh_Quad* tmp = new sMesh_Quad( qep[k][0], qep[k][1],
-                                        qep[k][2], qep[k][3], dirs[k] );
+      sMesh_Quad* tmp = makeQuad( w, qep[k][0], qep[k][1],
+                                     qep[k][2], qep[k][3], dirs[k] );
       if( tmp == NULL ) {
          FPRINTF( stdout, " [Error]  Could not create area object \n" );
          return -3;
       }
-      quad_uid_map[ tmp->getUID() ] = tmp;
-      quad_ptr_map[ tmp ] = tmp->getUID();
+
+      // set pointer to child
+      ChildSetToken token;
+      if( k==0 ) p->setSubdivision( 4, token );
+      p->setChildren( k, tmp, token );
    }
 
    return 0;
@@ -992,7 +3578,8 @@ int sMesh_Core::subdivideByRule1( sMesh_Tri* p )
 // Function that performs subdivision by "rule 2" in the "u" direction
 //
 
-int sMesh_Core::subdivideByRule2u( sMesh_Quad* p )
+int sMesh_Core::subdivideByRule2u( sMesh_Quad* p,
+                                    sMesh_Worker* w, unsigned long key )
 {
    if( p == NULL ) {
       FPRINTF( stdout, " [Error]  Quadrilateral pointer is null \n" );
@@ -1022,8 +3609,7 @@ int sMesh_Core::subdivideByRule2u( sMesh_Quad* p )
    sMesh_Edge *etmp = p->getEdgePtr(0);        // get edge 0 of the quad
    if( etmp->isSplit() ) {                     // edge 0 is split
    } else {
-      int iret = etmp->split( &node_uid_map, &node_ptr_map,
-                              &edge_uid_map, &edge_ptr_map );
+      int iret = splitEdge( w, etmp );
       if( iret ) {
          FPRINTF( stdout, " [Error]  Fatal in splitting edge attempt \n" );
          return 2;
@@ -1069,8 +3655,7 @@ int sMesh_Core::subdivideByRule2u( sMesh_Quad* p )
    etmp = p->getEdgePtr(2);                    // get edge 2 of the quad
    if( etmp->isSplit() ) {                     // edge 2 is split
    } else {
-      int iret = etmp->split( &node_uid_map, &node_ptr_map,
-                              &edge_uid_map, &edge_ptr_map );
+      int iret = splitEdge( w, etmp );
       if( iret ) {
          FPRINTF( stdout, " [Error]  Fatal in splitting edge attempt \n" );
          return 2;
@@ -1120,13 +3705,12 @@ int sMesh_Core::subdivideByRule2u( sMesh_Quad* p )
    }
 
    // create element-splitting edge
-   sMesh_Edge* sep = new sMesh_Edge( mnpA, mnpB );
+   if( w != NULL ) w->setKey( key + 2 );
+   sMesh_Edge* sep = makeEdge( w, mnpA, mnpB );
    if( sep == NULL ) {
       FPRINTF( stdout, " [Error]  Could not create edge object \n" );
       return -1;
    }
-   edge_uid_map[ sep->getUID() ] = sep;
-   edge_ptr_map[ sep ] = sep->getUID();
    // assign pointers
    qep[0][1] = sep;
    qep[1][3] = sep;
@@ -1140,14 +3724,12 @@ int sMesh_Core::subdivideByRule2u( sMesh_Quad* p )
 
    // create two quadrilaterals
    for(int k=0;k<2;++k) {
-      sMesh_Quad* tmp = new sMesh_Quad( qep[k][0], qep[k][1],
-                                        qep[k][2], qep[k][3], dirs[k] );
+      sMesh_Quad* tmp = makeQuad( w, qep[k][0], qep[k][1],
+                                     qep[k][2], qep[k][3], dirs[k] );
       if( tmp == NULL ) {
          FPRINTF( stdout, " [Error]  Could not create area object \n" );
          return -2;
       }
-      quad_uid_map[ tmp->getUID() ] = tmp;
-      quad_ptr_map[ tmp ] = tmp->getUID();
 
       // set pointer to child
       ChildSetToken token;
@@ -1163,7 +3745,8 @@ int sMesh_Core::subdivideByRule2u( sMesh_Quad* p )
 // Function that performs subdivision by "rule 2" in the "v" direction
 //
 
-int sMesh_Core::subdivideByRule2v( sMesh_Quad* p )
+int sMesh_Core::subdivideByRule2v( sMesh_Quad* p,
+                                    sMesh_Worker* w, unsigned long key )
 {
    if( p == NULL ) {
       FPRINTF( stdout, " [Error]  Quadrilateral pointer is null \n" );
@@ -1193,8 +3776,7 @@ int sMesh_Core::subdivideByRule2v( sMesh_Quad* p )
    sMesh_Edge *etmp = p->getEdgePtr(3);        // get edge 3 of the quad
    if( etmp->isSplit() ) {                     // edge 3 is split
    } else {
-      int iret = etmp->split( &node_uid_map, &node_ptr_map,
-                              &edge_uid_map, &edge_ptr_map );
+      int iret = splitEdge( w, etmp );
       if( iret ) {
          FPRINTF( stdout, " [Error]  Fatal in splitting edge attempt \n" );
          return 2;
@@ -1240,8 +3822,7 @@ int sMesh_Core::subdivideByRule2v( sMesh_Quad* p )
    etmp = p->getEdgePtr(1);                    // get edge 1 of the quad
    if( etmp->isSplit() ) {                     // edge 1 is split
    } else {
-      int iret = etmp->split( &node_uid_map, &node_ptr_map,
-                              &edge_uid_map, &edge_ptr_map );
+      int iret = splitEdge( w, etmp );
       if( iret ) {
          FPRINTF( stdout, " [Error]  Fatal in splitting edge attempt \n" );
          return 3;
@@ -1287,13 +3868,12 @@ int sMesh_Core::subdivideByRule2v( sMesh_Quad* p )
    }
 
    // create element-splitting edge
-   sMesh_Edge* sep = new sMesh_Edge( mnpA, mnpB );
+   if( w != NULL ) w->setKey( key + 2 );
+   sMesh_Edge* sep = makeEdge( w, mnpA, mnpB );
    if( sep == NULL ) {
       FPRINTF( stdout, " [Error]  Could not create edge object \n" );
       return -1;
    }
-   edge_uid_map[ sep->getUID() ] = sep;
-   edge_ptr_map[ sep ] = sep->getUID();
    // assign pointers
    qep[0][2] = sep;
    qep[1][0] = sep;
@@ -1307,14 +3887,12 @@ int sMesh_Core::subdivideByRule2v( sMesh_Quad* p )
 
    // create two quadrilaterals
    for(int k=0;k<2;++k) {
-      sMesh_Quad* tmp = new sMesh_Quad( qep[k][0], qep[k][1],
-                                        qep[k][2], qep[k][3], dirs[k] );
+      sMesh_Quad* tmp = makeQuad( w, qep[k][0], qep[k][1],
+                                     qep[k][2], qep[k][3], dirs[k] );
       if( tmp == NULL ) {
          FPRINTF( stdout, " [Error]  Could not create area object \n" );
          return -2;
       }
-      quad_uid_map[ tmp->getUID() ] = tmp;
-      quad_ptr_map[ tmp ] = tmp->getUID();
 
       // set pointer to child
       ChildSetToken token;
@@ -1335,9 +3913,9 @@ int sMesh_Core::dumpEdges( const char filename[], int iop ) const
    fprintf( stdout, " [sMesh_Core:%s]  Dumping edges for Gnuplot-ing\n",FUNC );
    FILE *fp = fopen( filename, "w" );
    fprintf( fp, "# Edges after Rule 3 subdivision\n" );
-   uidmap_it eit;
-   for( eit = edge_uid_map.begin(); eit != edge_uid_map.end(); ++eit ) {
-      sMesh_Edge* ep = (sMesh_Edge*) eit->second;
+   for(size_t n=0;n<edge_table.size();++n) {
+      sMesh_Edge* ep = edge_table[n];
+      if( ep == NULL ) continue;
       int ic=1;   // default is to print
       if( ep->isSplit() == 1 && iop == 1 ) ic=0;   // skip split edges
 
@@ -15,6 +15,7 @@ extern "C" {
 
 
 #include "debug.h"
+#include "incg_mesh.h"
 
 
 //
@@ -50,10 +51,10 @@ struct edgebytes_s {
 
    // equality testing (unary?) operator
    bool operator==( const struct edgebytes_s & other ) const {
-      int n=UIDSIZE-1;
+      int n=0;
       while( n < UIDSIZE ) {   // sweep is little endian, but it does not matter
          if( digits[n] != other.digits[n] ) return false;
-         --n;
+         ++n;
       }
       return true;
    }
@@ -76,58 +77,210 @@ union edgeid_u {
    struct edgeid_s ids;
    struct edgebytes_s bytes;
 
-   // equality testing (unary?) operator
+   // equality testing (unary?) operator, word-wise
    bool operator==( const edgeid_u & other ) const {
-      int n=0;
-      while( n < UIDSIZE ) {   // sweep is little endian, but it does not matter
-         if( bytes.digits[n] != other.bytes.digits[n] ) return false;
-         --n;
-      }
-      return true;
+      return ids.i == other.ids.i && ids.j == other.ids.j;
    }
 
-   // ordinality comparison operator (comparator)
+   // ordinality comparison operator (comparator), word-wise by (i,j)
    bool operator<( const edgeid_u & other ) const {
-      int n=UIDSIZE-1;
-      while( n >= 0 ) {        // sweep is big endian
-         if( bytes.digits[n] != other.bytes.digits[n] ) {
-           if( bytes.digits[n] > other.bytes.digits[n] ) return false;
-           return true;
-         }
-         --n;
-      }
-      return false;    // all digits are equal
+      if( ids.i != other.ids.i ) return ids.i < other.ids.i;
+      return ids.j < other.ids.j;
    }
 };
 
 typedef edgeid_u edgeid_t;
 
 
-// a "hash table" map of key-value pairs for edges
-typedef std::map< edgeid_u, void* > edgeid_map_t;
-typedef std::map< edgeid_u, void* > :: const_iterator edgeid_map_it;
-typedef std::map< void*, edgeid_u > edgeptr_map_t;
-typedef std::map< void*, edgeid_u > :: const_iterator edgeptr_map_it;
+//
+// A hash table of edges by open addressing (linear probing) on the pair of
+// their node indices packed in a 64-bit key (see makeKey()); a key maps to a
+// value, which is typically the index of an edge in an array. Bulk insertion
+// prefetches the slots of the keys that follow.
+//
+
+class sMesh_EdgeHash {
+ public:
+   sMesh_EdgeHash();
+   ~sMesh_EdgeHash();
+
+   static unsigned long makeKey( unsigned long i, unsigned long j );
+   int reserve( long n );
+   void clear();
+   long size() const;
+   long find( unsigned long key ) const;
+   int insert( unsigned long key, long val );
+   long insertBulk( long n, const unsigned long keys[], long vals[] );
+
+ protected:
+
+ private:
+   std::vector< unsigned long > keys;
+   std::vector< long > vals;
+   unsigned long mask;
+   int nbits;
+   long count;
+
+   unsigned long slot( unsigned long key ) const;
+};
+
+class sMesh_Node;
+class sMesh_Edge;
+class sMesh_Quad;
+class sMesh_Tri;
+
+//
+// References between the objects of a mesh are tagged pointers: the kind of
+// the object (INCG_SMESH_REF_*) is kept in the low bits of its pointer, which
+// are free as objects are aligned to at least 8 bytes
+//
+
+#define INCG_SMESH_REF_NODE    0
+#define INCG_SMESH_REF_EDGE    1
+#define INCG_SMESH_REF_TRI     2
+#define INCG_SMESH_REF_QUAD    3
+#define INCG_SMESH_REF_MASK    0x07UL
+
+typedef unsigned long smesh_ref_t;
+
+static inline smesh_ref_t smesh_ref_make( const void* p, int kind )
+{
+   return ((unsigned long) p) | ((unsigned long) kind);
+}
+
+static inline int smesh_ref_kind( smesh_ref_t r )
+{
+   return (int) ( r & INCG_SMESH_REF_MASK );
+}
+
+static inline void* smesh_ref_ptr( smesh_ref_t r )
+{
+   return (void*) ( r & ~INCG_SMESH_REF_MASK );
+}
+
+// references kept in a node or an edge before they spill to the heap
+#define INCG_SMESH_NODE_NREF   6
+#define INCG_SMESH_EDGE_NREF   2
+
+//
+// A compressed (CSR) copy of the references of the nodes and the edges of a
+// mesh by their UIDs: those of node "u" are nref[ nofs[u] ... nofs[u+1]-1 ]
+// and those of edge "u" are eref[ eofs[u] ... eofs[u+1]-1 ], in the order in
+// which they were added (UIDs that are not objects of the mesh have none)
+//
+
+struct incg_smesh_refs_s {
+   long nn, ne;
+   long *nofs, *eofs;
+   smesh_ref_t *nref, *eref;
+};
+
+// tables of objects indexed by their UIDs (null where a UID is not an object
+// of the mesh); an object knows its own UID, so no reverse map is kept
+typedef std::vector< sMesh_Node* > nodetab_t;
+typedef std::vector< sMesh_Edge* > edgetab_t;
+typedef std::vector< sMesh_Quad* > quadtab_t;
+typedef std::vector< sMesh_Tri* > tritab_t;
+
+
+//
+// A slab allocator of objects of one size: objects are placed one after the
+// other in large blocks ("slabs") and are all released with the allocator; a
+// block of many objects is contiguous. Objects are made in the storage (by
+// placement new) and must be destroyed by their owner.
+//
+
+#define INCG_SMESH_SLAB   4096        // least number of objects of a slab
+
+class sMesh_Slab {
+ public:
+   sMesh_Slab( size_t size_ );
+   ~sMesh_Slab();
+
+   void* alloc();
+   void* allocBlock( long n );
+   long getCount() const;
+   void release();
+   void adopt( sMesh_Slab & other );
+
+ protected:
+
+ private:
+   size_t size;
+   std::vector< char* > slabs;
+   char* next;
+   long nfree, count;
+
+   sMesh_Slab( const sMesh_Slab & );               // not to be copied
+   sMesh_Slab & operator=( const sMesh_Slab & );
+};
+
+
+//
+// A pool of the arrays of references that spill from nodes and edges: arrays
+// of 2^k references are cut from large blocks and, when given back, wait in a
+// free list of their size (linked through their first entry) to be taken
+// again; all blocks are released with the pool. Every thread of a team takes
+// and gives in an arena of its own, so that objects can be given references in
+// parallel; threads beyond the arenas share one more in a critical section.
+//
+
+#define INCG_SMESH_POOL_BLOCK   65536     // least references of a block
+#define INCG_SMESH_POOL_NCLASS  32        // sizes of the arrays
+#define INCG_SMESH_SPILL        4         // references of a first spill
 
-typedef std::map< long, void* > uidmap_t;
-typedef std::map< long, void* > :: const_iterator uidmap_it;
-typedef std::map< void*, long > ptrmap_t;
-typedef std::map< void*, long > :: const_iterator ptrmap_it;
+class sMesh_RefPool {
+ public:
+   sMesh_RefPool();
+   ~sMesh_RefPool();
+
+   smesh_ref_t* take( unsigned int cap );
+   void give( smesh_ref_t* p, unsigned int cap );
+   void release();
+
+ protected:
+
+ private:
+   struct arena_s {
+      std::vector< smesh_ref_t* > blocks;
+      smesh_ref_t* next;
+      long nfree;
+      smesh_ref_t* head[ INCG_SMESH_POOL_NCLASS ];
+   };
+   std::vector< struct arena_s > arena;    // one per thread, and one shared
+
+   smesh_ref_t* takeFrom( struct arena_s & a, unsigned int cap );
+   void giveTo( struct arena_s & a, smesh_ref_t* p, unsigned int cap );
+
+   sMesh_RefPool( const sMesh_RefPool & );         // not to be copied
+   sMesh_RefPool & operator=( const sMesh_RefPool & );
+};
 
 
 //----------------------------------------------------------------------------
 
 //
-// Forward declaration
+// Forward declarations
 //
 
 class sMesh_uid_factory;
+class sMesh_Worker;
+struct incg_check_s;
+struct incg_part_s;
+struct incg_partmap_s;
+struct incg_smooth_s;
+struct incg_qual_s;
+struct incg_isect_s;
 
 //
-// Global variable pointing to the UID FACTORY used by object constructors
+// A token class to bypass compile-time issues with class-method friend-ing
 //
 
-extern sMesh_uid_factory* global_UID_factory;
+class ChildSetToken {
+ private:
+   ChildSetToken() { };
+   friend class sMesh_Core;     // only the Core class can create this object
+};
 
 
 //
@@ -136,7 +289,8 @@ extern sMesh_uid_factory* global_UID_factory;
 
 class sMesh_Node {
  public:
-   sMesh_Node();
+   sMesh_Node( sMesh_uid_factory* f );
+   sMesh_Node( sMesh_uid_factory* f, long uid_ );
    ~sMesh_Node();
 
    unsigned char flags;
@@ -145,15 +299,22 @@ class sMesh_Node {
    double x,y,z;
 
    long getUID() const;
-   int addRef( void * );
-   int removeRef( void * );
+   int addRef( smesh_ref_t r, sMesh_RefPool* pool );
+   int removeRef( smesh_ref_t r, sMesh_RefPool* pool );
    unsigned int getNumRefs() const;
+   smesh_ref_t getRef( unsigned int k ) const;
+
+   // the specific token is needed for these methods to be called
+   int setUID( long uid_, ChildSetToken& token );
+   void dropRefs( ChildSetToken& token, sMesh_RefPool* pool );
 
  protected:
 
  private:
    long uid;
-   std::list< void* > refs;
+   unsigned int nref=0, ncap=0;                 // references; pool capacity
+   smesh_ref_t rin[ INCG_SMESH_NODE_NREF ];     // first references
+   smesh_ref_t* rmore=NULL;                     // references that spilled
 };
 
 
@@ -163,7 +324,9 @@ class sMesh_Node {
 
 class sMesh_Edge {
  public:
-   sMesh_Edge( sMesh_Node * np1_, sMesh_Node * np2_ );
+   sMesh_Edge( sMesh_uid_factory* f, sMesh_Node * np1_, sMesh_Node * np2_ );
+   sMesh_Edge( sMesh_uid_factory* f, long uid_,
+               sMesh_Node * np1_, sMesh_Node * np2_ );
    ~sMesh_Edge();
 
    unsigned char flags;
@@ -174,48 +337,52 @@ class sMesh_Edge {
    //            |____________ 0: primary edge, 1: injected (by subdivision)
 
    long getUID() const;
-   int addRef( void * );
-   int removeRef( void * );
+   int addRef( smesh_ref_t r, sMesh_RefPool* pool );
+   int removeRef( smesh_ref_t r, sMesh_RefPool* pool );
    unsigned int getNumRefs() const;
+   smesh_ref_t getRef( unsigned int k ) const;
    sMesh_Node* getNodePtr( int which_one ) const;
    int isBoundary() const;
    int computeLength();
    double getLength() const;
    sMesh_Edge* getChildPtr( int which_one ) const;
    int isSplit() const;
-   int split( uidmap_t* node_uid, ptrmap_t* node_ptr,
-              uidmap_t* edge_uid, ptrmap_t* edge_ptr );
+   int split( sMesh_uid_factory* f, nodetab_t* nodes, edgetab_t* edges,
+              sMesh_Slab* node_slab, sMesh_Slab* edge_slab );
+   int split( sMesh_Worker* w );
+   int claim( unsigned long ticket_ );
+   unsigned long getClaim() const;
+
+   // the specific token is needed for these methods to be called
+   int setUID( long uid_, ChildSetToken& token );
+   int reorient( ChildSetToken& token );
+   void dropRefs( ChildSetToken& token, sMesh_RefPool* pool );
 
  protected:
 
  private:
    long uid;
    sMesh_Node *np1, *np2;
-   std::list< void* > refs;
+   unsigned int nref=0, ncap=0;                 // references; pool capacity
+   smesh_ref_t rin[ INCG_SMESH_EDGE_NREF ];     // first references
+   smesh_ref_t* rmore=NULL;                     // references that spilled
    double length=0.0;
    sMesh_Edge *cp1=NULL, *cp2=NULL;   // edge subdivision children
+   unsigned long ticket=~0UL;         // least claim to split the edge
 };
 
 
-//
-// A token class to bypass compile-time issues with class-method friend-ing
-//
-
-class ChildSetToken {
- private:
-   ChildSetToken() { };
-   friend class sMesh_Core;     // only the Core class can create this object
-};
-
-
-
 //
 // The mesh quadrilateral class
 //
 
 class sMesh_Quad {
  public:
-   sMesh_Quad( sMesh_Edge * ne1_, sMesh_Edge * ne2_,
+   sMesh_Quad( sMesh_uid_factory* f,
+               sMesh_Edge * ne1_, sMesh_Edge * ne2_,
+               sMesh_Edge * ne3_, sMesh_Edge * ne4_, unsigned char dirs_ );
+   sMesh_Quad( sMesh_uid_factory* f, long uid_,
+               sMesh_Edge * ne1_, sMesh_Edge * ne2_,
                sMesh_Edge * ne3_, sMesh_Edge * ne4_, unsigned char dirs_ );
    ~sMesh_Quad();
 
@@ -224,8 +391,10 @@ class sMesh_Quad {
    sMesh_Edge* getEdgePtr( int which_one ) const;
    int needsSubdivision() const;
 
-   // the specific token is needed for this method to be called
+   // the specific token is needed for these methods to be called
    int setChildren( int index, sMesh_Quad* p, ChildSetToken& token );
+   int setUID( long uid_, ChildSetToken& token );
+   int flipEdge( const sMesh_Edge* ep, ChildSetToken& token );
    sMesh_Quad* getChildPtr( int index ) const;
 
  protected:
@@ -251,7 +420,10 @@ class sMesh_Quad {
 
 class sMesh_Tri {
  public:
-   sMesh_Tri( sMesh_Edge * ne1_, sMesh_Edge * ne2_,
+   sMesh_Tri( sMesh_uid_factory* f, sMesh_Edge * ne1_, sMesh_Edge * ne2_,
+              sMesh_Edge * ne3_, unsigned char dirs_ );
+   sMesh_Tri( sMesh_uid_factory* f, long uid_,
+              sMesh_Edge * ne1_, sMesh_Edge * ne2_,
               sMesh_Edge * ne3_, unsigned char dirs_ );
    ~sMesh_Tri();
 
@@ -260,9 +432,11 @@ class sMesh_Tri {
    sMesh_Edge* getEdgePtr( int which_one ) const;
    int computeHeuristics( unsigned char & attr_, double & len_max );
 
-   // the specific token is needed for this method to be called
+   // the specific token is needed for these methods to be called
    int setSubdivision( unsigned char n, ChildSetToken& token );
    int setChildren( int index, void* p, ChildSetToken& token );
+   int setUID( long uid_, ChildSetToken& token );
+   int flipEdge( const sMesh_Edge* ep, ChildSetToken& token );
    void* getChildPtr( int index ) const;
    unsigned char getSubdivAttr() const { return sattr; };
 
@@ -293,6 +467,58 @@ class sMesh_Tri {
 };
 
 
+//
+// A worker that makes objects of a mesh concurrently with other workers (one
+// per thread). UIDs are taken from blocks that the worker reserves from the
+// factory (INCG_SMESH_UID_BLOCK at a time) and objects are placed in its own
+// slabs; no lock is taken. Objects are not given the references of the new
+// objects that use them, and are not known to the mesh or the factory until
+// the workers are published with sMesh_Core::publish(). Every object is
+// recorded with the current key of the worker (such as the index of an item of
+// work), by which the objects can be renumbered after they are published.
+//
+
+#define INCG_SMESH_UID_BLOCK   1024   // UIDs of a kind reserved at a time
+
+class sMesh_Worker {
+ public:
+   sMesh_Worker( sMesh_uid_factory* f );
+   ~sMesh_Worker();
+
+   void setKey( unsigned long key_ );
+   sMesh_Node* newNode();
+   sMesh_Edge* newEdge( sMesh_Node * np1_, sMesh_Node * np2_ );
+   sMesh_Quad* newQuad( sMesh_Edge * ne1_, sMesh_Edge * ne2_,
+                        sMesh_Edge * ne3_, sMesh_Edge * ne4_,
+                        unsigned char dirs_ );
+   sMesh_Tri* newTri( sMesh_Edge * ne1_, sMesh_Edge * ne2_,
+                      sMesh_Edge * ne3_, unsigned char dirs_ );
+   long getCount( int kind ) const;
+
+ protected:
+
+ private:
+   sMesh_uid_factory* factory;
+   unsigned long key;
+   long uid_next[4], uid_end[4];                // blocks of UIDs by kind
+   std::vector< unsigned long > keys[4];        // objects made, by kind
+   std::vector< void* > objs[4];
+
+   sMesh_Slab node_slab;
+   sMesh_Slab edge_slab;
+   sMesh_Slab quad_slab;
+   sMesh_Slab tri_slab;
+
+   long takeUID( int kind );
+   void clear();
+
+   sMesh_Worker( const sMesh_Worker & );           // not to be copied
+   sMesh_Worker & operator=( const sMesh_Worker & );
+
+   friend class sMesh_Core;     // the Core class publishes the objects
+};
+
+
 //
 // The mesh core class
 //
@@ -300,11 +526,34 @@ class sMesh_Tri {
 class sMesh_Core {
  public:
    sMesh_Core();
+   sMesh_Core( sMesh_uid_factory* f );
    ~sMesh_Core();
 
+   sMesh_uid_factory* getFactory() const;
+
    int loadData( int nno, const node_t nodes[],
                  int nel, const face_t faces[] );
+   int loadDataParallel( int nno, const node_t nodes[],
+                         int nel, const face_t faces[] );
    int quadify();
+   int quadifyParallel();
+   int exportData( std::vector< node_t > & nodes,
+                   std::vector< face_t > & faces ) const;
+   int loadMesh( const mesh_t* m );
+   int exportMesh( mesh_t* m ) const;
+   int writeBinary( const char filename[] ) const;
+   int loadBinary( const char filename[] );
+   int writePlot( const char filename[], int iformat ) const;
+   int check( struct incg_check_s* c ) const;
+   int checkSample( struct incg_check_s* c, long nstride, long ioff ) const;
+   int snapshotRefs( struct incg_smesh_refs_s* r ) const;
+   int partition( int npart, int method, int nlayer,
+                  struct incg_part_s* p, struct incg_partmap_s* maps ) const;
+   int smooth( const struct incg_smooth_s* opt );
+   int quality( double* emet, struct incg_qual_s* q ) const;
+   int curvature( int iweight, double* vn, double* va, double* vk ) const;
+   int intersect( struct incg_isect_s* is ) const;
+   int publish( int nw, sMesh_Worker* w[], int irenum );
 #ifdef _DEBUG_
    int dumpEdges( const char filename[], int iop ) const;
 #endif
@@ -312,29 +561,45 @@ class sMesh_Core {
  protected:
 
  private:
-   edgeid_map_t edgeid_map;
-   edgeptr_map_t edgeptr_map;
-
-   uidmap_t node_uid_map;
-   ptrmap_t node_ptr_map;
-   uidmap_t edge_uid_map;
-   ptrmap_t edge_ptr_map;
-   uidmap_t quad_uid_map;
-   ptrmap_t quad_ptr_map;
-   uidmap_t tri_uid_map;
-   ptrmap_t tri_ptr_map;
+   sMesh_uid_factory* factory;        // makes the UIDs of the objects
+   int own_factory;                   // 1: the factory is deleted with mesh
+
+   nodetab_t node_table;
+   edgetab_t edge_table;
+   quadtab_t quad_table;
+   tritab_t tri_table;
+
+   sMesh_Slab node_slab;
+   sMesh_Slab edge_slab;
+   sMesh_Slab quad_slab;
+   sMesh_Slab tri_slab;
 
    std::list< sMesh_Edge* > rem_eptr;
    std::list< sMesh_Quad* > rem_qptr;
    std::list< sMesh_Tri* > rem_tptr;
 
-   int subdivideByRule3( sMesh_Tri* p, int index );
-   int subdivideByRule1( sMesh_Tri* p );
-   int subdivideByRule2u( sMesh_Quad* p );
-   int subdivideByRule2v( sMesh_Quad* p );
+   sMesh_Node* makeNode( sMesh_Worker* w );
+   sMesh_Edge* makeEdge( sMesh_Worker* w, sMesh_Node* np1, sMesh_Node* np2 );
+   sMesh_Quad* makeQuad( sMesh_Worker* w, sMesh_Edge* ep1, sMesh_Edge* ep2,
+                         sMesh_Edge* ep3, sMesh_Edge* ep4, unsigned char dirs );
+   sMesh_Tri* makeTri( sMesh_Worker* w, sMesh_Edge* ep1, sMesh_Edge* ep2,
+                       sMesh_Edge* ep3, unsigned char dirs );
+   int splitEdge( sMesh_Worker* w, sMesh_Edge* ep );
+
+   int subdivideByRule3( sMesh_Tri* p, int index,
+                         sMesh_Worker* w, unsigned long key );
+   int subdivideByRule1( sMesh_Tri* p, sMesh_Worker* w, unsigned long key );
+   int subdivideByRule2u( sMesh_Quad* p, sMesh_Worker* w, unsigned long key );
+   int subdivideByRule2v( sMesh_Quad* p, sMesh_Worker* w, unsigned long key );
 };
 
 
+// --------------------------------------------------------------------
+// Supporting surface-mesh function prototypes
+// --------------------------------------------------------------------
+
+int incg_Smesh_FreeRefs( struct incg_smesh_refs_s* r );
+
 
 #ifdef __cplusplus
 }
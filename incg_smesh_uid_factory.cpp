@@ -20,6 +20,7 @@ sMesh_uid_factory::sMesh_uid_factory()
    edge_uid = -1;
    quad_uid = -1;
    tri_uid = -1;
+   refpool = new sMesh_RefPool();
 }
 
 sMesh_uid_factory::~sMesh_uid_factory()
@@ -28,6 +29,7 @@ sMesh_uid_factory::~sMesh_uid_factory()
    edges.clear();
    quads.clear();
    tris.clear();
+   delete refpool;
 }
 
 long sMesh_uid_factory::getLastNodeUID() const
@@ -78,6 +80,141 @@ long sMesh_uid_factory::getNewTriUID( sMesh_Tri *p )
    return( tri_uid );
 }
 
+// Blocks of consecutive UIDs are reserved for objects that are made in bulk
+// (possibly by many threads); each object sets its pointer at its UID.
+
+long sMesh_uid_factory::getNewNodeUIDs( long n )
+{
+   long first = node_uid + 1;
+   nodes.resize( nodes.size() + n, NULL );
+   node_uid += n;
+   return( first );
+}
+
+long sMesh_uid_factory::getNewEdgeUIDs( long n )
+{
+   long first = edge_uid + 1;
+   edges.resize( edges.size() + n, NULL );
+   edge_uid += n;
+   return( first );
+}
+
+long sMesh_uid_factory::getNewQuadUIDs( long n )
+{
+   long first = quad_uid + 1;
+   quads.resize( quads.size() + n, NULL );
+   quad_uid += n;
+   return( first );
+}
+
+long sMesh_uid_factory::getNewTriUIDs( long n )
+{
+   long first = tri_uid + 1;
+   tris.resize( tris.size() + n, NULL );
+   tri_uid += n;
+   return( first );
+}
+
+// Blocks of UIDs are reserved by threads that make objects concurrently; only
+// the counters change (atomically), and the tables are grown for the blocks
+// by growTables() before objects set their pointers.
+
+long sMesh_uid_factory::reserveNodeUIDs( long n )
+{
+   long last;
+#pragma omp atomic capture
+   { node_uid += n; last = node_uid; }
+   return( last - n + 1 );
+}
+
+long sMesh_uid_factory::reserveEdgeUIDs( long n )
+{
+   long last;
+#pragma omp atomic capture
+   { edge_uid += n; last = edge_uid; }
+   return( last - n + 1 );
+}
+
+long sMesh_uid_factory::reserveQuadUIDs( long n )
+{
+   long last;
+#pragma omp atomic capture
+   { quad_uid += n; last = quad_uid; }
+   return( last - n + 1 );
+}
+
+long sMesh_uid_factory::reserveTriUIDs( long n )
+{
+   long last;
+#pragma omp atomic capture
+   { tri_uid += n; last = tri_uid; }
+   return( last - n + 1 );
+}
+
+int sMesh_uid_factory::growTables()
+{
+   if( (long) nodes.size() < node_uid + 1 ) nodes.resize( node_uid + 1, NULL );
+   if( (long) edges.size() < edge_uid + 1 ) edges.resize( edge_uid + 1, NULL );
+   if( (long) quads.size() < quad_uid + 1 ) quads.resize( quad_uid + 1, NULL );
+   if( (long) tris.size() < tri_uid + 1 ) tris.resize( tri_uid + 1, NULL );
+   return( 0 );
+}
+
+// The counters are set back (or forward) to a UID, and the tables are cut or
+// grown to it; objects above that UID are then no longer known.
+
+int sMesh_uid_factory::setLastNodeUID( long uid_ )
+{
+   node_uid = uid_;
+   nodes.resize( uid_ + 1, NULL );
+   return( 0 );
+}
+
+int sMesh_uid_factory::setLastEdgeUID( long uid_ )
+{
+   edge_uid = uid_;
+   edges.resize( uid_ + 1, NULL );
+   return( 0 );
+}
+
+int sMesh_uid_factory::setLastQuadUID( long uid_ )
+{
+   quad_uid = uid_;
+   quads.resize( uid_ + 1, NULL );
+   return( 0 );
+}
+
+int sMesh_uid_factory::setLastTriUID( long uid_ )
+{
+   tri_uid = uid_;
+   tris.resize( uid_ + 1, NULL );
+   return( 0 );
+}
+
+int sMesh_uid_factory::setNodePtr( long uid_, sMesh_Node *p )
+{
+   nodes[ uid_ ] = p;
+   return( 0 );
+}
+
+int sMesh_uid_factory::setEdgePtr( long uid_, sMesh_Edge *p )
+{
+   edges[ uid_ ] = p;
+   return( 0 );
+}
+
+int sMesh_uid_factory::setQuadPtr( long uid_, sMesh_Quad *p )
+{
+   quads[ uid_ ] = p;
+   return( 0 );
+}
+
+int sMesh_uid_factory::setTriPtr( long uid_, sMesh_Tri *p )
+{
+   tris[ uid_ ] = p;
+   return( 0 );
+}
+
 sMesh_Node * sMesh_uid_factory::getNodePtr( long index_ ) const
 {
    sMesh_Node *p = nodes[ index_ ];
@@ -106,6 +243,11 @@ sMesh_Tri * sMesh_uid_factory::getTriPtr( long index_ ) const
    return( p );
 }
 
+sMesh_RefPool * sMesh_uid_factory::getRefPool() const
+{
+   return( refpool );
+}
+
 long sMesh_uid_factory::sizeNodes() const
 {
    long isize = (long) nodes.size();
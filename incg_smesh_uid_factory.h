@@ -20,6 +20,7 @@ class sMesh_Node;
 class sMesh_Edge;
 class sMesh_Quad;
 class sMesh_Tri;
+class sMesh_RefPool;
 
 
 //
@@ -41,6 +42,27 @@ public:
    long getNewQuadUID( sMesh_Quad *p );
    long getNewTriUID( sMesh_Tri *p );
 
+   long getNewNodeUIDs( long n );
+   long getNewEdgeUIDs( long n );
+   long getNewQuadUIDs( long n );
+   long getNewTriUIDs( long n );
+
+   long reserveNodeUIDs( long n );
+   long reserveEdgeUIDs( long n );
+   long reserveQuadUIDs( long n );
+   long reserveTriUIDs( long n );
+   int growTables();
+
+   int setLastNodeUID( long uid_ );
+   int setLastEdgeUID( long uid_ );
+   int setLastQuadUID( long uid_ );
+   int setLastTriUID( long uid_ );
+
+   int setNodePtr( long uid_, sMesh_Node *p );
+   int setEdgePtr( long uid_, sMesh_Edge *p );
+   int setQuadPtr( long uid_, sMesh_Quad *p );
+   int setTriPtr( long uid_, sMesh_Tri *p );
+
    long sizeNodes() const;
    long sizeEdges() const;
    long sizeQuads() const;
@@ -51,6 +73,8 @@ public:
    sMesh_Quad * getQuadPtr( long index_ ) const;
    sMesh_Tri * getTriPtr( long index_ ) const;
 
+   sMesh_RefPool * getRefPool() const;
+
    std::vector< sMesh_Node * > nodes;
    std::vector< sMesh_Edge * > edges;
    std::vector< sMesh_Quad * > quads;
@@ -60,6 +84,10 @@ protected:
 
 private:
    long node_uid, edge_uid, tri_uid, quad_uid;
+   sMesh_RefPool *refpool;              // references that spill from objects
+
+   sMesh_uid_factory( const sMesh_uid_factory & );     // not to be copied
+   sMesh_uid_factory & operator=( const sMesh_uid_factory & );
 
 };
 
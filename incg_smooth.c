@@ -0,0 +1,585 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "incg_smooth.h"
+#include "incg_sort.h"
+
+
+//
+// Internal view of the faces around the vertices that are smoothed. The
+// corners of vertex i are vc[ vofs[i] ... vofs[i+1]-1 ], each as 4*face+k in
+// ascending order. Free vertices are listed by colour, with those of colour c
+// in order[ cofs[c] ... cofs[c+1]-1 ]; no two vertices of a face share a
+// colour, so the vertices of a colour can move at the same time.
+//
+struct incg_smooth_work_s {
+   long int nv;
+   const long int *faces;
+   long int *vofs, *vc;
+   char *fix;
+   int ncol, maxc;
+   long int *cofs, *order;
+};
+
+
+//
+// Function to return the number of vertices of a face (3 or 4)
+//
+static int incg_Smooth_FaceSize( const long int* f )
+{
+   return f[3] < 0 ? 3 : 4;
+}
+
+
+//
+// Function to mix the bits of an index to give the priority of a vertex in
+// the colouring (the finalizer of "splitmix64")
+//
+static unsigned long incg_Smooth_Hash( unsigned long x )
+{
+   x ^= x >> 30;
+   x *= 0xbf58476d1ce4e5b9UL;
+   x ^= x >> 27;
+   x *= 0x94d049bb133111ebUL;
+   x ^= x >> 31;
+
+   return x;
+}
+
+
+//
+// Function to form the corners of the vertices by a (stable) sort of all the
+// corners of the faces by their vertex
+//
+static int incg_Smooth_Corners( long int nf, struct incg_smooth_work_s* w )
+{
+   unsigned long *key;
+   long int nc = 4*nf, i;
+   int ierr;
+
+
+   key = (unsigned long *) malloc( ((size_t) nc) * sizeof( unsigned long ) );
+   w->vc = (long int *) malloc( ((size_t) nc) * sizeof( long int ) );
+   w->vofs = (long int *) calloc( ((size_t) (w->nv+1)), sizeof( long int ) );
+   if( key == NULL || w->vc == NULL || w->vofs == NULL ) {
+      if( key != NULL ) free( key );
+      return -1;
+   }
+
+#pragma omp parallel for
+   for(i=0;i<nc;++i) {
+      const long int *f = &( w->faces[ i - i%4 ] );
+
+      key[i] = i%4 < incg_Smooth_FaceSize( f ) ?
+               (unsigned long) w->faces[i] : (unsigned long) w->nv;
+      w->vc[i] = i;
+   }
+   ierr = incg_Sort_RadixKeys( nc, key, w->vc,
+                               incg_Sort_NumBits( (unsigned long) w->nv ) );
+   if( ierr ) {
+      free( key );
+      return ierr;
+   }
+
+#pragma omp parallel for
+   for(i=0;i<nc;++i) {
+      if( key[i] < (unsigned long) w->nv ) {
+#pragma omp atomic
+         ++w->vofs[ key[i] ];
+      }
+   }
+   (void) incg_Sort_ScanExclusive( w->nv+1, w->vofs );
+   free( key );
+
+   w->maxc = 0;
+   for(i=0;i<w->nv;++i) {
+      long int n = w->vofs[i+1] - w->vofs[i];
+      if( n > w->maxc ) w->maxc = (int) n;
+   }
+
+   return 0;
+}
+
+
+//
+// Function to fix the vertices that are not in the interior of the surface:
+// vertices without faces and vertices whose edges are not each used once in
+// every direction by their faces (boundary and non-manifold vertices)
+//
+static void incg_Smooth_Boundary( struct incg_smooth_work_s* w )
+{
+   long int i;
+
+#pragma omp parallel for schedule(dynamic,1024)
+   for(i=0;i<w->nv;++i) {
+      long int ja,jb;
+
+      if( w->fix[i] ) continue;
+      if( w->vofs[i] == w->vofs[i+1] ) {
+         w->fix[i] = 1;
+         continue;
+      }
+
+      for(ja=w->vofs[i];ja<w->vofs[i+1] && !w->fix[i];++ja) {
+         const long int *f = &( w->faces[ w->vc[ja] - w->vc[ja]%4 ] );
+         int m = incg_Smooth_FaceSize( f ), k = (int) ( w->vc[ja]%4 );
+         long int iv = f[ (k+1)%m ];
+         int nn=0, np=0;
+
+         for(jb=w->vofs[i];jb<w->vofs[i+1];++jb) {
+            const long int *g = &( w->faces[ w->vc[jb] - w->vc[jb]%4 ] );
+            int mg = incg_Smooth_FaceSize( g ), kg = (int) ( w->vc[jb]%4 );
+
+            if( g[ (kg+1)%mg ] == iv ) ++nn;
+            if( g[ (kg+mg-1)%mg ] == iv ) ++np;
+         }
+         if( nn != np || nn != 1 ) w->fix[i] = 1;
+      }
+   }
+}
+
+
+//
+// Function to colour the free vertices such that no two vertices of a face
+// have the same colour. Rounds of the parallel greedy scheme of Jones and
+// Plassmann are made: a vertex whose priority is the highest among its
+// uncoloured neighbours takes the lowest colour that its neighbours do not
+// have. Priorities are fixed hashes of the indices, so the colouring does not
+// depend on the number of threads.
+//
+static int incg_Smooth_Colour( struct incg_smooth_work_s* w )
+{
+   unsigned long *key=NULL;
+   int *col=NULL, ncol=0;
+   char *top=NULL;
+   long int nv = w->nv, nleft=0, i;
+   int ierr=0;
+
+
+   col = (int *) malloc( ((size_t) nv) * sizeof( int ) );
+   top = (char *) malloc( ((size_t) nv) * sizeof( char ) );
+   if( col == NULL || top == NULL ) {
+      ierr = -1;
+      goto cleanup;
+   }
+
+#pragma omp parallel for reduction(+:nleft)
+   for(i=0;i<nv;++i) {
+      col[i] = w->fix[i] ? -2 : -1;
+      nleft += w->fix[i] ? 0 : 1;
+   }
+
+   while( nleft > 0 ) {
+      long int ndone=0;
+
+      // vertices of highest priority among their uncoloured neighbours
+#pragma omp parallel for schedule(dynamic,1024)
+      for(i=0;i<nv;++i) {
+         unsigned long hi = incg_Smooth_Hash( (unsigned long) i );
+         long int j;
+
+         top[i] = 0;
+         if( col[i] != -1 ) continue;
+         top[i] = 1;
+         for(j=w->vofs[i];j<w->vofs[i+1] && top[i];++j) {
+            const long int *f = &( w->faces[ w->vc[j] - w->vc[j]%4 ] );
+            int m = incg_Smooth_FaceSize( f ), k;
+
+            for(k=0;k<m;++k) {
+               unsigned long hu;
+               if( f[k] == i || col[ f[k] ] != -1 ) continue;
+               hu = incg_Smooth_Hash( (unsigned long) f[k] );
+               if( hu > hi || ( hu == hi && f[k] > i ) ) top[i] = 0;
+            }
+         }
+      }
+
+      // they take the lowest colour free among their neighbours
+#pragma omp parallel for schedule(dynamic,1024) reduction(+:ndone) \
+                         reduction(max:ncol)
+      for(i=0;i<nv;++i) {
+         int c = 0, used = 1;
+
+         if( !top[i] ) continue;
+         while( used ) {
+            long int j;
+
+            used = 0;
+            for(j=w->vofs[i];j<w->vofs[i+1] && !used;++j) {
+               const long int *f = &( w->faces[ w->vc[j] - w->vc[j]%4 ] );
+               int m = incg_Smooth_FaceSize( f ), k;
+
+               for(k=0;k<m;++k) if( col[ f[k] ] == c ) used = 1;
+            }
+            if( used ) ++c;
+         }
+         col[i] = c;
+         if( c+1 > ncol ) ncol = c+1;
+         ++ndone;
+      }
+      nleft -= ndone;
+   }
+
+   // list the free vertices by colour
+   key = (unsigned long *) malloc( ((size_t) nv) * sizeof( unsigned long ) );
+   w->order = (long int *) malloc( ((size_t) nv) * sizeof( long int ) );
+   w->cofs = (long int *) calloc( ((size_t) (ncol+2)), sizeof( long int ) );
+   if( key == NULL || w->order == NULL || w->cofs == NULL ) {
+      ierr = -1;
+      goto cleanup;
+   }
+#pragma omp parallel for
+   for(i=0;i<nv;++i) {
+      key[i] = col[i] < 0 ? (unsigned long) ncol : (unsigned long) col[i];
+      w->order[i] = i;
+   }
+   ierr = incg_Sort_RadixKeys( nv, key, w->order,
+                               incg_Sort_NumBits( (unsigned long) ncol ) );
+   if( ierr ) goto cleanup;
+   for(i=0;i<nv;++i) ++w->cofs[ key[i] ];
+   (void) incg_Sort_ScanExclusive( ncol+2, w->cofs );
+   w->ncol = ncol;
+
+cleanup:
+   if( key != NULL ) free( key );
+   if( top != NULL ) free( top );
+   if( col != NULL ) free( col );
+
+   return ierr;
+}
+
+
+//
+// Function to return the slot of a vertex in the list of ring vertices of a
+// vertex being smoothed, adding it when it is not there
+//
+static int incg_Smooth_Slot( long int iv, int* n, long int* id, double* acc )
+{
+   int k;
+
+   for(k=0;k<*n;++k) if( id[k] == iv ) return k;
+
+   id[k] = iv;
+   acc[3*k+0] = 0.0;
+   acc[3*k+1] = 0.0;
+   acc[3*k+2] = 0.0;
+   ++( *n );
+
+   return k;
+}
+
+
+//
+// Function to add the unit vector from one vertex to another to a sum
+//
+static void incg_Smooth_AddUnit( const double* xa, const double* xb,
+                                 double* acc )
+{
+   double d[3], r;
+
+   d[0] = xb[0] - xa[0];
+   d[1] = xb[1] - xa[1];
+   d[2] = xb[2] - xa[2];
+   r = sqrt( d[0]*d[0] + d[1]*d[1] + d[2]*d[2] );
+   if( r > 0.0 ) {
+      acc[0] += d[0]/r;
+      acc[1] += d[1]/r;
+      acc[2] += d[2]/r;
+   }
+}
+
+
+//
+// Function to compute the move of a vertex towards the point of a method.
+// Laplacian: the average of the neighbours along the sides of the faces.
+// Angle-based (after Zhou and Shimada): every neighbour along a side of a face
+// gives the point on the bisector of its angle in the polygon around the
+// vertex, at the distance of the vertex, and the average of those is taken.
+// The move is made tangent to the surface (normal to the sum of the faces'
+// areas) on request. The scratch arrays have room for 2*maxc ring vertices.
+//
+static void incg_Smooth_Move( const struct incg_smooth_work_s* w,
+                              const double* x, long int i,
+                              int method, int itangent,
+                              long int* id, double* acc, double* d )
+{
+   const double *xi = &( x[3*i] );
+   double t[3] = { 0.0, 0.0, 0.0 };
+   long int j;
+   int n = 0, k;
+
+
+   if( method == INCG_SMOOTH_ANGLE ) {
+      // sums of the unit vectors to the ring vertices' polygon neighbours
+      for(j=w->vofs[i];j<w->vofs[i+1];++j) {
+         const long int *f = &( w->faces[ w->vc[j] - w->vc[j]%4 ] );
+         int m = incg_Smooth_FaceSize( f ), kc = (int) ( w->vc[j]%4 );
+         long int ja = f[ (kc+1)%m ], jb = f[ (kc+m-1)%m ];
+         long int qa = f[ (kc+2)%m ], qb = f[ (kc+m-2)%m ];
+
+         k = incg_Smooth_Slot( ja, &n, id, acc );
+         incg_Smooth_AddUnit( &( x[3*ja] ), &( x[3*qa] ), &( acc[3*k] ) );
+         k = incg_Smooth_Slot( jb, &n, id, acc );
+         incg_Smooth_AddUnit( &( x[3*jb] ), &( x[3*qb] ), &( acc[3*k] ) );
+      }
+      for(k=0;k<n;++k) {
+         const double *xj = &( x[3*id[k]] );
+         double *b = &( acc[3*k] ), dx[3], r, s;
+
+         dx[0] = xi[0] - xj[0];
+         dx[1] = xi[1] - xj[1];
+         dx[2] = xi[2] - xj[2];
+         r = sqrt( dx[0]*dx[0] + dx[1]*dx[1] + dx[2]*dx[2] );
+         s = sqrt( b[0]*b[0] + b[1]*b[1] + b[2]*b[2] );
+         if( s > 0.0 ) {
+            s = r/s;
+            if( b[0]*dx[0] + b[1]*dx[1] + b[2]*dx[2] < 0.0 ) s = -s;
+            t[0] += xj[0] + s*b[0];
+            t[1] += xj[1] + s*b[1];
+            t[2] += xj[2] + s*b[2];
+         } else {
+            t[0] += xi[0];
+            t[1] += xi[1];
+            t[2] += xi[2];
+         }
+      }
+   } else {
+      // sums of the neighbours before and after the vertex in every face
+      for(j=w->vofs[i];j<w->vofs[i+1];++j) {
+         const long int *f = &( w->faces[ w->vc[j] - w->vc[j]%4 ] );
+         int m = incg_Smooth_FaceSize( f ), kc = (int) ( w->vc[j]%4 );
+         const double *xa = &( x[ 3*f[ (kc+1)%m ] ] );
+         const double *xb = &( x[ 3*f[ (kc+m-1)%m ] ] );
+
+         t[0] += xa[0] + xb[0];
+         t[1] += xa[1] + xb[1];
+         t[2] += xa[2] + xb[2];
+      }
+      n = (int) ( 2*( w->vofs[i+1] - w->vofs[i] ) );
+   }
+
+   d[0] = t[0]/n - xi[0];
+   d[1] = t[1]/n - xi[1];
+   d[2] = t[2]/n - xi[2];
+
+   if( itangent ) {
+      double a[3] = { 0.0, 0.0, 0.0 }, r, s;
+
+      // sum of the faces' (Newell) area vectors
+      for(j=w->vofs[i];j<w->vofs[i+1];++j) {
+         const long int *f = &( w->faces[ w->vc[j] - w->vc[j]%4 ] );
+         int m = incg_Smooth_FaceSize( f );
+
+         for(k=0;k<m;++k) {
+            const double *xa = &( x[ 3*f[k] ] ), *xb = &( x[ 3*f[(k+1)%m] ] );
+
+            a[0] += ( xa[1] - xb[1] )*( xa[2] + xb[2] );
+            a[1] += ( xa[2] - xb[2] )*( xa[0] + xb[0] );
+            a[2] += ( xa[0] - xb[0] )*( xa[1] + xb[1] );
+         }
+      }
+      r = a[0]*a[0] + a[1]*a[1] + a[2]*a[2];
+      if( r > 0.0 ) {
+         s = ( d[0]*a[0] + d[1]*a[1] + d[2]*a[2] )/r;
+         d[0] -= s*a[0];
+         d[1] -= s*a[1];
+         d[2] -= s*a[2];
+      }
+   }
+}
+
+
+//
+// Function to smooth the vertices of a set of faces (triangles and quads, as
+// with incg_MeshFile_WriteFaces()) of "nv" vertices with coordinates "x",
+// which are modified. The vertices flagged in the optional array "fixed", and
+// the vertices on boundaries or where the surface is not manifold, are held
+// fixed. The free vertices are coloured and every step sweeps the colours in
+// turn, moving the vertices of a colour in parallel from the positions of the
+// others (a colour-ordered Gauss-Seidel sweep). The outcome depends neither
+// on the number of threads nor on the schedule.
+//
+
+int incg_Smooth_Faces( long int nv, double* x,
+                       long int nf, const long int* faces,
+                       const char* fixed, const struct incg_smooth_s* opt )
+{
+   struct incg_smooth_work_s w;
+   long int *id=NULL, i;
+   double *acc=NULL, omega[2];
+   int nthr=1, npass, it, ip, c, nbad=0, ierr=0;
+
+
+   if( x == NULL || faces == NULL || opt == NULL ) return 1;
+   if( nv <= 0 || nf <= 0 ) return 2;
+   if( opt->niter < 0 || opt->lambda <= 0.0 || opt->lambda > 1.0 ) return 3;
+   if( opt->method != INCG_SMOOTH_LAPLACE &&
+       opt->method != INCG_SMOOTH_TAUBIN &&
+       opt->method != INCG_SMOOTH_ANGLE ) return 3;
+
+#pragma omp parallel for reduction(+:nbad)
+   for(i=0;i<nf;++i) {
+      const long int *f = &( faces[4*i] );
+      int k;
+
+      for(k=0;k<incg_Smooth_FaceSize( f );++k) {
+         if( f[k] < 0 || f[k] >= nv ) ++nbad;
+      }
+   }
+   if( nbad ) return 4;
+   if( opt->niter == 0 ) return 0;
+
+   // factors of the steps of an iteration
+   npass = 1;
+   omega[0] = opt->lambda;
+   omega[1] = opt->mu;
+   if( opt->method == INCG_SMOOTH_TAUBIN ) {
+      npass = 2;
+      if( omega[1] >= 0.0 ) {
+         omega[1] = omega[0] / ( INCG_SMOOTH_PASSBAND*omega[0] - 1.0 );
+      }
+   }
+
+   memset( &w, 0, sizeof(struct incg_smooth_work_s) );
+   w.nv = nv;
+   w.faces = faces;
+   w.fix = (char *) malloc( ((size_t) nv) * sizeof( char ) );
+   if( w.fix == NULL ) return -1;
+#pragma omp parallel for
+   for(i=0;i<nv;++i) w.fix[i] = fixed != NULL ? fixed[i] : 0;
+
+   ierr = incg_Smooth_Corners( nf, &w );
+   if( ierr ) goto cleanup;
+   incg_Smooth_Boundary( &w );
+   ierr = incg_Smooth_Colour( &w );
+   if( ierr ) goto cleanup;
+
+#ifdef _OPENMP
+   nthr = omp_get_max_threads();
+#endif
+   id = (long int *) malloc( ((size_t) (2*w.maxc*nthr)) * sizeof( long int ) );
+   acc = (double *) malloc( ((size_t) (6*w.maxc*nthr)) * sizeof( double ) );
+   if( id == NULL || acc == NULL ) {
+      ierr = -1;
+      goto cleanup;
+   }
+
+   for(it=0;it<opt->niter;++it) {
+      for(ip=0;ip<npass;++ip) {
+         for(c=0;c<w.ncol;++c) {
+#pragma omp parallel num_threads( nthr )
+{           int ith=0;
+            long int j;
+
+#ifdef _OPENMP
+            ith = omp_get_thread_num();
+#endif
+#pragma omp for schedule(dynamic,256)
+            for(j=w.cofs[c];j<w.cofs[c+1];++j) {
+               long int iv = w.order[j];
+               double d[3];
+
+               incg_Smooth_Move( &w, x, iv, opt->method, opt->itangent,
+                                 &( id[ 2*w.maxc*ith ] ),
+                                 &( acc[ 6*w.maxc*ith ] ), d );
+               x[3*iv+0] += omega[ip]*d[0];
+               x[3*iv+1] += omega[ip]*d[1];
+               x[3*iv+2] += omega[ip]*d[2];
+            }
+}
+         }
+      }
+   }
+
+cleanup:
+   if( acc != NULL ) free( acc );
+   if( id != NULL ) free( id );
+   if( w.order != NULL ) free( w.order );
+   if( w.cofs != NULL ) free( w.cofs );
+   if( w.vc != NULL ) free( w.vc );
+   if( w.vofs != NULL ) free( w.vofs );
+   free( w.fix );
+
+   return ierr;
+}
+
+
+//
+// Function to smooth the vertices of a mesh object; the vertices of edges
+// without a triangle on one side are held fixed
+//
+
+int incg_Smooth_Mesh( mesh_t* m, const struct incg_smooth_s* opt )
+{
+   long int *faces=NULL, i;
+   double *x=NULL;
+   char *fixed=NULL;
+   int ierr;
+
+
+   if( m == NULL || opt == NULL ) return 1;
+   if( m->nv == 0 || m->ne == 0 || m->nt == 0 ) return 2;
+
+   x = (double *) malloc( ((size_t) (3*m->nv)) * sizeof( double ) );
+   faces = (long int *) malloc( ((size_t) (4*m->nt)) * sizeof( long int ) );
+   fixed = (char *) calloc( ((size_t) m->nv), sizeof( char ) );
+   if( x == NULL || faces == NULL || fixed == NULL ) {
+      ierr = -1;
+      goto cleanup;
+   }
+
+#pragma omp parallel for
+   for(i=0;i<m->nv;++i) {
+      x[3*i+0] = m->v[i].x;
+      x[3*i+1] = m->v[i].y;
+      x[3*i+2] = m->v[i].z;
+   }
+#pragma omp parallel for
+   for(i=0;i<m->nt;++i) {
+      const triangle_t *t = &( m->t[i] );
+      faces[4*i+0] = t->d1 == 0 ? t->e1->va - m->v : t->e1->vb - m->v;
+      faces[4*i+1] = t->d2 == 0 ? t->e2->va - m->v : t->e2->vb - m->v;
+      faces[4*i+2] = t->d3 == 0 ? t->e3->va - m->v : t->e3->vb - m->v;
+      faces[4*i+3] = -1;
+   }
+   for(i=0;i<m->ne;++i) {
+      if( m->e[i].tl == NULL || m->e[i].tr == NULL ) {
+         fixed[ m->e[i].va - m->v ] = 1;
+         fixed[ m->e[i].vb - m->v ] = 1;
+      }
+   }
+
+   ierr = incg_Smooth_Faces( m->nv, x, m->nt, faces, fixed, opt );
+   if( ierr == 0 ) {
+#pragma omp parallel for
+      for(i=0;i<m->nv;++i) {
+         m->v[i].x = x[3*i+0];
+         m->v[i].y = x[3*i+1];
+         m->v[i].z = x[3*i+2];
+      }
+   }
+
+cleanup:
+   if( fixed != NULL ) free( fixed );
+   if( faces != NULL ) free( faces );
+   if( x != NULL ) free( x );
+
+   return ierr;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
@@ -0,0 +1,45 @@
+
+#ifndef _INCG_SMOOTH_H_
+#define _INCG_SMOOTH_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "incg_mesh.h"
+
+// methods of smoothing
+#define INCG_SMOOTH_LAPLACE     0   // towards the average of the neighbours
+#define INCG_SMOOTH_TAUBIN      1   // alternating shrinking/inflating steps
+#define INCG_SMOOTH_ANGLE       2   // bisecting angles at the neighbours
+
+// pass-band frequency from which the Taubin inflating factor is set
+#define INCG_SMOOTH_PASSBAND    0.1
+
+//
+// Options of a smoothing of the vertices of a mesh: the method, the number of
+// iterations, the fraction of the move that vertices make in a step (lambda,
+// and mu < 0 for the inflating steps of Taubin's method, set from the
+// pass-band when not negative), and whether vertices move in their tangent
+// plane only (to keep them on a curved surface)
+//
+struct incg_smooth_s {
+   int method;
+   int niter;
+   double lambda, mu;
+   int itangent;
+};
+
+// -------------------- function prototypes/signatures --------------------
+
+int incg_Smooth_Mesh( mesh_t* m, const struct incg_smooth_s* opt );
+
+int incg_Smooth_Faces( long int nv, double* x,
+                       long int nf, const long int* faces,
+                       const char* fixed, const struct incg_smooth_s* opt );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
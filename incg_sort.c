@@ -0,0 +1,218 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "incg_sort.h"
+
+// number of bits of the digit of each pass of the radix sort
+#define INCG_SORT_DIGIT  11
+#define INCG_SORT_RADIX  (1 << INCG_SORT_DIGIT)
+
+
+//
+// Function to return the number of bits needed to store a (key) value
+//
+int incg_Sort_NumBits( unsigned long kmax )
+{
+   int n=0;
+
+   while( kmax ) {
+      kmax = kmax >> 1;
+      ++n;
+   }
+
+   return n;
+}
+
+
+//
+// Function to sort an array of keys and an accompanying array of values by
+// the keys in ascending order with a least-significant-digit radix sort.
+// Only the lowest "nbits" bits of the keys are considered. The sort is
+// stable, so values with equal keys retain their order. Every pass is made
+// in parallel with per-thread histograms of contiguous ranges of the arrays,
+// and passes over digits that are the same for all keys are skipped. The
+// values array may be null.
+//
+int incg_Sort_RadixKeys(
+   long int n,
+   unsigned long *key,
+   long int *val,
+   int nbits )
+{
+   unsigned long *k1 = key, *k2;
+   long int *v1 = val, *v2 = NULL;
+   long int *hist;
+   int nthr=1, shift;
+
+
+   if( n < 0 || nbits < 0 || nbits > 64 ) return 1;
+   if( n < 2 || nbits == 0 ) return 0;
+   if( key == NULL ) return 2;
+
+#ifdef _OPENMP
+   nthr = omp_get_max_threads();
+#endif
+   k2 = (unsigned long *) malloc( ((size_t) n) * sizeof( unsigned long ) );
+   if( val != NULL ) {
+      v2 = (long int *) malloc( ((size_t) n) * sizeof( long int ) );
+   }
+   hist = (long int *) malloc( ((size_t) nthr) * INCG_SORT_RADIX *
+                               sizeof( long int ) );
+   if( k2 == NULL || hist == NULL || ( val != NULL && v2 == NULL ) ) {
+      if( k2 != NULL ) free( k2 );
+      if( v2 != NULL ) free( v2 );
+      if( hist != NULL ) free( hist );
+      return -1;
+   }
+
+   for(shift=0;shift<nbits;shift+=INCG_SORT_DIGIT) {
+      int iskip=0;
+
+#pragma omp parallel num_threads( nthr )
+{     int it=0, nt=1;
+      long int i,i0,i1,*h;
+
+#ifdef _OPENMP
+      it = omp_get_thread_num();
+      nt = omp_get_num_threads();
+#endif
+      i0 = (long int) ( ((double) n) * it / nt );
+      i1 = (long int) ( ((double) n) * (it+1) / nt );
+      if( it == nt-1 ) i1 = n;
+      h = &( hist[ it*INCG_SORT_RADIX ] );
+
+      // histogram of the digit over this thread's range
+      memset( h, 0, INCG_SORT_RADIX * sizeof( long int ) );
+      for(i=i0;i<i1;++i) ++h[ (k1[i] >> shift) & (INCG_SORT_RADIX-1) ];
+#pragma omp barrier
+
+      // offsets by digit and then by thread (keeps the sort stable)
+#pragma omp single
+{     long int off=0, d, k, tmp;
+
+      for(d=0;d<INCG_SORT_RADIX;++d) {
+         long int nd=0;
+         for(k=0;k<nt;++k) {
+            tmp = hist[ k*INCG_SORT_RADIX + d ];
+            hist[ k*INCG_SORT_RADIX + d ] = off;
+            off += tmp;
+            nd += tmp;
+         }
+         if( nd == n ) iskip = 1;
+      }
+}
+      // scatter
+      if( iskip == 0 ) {
+         for(i=i0;i<i1;++i) {
+            long int j = h[ (k1[i] >> shift) & (INCG_SORT_RADIX-1) ]++;
+            k2[j] = k1[i];
+            if( v1 != NULL ) v2[j] = v1[i];
+         }
+      }
+}
+      if( iskip == 0 ) {
+         unsigned long *ktmp = k1;
+         long int *vtmp = v1;
+         k1 = k2; k2 = ktmp;
+         v1 = v2; v2 = vtmp;
+      }
+   }
+
+   // the final pass may have left the data in the work arrays
+   if( k1 != key ) {
+      long int i;
+
+#pragma omp parallel for
+      for(i=0;i<n;++i) {
+         key[i] = k1[i];
+         if( val != NULL ) val[i] = v1[i];
+      }
+      free( k1 );
+      if( v1 != NULL ) free( v1 );
+   } else {
+      free( k2 );
+      if( v2 != NULL ) free( v2 );
+   }
+   free( hist );
+
+   return 0;
+}
+
+
+//
+// Function to replace the entries of an array by their exclusive prefix sum
+// and return the total. Threads sum contiguous ranges of the array, then the
+// sums of the ranges are scanned and added to the ranges.
+//
+long int incg_Sort_ScanExclusive( long int n, long int *a )
+{
+   long int *part, total=0;
+   int nthr=1;
+
+
+   if( n <= 0 || a == NULL ) return 0;
+
+#ifdef _OPENMP
+   nthr = omp_get_max_threads();
+#endif
+   part = (long int *) malloc( ((size_t) (nthr+1)) * sizeof( long int ) );
+   if( part == NULL ) {
+      long int i,tmp;
+
+      for(i=0;i<n;++i) {
+         tmp = a[i];
+         a[i] = total;
+         total += tmp;
+      }
+      return total;
+   }
+
+#pragma omp parallel num_threads( nthr )
+{  int it=0, nt=1;
+   long int i,i0,i1,sum=0,tmp;
+
+#ifdef _OPENMP
+   it = omp_get_thread_num();
+   nt = omp_get_num_threads();
+#endif
+   i0 = (long int) ( ((double) n) * it / nt );
+   i1 = (long int) ( ((double) n) * (it+1) / nt );
+   if( it == nt-1 ) i1 = n;
+
+   for(i=i0;i<i1;++i) sum += a[i];
+   part[it] = sum;
+#pragma omp barrier
+#pragma omp single
+{  int k;
+
+   for(k=0;k<nt;++k) {
+      tmp = part[k];
+      part[k] = total;
+      total += tmp;
+   }
+}
+   sum = part[it];
+   for(i=i0;i<i1;++i) {
+      tmp = a[i];
+      a[i] = sum;
+      sum += tmp;
+   }
+}
+   free( part );
+
+   return total;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
@@ -0,0 +1,23 @@
+
+#ifndef _INCG_SORT_H_
+#define _INCG_SORT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int incg_Sort_RadixKeys(
+   long int n,
+   unsigned long *key,
+   long int *val,
+   int nbits );
+
+int incg_Sort_NumBits( unsigned long kmax );
+
+long int incg_Sort_ScanExclusive( long int n, long int *a );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
@@ -0,0 +1,373 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <math.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "incg_stream.h"
+#include "incg_sort.h"
+
+
+// lattice points of a row that are refined at once (bounds the work arrays)
+#define INCG_STREAM_SEG       4096
+
+
+//
+// Context of a streaming refinement: the coarse mesh, the number of segments
+// of every coarse edge, the offsets of the blocks of vertex IDs and the files
+//
+struct incg_stream_s {
+   const mesh_t* m;
+   long int n;            // segments per coarse edge (2^levels)
+   long int nv0;          // start of IDs of vertices inside coarse edges
+   long int ni0;          // start of IDs of vertices inside coarse triangles
+   long int ni;           // number of vertices inside every coarse triangle
+   int fdx, fdt;          // descriptors of the vertex and triangle files
+};
+
+
+//
+// Function to return a vertex (0,1,2) of a triangle, as the loop goes
+//
+static const vertex_t* incg_Stream_Corner( const triangle_t* t, int k )
+{
+   const edge_t *e;
+   char d;
+
+   if( k == 0 ) {
+      e = t->e1; d = t->d1;
+   } else if( k == 1 ) {
+      e = t->e2; d = t->d2;
+   } else {
+      e = t->e3; d = t->d3;
+   }
+
+   if( d == 0 ) return e->va;
+   return e->vb;
+}
+
+
+//
+// Function to return the global ID of the vertex at lattice position (i,j) of
+// a coarse triangle (i along the first edge, j along the third edge reversed).
+// Vertices on coarse edges are numbered by the edge in the edge's direction,
+// such that the triangles on either side of it agree.
+//
+static long int incg_Stream_VertexID( const struct incg_stream_s* c,
+                                      const triangle_t* t,
+                                      long int i, long int j )
+{
+   const long int n = c->n;
+   const edge_t *e;
+   long int s;
+   char d;
+
+   if( j == 0 && i == 0 ) return incg_Stream_Corner( t, 0 )->id;
+   if( j == 0 && i == n ) return incg_Stream_Corner( t, 1 )->id;
+   if( j == n )           return incg_Stream_Corner( t, 2 )->id;
+
+   if( j == 0 ) {
+      e = t->e1; d = t->d1; s = i;
+   } else if( i + j == n ) {
+      e = t->e2; d = t->d2; s = j;
+   } else if( i == 0 ) {
+      e = t->e3; d = t->d3; s = n - j;
+   } else {
+      // interior vertices are numbered by rows of the lattice
+      long int off = (j-1)*(n-1) - ((j-1)*j)/2;
+      return c->ni0 + t->id*c->ni + off + (i-1);
+   }
+
+   if( d ) s = n - s;
+   return c->nv0 + e->id*(n-1) + (s-1);
+}
+
+
+//
+// Function to write a block of data at a position of a file
+//
+static int incg_Stream_Write( int fd, const void* buf, size_t size,
+                              off_t pos )
+{
+   const char *p = (const char *) buf;
+
+   while( size > 0 ) {
+      ssize_t nw = pwrite( fd, p, size, pos );
+      if( nw <= 0 ) return 1;
+      p += nw;
+      pos += (off_t) nw;
+      size -= (size_t) nw;
+   }
+
+   return 0;
+}
+
+
+//
+// Function to refine one row of the lattice of a coarse triangle: the
+// vertices inside the triangle on row "j" are written, and so are the
+// triangles between rows "j" and "j+1". The first row also writes the
+// corners and the vertices inside the coarse edges that the triangle owns
+// (those it is "left" of, or "right" of on boundaries). Rows are 0 to n-1
+// (the last row of the lattice is a corner). A row is done in segments of at
+// most INCG_STREAM_SEG lattice points, each one written where its IDs place
+// it, and the work arrays must hold 3*INCG_STREAM_SEG doubles and
+// 8*INCG_STREAM_SEG+2 IDs.
+//
+static int incg_Stream_Row( const struct incg_stream_s* c,
+                            const triangle_t* t, long int j,
+                            double* xw, long int* iw )
+{
+   const long int n = c->n, ns = INCG_STREAM_SEG;
+   const vertex_t *p0, *p1, *p2;
+   long int *ia = iw, *ib = &( iw[ns+1] ), *it = &( iw[2*(ns+1)] );
+   long int i,i0,i1,k,nr;
+   int ierr=0;
+
+
+   p0 = incg_Stream_Corner( t, 0 );
+   p1 = incg_Stream_Corner( t, 1 );
+   p2 = incg_Stream_Corner( t, 2 );
+
+   if( j == 0 ) {
+      const edge_t *ep[3] = { t->e1, t->e2, t->e3 };
+      const char dp[3] = { t->d1, t->d2, t->d3 };
+      const vertex_t *pc[3] = { p0, p1, p2 };
+
+      for(k=0;k<3 && ierr==0;++k) {
+         const vertex_t *va = ep[k]->va, *vb = ep[k]->vb;
+
+         xw[0] = pc[k]->x;
+         xw[1] = pc[k]->y;
+         xw[2] = pc[k]->z;
+         ierr = incg_Stream_Write( c->fdx, xw, 3*sizeof(double),
+                                   (off_t) (3*sizeof(double))*pc[k]->id );
+
+         if( n < 2 || ierr ) continue;
+         if( dp[k] == 1 && ep[k]->tl != NULL ) continue;
+         for(i0=1;i0<n && ierr==0;i0+=ns) {
+            i1 = i0 + ns < n ? i0 + ns : n;
+            for(i=i0;i<i1;++i) {
+               double f = ((double) i)/((double) n);
+               xw[3*(i-i0)+0] = va->x + f*( vb->x - va->x );
+               xw[3*(i-i0)+1] = va->y + f*( vb->y - va->y );
+               xw[3*(i-i0)+2] = va->z + f*( vb->z - va->z );
+            }
+            ierr = incg_Stream_Write( c->fdx, xw, 3*(i1-i0)*sizeof(double),
+                   (off_t) (3*sizeof(double))*
+                   ( c->nv0 + ep[k]->id*(n-1) + (i0-1) ) );
+         }
+      }
+   }
+
+   // vertices inside the coarse triangle on this row
+   if( j > 0 && n-j > 1 ) {
+      double fj = ((double) j)/((double) n);
+      for(i0=1;i0<n-j && ierr==0;i0+=ns) {
+         i1 = i0 + ns < n-j ? i0 + ns : n-j;
+         for(i=i0;i<i1;++i) {
+            double fi = ((double) i)/((double) n);
+            xw[3*(i-i0)+0] = p0->x + fi*( p1->x - p0->x ) +
+                                     fj*( p2->x - p0->x );
+            xw[3*(i-i0)+1] = p0->y + fi*( p1->y - p0->y ) +
+                                     fj*( p2->y - p0->y );
+            xw[3*(i-i0)+2] = p0->z + fi*( p1->z - p0->z ) +
+                                     fj*( p2->z - p0->z );
+         }
+         ierr = incg_Stream_Write( c->fdx, xw, 3*(i1-i0)*sizeof(double),
+                (off_t) (3*sizeof(double))*
+                incg_Stream_VertexID( c, t, i0, j ) );
+      }
+   }
+
+   // triangles between this row and the next, in the loop of the parent;
+   // every lattice point before the last one of the row makes two of them
+   for(i0=0;i0<n-j && ierr==0;i0+=ns) {
+      i1 = i0 + ns < n-j ? i0 + ns : n-j;
+      for(i=i0;i<=i1;++i) ia[i-i0] = incg_Stream_VertexID( c, t, i, j );
+      for(i=i0;i<=i1 && i<=n-j-1;++i) {
+         ib[i-i0] = incg_Stream_VertexID( c, t, i, j+1 );
+      }
+      nr = 0;
+      for(i=i0;i<i1;++i) {
+         it[3*nr+0] = ia[i-i0];
+         it[3*nr+1] = ia[i-i0+1];
+         it[3*nr+2] = ib[i-i0];
+         ++nr;
+         if( i < n-j-1 ) {
+            it[3*nr+0] = ia[i-i0+1];
+            it[3*nr+1] = ib[i-i0+1];
+            it[3*nr+2] = ib[i-i0];
+            ++nr;
+         }
+      }
+      ierr = incg_Stream_Write( c->fdt, it, 3*nr*sizeof(long int),
+                (off_t) (3*sizeof(long int))*
+                ( t->id*n*n + 2*n*j - j*j + 2*i0 ) );
+   }
+
+   return ierr;
+}
+
+
+//
+// Function that performs "nlev" uniform refinements of a mesh object out of
+// core: the refined vertices and triangles are written straight to two files
+// and the refined mesh is never held in memory. The coarse triangles are
+// visited in chunks of "nchunk" triangles in the order of a Morton curve of
+// their centroids, and the rows of the lattice of every triangle in a chunk
+// are refined in parallel. The memory used is that of the coarse mesh and
+// a fixed segment of a row of a refined triangle per thread, whatever the
+// number of levels.
+// All IDs follow from the coarse mesh, such that the pieces that are made
+// from different chunks (or processes) fit together: the coarse vertices keep
+// their IDs, followed by the vertices inside the coarse edges (by edge) and
+// the vertices inside coarse triangles (by triangle), while the "4^nlev"
+// children of a coarse triangle follow one another. The vertex positions are
+// those of incg_RefineMesh_Uniform(), but the numbering is different.
+// The vertex file holds x,y,z (double) triplets and the triangle file holds
+// triplets of base-0 vertex IDs (long int), both by ID and without a header.
+// The counts of vertices and triangles are returned in "nvf" and "ntf".
+//
+int incg_RefineMesh_Stream(
+   const mesh_t* m,
+   int nlev,
+   long int nchunk,
+   const char* xfile,
+   const char* tfile,
+   long int *nvf,
+   long int *ntf )
+{
+   struct incg_stream_s c;
+   unsigned long *key=NULL;
+   long int *ord=NULL, i, ic;
+   double xmin[3], xmax[3];
+   int ierr=0, k;
+
+
+   if( m == NULL || xfile == NULL || tfile == NULL ) return 1;
+   if( m->nv == 0 || m->ne == 0 || m->nt == 0 ) return 2;
+   if( nlev < 0 || nlev > 24 ) return 3;
+   if( nchunk <= 0 ) nchunk = 1;
+
+   c.m = m;
+   c.n = 1L << nlev;
+   c.nv0 = m->nv;
+   c.ni0 = m->nv + m->ne*(c.n-1);
+   c.ni = ((c.n-1)*(c.n-2))/2;
+   if( nvf != NULL ) *nvf = c.ni0 + m->nt*c.ni;
+   if( ntf != NULL ) *ntf = m->nt*c.n*c.n;
+
+   // order of the coarse triangles along a Morton curve of their centroids
+   key = (unsigned long *) malloc( ((size_t) m->nt) * sizeof( unsigned long ) );
+   ord = (long int *) malloc( ((size_t) m->nt) * sizeof( long int ) );
+   if( key == NULL || ord == NULL ) {
+      if( key != NULL ) free( key );
+      if( ord != NULL ) free( ord );
+      return -1;
+   }
+   xmin[0] = xmax[0] = m->v[0].x;
+   xmin[1] = xmax[1] = m->v[0].y;
+   xmin[2] = xmax[2] = m->v[0].z;
+   for(i=1;i<m->nv;++i) {
+      if( m->v[i].x < xmin[0] ) xmin[0] = m->v[i].x;
+      if( m->v[i].y < xmin[1] ) xmin[1] = m->v[i].y;
+      if( m->v[i].z < xmin[2] ) xmin[2] = m->v[i].z;
+      if( m->v[i].x > xmax[0] ) xmax[0] = m->v[i].x;
+      if( m->v[i].y > xmax[1] ) xmax[1] = m->v[i].y;
+      if( m->v[i].z > xmax[2] ) xmax[2] = m->v[i].z;
+   }
+   for(k=0;k<3;++k) {
+      xmax[k] -= xmin[k];
+      if( xmax[k] <= 0.0 ) xmax[k] = 1.0;
+   }
+#pragma omp parallel for
+   for(i=0;i<m->nt;++i) {
+      const triangle_t *t = &( m->t[i] );
+      const vertex_t *p0 = incg_Stream_Corner( t, 0 );
+      const vertex_t *p1 = incg_Stream_Corner( t, 1 );
+      const vertex_t *p2 = incg_Stream_Corner( t, 2 );
+      unsigned long ix[3], h=0;
+      int b;
+
+      ix[0] = (unsigned long) ( 2097151.0*
+              ( (p0->x + p1->x + p2->x)/3.0 - xmin[0] )/xmax[0] );
+      ix[1] = (unsigned long) ( 2097151.0*
+              ( (p0->y + p1->y + p2->y)/3.0 - xmin[1] )/xmax[1] );
+      ix[2] = (unsigned long) ( 2097151.0*
+              ( (p0->z + p1->z + p2->z)/3.0 - xmin[2] )/xmax[2] );
+      for(b=20;b>=0;--b) {
+         h = (h << 3) | (((ix[0] >> b) & 1UL) << 2)
+                      | (((ix[1] >> b) & 1UL) << 1)
+                      |  ((ix[2] >> b) & 1UL);
+      }
+      key[i] = h;
+      ord[i] = i;
+   }
+   ierr = incg_Sort_RadixKeys( m->nt, key, ord, 63 );
+   free( key );
+   if( ierr ) {
+      free( ord );
+      return ierr;
+   }
+
+   c.fdx = open( xfile, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+   c.fdt = open( tfile, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+   if( c.fdx < 0 || c.fdt < 0 ) {
+      if( c.fdx >= 0 ) close( c.fdx );
+      if( c.fdt >= 0 ) close( c.fdt );
+      free( ord );
+      return 4;
+   }
+
+   for(ic=0;ic<m->nt && ierr==0;ic+=nchunk) {
+      long int nc = nchunk;
+      if( ic + nc > m->nt ) nc = m->nt - ic;
+
+#pragma omp parallel
+{     double *xw;
+      long int *iw, iwork;
+      int ierr_t=0;
+
+      xw = (double *) malloc( ((size_t) (3*INCG_STREAM_SEG)) *
+                              sizeof( double ) );
+      iw = (long int *) malloc( ((size_t) (8*INCG_STREAM_SEG+2)) *
+                                sizeof( long int ) );
+      if( xw == NULL || iw == NULL ) ierr_t = -1;
+
+#pragma omp for schedule(dynamic,16)
+      for(iwork=0;iwork<nc*c.n;++iwork) {
+         if( ierr_t ) continue;
+         ierr_t = incg_Stream_Row( &c, &( m->t[ ord[ ic + iwork/c.n ] ] ),
+                                   iwork%c.n, xw, iw );
+      }
+
+      if( ierr_t ) {
+#pragma omp critical
+         ierr = ierr_t;
+      }
+      if( xw != NULL ) free( xw );
+      if( iw != NULL ) free( iw );
+}
+   }
+
+   if( close( c.fdx ) ) ierr = 5;
+   if( close( c.fdt ) ) ierr = 5;
+   free( ord );
+
+   return ierr;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
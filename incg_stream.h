@@ -0,0 +1,17 @@
+
+#ifndef _INCG_STREAM_H_
+#define _INCG_STREAM_H_
+
+#include "incg_mesh.h"
+
+int incg_RefineMesh_Stream(
+   const mesh_t* m,
+   int nlev,
+   long int nchunk,
+   const char* xfile,
+   const char* tfile,
+   long int *nvf,
+   long int *ntf );
+
+#endif
+
@@ -0,0 +1,321 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "incg_weld.h"
+#include "incg_sort.h"
+
+
+//
+// Function to hash the integer coordinates of a cell of a uniform grid to a
+// number of "nb" bits
+//
+static unsigned long incg_Weld_HashCell( long int i, long int j, long int k,
+                                         int nb )
+{
+   unsigned long h;
+
+   h = ((unsigned long) i) * 73856093UL ^
+       ((unsigned long) j) * 19349663UL ^
+       ((unsigned long) k) * 83492791UL;
+   h *= 0x9E3779B97F4A7C15UL;
+
+   return( h >> (64 - nb) );
+}
+
+
+//
+// Function to find the root of the set of a point in a forest of sets whose
+// parents are never greater than their children. The parents are read and
+// written atomically, so that sets are found while others are being joined;
+// every other link of the path is shortened to its grandparent (halving),
+// which is an ancestor of the point whatever other threads write.
+//
+static long int incg_Weld_Find( long int *par, long int i )
+{
+   long int p, g;
+
+   for(;;) {
+#pragma omp atomic read
+      p = par[i];
+      if( p == i ) return i;
+#pragma omp atomic read
+      g = par[p];
+      if( g != p ) {
+#pragma omp atomic write
+         par[i] = g;
+      }
+      i = g;
+   }
+}
+
+
+//
+// Function to join the sets of two points by linking the greater root to the
+// lesser one (link-by-min); the link is made only if the greater root is still
+// a root, and is tried again otherwise. The root of every set is therefore its
+// lowest indexed point, in whatever order the sets are joined.
+//
+static void incg_Weld_Union( long int *par, long int a, long int b )
+{
+   long int p;
+
+   for(;;) {
+      a = incg_Weld_Find( par, a );
+      b = incg_Weld_Find( par, b );
+      if( a == b ) return;
+      if( a < b ) { p = a; a = b; b = p; }
+#pragma omp atomic compare capture
+      { p = par[a]; if( par[a] == a ) { par[a] = b; } }
+      if( p == a ) return;
+   }
+}
+
+
+//
+// Function to merge the points (x,y,z triplets) that are connected by chains
+// of points that lie within a distance "tol" of each other. Points are hashed
+// by the cell of a uniform grid of spacing "tol" that they fall in, and they
+// are sorted by the hash with the radix sort; a point is then compared against
+// the points of the buckets of its own and its 26 neighbouring cells, and the
+// sets of every pair within the tolerance are joined (union-find). All steps
+// are parallel and their outcome does not depend on the number of threads.
+// The array "remap" (of size "np") receives the index of each point in the
+// welded set, and an array of the "npw" welded points, which keep the
+// coordinates of the lowest indexed point of their set, is allocated and
+// returned in "xw". A tolerance that makes more than INCG_WELD_MAXCELLS cells
+// along the extent of the points is rejected (return 3).
+//
+int incg_Weld_Points(
+   long int np,
+   const double *x,
+   double tol,
+   long int *remap,
+   long int *npw,
+   double **xw )
+{
+   unsigned long *key=NULL;
+   long int *val=NULL, *bs=NULL, *rep=NULL, *par=NULL, nbk, i;
+   double xmin[3] = { 0.0, 0.0, 0.0 }, *xo=NULL;
+   int nb, ic, ierr=0;
+
+
+   if( np <= 0 || x == NULL || remap == NULL ||
+       npw == NULL || xw == NULL ) return 1;
+   if( !( tol > 0.0 ) ) return 2;
+
+   // bucket count is the power of two that is (just) above the point count
+   nb = incg_Sort_NumBits( (unsigned long) np );
+   nbk = 1L << nb;
+
+   key = (unsigned long *) malloc( ((size_t) np) * sizeof( unsigned long ) );
+   val = (long int *) malloc( ((size_t) np) * sizeof( long int ) );
+   bs = (long int *) malloc( ((size_t) (nbk+1)) * sizeof( long int ) );
+   rep = (long int *) malloc( ((size_t) (2*np)) * sizeof( long int ) );
+   if( key == NULL || val == NULL || bs == NULL || rep == NULL ) {
+      if( key != NULL ) free( key );
+      if( val != NULL ) free( val );
+      if( bs != NULL ) free( bs );
+      if( rep != NULL ) free( rep );
+      return -1;
+   }
+   par = &( rep[np] );
+
+   // lower corner of the points (the origin of the grid) and the extent
+   for(ic=0;ic<3;++ic) {
+      double xm = x[ic], xx = x[ic];
+
+#pragma omp parallel for reduction(min:xm) reduction(max:xx)
+      for(i=0;i<np;++i) {
+         if( x[3*i+ic] < xm ) xm = x[3*i+ic];
+         if( x[3*i+ic] > xx ) xx = x[3*i+ic];
+      }
+      xmin[ic] = xm;
+      if( !( ( xx - xm )/tol < (double) INCG_WELD_MAXCELLS ) ) ierr = 3;
+   }
+   if( ierr ) {
+      free( key );
+      free( val );
+      free( bs );
+      free( rep );
+      return ierr;
+   }
+
+   // sort points by the hash of their cell
+#pragma omp parallel for
+   for(i=0;i<np;++i) {
+      long int ci = (long int) floor( ( x[3*i+0] - xmin[0] )/tol );
+      long int cj = (long int) floor( ( x[3*i+1] - xmin[1] )/tol );
+      long int ck = (long int) floor( ( x[3*i+2] - xmin[2] )/tol );
+      key[i] = incg_Weld_HashCell( ci, cj, ck, nb );
+      val[i] = i;
+   }
+   ierr = incg_Sort_RadixKeys( np, key, val, nb );
+   if( ierr ) {
+      free( key );
+      free( val );
+      free( bs );
+      free( rep );
+      return ierr;
+   }
+
+   // start of each bucket in the sorted arrays (empty ones included)
+#pragma omp parallel for
+   for(i=0;i<np;++i) {
+      long int b, b0 = 0;
+
+      if( i > 0 ) {
+         if( key[i] == key[i-1] ) continue;
+         b0 = (long int) key[i-1] + 1;
+      }
+      for(b=b0;b<=(long int) key[i];++b) bs[b] = i;
+   }
+#pragma omp parallel for
+   for(i=(long int) key[np-1]+1;i<=nbk;++i) bs[i] = np;
+
+   // join the sets of the pairs of points within the tolerance
+#pragma omp parallel for
+   for(i=0;i<np;++i) par[i] = i;
+#pragma omp parallel for schedule(dynamic,256)
+   for(i=0;i<np;++i) {
+      const double *xp = &( x[3*i] );
+      long int ci = (long int) floor( ( xp[0] - xmin[0] )/tol );
+      long int cj = (long int) floor( ( xp[1] - xmin[1] )/tol );
+      long int ck = (long int) floor( ( xp[2] - xmin[2] )/tol );
+      int di,dj,dk;
+
+      for(di=-1;di<=1;++di)
+      for(dj=-1;dj<=1;++dj)
+      for(dk=-1;dk<=1;++dk) {
+         unsigned long b = incg_Weld_HashCell( ci+di, cj+dj, ck+dk, nb );
+         long int n;
+
+         for(n=bs[b];n<bs[b+1];++n) {
+            long int j = val[n];
+            double dx,dy,dz;
+
+            if( j >= i ) continue;
+            dx = x[3*j+0] - xp[0];
+            dy = x[3*j+1] - xp[1];
+            dz = x[3*j+2] - xp[2];
+            if( dx*dx + dy*dy + dz*dz <= tol*tol ) {
+               incg_Weld_Union( par, i, j );
+            }
+         }
+      }
+   }
+   free( key );
+   free( val );
+   free( bs );
+
+   // the root of the set of each point (the sets no longer change)
+#pragma omp parallel for
+   for(i=0;i<np;++i) {
+      long int r = i;
+      while( par[r] != r ) r = par[r];
+      rep[i] = r;
+   }
+
+   // number the welded points in the order of their lowest indexed point
+#pragma omp parallel for
+   for(i=0;i<np;++i) remap[i] = ( rep[i] == i ? 1 : 0 );
+   *npw = incg_Sort_ScanExclusive( np, remap );
+
+   xo = (double *) malloc( ((size_t) (3*(*npw))) * sizeof( double ) );
+   if( xo == NULL ) {
+      free( rep );
+      return -1;
+   }
+#pragma omp parallel for
+   for(i=0;i<np;++i) {
+      if( rep[i] == i ) {
+         xo[ 3*remap[i]+0 ] = x[3*i+0];
+         xo[ 3*remap[i]+1 ] = x[3*i+1];
+         xo[ 3*remap[i]+2 ] = x[3*i+2];
+      }
+   }
+#pragma omp parallel for
+   for(i=0;i<np;++i) {
+      if( rep[i] != i ) remap[i] = remap[ rep[i] ];
+   }
+   free( rep );
+
+   *xw = xo;
+
+   return 0;
+}
+
+
+//
+// Function to weld the points of a triangle "soup" that lie within a distance
+// "tol" of each other. The welded soup "w" receives newly allocated arrays of
+// coordinates and connectivity, with the triangles of "s" in their order
+// (triangles that collapse are kept). When "remap" is not null, an array with
+// the index of every point of "s" in "w" is allocated and returned in it.
+//
+int incg_Weld_Tris(
+   const struct ingeom_tris_s* s,
+   double tol,
+   struct ingeom_tris_s* w,
+   int **remap )
+{
+   long int *lmap, npw, i;
+   double *xw=NULL;
+   int *icon, ierr;
+
+
+   if( s == NULL || w == NULL ) return 1;
+   if( s->np <= 0 || s->nt <= 0 || s->icon == NULL || s->x == NULL ) return 2;
+
+   lmap = (long int *) malloc( ((size_t) s->np) * sizeof( long int ) );
+   icon = (int *) malloc( ((size_t) (3*s->nt)) * sizeof( int ) );
+   if( lmap == NULL || icon == NULL ) {
+      if( lmap != NULL ) free( lmap );
+      if( icon != NULL ) free( icon );
+      return -1;
+   }
+
+   ierr = incg_Weld_Points( (long int) s->np, s->x, tol, lmap, &npw, &xw );
+   if( ierr ) {
+      free( lmap );
+      free( icon );
+      return ierr;
+   }
+
+#pragma omp parallel for
+   for(i=0;i<3*((long int) s->nt);++i) icon[i] = (int) lmap[ s->icon[i] ];
+
+   if( remap != NULL ) {
+      *remap = (int *) malloc( ((size_t) s->np) * sizeof( int ) );
+      if( *remap == NULL ) {
+         free( lmap );
+         free( icon );
+         free( xw );
+         return -1;
+      }
+#pragma omp parallel for
+      for(i=0;i<(long int) s->np;++i) (*remap)[i] = (int) lmap[i];
+   }
+   free( lmap );
+
+   w->np = (int) npw;
+   w->nt = s->nt;
+   w->icon = icon;
+   w->x = xw;
+
+   return 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
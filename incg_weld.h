@@ -0,0 +1,25 @@
+
+#ifndef _INCG_WELD_H_
+#define _INCG_WELD_H_
+
+#include "incg_mesh.h"
+
+// largest number of cells of the welding grid along the extent of the points
+#define INCG_WELD_MAXCELLS   (1L << 40)
+
+int incg_Weld_Points(
+   long int np,
+   const double *x,
+   double tol,
+   long int *remap,
+   long int *npw,
+   double **xw );
+
+int incg_Weld_Tris(
+   const struct ingeom_tris_s* s,
+   double tol,
+   struct ingeom_tris_s* w,
+   int **remap );
+
+#endif
+
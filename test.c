@@ -1,11 +1,29 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <math.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "incg_utils.h"
 #include "incg_tet.h"
 #include "incg_tri.h"
 #include "incg_mesh.h"
+#include "incg_weld.h"
+#include "incg_stream.h"
+#include "incg_meshio.h"
+#include "incg_adj.h"
+#include "incg_check.h"
+#include "incg_part.h"
+#include "incg_hier.h"
+#include "incg_smooth.h"
+#include "incg_qual.h"
+#include "incg_curv.h"
+#include "incg_geod.h"
+#include "incg_isect.h"
 
 //
 // a function to generate a random point inside a triangle
@@ -113,9 +131,1296 @@ void test_point_projection_on_plane()
    fclose(fp);
 }
 
+//
+// a function to keep the levels of refinements of a cube, to prolongate the
+// coordinates of the coarsest level to the finest one, and to check that the
+// restriction is the transpose of the prolongation: (P u, r) = (u, R r)
+//
+int test_mesh_hierarchy()
+{
+   mesh_t mesh;
+   struct incg_hier_s hier;
+   double *u[3] = { NULL, NULL, NULL }, *r[2] = { NULL, NULL };
+   double err = 0.0, dpu = 0.0, dur = 0.0;
+   long int i;
+   int l, ierr = 1;
+
+   (void) incg_MakeMesh_Cube( &mesh );
+   if( incg_Hier_Build( &mesh, 2, &hier ) != 0 ) return 1;
+
+   for(l=0;l<=2;++l) {
+      u[l] = (double *) malloc( ((size_t) (3*hier.lev[l].nv)) *
+                                sizeof( double ) );
+   }
+   for(l=0;l<2;++l) {
+      r[l] = (double *) malloc( ((size_t) (3*hier.lev[l+1].nv)) *
+                                sizeof( double ) );
+   }
+   if( u[0] != NULL && u[1] != NULL && u[2] != NULL &&
+       r[0] != NULL && r[1] != NULL ) {
+      for(i=0;i<hier.lev[0].nv;++i) {
+         u[0][3*i+0] = hier.lev[0].v[i].x;
+         u[0][3*i+1] = hier.lev[0].v[i].y;
+         u[0][3*i+2] = hier.lev[0].v[i].z;
+      }
+      (void) incg_Hier_Prolong( &hier, 0, 3, u[0], u[1] );
+      (void) incg_Hier_Prolong( &hier, 1, 3, u[1], u[2] );
+      for(i=0;i<hier.lev[2].nv;++i) {
+         double d = fabs( u[2][3*i+0] - hier.lev[2].v[i].x ) +
+                    fabs( u[2][3*i+1] - hier.lev[2].v[i].y ) +
+                    fabs( u[2][3*i+2] - hier.lev[2].v[i].z );
+         if( d > err ) err = d;
+      }
+      printf("Levels: %ld, %ld, %ld triangles; prolongation error %g \n",
+             hier.lev[0].nt, hier.lev[1].nt, hier.lev[2].nt, err );
+
+      // a residual on the finest level, restricted to level 1
+      for(i=0;i<3*hier.lev[2].nv;++i) r[1][i] = sin( 0.7*i + 0.3 );
+      ierr = incg_Hier_Restrict( &hier, 1, 3, r[1], r[0] );
+      if( ierr == 0 ) {
+         for(i=0;i<3*hier.lev[2].nv;++i) dpu += u[2][i]*r[1][i];
+         for(i=0;i<3*hier.lev[1].nv;++i) dur += u[1][i]*r[0][i];
+         ierr = fabs( dpu - dur ) <= 1.0e-12*fabs( dpu ) ? 0 : 1;
+      }
+      printf("Restriction: (P u, r) = %.15g, (u, R r) = %.15g %s\n",
+             dpu, dur, ierr ? "FAILED" : "ok" );
+   }
+
+   for(l=0;l<=2;++l) if( u[l] != NULL ) free( u[l] );
+   for(l=0;l<2;++l) if( r[l] != NULL ) free( r[l] );
+   (void) incg_Hier_Free( &hier );
+   return ierr;
+}
+
+//
+// a function to form the mesh of a triangle "soup" and check its counts and
+// that the mesh is valid
+//
+int test_mesh_fromtris_check( const char* name, int np, double* x,
+                              int nt, int* icon, long int ne )
+{
+   mesh_t mesh;
+   struct ingeom_tris_s tris;
+   struct incg_check_s check;
+   long int nbad = -1, nviol = -1;
+   int ierr;
+
+   tris.np = np;
+   tris.nt = nt;
+   tris.x = x;
+   tris.icon = icon;
+   ierr = incg_MakeMesh_FromTris( &mesh, &tris, &nbad, NULL );
+   if( ierr ) {
+      printf("%s: FAILED (%d) \n", name, ierr );
+      return 1;
+   }
+   if( incg_Check_Mesh( &mesh, &check ) == 0 ) {
+      nviol = incg_Check_Count( &check );
+      (void) incg_Check_Free( &check );
+   }
+   if( mesh.nv != np || mesh.ne != ne || mesh.nt != nt ||
+       nbad != 0 || nviol != 0 ) ierr = 1;
+   printf("%s: %ld vertices, %ld edges, %ld triangles, %ld non-manifold, "
+          "%ld violations %s\n", name, mesh.nv, mesh.ne, mesh.nt, nbad,
+          nviol, ierr ? "FAILED" : "ok" );
+
+   free( mesh.v );
+   free( mesh.e );
+   free( mesh.t );
+   return ierr;
+}
+
+//
+// a function to form the meshes of an octahedron and of a cube from their
+// triangles
+//
+int test_mesh_fromtris()
+{
+   double xo[6][3] = { { 1.0, 0.0, 0.0 }, {-1.0, 0.0, 0.0 },
+                       { 0.0, 1.0, 0.0 }, { 0.0,-1.0, 0.0 },
+                       { 0.0, 0.0, 1.0 }, { 0.0, 0.0,-1.0 } };
+   int io[8][3] = { { 0, 2, 4 }, { 2, 1, 4 }, { 1, 3, 4 }, { 3, 0, 4 },
+                    { 2, 0, 5 }, { 1, 2, 5 }, { 3, 1, 5 }, { 0, 3, 5 } };
+   double xc[8][3];
+   int ic[12][3] = { { 0, 2, 3 }, { 0, 3, 1 }, { 4, 5, 7 }, { 4, 7, 6 },
+                     { 0, 1, 5 }, { 0, 5, 4 }, { 2, 6, 7 }, { 2, 7, 3 },
+                     { 0, 4, 6 }, { 0, 6, 2 }, { 1, 3, 7 }, { 1, 7, 5 } };
+   int i, nfail = 0;
+
+   // (vertex i of the cube is at the bits of i)
+   for(i=0;i<8;++i) {
+      xc[i][0] = (double) ( i & 1 );
+      xc[i][1] = (double) ( (i >> 1) & 1 );
+      xc[i][2] = (double) ( (i >> 2) & 1 );
+   }
+
+   nfail += test_mesh_fromtris_check( "Octahedron", 6, &( xo[0][0] ),
+                                      8, &( io[0][0] ), 12 );
+   nfail += test_mesh_fromtris_check( "Cube", 8, &( xc[0][0] ),
+                                      12, &( ic[0][0] ), 18 );
+   return nfail;
+}
+
+//
+// a function to weld points on a line that are connected only through a chain
+// of points within the tolerance (0 at 0, 1 at 3, 2 at 1, 3 at 2, tolerance
+// 1): all of them are one point, at the first point; a tolerance that is tiny
+// for the extent of the points is rejected
+//
+int test_mesh_weld_chain()
+{
+   double x[12] = { 0.0, 0.0, 0.0,   3.0, 0.0, 0.0,
+                    1.0, 0.0, 0.0,   2.0, 0.0, 0.0 };
+   double *xw = NULL;
+   long int remap[4] = { -1, -1, -1, -1 }, npw = -1;
+   int ierr, itol;
+
+   ierr = incg_Weld_Points( 4, x, 1.0, remap, &npw, &xw );
+   if( ierr == 0 ) {
+      if( npw != 1 || remap[0] != 0 || remap[1] != 0 || remap[2] != 0 ||
+          remap[3] != 0 || xw[0] != 0.0 ) ierr = 1;
+      free( xw );
+   }
+   itol = incg_Weld_Points( 4, x, 1.0e-300, remap, &npw, &xw );
+   printf("Welded a chain of 4 points to %ld, tiny tolerance (%d) %s\n",
+          npw, itol, ( ierr == 0 && itol == 3 ) ? "ok" : "FAILED" );
+
+   return ( ierr == 0 && itol == 3 ) ? 0 : 1;
+}
+
+//
+// a function to weld a soup of the triangles of a sphere, every one with its
+// own (slightly perturbed) copies of its points, back to the points of the
+// sphere, and to form the mesh of the welded soup
+//
+int test_mesh_weld()
+{
+   struct ingeom_sphere_s sphere = { 0 };
+   struct ingeom_tris_s soup, welded;
+   mesh_t mesh;
+   long int nbad = -1;
+   int i, k, ierr;
+
+   sphere.ns = 2;
+   ierr = incg_MakeMesh_Sphere( NULL, &sphere, INCG_SPHERE_ICOSAHEDRON );
+   if( ierr ) return 1;
+
+   soup.np = 3*sphere.nt;
+   soup.nt = sphere.nt;
+   soup.x = (double *) malloc( ((size_t) (3*soup.np)) * sizeof( double ) );
+   soup.icon = (int *) malloc( ((size_t) (3*soup.nt)) * sizeof( int ) );
+   if( soup.x == NULL || soup.icon == NULL ) {
+      if( soup.x != NULL ) free( soup.x );
+      if( soup.icon != NULL ) free( soup.icon );
+      free( sphere.x );
+      free( sphere.icon );
+      return 1;
+   }
+   for(i=0;i<3*soup.nt;++i) {
+      for(k=0;k<3;++k) {
+         soup.x[3*i+k] = sphere.x[ 3*sphere.icon[i] + k ] +
+                         1.0e-9*( (double) ( (i+k)%5 ) - 2.0 );
+      }
+      soup.icon[i] = i;
+   }
+
+   ierr = incg_Weld_Tris( &soup, 1.0e-6, &welded, NULL );
+   if( ierr == 0 ) {
+      ierr = incg_MakeMesh_FromTris( &mesh, &welded, &nbad, NULL );
+      if( ierr == 0 ) {
+         if( welded.np != sphere.np || mesh.ne != 3*sphere.nt/2 ||
+             nbad != 0 ) ierr = 1;
+         printf("Welded %d points to %d (of %d), %ld edges %s\n",
+                soup.np, welded.np, sphere.np, mesh.ne,
+                ierr ? "FAILED" : "ok" );
+         free( mesh.v );
+         free( mesh.e );
+         free( mesh.t );
+      }
+      free( welded.x );
+      free( welded.icon );
+   }
+   if( ierr ) ierr = 1;
+
+   free( soup.x );
+   free( soup.icon );
+   free( sphere.x );
+   free( sphere.icon );
+   return ierr;
+}
+
+//
+// functions to put the vertices of a triangle in its loop starting from the
+// least one, and to order triangles by their vertices
+//
+void test_tri_canon( long int* t )
+{
+   while( t[0] > t[1] || t[0] > t[2] ) {
+      long int tmp = t[0];
+      t[0] = t[1];
+      t[1] = t[2];
+      t[2] = tmp;
+   }
+}
+
+int test_tri_compare( const void* a, const void* b )
+{
+   const long int *ta = (const long int *) a, *tb = (const long int *) b;
+   int k;
+
+   for(k=0;k<3;++k) {
+      if( ta[k] < tb[k] ) return -1;
+      if( ta[k] > tb[k] ) return 1;
+   }
+   return 0;
+}
+
+//
+// a function to refine a cube out of core and in memory by the same levels;
+// the vertices of the two are matched by welding them together, and the two
+// sets of triangles must then be the same (with their loops)
+//
+int test_mesh_stream()
+{
+   const int nlev = 3;
+   mesh_t coarse, fine;
+   long int nvf = 0, ntf = 0, npw = 0, i;
+   long int *remap=NULL, *ts=NULL, *tu=NULL;
+   double *x=NULL, *xw=NULL;
+   FILE *fp;
+   int ierr;
+
+   (void) incg_MakeMesh_Cube( &coarse );
+   (void) incg_MakeMesh_Cube( &fine );
+   ierr = incg_RefineMesh_Stream( &coarse, nlev, 2,
+                                  "stream_x.bin", "stream_t.bin", &nvf, &ntf );
+   if( ierr == 0 ) ierr = incg_RefineMesh_UniformLevels( &fine, nlev );
+   if( ierr == 0 && ( nvf != fine.nv || ntf != fine.nt ) ) ierr = 1;
+
+   if( ierr == 0 ) {
+      x = (double *) malloc( ((size_t) (6*nvf)) * sizeof( double ) );
+      remap = (long int *) malloc( ((size_t) (2*nvf)) * sizeof( long int ) );
+      ts = (long int *) malloc( ((size_t) (3*ntf)) * sizeof( long int ) );
+      tu = (long int *) malloc( ((size_t) (3*ntf)) * sizeof( long int ) );
+      if( x == NULL || remap == NULL || ts == NULL || tu == NULL ) ierr = -1;
+   }
+   if( ierr == 0 ) {
+      fp = fopen( "stream_x.bin", "r" );
+      if( fp == NULL ||
+          fread( x, sizeof(double), 3*nvf, fp ) != (size_t) (3*nvf) ) {
+         ierr = 2;
+      }
+      if( fp != NULL ) fclose( fp );
+      fp = fopen( "stream_t.bin", "r" );
+      if( fp == NULL ||
+          fread( ts, sizeof(long int), 3*ntf, fp ) != (size_t) (3*ntf) ) {
+         ierr = 2;
+      }
+      if( fp != NULL ) fclose( fp );
+   }
+   if( ierr == 0 ) {
+      for(i=0;i<nvf;++i) {
+         x[ 3*(nvf+i)+0 ] = fine.v[i].x;
+         x[ 3*(nvf+i)+1 ] = fine.v[i].y;
+         x[ 3*(nvf+i)+2 ] = fine.v[i].z;
+      }
+      ierr = incg_Weld_Points( 2*nvf, x, 1.0e-9, remap, &npw, &xw );
+   }
+   if( ierr == 0 ) {
+      for(i=0;i<ntf;++i) {
+         const triangle_t *t = &( fine.t[i] );
+
+         ts[3*i+0] = remap[ ts[3*i+0] ];
+         ts[3*i+1] = remap[ ts[3*i+1] ];
+         ts[3*i+2] = remap[ ts[3*i+2] ];
+         tu[3*i+0] = remap[ nvf + ( t->d1 == 0 ? t->e1->va : t->e1->vb )->id ];
+         tu[3*i+1] = remap[ nvf + ( t->d2 == 0 ? t->e2->va : t->e2->vb )->id ];
+         tu[3*i+2] = remap[ nvf + ( t->d3 == 0 ? t->e3->va : t->e3->vb )->id ];
+         test_tri_canon( &( ts[3*i] ) );
+         test_tri_canon( &( tu[3*i] ) );
+      }
+      qsort( ts, (size_t) ntf, 3*sizeof(long int), test_tri_compare );
+      qsort( tu, (size_t) ntf, 3*sizeof(long int), test_tri_compare );
+      if( npw != nvf ||
+          memcmp( ts, tu, ((size_t) (3*ntf)) * sizeof(long int) ) ) ierr = 1;
+   }
+   printf("Streamed: %ld vertices (%ld matched), %ld triangles %s\n",
+          nvf, npw, ntf, ierr ? "FAILED" : "ok" );
+
+   (void) unlink( "stream_x.bin" );
+   (void) unlink( "stream_t.bin" );
+   if( x != NULL ) free( x );
+   if( xw != NULL ) free( xw );
+   if( remap != NULL ) free( remap );
+   if( ts != NULL ) free( ts );
+   if( tu != NULL ) free( tu );
+   free( coarse.v );
+   free( coarse.e );
+   free( coarse.t );
+   free( fine.v );
+   free( fine.e );
+   free( fine.t );
+   return ierr ? 1 : 0;
+}
+
+//
+// a function to check a mesh in parts and to find a triangle whose loop is
+// broken by the part that holds it as well as by a check of the whole mesh
+//
+int test_mesh_check_parts( mesh_t* m, long int it )
+{
+   const int npart = 7;
+   struct incg_check_s check;
+   long int nbad=0, nfound=0, k;
+   int ip, ierr=0;
+
+   for(ip=0;ip<npart && ierr==0;++ip) {
+      ierr = incg_Check_MeshSample( m, npart, ip, &check );
+      if( ierr == 0 ) {
+         nbad += incg_Check_Count( &check );
+         (void) incg_Check_Free( &check );
+      }
+   }
+
+   m->t[it].d1 = (char) ( 1 - m->t[it].d1 );
+   for(ip=0;ip<=npart && ierr==0;++ip) {
+      // the last one is a check of the whole mesh
+      if( ip < npart ) {
+         ierr = incg_Check_MeshSample( m, npart, ip, &check );
+      } else {
+         ierr = incg_Check_Mesh( m, &check );
+      }
+      if( ierr ) break;
+      for(k=0;k<check.nbad[INCG_CHECK_TRIS];++k) {
+         if( check.ibad[INCG_CHECK_TRIS][k] == it ) ++nfound;
+      }
+      (void) incg_Check_Free( &check );
+   }
+   m->t[it].d1 = (char) ( 1 - m->t[it].d1 );
+
+   printf("Checked in %d parts: %ld violations, broken triangle found %ld "
+          "times %s\n", npart, nbad, nfound,
+          ( ierr == 0 && nbad == 0 && nfound == 2 ) ? "ok" : "FAILED" );
+   return ( ierr == 0 && nbad == 0 && nfound == 2 ) ? 0 : 1;
+}
+
+//
+// a function to read back the vertices and triangles of a mesh from a file of
+// one of the plotting formats and compare them with those of the mesh (the
+// raw-appended VTU file is only read for its counts and its vertices)
+//
+int test_mesh_plot_read( const mesh_t* m, int iformat, const char* filename )
+{
+   const char tag[] = "<AppendedData encoding=\"raw\">\n_";
+   FILE *fp;
+   char line[256], *buf, *p;
+   long int nv = -1, nf = -1, n, i, k;
+   int ierr = 0;
+
+   fp = fopen( filename, "rb" );
+   if( fp == NULL ) return 1;
+
+   if( iformat == INCG_PLOT_VTU ) {
+      (void) fseek( fp, 0L, SEEK_END );
+      n = ftell( fp );
+      (void) fseek( fp, 0L, SEEK_SET );
+      buf = (char *) malloc( (size_t) (n+1) );
+      if( buf == NULL || fread( buf, 1, (size_t) n, fp ) != (size_t) n ) {
+         if( buf != NULL ) free( buf );
+         fclose( fp );
+         return 1;
+      }
+      fclose( fp );
+      buf[n] = '\0';
+      p = strstr( buf, "NumberOfPoints=" );
+      if( p == NULL ||
+          sscanf( p, "NumberOfPoints=\"%ld\" NumberOfCells=\"%ld\"",
+                  &nv, &nf ) != 2 ) ierr = 1;
+      p = strstr( buf, tag );
+      if( ierr == 0 && p != NULL && nv == m->nv && nf == m->nt &&
+          ( p - buf ) + (long int) sizeof(tag)-1 + 8 + 24*nv <= n ) {
+         p += sizeof(tag)-1 + 8;
+         for(i=0;i<nv;++i) {
+            double x[3];
+
+            memcpy( x, &( p[24*i] ), 3*sizeof(double) );
+            if( x[0] != m->v[i].x || x[1] != m->v[i].y ||
+                x[2] != m->v[i].z ) ierr = 1;
+         }
+      } else {
+         ierr = 1;
+      }
+      free( buf );
+      return ierr;
+   }
+
+   // the counts, and the vertices in text
+   while( fgets( line, 256, fp ) != NULL ) {
+      if( iformat == INCG_PLOT_TECPLOT && strstr( line, "NODES=" ) ) {
+         (void) sscanf( strstr( line, "NODES=" ), "NODES=%ld, ELEMENTS=%ld",
+                        &nv, &nf );
+         if( fgets( line, 256, fp ) == NULL ) ierr = 1;
+         break;
+      }
+      if( iformat == INCG_PLOT_VTK && sscanf( line, "POINTS %ld", &nv ) == 1 ) {
+         break;
+      }
+   }
+   if( nv != m->nv ) ierr = 1;
+   for(i=0;i<nv && ierr==0;++i) {
+      double x[3];
+
+      if( fscanf( fp, "%lf %lf %lf", &( x[0] ), &( x[1] ), &( x[2] ) ) != 3 ||
+          x[0] != m->v[i].x || x[1] != m->v[i].y || x[2] != m->v[i].z ) {
+         ierr = 1;
+      }
+   }
+
+   // the triangles (base-1 in Tecplot, after their count in VTK)
+   if( ierr == 0 && iformat == INCG_PLOT_VTK ) {
+      if( fscanf( fp, " CELLS %ld %ld", &nf, &n ) != 2 ) ierr = 1;
+   }
+   if( nf != m->nt ) ierr = 1;
+   for(i=0;i<nf && ierr==0;++i) {
+      const triangle_t *t = &( m->t[i] );
+      long int c[4], v[3];
+
+      v[0] = ( t->d1 == 0 ? t->e1->va : t->e1->vb )->id;
+      v[1] = ( t->d2 == 0 ? t->e2->va : t->e2->vb )->id;
+      v[2] = ( t->d3 == 0 ? t->e3->va : t->e3->vb )->id;
+      if( iformat == INCG_PLOT_TECPLOT ) {
+         if( fscanf( fp, "%ld %ld %ld",
+                     &( c[1] ), &( c[2] ), &( c[3] ) ) != 3 ) ierr = 1;
+         for(k=1;k<4;++k) c[k] -= 1;
+      } else {
+         if( fscanf( fp, "%ld %ld %ld %ld",
+                     &( c[0] ), &( c[1] ), &( c[2] ), &( c[3] ) ) != 4 ||
+             c[0] != 3 ) ierr = 1;
+      }
+      for(k=0;k<3;++k) if( c[k+1] != v[k] ) ierr = 1;
+   }
+
+   fclose( fp );
+   return ierr;
+}
+
+//
+// a function to write the mesh of a sphere in the plotting formats and to
+// read it back
+//
+int test_mesh_plot()
+{
+   const char *fn[3] = { "plot_test.dat", "plot_test.vtk", "plot_test.vtu" };
+   const int ifmt[3] = { INCG_PLOT_TECPLOT, INCG_PLOT_VTK, INCG_PLOT_VTU };
+   mesh_t mesh;
+   struct ingeom_sphere_s sphere = { 0 };
+   int k, ierr, nfail = 0;
+
+   sphere.ns = 2;
+   ierr = incg_MakeMesh_Sphere( &mesh, &sphere, INCG_SPHERE_ICOSAHEDRON );
+   if( ierr ) return 1;
+   free( sphere.x );
+   free( sphere.icon );
+
+   for(k=0;k<3;++k) {
+      ierr = incg_MeshFile_Plot( &mesh, ifmt[k], "Sphere", fn[k] );
+      if( ierr == 0 ) ierr = test_mesh_plot_read( &mesh, ifmt[k], fn[k] );
+      printf("Plotted %ld vertices, %ld triangles to %s %s\n",
+             mesh.nv, mesh.nt, fn[k], ierr ? "FAILED" : "ok" );
+      if( ierr ) ++nfail;
+      (void) unlink( fn[k] );
+   }
+
+   free( mesh.v );
+   free( mesh.e );
+   free( mesh.t );
+   return nfail;
+}
+
+//
+// a function to smooth a unit sphere by Loop subdivision; the refined sphere
+// has the counts of two uniform refinements and its vertices, which are on
+// the limit surface of the incoming vertices, stay just inside the sphere
+//
+int test_mesh_loop()
+{
+   mesh_t mesh;
+   struct ingeom_sphere_s sphere = { 0 };
+   double rmin = 1.0e30, rmax = 0.0;
+   long int i;
+   int ierr;
+
+   sphere.ns = 3;
+   ierr = incg_MakeMesh_Sphere( &mesh, &sphere, INCG_SPHERE_ICOSAHEDRON );
+   if( ierr ) return 1;
+   free( sphere.x );
+   free( sphere.icon );
+
+   ierr = incg_RefineMesh_Loop( &mesh, 2 );
+   if( ierr == 0 ) {
+      for(i=0;i<mesh.nv;++i) {
+         double r = sqrt( mesh.v[i].x*mesh.v[i].x + mesh.v[i].y*mesh.v[i].y +
+                          mesh.v[i].z*mesh.v[i].z );
+         if( r < rmin ) rmin = r;
+         if( r > rmax ) rmax = r;
+      }
+      if( mesh.nv != 10242 || mesh.nt != 20480 ||
+          rmin < 0.99 || rmax > 1.0 ) ierr = 1;
+   }
+   printf("Loop sphere: %ld vertices, %ld triangles, radius in [%lf,%lf] %s\n",
+          mesh.nv, mesh.nt, rmin, rmax, ierr ? "FAILED" : "ok" );
+
+   free( mesh.v );
+   free( mesh.e );
+   free( mesh.t );
+   return ierr;
+}
+
+//
+// a function to check the areas and curvatures of the vertices of a unit
+// sphere: the areas add up to about 4 pi, and so do the Gaussian curvatures
+// times the areas (Gauss-Bonnet), and the mean curvatures are about 1
+//
+int test_mesh_curvature_check( const char* name, long int nv,
+                               const double* va, const double* vk )
+{
+   double area = 0.0, gsum = 0.0, hmin = 1.0e30, hmax = -1.0e30;
+   long int i;
+   int ierr = 0;
+
+   for(i=0;i<nv;++i) {
+      double h = vk[ INCG_CURV_NCURV*i + INCG_CURV_MEAN ];
+      area += va[i];
+      gsum += va[i] * vk[ INCG_CURV_NCURV*i + INCG_CURV_GAUSS ];
+      if( h < hmin ) hmin = h;
+      if( h > hmax ) hmax = h;
+   }
+   if( fabs( area - 4.0*M_PI ) > 0.01*4.0*M_PI ||
+       fabs( gsum - 4.0*M_PI ) > 1.0e-9 ||
+       hmin < 0.95 || hmax > 1.05 ) ierr = 1;
+   printf("%s: area %lf, total Gaussian curvature %lf, mean curvature in "
+          "[%lf,%lf] %s\n", name, area, gsum, hmin, hmax,
+          ierr ? "FAILED" : "ok" );
+
+   return ierr;
+}
+
+//
+// a function to compute the curvatures of the vertices of a unit sphere of
+// triangles, and of one of quads made by projecting the grids of the faces of
+// a cube (whose shared points are welded)
+//
+int test_mesh_curvature()
+{
+   const int n = 8;
+   mesh_t mesh;
+   struct ingeom_sphere_s sphere = { 0 };
+   double *va=NULL, *vk=NULL, *x=NULL, *xw=NULL;
+   long int *remap=NULL, *faces=NULL, np, npw=0, nf, i;
+   int nfail = 0, ierr, k, a, b;
+
+   sphere.ns = 3;
+   if( incg_MakeMesh_Sphere( &mesh, &sphere, INCG_SPHERE_ICOSAHEDRON ) ) {
+      return 1;
+   }
+   free( sphere.x );
+   free( sphere.icon );
+
+   va = (double *) malloc( ((size_t) mesh.nv) * sizeof( double ) );
+   vk = (double *) malloc( ((size_t) (INCG_CURV_NCURV*mesh.nv)) *
+                           sizeof( double ) );
+   ierr = ( va == NULL || vk == NULL );
+   if( ierr == 0 ) ierr = incg_Curv_Mesh( &mesh, INCG_CURV_ANGLE, NULL, va, vk );
+   if( ierr == 0 ) {
+      nfail += test_mesh_curvature_check( "Sphere", mesh.nv, va, vk );
+   } else {
+      ++nfail;
+   }
+   if( va != NULL ) free( va );
+   if( vk != NULL ) free( vk );
+   va = vk = NULL;
+   free( mesh.v );
+   free( mesh.e );
+   free( mesh.t );
+
+   // the n x n grid of every face of the cube, projected on the sphere
+   np = 6*(n+1)*(n+1);
+   nf = 6*n*n;
+   x = (double *) malloc( ((size_t) (3*np)) * sizeof( double ) );
+   remap = (long int *) malloc( ((size_t) np) * sizeof( long int ) );
+   faces = (long int *) malloc( ((size_t) (4*nf)) * sizeof( long int ) );
+   if( x == NULL || remap == NULL || faces == NULL ) {
+      ierr = -1;
+      goto cleanup;
+   }
+   for(k=0;k<6;++k) {
+      int ia = k/2, ib = (ia+1)%3, ic = (ia+2)%3;
+      double sg = ( k%2 == 0 ? 1.0 : -1.0 );
+      for(b=0;b<=n;++b) {
+         for(a=0;a<=n;++a) {
+            double *xp = &( x[3*((k*(n+1)+b)*(n+1)+a)] ), r;
+            xp[ia] = sg;
+            xp[ib] = sg*( -1.0 + 2.0*((double) a)/((double) n) );
+            xp[ic] = -1.0 + 2.0*((double) b)/((double) n);
+            r = sqrt( xp[0]*xp[0] + xp[1]*xp[1] + xp[2]*xp[2] );
+            xp[0] /= r;
+            xp[1] /= r;
+            xp[2] /= r;
+         }
+      }
+      for(b=0;b<n;++b) {
+         for(a=0;a<n;++a) {
+            long int *f = &( faces[4*((k*n+b)*n+a)] );
+            long int v = (k*(n+1)+b)*(n+1)+a;
+            f[0] = v; f[1] = v+1; f[2] = v+n+2; f[3] = v+n+1;
+         }
+      }
+   }
+   ierr = incg_Weld_Points( np, x, 1.0e-9, remap, &npw, &xw );
+   if( ierr ) goto cleanup;
+   for(i=0;i<4*nf;++i) faces[i] = remap[ faces[i] ];
+
+   va = (double *) malloc( ((size_t) npw) * sizeof( double ) );
+   vk = (double *) malloc( ((size_t) (INCG_CURV_NCURV*npw)) *
+                           sizeof( double ) );
+   if( va == NULL || vk == NULL ) {
+      ierr = -1;
+      goto cleanup;
+   }
+   ierr = incg_Curv_Faces( npw, xw, nf, faces, INCG_CURV_ANGLE, NULL, va, vk );
+   if( ierr == 0 ) {
+      if( npw != 6*n*n + 2 ) ierr = 1;
+      ierr += test_mesh_curvature_check( "Sphere of quads", npw, va, vk );
+   }
+
+cleanup:
+   if( ierr ) ++nfail;
+   if( x != NULL ) free( x );
+   if( xw != NULL ) free( xw );
+   if( remap != NULL ) free( remap );
+   if( faces != NULL ) free( faces );
+   if( va != NULL ) free( va );
+   if( vk != NULL ) free( vk );
+   return nfail;
+}
+
+//
+// a function to compute the geodesic distances on a unit sphere from a vertex
+// and from a pair of vertices, with the operators factored once: the farthest
+// vertex from one is across the sphere, at nearly pi, and the distances are
+// the same with one thread as with all of them (up to the rounding of the
+// mean length of the edges)
+//
+int test_mesh_geodesic()
+{
+   mesh_t mesh;
+   struct ingeom_sphere_s sphere = { 0 };
+   struct incg_geod_s geod;
+   long int sofs[3] = { 0, 1, 3 }, src[3] = { 0, 0, 3 };
+   double *dist, dmax[2] = { 0.0, 0.0 }, ddif=0.0;
+   long int i;
+   int nt0=1, ipass, ierr=0, nfail=0;
+
+   sphere.ns = 4;
+   if( incg_MakeMesh_Sphere( &mesh, &sphere, INCG_SPHERE_ICOSAHEDRON ) ) {
+      printf(" Geodesic: sphere FAILED \n");
+      return 1;
+   }
+   free( sphere.x );
+   free( sphere.icon );
+
+#ifdef _OPENMP
+   nt0 = omp_get_max_threads();
+#endif
+   dist = (double *) malloc( ((size_t) (4*mesh.nv)) * sizeof( double ) );
+   if( dist == NULL ) ierr = -1;
+   for(ipass=0;ipass<2 && ierr == 0;++ipass) {
+#ifdef _OPENMP
+      omp_set_num_threads( ipass == 0 ? nt0 : 1 );
+#endif
+      ierr = incg_Geod_Build( &mesh, 1.0, &geod );
+      if( ierr ) break;
+      ierr = incg_Geod_Distance( &geod, 2, sofs, src,
+                                 &( dist[2*ipass*mesh.nv] ) );
+      (void) incg_Geod_Free( &geod );
+   }
+#ifdef _OPENMP
+   omp_set_num_threads( nt0 );
+#endif
+
+   if( ierr ) {
+      printf(" Geodesic: build/distance FAILED (%d) \n", ierr );
+      ++nfail;
+   } else {
+      for(i=0;i<mesh.nv;++i) {
+         double d = fabs( dist[i] - dist[2*mesh.nv+i] );
+         if( dist[i] > dmax[0] ) dmax[0] = dist[i];
+         if( dist[mesh.nv+i] > dmax[1] ) dmax[1] = dist[mesh.nv+i];
+         if( d > ddif ) ddif = d;
+         d = fabs( dist[mesh.nv+i] - dist[3*mesh.nv+i] );
+         if( d > ddif ) ddif = d;
+      }
+      printf(" Sphere: farthest from one vertex %lf, from two %lf \n",
+             dmax[0], dmax[1] );
+      if( fabs( dmax[0] - M_PI ) > 0.05*M_PI || dmax[1] >= dmax[0] ) {
+         printf(" Geodesic: farthest distance FAILED \n");
+         ++nfail;
+      }
+      if( ddif > 1.0e-12 ) {
+         printf(" Geodesic: threads differ by %le FAILED \n", ddif );
+         ++nfail;
+      }
+      if( nfail == 0 ) printf(" Geodesic: distances ok \n");
+   }
+
+   if( dist != NULL ) free( dist );
+   free( mesh.v );
+   free( mesh.e );
+   free( mesh.t );
+   return nfail;
+}
+
+//
+// a function to create unit spheres from an icosahedron and an octahedron at
+// a number of refinements: the counts are those of the base polyhedron times
+// 4^ns, and every vertex is on the sphere (it is projected as it is made)
+//
+int test_mesh_sphere()
+{
+   struct ingeom_sphere_s sphere;
+   int itype, ns, nfail = 0;
+
+   for(itype=0;itype<2;++itype) {
+      // (faces and vertices of the base polyhedron)
+      int nf = ( itype == INCG_SPHERE_ICOSAHEDRON ? 20 : 8 );
+      int nb = ( itype == INCG_SPHERE_ICOSAHEDRON ? 10 : 4 );
+
+      for(ns=0;ns<=4;++ns) {
+         double emax = 0.0;
+         int ierr, i;
+
+         memset( &sphere, 0, sizeof(struct ingeom_sphere_s) );
+         sphere.ns = ns;
+         ierr = incg_MakeMesh_Sphere( NULL, &sphere, itype );
+         if( ierr == 0 ) {
+            for(i=0;i<sphere.np;++i) {
+               double *x = &( sphere.x[3*i] );
+               double e = fabs( sqrt( x[0]*x[0] + x[1]*x[1] + x[2]*x[2] )
+                                - 1.0 );
+               if( e > emax ) emax = e;
+            }
+            if( sphere.np != nb*(1 << (2*ns)) + 2 ||
+                sphere.nt != nf*(1 << (2*ns)) || emax > 1.0e-14 ) ierr = 1;
+            free( sphere.x );
+            free( sphere.icon );
+         }
+         printf("Sphere (%s, %d): %d nodes, %d triangles, radius error %g "
+                "%s\n", itype == INCG_SPHERE_ICOSAHEDRON ?
+                "icosahedron" : "octahedron", ns, sphere.np, sphere.nt, emax,
+                ierr ? "FAILED" : "ok" );
+         if( ierr ) ++nfail;
+      }
+   }
+
+   return nfail;
+}
+
+//
+// a function to build the vertex adjacency of a mesh, to refine the mesh, and
+// to update the adjacency; it must be that of a fresh build on the refined mesh
+//
+int test_mesh_adj_refine( const char* name, mesh_t* m )
+{
+   struct incg_adj_s a, b;
+   long int nbad = -1, i;
+   int ierr;
+
+   ierr = incg_Adj_Build( m, &a );
+   if( ierr ) return 1;
+   ierr = incg_RefineMesh_Uniform( m );
+   if( ierr == 0 ) ierr = incg_Adj_Refine( m, &a );
+   if( ierr == 0 ) ierr = incg_Adj_Build( m, &b );
+   if( ierr == 0 ) {
+      nbad = 0;
+      if( a.nv != b.nv || a.nv != m->nv ) nbad = 1;
+      for(i=0;i<=m->nv && nbad==0;++i) {
+         if( a.tofs[i] != b.tofs[i] || a.eofs[i] != b.eofs[i] ) ++nbad;
+      }
+      for(i=0;i<b.tofs[m->nv] && nbad==0;++i) {
+         if( a.tri[i] != b.tri[i] ) ++nbad;
+      }
+      for(i=0;i<b.eofs[m->nv] && nbad==0;++i) {
+         if( a.edge[i] != b.edge[i] || a.vert[i] != b.vert[i] ) ++nbad;
+      }
+      (void) incg_Adj_Free( &b );
+   }
+   (void) incg_Adj_Free( &a );
+
+   printf("%s: adjacency of %ld vertices after refinement, %ld mismatches %s\n",
+          name, m->nv, nbad, ( ierr == 0 && nbad == 0 ) ? "ok" : "FAILED" );
+   return ( ierr == 0 && nbad == 0 ) ? 0 : 1;
+}
+
+//
+// a function to compare the refined adjacency with a fresh one on a sphere and
+// on two triangles (whose vertices are all on the boundary)
+//
+int test_mesh_adj()
+{
+   struct ingeom_sphere_s sphere = { 0 };
+   double x[4][3] = { { 0.0, 0.0, 0.0 }, { 1.0, 0.0, 0.0 },
+                      { 1.0, 1.0, 0.0 }, { 0.0, 1.0, 0.0 } };
+   int icon[2][3] = { { 0, 1, 2 }, { 0, 2, 3 } };
+   struct ingeom_tris_s tris;
+   mesh_t mesh;
+   int nfail = 0;
+
+   sphere.ns = 2;
+   if( incg_MakeMesh_Sphere( &mesh, &sphere, INCG_SPHERE_ICOSAHEDRON ) ) {
+      return 1;
+   }
+   free( sphere.x );
+   free( sphere.icon );
+   nfail += test_mesh_adj_refine( "Sphere", &mesh );
+   free( mesh.v );
+   free( mesh.e );
+   free( mesh.t );
+
+   tris.np = 4;
+   tris.nt = 2;
+   tris.x = &( x[0][0] );
+   tris.icon = &( icon[0][0] );
+   if( incg_MakeMesh_FromTris( &mesh, &tris, NULL, NULL ) ) return nfail+1;
+   nfail += test_mesh_adj_refine( "Two triangles", &mesh );
+   free( mesh.v );
+   free( mesh.e );
+   free( mesh.t );
+
+   return nfail;
+}
+
+//
+// a function to count the violations of a partition and of its halo maps: the
+// part sizes add up and are within the tolerance of the graph partitioner (or
+// differ by one for bisection), a part sends only elements it owns, and the
+// list it sends to a neighbour is, in global IDs, the list the neighbour
+// receives from it, made of ghosts of the sending part
+//
+long int test_mesh_part_check( const struct incg_part_s* p,
+                               const struct incg_partmap_s* maps, int method )
+{
+   long int nbad=0, nsum=0, nmin=p->nel, nmax=0, *cnt, i, n;
+   int ip, k, kq;
+
+   cnt = (long int *) calloc( (size_t) p->npart, sizeof(long int) );
+   if( cnt == NULL ) return -1;
+   for(i=0;i<p->nel;++i) {
+      if( p->part[i] < 0 || p->part[i] >= p->npart ) ++nbad;
+      else ++cnt[ p->part[i] ];
+   }
+   for(ip=0;ip<p->npart;++ip) {
+      if( cnt[ip] != p->nelp[ip] ) ++nbad;
+      nsum += p->nelp[ip];
+      if( p->nelp[ip] < nmin ) nmin = p->nelp[ip];
+      if( p->nelp[ip] > nmax ) nmax = p->nelp[ip];
+   }
+   free( cnt );
+   if( nsum != p->nel ) ++nbad;
+   if( method == INCG_PART_RCB ) {
+      if( nmax - nmin > 1 ) ++nbad;
+   } else {
+      if( nmax > (long int) ( ( 1.0 + INCG_PART_TOLERANCE ) *
+                              p->nel / p->npart ) + 1 ) ++nbad;
+   }
+
+   for(ip=0;ip<p->npart;++ip) {
+      const struct incg_partmap_s *a = &( maps[ip] );
+      for(k=0;k<a->nnbr;++k) {
+         const struct incg_partmap_s *b = &( maps[ a->nbr[k] ] );
+         for(kq=0;kq<b->nnbr && b->nbr[kq] != ip;++kq);
+         if( kq == b->nnbr ||
+             a->sofs[k+1] - a->sofs[k] != b->rofs[kq+1] - b->rofs[kq] ) {
+            ++nbad;
+            continue;
+         }
+         for(n=0;n<a->sofs[k+1]-a->sofs[k];++n) {
+            long int ls = a->send[ a->sofs[k] + n ];
+            long int lr = b->recv[ b->rofs[kq] + n ];
+            if( ls < 0 || ls >= a->nown || lr < b->nown || lr >= b->nel ||
+                a->l2g[ls] != b->l2g[lr] ||
+                p->part[ a->l2g[ls] ] != ip ) ++nbad;
+         }
+      }
+   }
+
+   return nbad;
+}
+
+//
+// a function to partition a sphere in four parts with a layer of ghosts by
+// bisection and by the graph partitioner, on one thread and on all of them:
+// the partitions and halos are valid and do not depend on the threads
+//
+int test_mesh_part()
+{
+   struct ingeom_sphere_s sphere = { 0 };
+   struct incg_part_s part[2];
+   struct incg_partmap_s pmaps[2][4];
+   mesh_t mesh;
+   int method, nthr = 1, nt0 = 1, nfail = 0, n;
+
+   sphere.ns = 3;
+   if( incg_MakeMesh_Sphere( &mesh, &sphere, INCG_SPHERE_ICOSAHEDRON ) ) {
+      return 1;
+   }
+   free( sphere.x );
+   free( sphere.icon );
+#ifdef _OPENMP
+   nt0 = omp_get_max_threads();
+   nthr = nt0 > 1 ? nt0 : 4;
+#endif
+
+   for(method=0;method<2;++method) {
+      long int nbad[2] = { -1, -1 };
+      int ierr = 0, isame = 0;
+
+      for(n=0;n<2;++n) {
+#ifdef _OPENMP
+         omp_set_num_threads( n == 0 ? 1 : nthr );
+#endif
+         if( ierr == 0 ) ierr = incg_Part_Mesh( &mesh, 4, method, &( part[n] ) );
+         if( ierr == 0 ) {
+            ierr = incg_Part_HaloMesh( &mesh, &( part[n] ), 1, pmaps[n] );
+            if( ierr ) (void) incg_Part_Free( &( part[n] ) );
+         }
+         if( ierr == 0 ) {
+            nbad[n] = test_mesh_part_check( &( part[n] ), pmaps[n], method );
+         }
+      }
+#ifdef _OPENMP
+      omp_set_num_threads( nt0 );
+#endif
+      if( ierr == 0 ) {
+         isame = memcmp( part[0].part, part[1].part,
+                         ((size_t) mesh.nt) * sizeof(int) ) == 0;
+         for(n=0;n<4 && isame;++n) {
+            if( pmaps[0][n].nel != pmaps[1][n].nel ||
+                memcmp( pmaps[0][n].l2g, pmaps[1][n].l2g,
+                        ((size_t) pmaps[0][n].nel) * sizeof(long int) ) )
+               isame = 0;
+         }
+         (void) incg_Part_Report( &( part[1] ), pmaps[1] );
+         for(n=0;n<2;++n) {
+            (void) incg_Part_FreeMaps( 4, pmaps[n] );
+            (void) incg_Part_Free( &( part[n] ) );
+         }
+      }
+      printf("Partition (%s): %ld and %ld violations, same on %d threads %d "
+             "%s\n", method == INCG_PART_RCB ? "bisection" : "graph",
+             nbad[0], nbad[1], nthr, isame, ( ierr == 0 && nbad[0] == 0 &&
+             nbad[1] == 0 && isame ) ? "ok" : "FAILED" );
+      if( ierr || nbad[0] != 0 || nbad[1] != 0 || !isame ) ++nfail;
+   }
+
+   free( mesh.v );
+   free( mesh.e );
+   free( mesh.t );
+   return nfail;
+}
+
+//
+// a function to smooth a grid of triangles whose inner vertices are displaced,
+// on one thread and on all of them: the boundary vertices stay as they were
+// (bit for bit), the inner ones move, and the results of the threads agree
+//
+int test_mesh_smooth()
+{
+   const int n = 12;
+   struct incg_smooth_s opt[2] = { { INCG_SMOOTH_TAUBIN, 5, 0.5, 0.0, 0 },
+                                   { INCG_SMOOTH_LAPLACE, 5, 0.5, 0.0, 1 } };
+   struct ingeom_tris_s tris;
+   mesh_t mesh[2];
+   double *x;
+   int *icon, i, j, k, nthr = 1, nt0 = 1, nfail = 0;
+
+   x = (double *) malloc( ((size_t) (3*(n+1)*(n+1))) * sizeof(double) );
+   icon = (int *) malloc( ((size_t) (6*n*n)) * sizeof(int) );
+   if( x == NULL || icon == NULL ) {
+      if( x != NULL ) free( x );
+      if( icon != NULL ) free( icon );
+      return 1;
+   }
+   for(j=0;j<=n;++j) {
+      for(i=0;i<=n;++i) {
+         double *xp = &( x[3*(j*(n+1)+i)] );
+         int inner = ( i > 0 && i < n && j > 0 && j < n );
+         xp[0] = (double) i + ( inner ? 0.3*sin( 7.0*i + 3.0*j ) : 0.0 );
+         xp[1] = (double) j + ( inner ? 0.3*cos( 5.0*i - 2.0*j ) : 0.0 );
+         xp[2] = 0.0;
+      }
+   }
+   for(j=0;j<n;++j) {
+      for(i=0;i<n;++i) {
+         int *t = &( icon[6*(j*n+i)] ), v = j*(n+1)+i;
+         t[0] = v; t[1] = v+1; t[2] = v+n+2;
+         t[3] = v; t[4] = v+n+2; t[5] = v+n+1;
+      }
+   }
+   tris.np = (n+1)*(n+1);
+   tris.nt = 2*n*n;
+   tris.x = x;
+   tris.icon = icon;
+#ifdef _OPENMP
+   nt0 = omp_get_max_threads();
+   nthr = nt0 > 1 ? nt0 : 4;
+#endif
+
+   for(k=0;k<2;++k) {
+      long int nfix = 0, nmove = 0, ndiff = 0, iv;
+      int ierr = 0, m;
+
+      for(m=0;m<2;++m) {
+#ifdef _OPENMP
+         omp_set_num_threads( m == 0 ? 1 : nthr );
+#endif
+         if( ierr == 0 ) ierr = incg_MakeMesh_FromTris( &( mesh[m] ), &tris,
+                                                        NULL, NULL );
+         if( ierr == 0 ) {
+            ierr = incg_Smooth_Mesh( &( mesh[m] ), &( opt[k] ) );
+            if( ierr ) {
+               free( mesh[m].v );
+               free( mesh[m].e );
+               free( mesh[m].t );
+            }
+         }
+      }
+#ifdef _OPENMP
+      omp_set_num_threads( nt0 );
+#endif
+      if( ierr == 0 ) {
+         for(iv=0;iv<tris.np;++iv) {
+            const vertex_t *v = &( mesh[0].v[iv] ), *w = &( mesh[1].v[iv] );
+            int inner = ( iv%(n+1) > 0 && iv%(n+1) < n &&
+                          iv/(n+1) > 0 && iv/(n+1) < n );
+            int moved = ( v->x != x[3*iv+0] || v->y != x[3*iv+1] ||
+                          v->z != x[3*iv+2] );
+            if( inner && moved ) ++nmove;
+            if( !inner && moved ) ++nfix;
+            if( v->x != w->x || v->y != w->y || v->z != w->z ) ++ndiff;
+         }
+         for(m=0;m<2;++m) {
+            free( mesh[m].v );
+            free( mesh[m].e );
+            free( mesh[m].t );
+         }
+      }
+      printf("Smoothed grid (%s): %ld of %d inner vertices moved, %ld "
+             "boundary ones moved, %ld differ on %d threads %s\n",
+             k == 0 ? "Taubin" : "Laplace, tangent", nmove, (n-1)*(n-1),
+             nfix, ndiff, nthr, ( ierr == 0 && nmove == (n-1)*(n-1) &&
+             nfix == 0 && ndiff == 0 ) ? "ok" : "FAILED" );
+      if( ierr || nmove != (n-1)*(n-1) || nfix != 0 || ndiff != 0 ) ++nfail;
+   }
+
+   free( x );
+   free( icon );
+   return nfail;
+}
+
+//
+// a function to measure faces of known metrics, each many times over so that
+// full tiles and a partial tile are computed: an equilateral triangle, a right
+// isosceles triangle, a unit square and a 2x1 rectangle
+//
+int test_mesh_qual()
+{
+   const double h = 0.5*sqrt(3.0);
+   double x[14][3] = { { 0.0, 0.0, 0.0 }, { 1.0, 0.0, 0.0 }, { 0.5,   h, 0.0 },
+                       { 2.0, 0.0, 0.0 }, { 3.0, 0.0, 0.0 }, { 2.0, 1.0, 0.0 },
+                       { 4.0, 0.0, 0.0 }, { 5.0, 0.0, 0.0 }, { 5.0, 1.0, 0.0 },
+                       { 4.0, 1.0, 0.0 },
+                       { 6.0, 0.0, 0.0 }, { 8.0, 0.0, 0.0 }, { 8.0, 1.0, 0.0 },
+                       { 6.0, 1.0, 0.0 } };
+   long int f[4][4] = { { 0, 1, 2, -1 }, { 3, 4, 5, -1 },
+                        { 6, 7, 8, 9 }, { 10, 11, 12, 13 } };
+   // min/max angle, aspect, skew, Jacobian, warpage of the four faces
+   const double v[4][INCG_QUAL_NMETRIC] = {
+      { 60.0, 60.0, 1.0, 0.0, 1.0, 0.0 },
+      { 45.0, 90.0, sqrt(2.0)*( 2.0 + sqrt(2.0) )/( 2.0*sqrt(3.0) ), 0.25,
+        sqrt(2.0/3.0), 0.0 },
+      { 90.0, 90.0, 1.0, 0.0, 1.0, 0.0 },
+      { 90.0, 90.0, 2.0, 0.0, 1.0, 0.0 } };
+   const long int nrep = 3*INCG_QUAL_TILE + 5;
+   struct incg_qual_s q;
+   long int *faces, nbad = 0, i;
+   double *emet, emax = 0.0;
+   int ierr, k;
+
+   faces = (long int *) malloc( ((size_t) (16*nrep)) * sizeof(long int) );
+   emet = (double *) malloc( ((size_t) (4*nrep*INCG_QUAL_NMETRIC)) *
+                             sizeof(double) );
+   if( faces == NULL || emet == NULL ) {
+      if( faces != NULL ) free( faces );
+      if( emet != NULL ) free( emet );
+      return 1;
+   }
+   for(i=0;i<4*nrep;++i) memcpy( &( faces[4*i] ), f[i%4], 4*sizeof(long int) );
+
+   ierr = incg_Qual_Faces( 14, &( x[0][0] ), 4*nrep, faces, emet, &q );
+   if( ierr == 0 ) {
+      for(i=0;i<4*nrep;++i) {
+         for(k=0;k<INCG_QUAL_NMETRIC;++k) {
+            double e = fabs( emet[INCG_QUAL_NMETRIC*i+k] - v[i%4][k] );
+            if( e > emax ) emax = e;
+         }
+      }
+      if( emax > 1.0e-9 ) ++nbad;
+      if( q.ntri != 2*nrep || q.nquad != 2*nrep ||
+          q.n[INCG_QUAL_WARPAGE] != 2*nrep ||
+          fabs( q.vmin[INCG_QUAL_MINANGLE] - 45.0 ) > 1.0e-9 ||
+          fabs( q.vmax[INCG_QUAL_ASPECT] - 2.0 ) > 1.0e-9 ) ++nbad;
+   }
+   printf("Quality of known faces: largest error %g, %ld bad statistics %s\n",
+          emax, nbad, ( ierr == 0 && nbad == 0 ) ? "ok" : "FAILED" );
+
+   free( faces );
+   free( emet );
+   return ( ierr == 0 && nbad == 0 ) ? 0 : 1;
+}
+
+//
+// a function to find the intersections of pairs of triangles: two that cross
+// and share no vertex are found, the same two sharing a vertex are skipped,
+// and of two that are nearly coplanar (a triangle in the plane x=y, the other
+// one ulp off it) only the pair across the plane is found
+//
+int test_mesh_isect()
+{
+   double x[6][3] = { { 0.0, 0.0, 0.0 }, { 2.0, 0.0, 0.0 }, { 0.0, 2.0, 0.0 },
+                      { 0.5, 0.5,-1.0 }, { 0.5, 0.5, 1.0 }, {-1.0,-1.0, 0.0 } };
+   double y[6][3] = { {-4.0,-4.0,-4.0 }, { 4.0, 4.0,-4.0 }, { 0.0, 0.0, 4.0 },
+                      { 0.0,-0.9, 1.0 }, { 0.0, 2.6,-1.6 }, { 0.0,-2.3,-0.8 } };
+   long int f[2][8] = { { 0, 1, 2, -1, 3, 4, 5, -1 },
+                        { 0, 1, 2, -1, 0, 3, 4, -1 } };
+   long int npair[4] = { -1, -1, -1, -1 }, nexp[4] = { 1, 0, 0, 1 };
+   struct incg_isect_s is;
+   int k, nfail=0;
+
+   for(k=0;k<4;++k) {
+      double *p = k < 2 ? &( x[0][0] ) : &( y[0][0] );
+      int ierr;
+
+      if( k >= 2 ) {
+         y[3][0] = nextafter( y[3][1], 1.0e300 );
+         y[4][0] = nextafter( y[4][1], 1.0e300 );
+         y[5][0] = nextafter( y[5][1], k == 2 ? 1.0e300 : -1.0e300 );
+      }
+      ierr = incg_Isect_Faces( 6, p, 2, f[k==1], &is );
+      if( ierr == 0 ) {
+         npair[k] = is.npair;
+         if( is.npair == 1 && ( is.pair[0] != 0 || is.pair[1] != 1 ) ) {
+            npair[k] = -1;
+         }
+         (void) incg_Isect_Free( &is );
+      }
+      if( npair[k] != nexp[k] ) ++nfail;
+   }
+   printf("Intersections: crossing %ld, sharing a vertex %ld, "
+          "off the plane %ld, across it %ld %s\n",
+          npair[0], npair[1], npair[2], npair[3], nfail ? "FAILED" : "ok" );
+
+   return nfail;
+}
+
+//
+// a function to write a mesh to a binary file, to map it and to form a mesh
+// from it, which must be the mesh that was written; the file with a vertex of
+// an edge out of range must then not form a mesh, and the file cut short must
+// not be mapped
+//
+int test_mesh_file( const mesh_t* m )
+{
+   struct incg_meshfile_s f;
+   struct incg_meshfile_head_s head;
+   mesh_t mf;
+   long int nbad = -1, i;
+   int ierr, icorrupt = 0, itrunc = 0;
+   FILE *fp;
+
+   ierr = incg_MeshFile_WriteMesh( m, "mesh.bin" );
+   if( ierr == 0 ) ierr = incg_MeshFile_Open( "mesh.bin", &f );
+   if( ierr == 0 ) {
+      ierr = incg_MeshFile_MakeMesh( &f, &mf );
+      (void) incg_MeshFile_Close( &f );
+   }
+   if( ierr == 0 ) {
+      nbad = 0;
+      if( mf.nv != m->nv || mf.ne != m->ne || mf.nt != m->nt ) nbad = 1;
+      for(i=0;i<m->nv && nbad==0;++i) {
+         if( mf.v[i].x != m->v[i].x || mf.v[i].y != m->v[i].y ||
+             mf.v[i].z != m->v[i].z ) ++nbad;
+      }
+      for(i=0;i<m->ne && nbad==0;++i) {
+         const edge_t *a = &( mf.e[i] ), *b = &( m->e[i] );
+         if( a->va->id != b->va->id || a->vb->id != b->vb->id ||
+             ( a->tl == NULL ? -1 : a->tl->id ) !=
+             ( b->tl == NULL ? -1 : b->tl->id ) ||
+             ( a->tr == NULL ? -1 : a->tr->id ) !=
+             ( b->tr == NULL ? -1 : b->tr->id ) ) ++nbad;
+      }
+      for(i=0;i<m->nt && nbad==0;++i) {
+         const triangle_t *a = &( mf.t[i] ), *b = &( m->t[i] );
+         if( a->e1->id != b->e1->id || a->e2->id != b->e2->id ||
+             a->e3->id != b->e3->id || a->d1 != b->d1 ||
+             a->d2 != b->d2 || a->d3 != b->d3 ) ++nbad;
+      }
+      free( mf.v );
+      free( mf.e );
+      free( mf.t );
+
+      // a vertex of the first edge out of range
+      fp = fopen( "mesh.bin", "r+b" );
+      if( fp != NULL ) {
+         if( fread( &head, sizeof(head), 1, fp ) == 1 ) {
+            for(i=0;i<(long int) head.nsec;++i) {
+               if( head.sec[i].type == INCG_MESHFILE_EDGEVERT ) {
+                  long int iv = m->nv;
+                  if( fseek( fp, head.sec[i].offset, SEEK_SET ) == 0 )
+                     (void) fwrite( &iv, sizeof(long int), 1, fp );
+               }
+            }
+         }
+         fclose( fp );
+      }
+      icorrupt = incg_MeshFile_Open( "mesh.bin", &f );
+      if( icorrupt == 0 ) {
+         icorrupt = incg_MeshFile_MakeMesh( &f, &mf );
+         (void) incg_MeshFile_Close( &f );
+         if( icorrupt == 0 ) {
+            free( mf.v );
+            free( mf.e );
+            free( mf.t );
+         }
+      }
+
+      // the last section, cut short, lies beyond the end of the file
+      if( truncate( "mesh.bin", 2*INCG_MESHFILE_ALIGN ) == 0 ) {
+         itrunc = incg_MeshFile_Open( "mesh.bin", &f );
+         if( itrunc == 0 ) (void) incg_MeshFile_Close( &f );
+      }
+   }
+   (void) unlink( "mesh.bin" );
+
+   if( icorrupt != 3 || itrunc != 5 ) ierr = 1;
+   printf("Mapped: %ld vertices, %ld edges, %ld triangles, %ld mismatches, "
+          "corrupt file (%d), truncated file (%d) %s\n", m->nv, m->ne, m->nt,
+          nbad, icorrupt, itrunc, ( ierr == 0 && nbad == 0 ) ? "ok" : "FAILED" );
+   return ( ierr == 0 && nbad == 0 ) ? 0 : 1;
+}
+
 int main(int argc, char **argv)
 {
-   int iret;
+   int iret, nfail = 0;
 
    double x1[3] = { 0.0, 0.0, 0.0 };
    double x2[3] = { 1.0, 0.0, 0.0 };
@@ -126,6 +1431,10 @@ int main(int argc, char **argv)
    double pl[4] = {-1.0,-1.0, 1.0, 0.0 };  // plane equation un-normalized
 
    mesh_t mesh;
+   struct incg_check_s check;
+   struct incg_smooth_s smooth = { INCG_SMOOTH_TAUBIN, 5, 0.5, 0.0, 1 };
+   struct incg_qual_s qual;
+   struct incg_isect_s isect;
 
    printf("--------\n");
    printf("Volume of tetrahedron: %lf \n", incg_Tet_CalcVolume( x1,x2,x3,x4 ) );
@@ -169,6 +1478,105 @@ int main(int argc, char **argv)
    (void) incg_RefineMesh_Uniform( &mesh );
    printf("--------\n");
 
-   return(0);
+   // test writing the mesh to a binary file and mapping it back
+   printf("Testing writing and mapping a binary mesh file \n");
+   nfail += test_mesh_file( &mesh );
+   printf("--------\n");
+
+   // test building the vertex adjacency and updating it after refinement
+   printf("Testing the vertex adjacency of a mesh \n");
+   nfail += test_mesh_adj_refine( "Cube", &mesh );
+   nfail += test_mesh_adj();
+   printf("--------\n");
+
+   // test validating the refined mesh
+   printf("Testing the validation of a mesh \n");
+   iret = incg_Check_Mesh( &mesh, &check );
+   if( iret == 0 ) {
+      printf("Violations: %ld \n", incg_Check_Count( &check ) );
+      (void) incg_Check_Free( &check );
+   }
+   nfail += test_mesh_check_parts( &mesh, mesh.nt/3 );
+   printf("--------\n");
+
+   // test partitioning the refined mesh with a layer of ghosts
+   printf("Testing the partitioning of a mesh \n");
+   nfail += test_mesh_part();
+   printf("--------\n");
+
+   // test keeping the levels of uniform refinements of a mesh
+   printf("Testing a hierarchy of refined meshes \n");
+   nfail += test_mesh_hierarchy();
+   printf("--------\n");
+
+   // test smoothing the vertices of the refined mesh in its tangent planes
+   printf("Testing the smoothing of a mesh \n");
+   iret = incg_Smooth_Mesh( &mesh, &smooth );
+   printf("Smoothed (%d): vertex %ld at %lf %lf %lf \n", iret, mesh.nv-1,
+          mesh.v[mesh.nv-1].x, mesh.v[mesh.nv-1].y, mesh.v[mesh.nv-1].z );
+   nfail += test_mesh_smooth();
+   printf("--------\n");
+
+   // test measuring the quality of the elements of the smoothed mesh
+   printf("Testing the quality metrics of a mesh \n");
+   iret = incg_Qual_Mesh( &mesh, NULL, &qual );
+   if( iret == 0 ) (void) incg_Qual_Report( &qual );
+   nfail += test_mesh_qual();
+   printf("--------\n");
+
+   // test finding self-intersections of the smoothed mesh
+   printf("Testing the self-intersections of a mesh \n");
+   iret = incg_Isect_Mesh( &mesh, &isect );
+   if( iret == 0 ) {
+      printf("Intersecting pairs of triangles: %ld \n", isect.npair );
+      (void) incg_Isect_Free( &isect );
+   }
+   nfail += test_mesh_isect();
+   printf("--------\n");
+
+   // test forming meshes from triangle soups
+   printf("Testing forming a mesh from triangles \n");
+   nfail += test_mesh_fromtris();
+   printf("--------\n");
+
+   // test welding the points of a triangle soup
+   printf("Testing welding a triangle soup \n");
+   nfail += test_mesh_weld_chain();
+   nfail += test_mesh_weld();
+   printf("--------\n");
+
+   // test refining a mesh out of core
+   printf("Testing the streaming refinement of a mesh \n");
+   nfail += test_mesh_stream();
+   printf("--------\n");
+
+   // test writing a mesh for plotting and reading it back
+   printf("Testing the plotting formats of a mesh \n");
+   nfail += test_mesh_plot();
+   printf("--------\n");
+
+   // test smoothing a sphere by Loop subdivision
+   printf("Testing the Loop subdivision of a mesh \n");
+   nfail += test_mesh_loop();
+   printf("--------\n");
+
+   // test the normals, areas and curvatures of the vertices of a sphere
+   printf("Testing the curvatures of a mesh \n");
+   nfail += test_mesh_curvature();
+   printf("--------\n");
+
+   // test the geodesic distances on a sphere
+   printf("Testing the geodesic distances on a mesh \n");
+   nfail += test_mesh_geodesic();
+   printf("--------\n");
+
+   // test creating a unit sphere from an icosahedron
+   printf("Testing creating a sphere mesh \n");
+   nfail += test_mesh_sphere();
+   printf("--------\n");
+
+   if( nfail ) printf("Failed checks: %d \n", nfail );
+
+   return( nfail );
 }
 
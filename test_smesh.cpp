@@ -0,0 +1,954 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+extern "C" {
+#include "incg_mesh.h"
+}
+#include "incg_check.h"
+#include "incg_smesh.h"
+#include "incg_smesh_uid_factory.h"
+
+
+//
+// a function to make the mesh of a sphere
+//
+int test_make_sphere( int ns, mesh_t* m )
+{
+   struct ingeom_sphere_s sphere;
+   int ierr;
+
+   memset( &sphere, 0, sizeof(struct ingeom_sphere_s) );
+   sphere.ns = ns;
+   ierr = incg_MakeMesh_Sphere( m, &sphere, INCG_SPHERE_ICOSAHEDRON );
+   if( ierr ) return ierr;
+   free( sphere.x );
+   free( sphere.icon );
+
+   return 0;
+}
+
+//
+// a function to free the arrays of a mesh
+//
+void test_free_mesh( mesh_t* m )
+{
+   free( m->v );
+   free( m->e );
+   free( m->t );
+   memset( m, 0, sizeof(mesh_t) );
+}
+
+//
+// a function to return the number of violations of a mesh, or -1 when it
+// cannot be checked
+//
+long test_count_mesh( const mesh_t* m )
+{
+   struct incg_check_s check;
+   long n;
+
+   if( incg_Check_Mesh( m, &check ) != 0 ) return -1;
+   n = incg_Check_Count( &check );
+   (void) incg_Check_Free( &check );
+
+   return n;
+}
+
+long test_count_smesh( const sMesh_Core & sm )
+{
+   struct incg_check_s check;
+   long n;
+
+   if( sm.check( &check ) != 0 ) return -1;
+   n = incg_Check_Count( &check );
+   (void) incg_Check_Free( &check );
+
+   return n;
+}
+
+//
+// a function to tell whether two meshes export the same nodes and faces
+//
+int test_same_export( const sMesh_Core & a, const sMesh_Core & b )
+{
+   std::vector< node_t > na, nb;
+   std::vector< face_t > fa, fb;
+   size_t i;
+
+   if( a.exportData( na, fa ) != 0 || b.exportData( nb, fb ) != 0 ) return 0;
+   if( na.size() != nb.size() || fa.size() != fb.size() ) return 0;
+   for(i=0;i<na.size();++i) {
+      if( na[i].x != nb[i].x || na[i].y != nb[i].y || na[i].z != nb[i].z ) {
+         return 0;
+      }
+   }
+   for(i=0;i<fa.size();++i) {
+      if( memcmp( fa[i].nodes, fb[i].nodes, sizeof(fa[i].nodes) ) != 0 ) {
+         return 0;
+      }
+   }
+
+   return 1;
+}
+
+//
+// a function to return the UID of the object of a reference
+//
+long test_ref_uid( smesh_ref_t r )
+{
+   const void *p = smesh_ref_ptr( r );
+
+   switch( smesh_ref_kind( r ) ) {
+    case INCG_SMESH_REF_NODE: return ((const sMesh_Node*) p)->getUID();
+    case INCG_SMESH_REF_EDGE: return ((const sMesh_Edge*) p)->getUID();
+    case INCG_SMESH_REF_TRI: return ((const sMesh_Tri*) p)->getUID();
+    case INCG_SMESH_REF_QUAD: return ((const sMesh_Quad*) p)->getUID();
+   }
+   return -1;
+}
+
+//
+// a function to tell whether the references of the nodes and the edges of two
+// meshes are to the same kinds and UIDs, in the same order
+//
+int test_same_refs( const sMesh_Core & a, const sMesh_Core & b )
+{
+   struct incg_smesh_refs_s ra, rb;
+   int isame = 1;
+   long i;
+
+   if( a.snapshotRefs( &ra ) != 0 ) return 0;
+   if( b.snapshotRefs( &rb ) != 0 ) {
+      (void) incg_Smesh_FreeRefs( &ra );
+      return 0;
+   }
+   if( ra.nn != rb.nn || ra.ne != rb.ne ||
+       ra.nofs[ra.nn] != rb.nofs[rb.nn] || ra.eofs[ra.ne] != rb.eofs[rb.ne] ) {
+      isame = 0;
+   }
+   for(i=0;i<ra.nn && isame;++i) if( ra.nofs[i] != rb.nofs[i] ) isame = 0;
+   for(i=0;i<ra.ne && isame;++i) if( ra.eofs[i] != rb.eofs[i] ) isame = 0;
+   for(i=0;i<ra.nofs[ra.nn] && isame;++i) {
+      if( smesh_ref_kind( ra.nref[i] ) != smesh_ref_kind( rb.nref[i] ) ||
+          test_ref_uid( ra.nref[i] ) != test_ref_uid( rb.nref[i] ) ) isame = 0;
+   }
+   for(i=0;i<ra.eofs[ra.ne] && isame;++i) {
+      if( smesh_ref_kind( ra.eref[i] ) != smesh_ref_kind( rb.eref[i] ) ||
+          test_ref_uid( ra.eref[i] ) != test_ref_uid( rb.eref[i] ) ) isame = 0;
+   }
+   (void) incg_Smesh_FreeRefs( &ra );
+   (void) incg_Smesh_FreeRefs( &rb );
+
+   return isame;
+}
+
+//
+// a function to form the arrays of node and face data of the mesh of a sphere
+// for loadData()
+//
+int test_sphere_data( int ns, std::vector< node_t > & nodes,
+                      std::vector< face_t > & faces )
+{
+   mesh_t m;
+   long i;
+
+   if( test_make_sphere( ns, &m ) != 0 ) return 1;
+   nodes.resize( m.nv );
+   faces.resize( m.nt );
+   for(i=0;i<m.nv;++i) {
+      nodes[i].x = m.v[i].x;
+      nodes[i].y = m.v[i].y;
+      nodes[i].z = m.v[i].z;
+   }
+   for(i=0;i<m.nt;++i) {
+      const triangle_t *t = &( m.t[i] );
+      faces[i].nodes[0] = ( t->d1 == 0 ? t->e1->va : t->e1->vb )->id;
+      faces[i].nodes[1] = ( t->d2 == 0 ? t->e2->va : t->e2->vb )->id;
+      faces[i].nodes[2] = ( t->d3 == 0 ? t->e3->va : t->e3->vb )->id;
+      faces[i].nodes[3] = -1;
+   }
+   test_free_mesh( &m );
+
+   return 0;
+}
+
+//
+// a function to form the arrays of node and face data of an open grid of
+// "nc" by "nc" unit cells in the plane z=0, with its inner nodes moved off the
+// lattice; every third cell is cut in two triangles by a diagonal (of which
+// some are obtuse) and the others are quadrilaterals
+//
+int test_grid_data( int nc, std::vector< node_t > & nodes,
+                    std::vector< face_t > & faces )
+{
+   long i, j, n;
+
+   if( nc < 1 ) return 1;
+   nodes.resize( (nc+1)*(nc+1) );
+   faces.clear();
+   for(j=0;j<=nc;++j) {
+      for(i=0;i<=nc;++i) {
+         n = j*(nc+1) + i;
+         nodes[n].x = (double) i;
+         nodes[n].y = (double) j;
+         nodes[n].z = 0.0;
+         if( 0 < i && i < nc && 0 < j && j < nc ) {
+            nodes[n].x += 0.25*sin( 1.7*((double) n) );
+            nodes[n].y += 0.25*cos( 2.3*((double) n) );
+         }
+      }
+   }
+   for(j=0;j<nc;++j) {
+      for(i=0;i<nc;++i) {
+         face_t f;
+         n = j*(nc+1) + i;
+         f.nodes[0] = n;
+         f.nodes[1] = n + 1;
+         f.nodes[2] = n + nc + 2;
+         f.nodes[3] = n + nc + 1;
+         if( (i+j) % 3 == 0 ) {
+            face_t g = { { n, n + nc + 2, n + nc + 1, -1 } };
+            f.nodes[3] = -1;
+            faces.push_back( f );
+            faces.push_back( g );
+         } else {
+            faces.push_back( f );
+         }
+      }
+   }
+
+   return 0;
+}
+
+//
+// a function to insert the edges of the faces of a sphere in the hash table of
+// edges, in bulk and one at a time, and to find them: the keys do not depend
+// on the order of the nodes, a repeated key takes the value of its first
+// insertion, and keys that were not inserted are not found
+//
+int test_smesh_edgehash()
+{
+   std::vector< node_t > nodes;
+   std::vector< face_t > faces;
+   std::vector< unsigned long > keys;
+   std::vector< long > vals;
+   sMesh_EdgeHash hb, h1;
+   long nf, ni=-1, nbad=0, i;
+   int k;
+
+   if( test_sphere_data( 3, nodes, faces ) != 0 ) return 1;
+   nf = (long) faces.size();
+   for(i=0;i<nf;++i) {
+      for(k=0;k<3;++k) {
+         keys.push_back( sMesh_EdgeHash::makeKey(
+                            (unsigned long) faces[i].nodes[k],
+                            (unsigned long) faces[i].nodes[(k+1)%3] ) );
+         vals.push_back( 3*i + k );
+      }
+   }
+
+   // every edge is in two faces, in opposite directions
+   if( hb.reserve( 3*nf ) == 0 ) ni = hb.insertBulk( 3*nf, keys.data(),
+                                                     vals.data() );
+   (void) h1.reserve( 3*nf/2 );
+   for(i=0;i<3*nf;++i) {
+      int iret = h1.insert( keys[i], 3*i );
+      long ifirst = hb.find( keys[i] );
+
+      // (the bulk values are of the first side of the edge)
+      if( ifirst < 0 || ifirst > i || vals[i] != ifirst ) ++nbad;
+      if( keys[ ifirst ] != keys[i] ) ++nbad;
+      if( iret != ( ifirst == i ? 0 : 1 ) ) ++nbad;
+      if( h1.find( keys[i] ) != 3*ifirst ) ++nbad;
+   }
+   if( hb.size() != 3*nf/2 || h1.size() != 3*nf/2 ) ++nbad;
+   if( hb.find( sMesh_EdgeHash::makeKey( 0, 0 ) ) != -1 ) ++nbad;
+   if( hb.find( sMesh_EdgeHash::makeKey( 0, nodes.size() ) ) != -1 ) ++nbad;
+   if( sMesh_EdgeHash::makeKey( 3, 7 ) != sMesh_EdgeHash::makeKey( 7, 3 ) ) {
+      ++nbad;
+   }
+
+   printf("Edge hash: %ld sides, %ld edges inserted, %ld mismatches %s\n",
+          3*nf, ni, nbad, ( ni == 3*nf/2 && nbad == 0 ) ? "ok" : "FAILED" );
+   return ( ni == 3*nf/2 && nbad == 0 ) ? 0 : 1;
+}
+
+//
+// a function to load the data of a sphere into an sMesh and to quadify it,
+// with the mesh checked clean after both
+//
+int test_smesh_tables()
+{
+   std::vector< node_t > nodes;
+   std::vector< face_t > faces;
+   sMesh_Core sm;
+   long nbad[2] = { -1, -1 };
+   int ierr;
+
+   ierr = test_sphere_data( 2, nodes, faces );
+   if( ierr == 0 ) {
+      ierr = sm.loadData( (int) nodes.size(), nodes.data(),
+                          (int) faces.size(), faces.data() );
+   }
+   if( ierr == 0 ) {
+      nbad[0] = test_count_smesh( sm );
+      ierr = sm.quadify();
+   }
+   if( ierr == 0 ) nbad[1] = test_count_smesh( sm );
+
+   printf("Loaded %d faces: %ld violations, quadified: %ld violations %s\n",
+          (int) faces.size(), nbad[0], nbad[1],
+          ( ierr == 0 && nbad[0] == 0 && nbad[1] == 0 ) ? "ok" : "FAILED" );
+   return ( ierr == 0 && nbad[0] == 0 && nbad[1] == 0 ) ? 0 : 1;
+}
+
+//
+// a function to load the triangles and quadrilaterals of a quadified sphere by
+// loadData() and by loadDataParallel() with a number of threads: the meshes
+// export the same data, and their references are to the same UIDs in the same
+// order; they are quadified again and compared once more
+//
+int test_smesh_loadparallel()
+{
+   std::vector< node_t > nodes;
+   std::vector< face_t > faces;
+   int ierr, nfail = 0, nthr, nt0 = 1;
+
+   {  sMesh_Core sq;
+
+      ierr = test_sphere_data( 2, nodes, faces );
+      if( ierr == 0 ) {
+         ierr = sq.loadData( (int) nodes.size(), nodes.data(),
+                             (int) faces.size(), faces.data() );
+      }
+      if( ierr == 0 ) ierr = sq.quadify();
+      if( ierr == 0 ) ierr = sq.exportData( nodes, faces );
+      if( ierr ) return 1;
+   }
+
+#ifdef _OPENMP
+   nt0 = omp_get_max_threads();
+#endif
+   for(nthr=1;nthr<=4;++nthr) {
+      sMesh_Core ss, sp;
+      int isame[2] = { 0, 0 };
+      long nbad = -1;
+
+#ifdef _OPENMP
+      omp_set_num_threads( nthr );
+#endif
+      ierr = ss.loadData( (int) nodes.size(), nodes.data(),
+                          (int) faces.size(), faces.data() );
+      if( ierr == 0 ) {
+         ierr = sp.loadDataParallel( (int) nodes.size(), nodes.data(),
+                                     (int) faces.size(), faces.data() );
+      }
+      if( ierr == 0 ) {
+         isame[0] = test_same_export( ss, sp ) && test_same_refs( ss, sp );
+         nbad = test_count_smesh( sp );
+         ierr = ss.quadify();
+      }
+      if( ierr == 0 ) ierr = sp.quadify();
+      if( ierr == 0 ) {
+         isame[1] = test_same_export( ss, sp ) && test_same_refs( ss, sp );
+      }
+
+      printf("Parallel load of %d faces, %d threads: same %d, quadified "
+             "same %d, %ld violations %s\n", (int) faces.size(), nthr,
+             isame[0], isame[1], nbad,
+             ( ierr == 0 && isame[0] && isame[1] && nbad == 0 ) ?
+             "ok" : "FAILED" );
+      if( ierr || !isame[0] || !isame[1] || nbad != 0 ) ++nfail;
+   }
+#ifdef _OPENMP
+   omp_set_num_threads( nt0 );
+#endif
+
+   return nfail;
+}
+
+//
+// a function to count the references of a snapshot that differ from those of
+// the objects: the objects are reached from the references of the nodes to
+// their edges and from the nodes of the edges, and all the references of the
+// snapshot must belong to an object that was reached (-1 if it fails)
+//
+long test_check_refs( const sMesh_Core & sm )
+{
+   struct incg_smesh_refs_s r;
+   std::vector< char > nseen, eseen;
+   long nbad=0, nsum=0, esum=0, u, i;
+   unsigned int k;
+   int j;
+
+   if( sm.snapshotRefs( &r ) != 0 ) return -1;
+   nseen.assign( r.nn, 0 );
+   eseen.assign( r.ne, 0 );
+   for(u=0;u<r.nn;++u) {
+      for(i=r.nofs[u];i<r.nofs[u+1];++i) {
+         const sMesh_Edge *ep;
+         if( smesh_ref_kind( r.nref[i] ) != INCG_SMESH_REF_EDGE ) continue;
+         ep = (const sMesh_Edge*) smesh_ref_ptr( r.nref[i] );
+         if( ep->getUID() < 0 || ep->getUID() >= r.ne ) { ++nbad; continue; }
+         if( eseen[ ep->getUID() ] ) continue;
+         eseen[ ep->getUID() ] = 1;
+
+         // the references of the edge
+         if( (long) ep->getNumRefs() !=
+             r.eofs[ ep->getUID()+1 ] - r.eofs[ ep->getUID() ] ) ++nbad;
+         for(k=0;k<ep->getNumRefs();++k) {
+            long n = r.eofs[ ep->getUID() ] + (long) k;
+            if( n >= r.eofs[ ep->getUID()+1 ] ||
+                r.eref[n] != ep->getRef(k) ) ++nbad;
+         }
+         esum += (long) ep->getNumRefs();
+
+         // the references of the nodes of the edge
+         for(j=1;j<=2;++j) {
+            const sMesh_Node *np = ep->getNodePtr( j );
+            long v = np->getUID();
+            if( v < 0 || v >= r.nn ) { ++nbad; continue; }
+            if( nseen[v] ) continue;
+            nseen[v] = 1;
+            if( (long) np->getNumRefs() != r.nofs[v+1] - r.nofs[v] ) ++nbad;
+            for(k=0;k<np->getNumRefs();++k) {
+               long n = r.nofs[v] + (long) k;
+               if( n >= r.nofs[v+1] || r.nref[n] != np->getRef(k) ) ++nbad;
+            }
+            nsum += (long) np->getNumRefs();
+         }
+      }
+   }
+   if( nsum != r.nofs[r.nn] ) ++nbad;
+   if( esum != r.eofs[r.ne] ) ++nbad;
+   (void) incg_Smesh_FreeRefs( &r );
+
+   return nbad;
+}
+
+//
+// a function to compare the snapshot of the references with the references of
+// the objects of a sphere, of the sphere quadified, and of a fan of triangles
+// whose middle node has more references than are kept inline
+//
+int test_smesh_refs()
+{
+   std::vector< node_t > nodes;
+   std::vector< face_t > faces;
+   long nbad[3] = { -1, -1, -1 };
+   int ierr, nfail = 0, i;
+
+   {  sMesh_Core sm;
+
+      ierr = test_sphere_data( 2, nodes, faces );
+      if( ierr == 0 ) {
+         ierr = sm.loadData( (int) nodes.size(), nodes.data(),
+                             (int) faces.size(), faces.data() );
+      }
+      if( ierr == 0 ) {
+         nbad[0] = test_check_refs( sm );
+         ierr = sm.quadify();
+      }
+      if( ierr == 0 ) nbad[1] = test_check_refs( sm );
+   }
+
+   if( ierr == 0 ) {
+      sMesh_Core sf;
+      int nfan = 3*INCG_SMESH_NODE_NREF;
+
+      nodes.resize( nfan+1 );
+      faces.resize( nfan );
+      nodes[0].x = nodes[0].y = nodes[0].z = 0.0;
+      for(i=0;i<nfan;++i) {
+         nodes[i+1].x = cos( 2.0*M_PI*((double) i)/((double) nfan) );
+         nodes[i+1].y = sin( 2.0*M_PI*((double) i)/((double) nfan) );
+         nodes[i+1].z = 0.0;
+         faces[i].nodes[0] = 0;
+         faces[i].nodes[1] = i+1;
+         faces[i].nodes[2] = (i+1) % nfan + 1;
+         faces[i].nodes[3] = -1;
+      }
+      ierr = sf.loadData( (int) nodes.size(), nodes.data(),
+                          (int) faces.size(), faces.data() );
+      if( ierr == 0 ) nbad[2] = test_check_refs( sf );
+   }
+
+   for(i=0;i<3;++i) {
+      static const char *name[3] = { "sphere", "quadified", "fan" };
+      printf("References of the %s: %ld mismatches %s\n", name[i], nbad[i],
+             ( ierr == 0 && nbad[i] == 0 ) ? "ok" : "FAILED" );
+      if( ierr || nbad[i] != 0 ) ++nfail;
+   }
+
+   return nfail;
+}
+
+//
+// a function to write a quadified sphere (triangles and quadrilaterals) to a
+// binary file and to load it back: the mesh that is loaded exports the same
+// data and checks clean
+//
+int test_smesh_binary()
+{
+   std::vector< node_t > nodes;
+   std::vector< face_t > faces;
+   sMesh_Core sm, sb;
+   long nbad = -1;
+   int ierr, isame = 0;
+
+   ierr = test_sphere_data( 2, nodes, faces );
+   if( ierr == 0 ) {
+      ierr = sm.loadData( (int) nodes.size(), nodes.data(),
+                          (int) faces.size(), faces.data() );
+   }
+   if( ierr == 0 ) ierr = sm.quadify();
+   if( ierr == 0 ) ierr = sm.writeBinary( "smesh.bin" );
+   if( ierr == 0 ) ierr = sb.loadBinary( "smesh.bin" );
+   if( ierr == 0 ) {
+      isame = test_same_export( sm, sb );
+      nbad = test_count_smesh( sb );
+   }
+   (void) unlink( "smesh.bin" );
+
+   printf("Binary file round trip: same %d, %ld violations %s\n", isame, nbad,
+          ( ierr == 0 && isame && nbad == 0 ) ? "ok" : "FAILED" );
+   return ( ierr == 0 && isame && nbad == 0 ) ? 0 : 1;
+}
+
+//
+// a function to load and quadify independent meshes of parts of different
+// sizes, one after the other and then concurrently in threads (each mesh with
+// its own factory): every mesh exports the same data both ways and checks clean
+//
+int test_smesh_concurrent()
+{
+   const int npart = 8;
+   std::vector< node_t > nodes[npart], nser[npart], npar[npart];
+   std::vector< face_t > faces[npart], fser[npart], fpar[npart];
+   long nbad[npart];
+   int ierr[npart], nfail = 0, nt0 = 1, n;
+   size_t i;
+
+   for(n=0;n<npart;++n) {
+      ierr[n] = test_sphere_data( 1 + n%3, nodes[n], faces[n] );
+      for(i=0;i<nodes[n].size();++i) nodes[n][i].z += 3.0*((double) n);
+   }
+   for(n=0;n<npart;++n) {
+      sMesh_Core sm;
+      if( ierr[n] == 0 ) {
+         ierr[n] = sm.loadData( (int) nodes[n].size(), nodes[n].data(),
+                                (int) faces[n].size(), faces[n].data() );
+      }
+      if( ierr[n] == 0 ) ierr[n] = sm.quadify();
+      if( ierr[n] == 0 ) ierr[n] = sm.exportData( nser[n], fser[n] );
+   }
+
+#ifdef _OPENMP
+   nt0 = omp_get_max_threads();
+   omp_set_num_threads( 4 );
+#endif
+#pragma omp parallel for schedule(dynamic,1)
+   for(n=0;n<npart;++n) {
+      sMesh_Core sm;
+      nbad[n] = -1;
+      if( ierr[n] == 0 ) {
+         ierr[n] = sm.loadData( (int) nodes[n].size(), nodes[n].data(),
+                                (int) faces[n].size(), faces[n].data() );
+      }
+      if( ierr[n] == 0 ) ierr[n] = sm.quadify();
+      if( ierr[n] == 0 ) ierr[n] = sm.exportData( npar[n], fpar[n] );
+      if( ierr[n] == 0 ) nbad[n] = test_count_smesh( sm );
+   }
+#ifdef _OPENMP
+   omp_set_num_threads( nt0 );
+#endif
+
+   for(n=0;n<npart;++n) {
+      int isame = ierr[n] == 0 &&
+                  nser[n].size() == npar[n].size() &&
+                  fser[n].size() == fpar[n].size() &&
+                  memcmp( nser[n].data(), npar[n].data(),
+                          nser[n].size()*sizeof(node_t) ) == 0 &&
+                  memcmp( fser[n].data(), fpar[n].data(),
+                          fser[n].size()*sizeof(face_t) ) == 0;
+
+      printf("Part %d of %d faces quadified in a thread: same %d, "
+             "%ld violations %s\n", n, (int) faces[n].size(), isame,
+             nbad[n], ( isame && nbad[n] == 0 ) ? "ok" : "FAILED" );
+      if( !isame || nbad[n] != 0 ) ++nfail;
+   }
+
+   return nfail;
+}
+
+//
+// a function to quadify spheres with quadify() and with quadifyParallel() at
+// a number of threads (one thread falls back to quadify()): the meshes export
+// the same data, their references are to the same UIDs in the same order, and
+// the mesh of quadifyParallel() checks clean
+//
+int test_smesh_quadparallel()
+{
+   std::vector< node_t > nodes;
+   std::vector< face_t > faces;
+   int ierr, nfail = 0, nthr, nt0 = 1, ns;
+
+#ifdef _OPENMP
+   nt0 = omp_get_max_threads();
+#endif
+   for(ns=2;ns<=3;++ns) {
+      ierr = test_sphere_data( ns, nodes, faces );
+      if( ierr ) return 1;
+
+      for(nthr=1;nthr<=4;++nthr) {
+         sMesh_Core ss, sp;
+         int isame = 0;
+         long nbad = -1;
+
+#ifdef _OPENMP
+         omp_set_num_threads( nthr );
+#endif
+         ierr = ss.loadData( (int) nodes.size(), nodes.data(),
+                             (int) faces.size(), faces.data() );
+         if( ierr == 0 ) {
+            ierr = sp.loadData( (int) nodes.size(), nodes.data(),
+                                (int) faces.size(), faces.data() );
+         }
+         if( ierr == 0 ) ierr = ss.quadify();
+         if( ierr == 0 ) ierr = sp.quadifyParallel();
+         if( ierr == 0 ) {
+            isame = test_same_export( ss, sp ) && test_same_refs( ss, sp );
+            nbad = test_count_smesh( sp );
+         }
+
+         printf("Parallel quadify of %d faces, %d threads: same %d, "
+                "%ld violations %s\n", (int) faces.size(), nthr, isame,
+                nbad, ( ierr == 0 && isame && nbad == 0 ) ? "ok" : "FAILED" );
+         if( ierr || !isame || nbad != 0 ) ++nfail;
+      }
+   }
+#ifdef _OPENMP
+   omp_set_num_threads( nt0 );
+#endif
+
+   return nfail;
+}
+
+//
+// a function to compare the parallel quadify with the serial one on an open
+// grid of quadrilaterals and triangles: rule 3 splits the obtuse triangles,
+// and rules 2u and 2v halve the quadrilaterals next to split edges, which adds
+// leaves to those of rules 3 and 1 alone
+//
+int test_smesh_quadgrid()
+{
+   std::vector< node_t > nodes;
+   std::vector< face_t > faces;
+   long nobt = 0, ntri = 0, nquad = 0, nleaf = 0;
+   int ierr, nfail = 0, nthr, nt0 = 1, k;
+   size_t n;
+
+   if( test_grid_data( 6, nodes, faces ) != 0 ) return 1;
+   for(n=0;n<faces.size();++n) {
+      if( faces[n].nodes[3] >= 0 ) {
+         ++nquad;
+         continue;
+      }
+      ++ntri;
+      for(k=0;k<3;++k) {
+         const node_t & a = nodes[ faces[n].nodes[k] ];
+         const node_t & b = nodes[ faces[n].nodes[(k+1)%3] ];
+         const node_t & c = nodes[ faces[n].nodes[(k+2)%3] ];
+         if( (b.x - a.x)*(c.x - a.x) + (b.y - a.y)*(c.y - a.y) < 0.0 ) ++nobt;
+      }
+   }
+
+#ifdef _OPENMP
+   nt0 = omp_get_max_threads();
+#endif
+   for(nthr=1;nthr<=8;++nthr) {
+      sMesh_Core ss, sp;
+      std::vector< node_t > nl;
+      std::vector< face_t > fl;
+      int isame = 0;
+      long nbad = -1;
+
+#ifdef _OPENMP
+      omp_set_num_threads( nthr );
+#endif
+      ierr = ss.loadData( (int) nodes.size(), nodes.data(),
+                          (int) faces.size(), faces.data() );
+      if( ierr == 0 ) {
+         ierr = sp.loadData( (int) nodes.size(), nodes.data(),
+                             (int) faces.size(), faces.data() );
+      }
+      if( ierr == 0 ) ierr = ss.quadify();
+      if( ierr == 0 ) ierr = sp.quadifyParallel();
+      if( ierr == 0 ) ierr = sp.exportData( nl, fl );
+      if( ierr == 0 ) {
+         isame = test_same_export( ss, sp ) && test_same_refs( ss, sp );
+         nbad = test_count_smesh( sp );
+         nleaf = (long) fl.size();
+      }
+
+      printf("Parallel quadify of a grid of %ld triangles (%ld obtuse) and "
+             "%ld quadrilaterals, %d threads: %ld leaves, same %d, %ld "
+             "violations %s\n", ntri, nobt, nquad, nthr, nleaf, isame, nbad,
+             ( ierr == 0 && isame && nbad == 0 && nobt > 0 &&
+               nleaf > nquad + 3*(ntri + nobt) ) ? "ok" : "FAILED" );
+      if( ierr || !isame || nbad != 0 || nobt == 0 ||
+          nleaf <= nquad + 3*(ntri + nobt) ) ++nfail;
+   }
+#ifdef _OPENMP
+   omp_set_num_threads( nt0 );
+#endif
+
+   return nfail;
+}
+
+//
+// a function to make tetrahedra with as many workers as there are threads,
+// taking the items of work out of order, and to publish them renumbered: the
+// UIDs are dense and in the order of the keys, the mesh checks clean, and it
+// exports the same data as loadData() of the faces of the tetrahedra
+//
+int test_smesh_publish()
+{
+   static const int tet_face[4][3] = { {0,2,1}, {0,1,3}, {1,2,3}, {0,3,2} };
+   static const int tet_edge[6][2] = { {0,1}, {0,2}, {0,3}, {1,2}, {1,3},
+                                       {2,3} };
+   const long ntet = 500;
+   std::vector< node_t > nodes( 4*ntet );
+   std::vector< face_t > faces( 4*ntet );
+   int nfail = 0, nthr, nt0 = 1, n;
+   long i;
+
+   for(i=0;i<ntet;++i) {
+      for(n=0;n<4;++n) {
+         nodes[4*i+n].x = 2.0*((double) i) + ( n == 1 ? 1.0 : 0.0 );
+         nodes[4*i+n].y = ( n == 2 ? 1.0 : 0.0 );
+         nodes[4*i+n].z = ( n == 3 ? 1.0 : 0.0 );
+         faces[4*i+n].nodes[0] = 4*i + tet_face[n][0];
+         faces[4*i+n].nodes[1] = 4*i + tet_face[n][1];
+         faces[4*i+n].nodes[2] = 4*i + tet_face[n][2];
+         faces[4*i+n].nodes[3] = -1;
+      }
+   }
+
+#ifdef _OPENMP
+   nt0 = omp_get_max_threads();
+#endif
+   for(nthr=1;nthr<=4;++nthr) {
+      sMesh_Core ss, sm;
+      std::vector< sMesh_Worker* > w;
+      std::vector< sMesh_Node* > np( 4*ntet );
+      std::vector< sMesh_Edge* > ep( 6*ntet );
+      std::vector< sMesh_Tri* > tp( 4*ntet );
+      long nuid = 0, nbad = -1;
+      int ierr, isame = 0, nw = 1;
+
+#ifdef _OPENMP
+      omp_set_num_threads( nthr );
+      nw = omp_get_max_threads();
+#endif
+      for(n=0;n<nw;++n) w.push_back( new sMesh_Worker( sm.getFactory() ) );
+
+#pragma omp parallel for schedule(dynamic,7)
+      for(i=0;i<ntet;++i) {
+         sMesh_Worker *wp = w[0];
+         sMesh_Edge *e[4][4];
+         long t = ( i*7919 ) % ntet;       // items are taken out of order
+         int j, k;
+#ifdef _OPENMP
+         wp = w[ omp_get_thread_num() ];
+#endif
+         wp->setKey( (unsigned long) t );
+         for(j=0;j<4;++j) {
+            np[4*t+j] = wp->newNode();
+            np[4*t+j]->x = nodes[4*t+j].x;
+            np[4*t+j]->y = nodes[4*t+j].y;
+            np[4*t+j]->z = nodes[4*t+j].z;
+         }
+         for(k=0;k<6;++k) {
+            int a = tet_edge[k][0], b = tet_edge[k][1];
+            ep[6*t+k] = wp->newEdge( np[4*t+a], np[4*t+b] );
+            ep[6*t+k]->computeLength();
+            e[a][b] = e[b][a] = ep[6*t+k];
+         }
+         for(j=0;j<4;++j) {
+            unsigned char dirs = 0x00;
+            sMesh_Edge *s[3];
+            for(k=0;k<3;++k) {
+               int a = tet_face[j][k], b = tet_face[j][(k+1)%3];
+               s[k] = e[a][b];
+               if( a < b ) s[k]->flags |= 0x01;
+               else {
+                  s[k]->flags |= 0x02;
+                  dirs |= 0x01 << (3 - k);
+               }
+            }
+            tp[4*t+j] = wp->newTri( s[0], s[1], s[2], dirs << 4 );
+         }
+      }
+      ierr = sm.publish( nw, w.data(), 1 );
+      for(n=0;n<nw;++n) delete w[n];
+
+      if( ierr == 0 ) {
+         for(i=0;i<4*ntet;++i) if( np[i]->getUID() != i ) ++nuid;
+         for(i=0;i<6*ntet;++i) if( ep[i]->getUID() != i ) ++nuid;
+         for(i=0;i<4*ntet;++i) if( tp[i]->getUID() != i ) ++nuid;
+         if( sm.getFactory()->getLastNodeUID() != 4*ntet-1 ) ++nuid;
+         if( sm.getFactory()->getLastEdgeUID() != 6*ntet-1 ) ++nuid;
+         if( sm.getFactory()->getLastTriUID() != 4*ntet-1 ) ++nuid;
+         nbad = test_count_smesh( sm );
+         ierr = ss.loadData( (int) nodes.size(), nodes.data(),
+                             (int) faces.size(), faces.data() );
+      }
+      if( ierr == 0 ) isame = test_same_export( ss, sm );
+
+      printf("Published %ld tetrahedra, %d workers: %ld misplaced UIDs, "
+             "%ld violations, same as loaded %d %s\n", ntet, nw, nuid, nbad,
+             isame, ( ierr == 0 && nuid == 0 && nbad == 0 && isame ) ?
+             "ok" : "FAILED" );
+      if( ierr || nuid != 0 || nbad != 0 || !isame ) ++nfail;
+   }
+#ifdef _OPENMP
+   omp_set_num_threads( nt0 );
+#endif
+
+   return nfail;
+}
+
+//
+// a function to load the mesh of a sphere into an sMesh and to export it back:
+// the counts, the vertices and the corners of the triangles are kept, and
+// both meshes check clean; the mesh that quadify makes is exported as well
+//
+int test_smesh_roundtrip()
+{
+   mesh_t m, mo, mq;
+   sMesh_Core sm;
+   long nbad[4] = { -1, -1, -1, -1 }, ndiff = 0, i;
+   int ierr, nfail = 0;
+
+   memset( &mo, 0, sizeof(mesh_t) );
+   memset( &mq, 0, sizeof(mesh_t) );
+   ierr = test_make_sphere( 2, &m );
+   if( ierr ) return 1;
+
+   ierr = sm.loadMesh( &m );
+   if( ierr == 0 ) {
+      nbad[0] = test_count_smesh( sm );
+      ierr = sm.exportMesh( &mo );
+   }
+   if( ierr == 0 ) {
+      nbad[1] = test_count_mesh( &mo );
+      for(i=0;i<m.nv && i<mo.nv;++i) {
+         if( m.v[i].x != mo.v[i].x || m.v[i].y != mo.v[i].y ||
+             m.v[i].z != mo.v[i].z ) ++ndiff;
+      }
+      for(i=0;i<m.nt && i<mo.nt;++i) {
+         const triangle_t *t = &( m.t[i] ), *to = &( mo.t[i] );
+         long ia = ( t->d1 == 0 ? t->e1->va : t->e1->vb )->id;
+         long ib = ( t->d2 == 0 ? t->e2->va : t->e2->vb )->id;
+         long ic = ( t->d3 == 0 ? t->e3->va : t->e3->vb )->id;
+         long ja = ( to->d1 == 0 ? to->e1->va : to->e1->vb )->id;
+         long jb = ( to->d2 == 0 ? to->e2->va : to->e2->vb )->id;
+         long jc = ( to->d3 == 0 ? to->e3->va : to->e3->vb )->id;
+
+         // the same loop, from any one of its corners
+         if( !( ia == ja && ib == jb && ic == jc ) &&
+             !( ia == jb && ib == jc && ic == ja ) &&
+             !( ia == jc && ib == ja && ic == jb ) ) ++ndiff;
+      }
+   }
+   printf("Round trip: %ld/%ld vertices, %ld/%ld edges, %ld/%ld triangles, "
+          "%ld differences, %ld + %ld violations %s\n",
+          m.nv, mo.nv, m.ne, mo.ne, m.nt, mo.nt, ndiff, nbad[0], nbad[1],
+          ( ierr == 0 && m.nv == mo.nv && m.ne == mo.ne && m.nt == mo.nt &&
+            ndiff == 0 && nbad[0] == 0 && nbad[1] == 0 ) ? "ok" : "FAILED" );
+   if( ierr || m.nv != mo.nv || m.ne != mo.ne || m.nt != mo.nt ||
+       ndiff != 0 || nbad[0] != 0 || nbad[1] != 0 ) ++nfail;
+
+   // quadrilaterals are exported as two triangles
+   ierr = sm.quadify();
+   if( ierr == 0 ) {
+      nbad[2] = test_count_smesh( sm );
+      ierr = sm.exportMesh( &mq );
+   }
+   if( ierr == 0 ) nbad[3] = test_count_mesh( &mq );
+   printf("Quadified: %ld vertices, %ld edges, %ld triangles, "
+          "%ld + %ld violations %s\n", mq.nv, mq.ne, mq.nt, nbad[2], nbad[3],
+          ( ierr == 0 && mq.nv - mq.ne + mq.nt == 2 &&
+            nbad[2] == 0 && nbad[3] == 0 ) ? "ok" : "FAILED" );
+   if( ierr || mq.nv - mq.ne + mq.nt != 2 || nbad[2] != 0 || nbad[3] != 0 ) {
+      ++nfail;
+   }
+
+   test_free_mesh( &m );
+   if( mo.v != NULL ) test_free_mesh( &mo );
+   if( mq.v != NULL ) test_free_mesh( &mq );
+   return nfail;
+}
+
+
+int main( int argc, char **argv )
+{
+   int nfail = 0;
+
+   // test moving a mesh of triangles into an sMesh and back
+   printf("Testing the conversion of an sMesh to and from triangles \n");
+   nfail += test_smesh_roundtrip();
+   printf("--------\n");
+
+   // test checking the tables of an sMesh after loading and quadifying
+   printf("Testing the tables of an sMesh \n");
+   nfail += test_smesh_tables();
+   printf("--------\n");
+
+   // test the hash table of the edges of the loader
+   printf("Testing the hash table of edges \n");
+   nfail += test_smesh_edgehash();
+   printf("--------\n");
+
+   // test the parallel loader against the serial one
+   printf("Testing the parallel loader of an sMesh \n");
+   nfail += test_smesh_loadparallel();
+   printf("--------\n");
+
+   // test the snapshot of the references
+   printf("Testing the snapshot of the references of an sMesh \n");
+   nfail += test_smesh_refs();
+   printf("--------\n");
+
+   // test writing and loading binary files
+   printf("Testing the binary files of an sMesh \n");
+   nfail += test_smesh_binary();
+   printf("--------\n");
+
+   // test independent meshes in threads
+   printf("Testing independent sMesh objects in threads \n");
+   nfail += test_smesh_concurrent();
+   printf("--------\n");
+
+   // test publishing the objects of many workers
+   printf("Testing the publishing of workers into an sMesh \n");
+   nfail += test_smesh_publish();
+   printf("--------\n");
+
+   // test the parallel quadify against the serial one
+   printf("Testing the parallel quadify of an sMesh \n");
+   nfail += test_smesh_quadparallel();
+   nfail += test_smesh_quadgrid();
+   printf("--------\n");
+
+   if( nfail ) printf("Failed checks: %d \n", nfail );
+   return( nfail );
+}